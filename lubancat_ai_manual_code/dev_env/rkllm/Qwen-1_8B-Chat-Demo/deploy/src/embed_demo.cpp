@@ -0,0 +1,214 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Embedding and retrieval with the last hidden layer of an rkllm model.
+ *
+ *   embed_demo model_path store_path add texts.txt [mean|last] [n_batch]
+ *       embeds every non empty line of texts.txt and appends it to the store,
+ *       the lines go to store_path.txt, line i is vector id i
+ *   embed_demo model_path store_path query "text" [top_k]
+ *       prints the top_k closest lines by cosine similarity
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "llm_embed.h"
+#include "vector_store.h"
+
+#define MAX_CONTEXT_LEN 512
+#define ADD_CHUNK 64
+
+static float elapsed_ms(std::chrono::steady_clock::time_point from)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - from).count();
+}
+
+static int read_lines(const std::string &path, std::vector<std::string> &lines)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        return -1;
+    }
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        lines.push_back(line);
+    }
+    return 0;
+}
+
+static int add_texts(llm_embedder_t *emb, const char *store_path, const char *texts_path)
+{
+    std::vector<std::string> lines, texts;
+    if (read_lines(texts_path, lines) != 0)
+    {
+        printf("open %s fail!\n", texts_path);
+        return -1;
+    }
+    for (const std::string &line : lines)
+    {
+        if (line.find_first_not_of(" \t") != std::string::npos)
+        {
+            texts.push_back(line);
+        }
+    }
+
+    vector_store_t store;
+    if (vector_store_open(&store, store_path, emb->dim, true) != 0)
+    {
+        return -1;
+    }
+    if (store.header->count == 0)
+    {
+        store.header->tag = emb->pooling;
+    }
+    else if (store.header->tag != (uint32_t)emb->pooling)
+    {
+        printf("%s holds %s pooled vectors\n", store_path, store.header->tag == LLM_POOL_LAST ? "last" : "mean");
+        vector_store_close(&store);
+        return -1;
+    }
+    FILE *fp = fopen((std::string(store_path) + ".txt").c_str(), "a");
+    if (fp == NULL)
+    {
+        printf("open %s.txt fail!\n", store_path);
+        vector_store_close(&store);
+        return -1;
+    }
+
+    // texts go in chunks, the vectors and their lines are written together
+    auto start = std::chrono::steady_clock::now();
+    std::vector<float> vectors((size_t)ADD_CHUNK * emb->dim);
+    std::vector<const char *> ptrs;
+    int ret = 0;
+    for (size_t i = 0; i < texts.size() && ret == 0; i += ADD_CHUNK)
+    {
+        int n = (int)std::min(texts.size() - i, (size_t)ADD_CHUNK);
+        ptrs.clear();
+        for (int j = 0; j < n; j++)
+        {
+            ptrs.push_back(texts[i + j].c_str());
+        }
+        ret = llm_embed(emb, ptrs.data(), n, vectors.data());
+        if (ret == 0)
+        {
+            ret = vector_store_add(&store, vectors.data(), n);
+        }
+        for (int j = 0; j < n && ret == 0; j++)
+        {
+            fprintf(fp, "%s\n", ptrs[j]);
+        }
+    }
+    float ms = elapsed_ms(start);
+    printf("%zu texts embedded in %.1f ms, %.1f texts/s, %d per run, store holds %llu\n", texts.size(), ms,
+           texts.size() * 1000.0f / ms, emb->n_batch, (unsigned long long)store.header->count);
+    fclose(fp);
+    vector_store_close(&store);
+    return ret;
+}
+
+static int query_text(llm_embedder_t *emb, const vector_store_t *store, const char *store_path, const char *text,
+                      int top_k)
+{
+    std::vector<std::string> lines;
+    read_lines(std::string(store_path) + ".txt", lines);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<float> query(emb->dim);
+    if (llm_embed(emb, &text, 1, query.data()) != 0)
+    {
+        return -1;
+    }
+    float embed_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<int64_t> ids(top_k);
+    std::vector<float> scores(top_k);
+    int n = vector_store_search(store, query.data(), top_k, ids.data(), scores.data());
+    float search_ms = elapsed_ms(start);
+
+    printf("embed %.1f ms, search %.3f ms over %llu vectors\n", embed_ms, search_ms,
+           (unsigned long long)store->header->count);
+    for (int i = 0; i < n; i++)
+    {
+        const char *line = ids[i] < (int64_t)lines.size() ? lines[ids[i]].c_str() : "";
+        printf("[%d] %.4f #%lld %s\n", i, scores[i], (long long)ids[i], line);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 5 || (strcmp(argv[3], "add") != 0 && strcmp(argv[3], "query") != 0))
+    {
+        fprintf(stderr, "Usage: %s model_path store_path add texts.txt [mean|last] [n_batch]\n", argv[0]);
+        fprintf(stderr, "       %s model_path store_path query text [top_k]\n", argv[0]);
+        return 1;
+    }
+    const char *model_path = argv[1];
+    const char *store_path = argv[2];
+    llm_embedder_t emb;
+    int ret;
+
+    if (strcmp(argv[3], "add") == 0)
+    {
+        llm_pooling_t pooling = argc > 5 && strcmp(argv[5], "last") == 0 ? LLM_POOL_LAST : LLM_POOL_MEAN;
+        int n_batch = argc > 6 ? atoi(argv[6]) : 1;
+        if (llm_embedder_init(&emb, model_path, MAX_CONTEXT_LEN, n_batch, pooling) != 0)
+        {
+            return -1;
+        }
+        printf("embedding size %d\n", emb.dim);
+        ret = add_texts(&emb, store_path, argv[4]);
+    }
+    else
+    {
+        // the query is pooled the way the store was
+        vector_store_t store;
+        if (vector_store_open(&store, store_path, 0, false) != 0)
+        {
+            return -1;
+        }
+        llm_pooling_t pooling = store.header->tag == LLM_POOL_LAST ? LLM_POOL_LAST : LLM_POOL_MEAN;
+        if (llm_embedder_init(&emb, model_path, MAX_CONTEXT_LEN, 1, pooling) != 0)
+        {
+            vector_store_close(&store);
+            return -1;
+        }
+        if ((uint32_t)emb.dim == store.header->dim)
+        {
+            ret = query_text(&emb, &store, store_path, argv[4], argc > 5 ? atoi(argv[5]) : 5);
+        }
+        else
+        {
+            printf("the model gives %d-d vectors, %s holds %u-d\n", emb.dim, store_path, store.header->dim);
+            ret = -1;
+        }
+        vector_store_close(&store);
+    }
+    llm_embedder_release(&emb);
+    return ret;
+}
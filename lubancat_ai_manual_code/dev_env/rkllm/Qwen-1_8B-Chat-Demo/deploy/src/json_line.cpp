@@ -0,0 +1,268 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_line.h"
+
+static void skip_ws(const std::string &s, size_t &i)
+{
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n'))
+    {
+        i++;
+    }
+}
+
+static void append_utf8(std::string &out, unsigned int cp)
+{
+    if (cp < 0x80)
+    {
+        out += (char)cp;
+    }
+    else if (cp < 0x800)
+    {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+static int parse_hex4(const std::string &s, size_t i, unsigned int *cp)
+{
+    if (i + 4 > s.size())
+    {
+        return -1;
+    }
+    char hex[5] = {s[i], s[i + 1], s[i + 2], s[i + 3], 0};
+    char *end;
+    *cp = (unsigned int)strtoul(hex, &end, 16);
+    return end == hex + 4 ? 0 : -1;
+}
+
+// s[i] is the opening quote, i ends after the closing one
+static int parse_string(const std::string &s, size_t &i, std::string *out)
+{
+    i++;
+    while (i < s.size())
+    {
+        char c = s[i++];
+        if (c == '"')
+        {
+            return 0;
+        }
+        if (c != '\\')
+        {
+            if (out != NULL)
+            {
+                *out += c;
+            }
+            continue;
+        }
+        if (i >= s.size())
+        {
+            return -1;
+        }
+        char e = s[i++];
+        unsigned int cp;
+        switch (e)
+        {
+        case 'n': cp = '\n'; break;
+        case 't': cp = '\t'; break;
+        case 'r': cp = '\r'; break;
+        case 'b': cp = '\b'; break;
+        case 'f': cp = '\f'; break;
+        case 'u':
+            if (parse_hex4(s, i, &cp) != 0)
+            {
+                return -1;
+            }
+            i += 4;
+            // surrogate pair
+            if (cp >= 0xD800 && cp < 0xDC00 && i + 6 <= s.size() && s[i] == '\\' && s[i + 1] == 'u')
+            {
+                unsigned int lo;
+                if (parse_hex4(s, i + 2, &lo) == 0 && lo >= 0xDC00 && lo < 0xE000)
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    i += 6;
+                }
+            }
+            break;
+        default: cp = (unsigned char)e; break;
+        }
+        if (out != NULL)
+        {
+            append_utf8(*out, cp);
+        }
+    }
+    return -1;
+}
+
+static int skip_value(const std::string &s, size_t &i)
+{
+    skip_ws(s, i);
+    if (i >= s.size())
+    {
+        return -1;
+    }
+    if (s[i] == '"')
+    {
+        return parse_string(s, i, NULL);
+    }
+    if (s[i] == '{' || s[i] == '[')
+    {
+        int depth = 0;
+        while (i < s.size())
+        {
+            if (s[i] == '"')
+            {
+                if (parse_string(s, i, NULL) != 0)
+                {
+                    return -1;
+                }
+                continue;
+            }
+            if (s[i] == '{' || s[i] == '[')
+            {
+                depth++;
+            }
+            else if (s[i] == '}' || s[i] == ']')
+            {
+                if (--depth == 0)
+                {
+                    i++;
+                    return 0;
+                }
+            }
+            i++;
+        }
+        return -1;
+    }
+    while (i < s.size() && s[i] != ',' && s[i] != '}' && s[i] != ']')
+    {
+        i++;
+    }
+    return 0;
+}
+
+// position of the value of key, npos if there is none
+static size_t find_member(const std::string &s, const char *key)
+{
+    size_t i = 0;
+    skip_ws(s, i);
+    if (i >= s.size() || s[i] != '{')
+    {
+        return std::string::npos;
+    }
+    i++;
+    while (true)
+    {
+        skip_ws(s, i);
+        if (i >= s.size() || s[i] != '"')
+        {
+            return std::string::npos;
+        }
+        std::string name;
+        if (parse_string(s, i, &name) != 0)
+        {
+            return std::string::npos;
+        }
+        skip_ws(s, i);
+        if (i >= s.size() || s[i] != ':')
+        {
+            return std::string::npos;
+        }
+        i++;
+        skip_ws(s, i);
+        if (name == key)
+        {
+            return i;
+        }
+        if (skip_value(s, i) != 0)
+        {
+            return std::string::npos;
+        }
+        skip_ws(s, i);
+        if (i >= s.size() || s[i] != ',')
+        {
+            return std::string::npos;
+        }
+        i++;
+    }
+}
+
+int json_get_string(const std::string &line, const char *key, std::string &value)
+{
+    size_t i = find_member(line, key);
+    if (i == std::string::npos || line[i] != '"')
+    {
+        return -1;
+    }
+    value.clear();
+    return parse_string(line, i, &value);
+}
+
+int json_get_number(const std::string &line, const char *key, double *value)
+{
+    size_t i = find_member(line, key);
+    if (i == std::string::npos)
+    {
+        return -1;
+    }
+    const char *start = line.c_str() + i;
+    char *end;
+    *value = strtod(start, &end);
+    return end != start ? 0 : -1;
+}
+
+void json_append_string(std::string &out, const char *s, size_t len)
+{
+    out += '"';
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char c = (unsigned char)s[i];
+        switch (c)
+        {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20)
+            {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out += esc;
+            }
+            else
+            {
+                out += (char)c;
+            }
+        }
+    }
+    out += '"';
+}
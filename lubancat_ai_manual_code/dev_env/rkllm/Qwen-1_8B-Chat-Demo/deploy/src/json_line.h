@@ -0,0 +1,28 @@
+#ifndef _RKLLM_JSON_LINE_H_
+#define _RKLLM_JSON_LINE_H_
+
+#include <string>
+
+/*
+ * Just enough JSON for newline delimited requests / replies: top level members of one
+ * object are looked up by key, nested values are skipped.
+ */
+
+/**
+ * @brief String member of the object in line, escapes decoded to utf-8
+ *
+ * @return int 0: found; -1: missing, not a string or not an object
+ */
+int json_get_string(const std::string &line, const char *key, std::string &value);
+
+/**
+ * @return int 0: found; -1: missing or not a number
+ */
+int json_get_number(const std::string &line, const char *key, double *value);
+
+/**
+ * @brief Append s as a quoted JSON string
+ */
+void json_append_string(std::string &out, const char *s, size_t len);
+
+#endif //_RKLLM_JSON_LINE_H_
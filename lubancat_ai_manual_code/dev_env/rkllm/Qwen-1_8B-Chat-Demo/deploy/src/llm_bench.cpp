@@ -0,0 +1,658 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Performance benchmark of a .rkllm model on top of RKLLMPerfStat.
+ *
+ * Every combination of the swept parameters is one config. The load time parameters
+ * (max_new_tokens, sampling, enabled cpus, embed_flash) need an rkllm_init each, the
+ * prompt lengths run on the same handle. A config runs --warmup times unrecorded and
+ * --repeat times recorded, the result is the median over the recorded runs:
+ *
+ *   ttft_ms         rkllm_run to the first generated token, wall clock
+ *   prefill_tok_s   perf.prefill_tokens / perf.prefill_time_ms
+ *   decode_tok_s    perf.generate_tokens / perf.generate_time_ms
+ *   peak_mem_mb     largest perf.memory_usage_mb of the runs
+ *
+ * Prompts are synthetic token ids (RKLLM_INPUT_TOKEN), so a prompt length is exact
+ * for every tokenizer and no chat template is added.
+ *
+ * --json writes one object per config and line, --compare reads such a file of an
+ * earlier run (another model export or runtime version) and reports every config whose
+ * prefill / decode tok/s dropped or whose TTFT grew by more than --tolerance percent.
+ * The exit code is 2 if there is a regression.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "rkllm.h"
+#include "json_line.h"
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+typedef struct
+{
+    uint32_t mask;
+    int num;
+} bench_cpus_t;
+
+typedef struct
+{
+    std::string model_path;
+    std::vector<int> prompt_lens = {32, 128, 512};
+    std::vector<int> max_new_tokens = {64};
+    std::vector<int> top_k = {1};
+    std::vector<float> top_p = {0.95f};
+    std::vector<float> temperature = {0.8f};
+    std::vector<bench_cpus_t> cpus = {{0, 0}};  // 0:0 is the runtime default
+    std::vector<int> embed_flash = {1};
+    int max_context_len = 1024;
+    int repeat = 3;
+    int warmup = 1;
+    std::string tag;
+    std::string csv_path;
+    std::string json_path;
+    std::string compare_path;
+    float tolerance = 5.0f;
+} bench_args_t;
+
+typedef struct
+{
+    int prompt_len;
+    int max_new_tokens;
+    int top_k;
+    float top_p;
+    float temperature;
+    bench_cpus_t cpus;
+    int embed_flash;
+} bench_config_t;
+
+typedef struct
+{
+    float init_ms;
+    int runs;
+    float ttft_ms;
+    float prefill_tok_s;
+    float decode_tok_s;
+    float generate_tokens;
+    float peak_mem_mb;
+} bench_result_t;
+
+// state of one rkllm_run, the callback fills it
+typedef struct
+{
+    time_point_t start;
+    float ttft_ms;
+    RKLLMPerfStat perf;
+    bool finished;
+    bool error;
+} bench_run_t;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void exit_handler(int)
+{
+    g_stop = 1;
+}
+
+static float elapsed_ms(time_point_t from, time_point_t to)
+{
+    return std::chrono::duration<float, std::milli>(to - from).count();
+}
+
+static int callback(RKLLMResult *result, void *userdata, LLMCallState state)
+{
+    bench_run_t *run = (bench_run_t *)userdata;
+    if (state == RKLLM_RUN_NORMAL)
+    {
+        if (run->ttft_ms < 0 && (result->text != NULL || result->token_id >= 0))
+        {
+            run->ttft_ms = elapsed_ms(run->start, std::chrono::steady_clock::now());
+        }
+    }
+    else if (state == RKLLM_RUN_FINISH)
+    {
+        run->perf = result->perf;
+        run->finished = true;
+    }
+    else if (state == RKLLM_RUN_ERROR)
+    {
+        run->error = true;
+    }
+    return 0;
+}
+
+static float median(std::vector<float> v)
+{
+    if (v.empty())
+    {
+        return 0.0f;
+    }
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0f;
+}
+
+// empty items are kept, they fail to parse
+static std::vector<std::string> split_list(const std::string &value)
+{
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= value.size())
+    {
+        size_t comma = value.find(',', start);
+        if (comma == std::string::npos)
+        {
+            comma = value.size();
+        }
+        items.push_back(value.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+// the whole string is one integer >= min, base 0 so masks can be hex
+static bool parse_int(const char *text, long min, int *value)
+{
+    char *end;
+    errno = 0;
+    long v = strtol(text, &end, 0);
+    if (end == text || *end != '\0' || errno != 0 || v < min || v > INT_MAX)
+    {
+        return false;
+    }
+    *value = (int)v;
+    return true;
+}
+
+// the whole string is one number, > 0 or >= 0 with allow_zero
+static bool parse_float(const char *text, bool allow_zero, float *value)
+{
+    char *end;
+    errno = 0;
+    float v = strtof(text, &end);
+    if (end == text || *end != '\0' || errno != 0 || !(allow_zero ? v >= 0.0f : v > 0.0f))
+    {
+        return false;
+    }
+    *value = v;
+    return true;
+}
+
+static int int_list(const std::string &value, long min, std::vector<int> &v)
+{
+    v.clear();
+    for (const std::string &item : split_list(value))
+    {
+        int x;
+        if (!parse_int(item.c_str(), min, &x))
+        {
+            return -1;
+        }
+        v.push_back(x);
+    }
+    return 0;
+}
+
+static int float_list(const std::string &value, std::vector<float> &v)
+{
+    v.clear();
+    for (const std::string &item : split_list(value))
+    {
+        float x;
+        if (!parse_float(item.c_str(), false, &x))
+        {
+            return -1;
+        }
+        v.push_back(x);
+    }
+    return 0;
+}
+
+// mask:num pairs, e.g. 0xf0:4,0x0f:4; 0:0 is the runtime default
+static int cpus_list(const std::string &value, std::vector<bench_cpus_t> &v)
+{
+    v.clear();
+    for (const std::string &item : split_list(value))
+    {
+        bench_cpus_t cpus;
+        char *end;
+        errno = 0;
+        unsigned long mask = strtoul(item.c_str(), &end, 0);
+        if (end == item.c_str() || item[0] == '-' || errno != 0 || mask > UINT32_MAX)
+        {
+            return -1;
+        }
+        cpus.mask = (uint32_t)mask;
+        if (*end == ':')
+        {
+            if (!parse_int(end + 1, 0, &cpus.num))
+            {
+                return -1;
+            }
+        }
+        else if (*end == '\0')
+        {
+            cpus.num = __builtin_popcount(cpus.mask);
+        }
+        else
+        {
+            return -1;
+        }
+        v.push_back(cpus);
+    }
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s model_path [options]\n"
+           "\n"
+           "  every option with a list is swept, all combinations are run\n"
+           "  --prompt_lens      Prompt lengths in tokens.(default: 32,128,512)\n"
+           "  --max_new_tokens   (default: 64)\n"
+           "  --top_k            (default: 1)\n"
+           "  --top_p            (default: 0.95)\n"
+           "  --temperature      (default: 0.8)\n"
+           "  --cpus             enabled_cpus_mask:enabled_cpus_num pairs, e.g. 0xf0:4,0x0f:4.(default: 0:0, the\n"
+           "                     runtime default)\n"
+           "  --embed_flash      (default: 1)\n"
+           "  --max_context_len  (default: 1024)\n"
+           "  --repeat           Recorded runs per config.(default: 3)\n"
+           "  --warmup           Unrecorded runs per config.(default: 1)\n"
+           "  --tag              Label of this run in the output, e.g. the model export or runtime version\n"
+           "  --csv              Write the results as CSV\n"
+           "  --json             Write the results as JSON, one config per line\n"
+           "  --compare          JSON of an earlier run to compare against\n"
+           "  --tolerance        Allowed change in percent before a config is a regression.(default: 5)\n",
+           prog);
+}
+
+static int parse_args(int argc, char **argv, bench_args_t &args)
+{
+    if (argc < 2 || argv[1][0] == '-')
+    {
+        return -1;
+    }
+    args.model_path = argv[1];
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            return -1;
+        }
+        std::string value = argv[++i];
+        int ret = 0;
+        if (arg == "--prompt_lens") ret = int_list(value, 1, args.prompt_lens);
+        else if (arg == "--max_new_tokens") ret = int_list(value, 1, args.max_new_tokens);
+        else if (arg == "--top_k") ret = int_list(value, 1, args.top_k);
+        else if (arg == "--top_p") ret = float_list(value, args.top_p);
+        else if (arg == "--temperature") ret = float_list(value, args.temperature);
+        else if (arg == "--cpus") ret = cpus_list(value, args.cpus);
+        else if (arg == "--embed_flash") ret = int_list(value, 0, args.embed_flash);
+        else if (arg == "--max_context_len") ret = parse_int(value.c_str(), 1, &args.max_context_len) ? 0 : -1;
+        else if (arg == "--repeat") ret = parse_int(value.c_str(), 1, &args.repeat) ? 0 : -1;
+        else if (arg == "--warmup") ret = parse_int(value.c_str(), 0, &args.warmup) ? 0 : -1;
+        else if (arg == "--tag") args.tag = value;
+        else if (arg == "--csv") args.csv_path = value;
+        else if (arg == "--json") args.json_path = value;
+        else if (arg == "--compare") args.compare_path = value;
+        else if (arg == "--tolerance") ret = parse_float(value.c_str(), true, &args.tolerance) ? 0 : -1;
+        else
+        {
+            printf("Unknown argument: %s\n", arg.c_str());
+            return -1;
+        }
+        if (ret != 0)
+        {
+            printf("invalid %s %s\n", arg.c_str(), value.c_str());
+            return -1;
+        }
+    }
+    if (args.prompt_lens.empty() || args.max_new_tokens.empty() || args.top_k.empty() || args.top_p.empty() ||
+        args.temperature.empty() || args.cpus.empty() || args.embed_flash.empty() || args.repeat <= 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+// the same config has the same key in every run, --compare matches on it
+static std::string config_key(const bench_config_t &c)
+{
+    char key[160];
+    snprintf(key, sizeof(key), "p%d_n%d_k%d_tp%.2f_t%.2f_m0x%x_c%d_e%d", c.prompt_len, c.max_new_tokens, c.top_k,
+             c.top_p, c.temperature, c.cpus.mask, c.cpus.num, c.embed_flash);
+    return key;
+}
+
+static int init_model(LLMHandle *handle, const bench_args_t &args, const bench_config_t &c)
+{
+    RKLLMParam param = rkllm_createDefaultParam();
+    param.model_path = args.model_path.c_str();
+    param.top_k = c.top_k;
+    param.top_p = c.top_p;
+    param.temperature = c.temperature;
+    param.repeat_penalty = 1.1;
+    param.frequency_penalty = 0.0;
+    param.presence_penalty = 0.0;
+    param.max_new_tokens = c.max_new_tokens;
+    param.max_context_len = args.max_context_len;
+    param.skip_special_token = true;
+    param.extend_param.base_domain_id = 0;
+    param.extend_param.embed_flash = c.embed_flash;
+    if (c.cpus.num > 0)
+    {
+        param.extend_param.enabled_cpus_num = c.cpus.num;
+        param.extend_param.enabled_cpus_mask = c.cpus.mask;
+    }
+    return rkllm_init(handle, &param, callback);
+}
+
+static int run_once(LLMHandle handle, std::vector<int32_t> &ids, bench_run_t *run)
+{
+    RKLLMInput input;
+    memset(&input, 0, sizeof(RKLLMInput));
+    input.input_type = RKLLM_INPUT_TOKEN;
+    input.token_input.input_ids = ids.data();
+    input.token_input.n_tokens = ids.size();
+
+    RKLLMInferParam infer_params;
+    memset(&infer_params, 0, sizeof(RKLLMInferParam));
+    infer_params.mode = RKLLM_INFER_GENERATE;
+    infer_params.keep_history = 0;
+
+    *run = bench_run_t();
+    run->ttft_ms = -1.0f;
+    run->start = std::chrono::steady_clock::now();
+    int ret = rkllm_run(handle, &input, &infer_params, run);
+    if (ret != 0 || run->error || !run->finished)
+    {
+        printf("rkllm_run fail! ret=%d\n", ret);
+        return -1;
+    }
+    return 0;
+}
+
+static int run_config(LLMHandle handle, const bench_args_t &args, const bench_config_t &c, bench_result_t *res)
+{
+    // spread over the vocab so the prompt is not one repeated token, below every vocab size in use
+    std::vector<int32_t> ids(c.prompt_len);
+    for (int i = 0; i < c.prompt_len; i++)
+    {
+        ids[i] = 1000 + (i * 7919) % 20000;
+    }
+
+    std::vector<float> ttft, prefill, decode, generated;
+    float peak_mem = 0.0f;
+    for (int r = 0; r < args.warmup + args.repeat && !g_stop; r++)
+    {
+        bench_run_t run;
+        if (run_once(handle, ids, &run) != 0)
+        {
+            return -1;
+        }
+        if (r < args.warmup)
+        {
+            continue;
+        }
+        const RKLLMPerfStat &perf = run.perf;
+        ttft.push_back(run.ttft_ms);
+        prefill.push_back(perf.prefill_time_ms > 0 ? perf.prefill_tokens * 1000.0f / perf.prefill_time_ms : 0.0f);
+        decode.push_back(perf.generate_time_ms > 0 ? perf.generate_tokens * 1000.0f / perf.generate_time_ms : 0.0f);
+        generated.push_back((float)perf.generate_tokens);
+        peak_mem = std::max(peak_mem, perf.memory_usage_mb);
+    }
+    res->runs = (int)ttft.size();
+    res->ttft_ms = median(ttft);
+    res->prefill_tok_s = median(prefill);
+    res->decode_tok_s = median(decode);
+    res->generate_tokens = median(generated);
+    res->peak_mem_mb = peak_mem;
+    return res->runs > 0 ? 0 : -1;
+}
+
+static std::string json_record(const bench_args_t &args, const bench_config_t &c, const bench_result_t &r)
+{
+    std::string line = "{\"key\": ";
+    std::string key = config_key(c);
+    json_append_string(line, key.data(), key.size());
+    line += ", \"tag\": ";
+    json_append_string(line, args.tag.data(), args.tag.size());
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             ", \"prompt_len\": %d, \"max_new_tokens\": %d, \"top_k\": %d, \"top_p\": %.3f, \"temperature\": %.3f, "
+             "\"cpus_mask\": %u, \"cpus_num\": %d, \"embed_flash\": %d, \"runs\": %d, \"init_ms\": %.1f, "
+             "\"ttft_ms\": %.2f, \"prefill_tok_s\": %.2f, \"decode_tok_s\": %.2f, \"generate_tokens\": %.1f, "
+             "\"peak_mem_mb\": %.1f}\n",
+             c.prompt_len, c.max_new_tokens, c.top_k, c.top_p, c.temperature, c.cpus.mask, c.cpus.num, c.embed_flash,
+             r.runs, r.init_ms, r.ttft_ms, r.prefill_tok_s, r.decode_tok_s, r.generate_tokens, r.peak_mem_mb);
+    return line + buf;
+}
+
+static std::string csv_record(const bench_args_t &args, const bench_config_t &c, const bench_result_t &r)
+{
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s,%d,%d,%d,%.3f,%.3f,0x%x,%d,%d,%d,%.1f,%.2f,%.2f,%.2f,%.1f,%.1f\n",
+             args.tag.c_str(), c.prompt_len, c.max_new_tokens, c.top_k, c.top_p, c.temperature, c.cpus.mask,
+             c.cpus.num, c.embed_flash, r.runs, r.init_ms, r.ttft_ms, r.prefill_tok_s, r.decode_tok_s,
+             r.generate_tokens, r.peak_mem_mb);
+    return buf;
+}
+
+static const char *CSV_HEADER = "tag,prompt_len,max_new_tokens,top_k,top_p,temperature,cpus_mask,cpus_num,embed_flash,"
+                                "runs,init_ms,ttft_ms,prefill_tok_s,decode_tok_s,generate_tokens,peak_mem_mb\n";
+
+// key -> JSON line of an earlier run
+static int load_baseline(const std::string &path, std::map<std::string, std::string> &baseline)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        printf("open %s fail!\n", path.c_str());
+        return -1;
+    }
+    std::string line, key;
+    while (std::getline(in, line))
+    {
+        if (json_get_string(line, "key", key) == 0)
+        {
+            baseline[key] = line;
+        }
+    }
+    return 0;
+}
+
+// relative change in percent where higher is better, so a loss is negative
+static float change_pct(double base, double now, bool higher_is_better)
+{
+    if (base <= 0)
+    {
+        return 0.0f;
+    }
+    float pct = (float)((now - base) * 100.0 / base);
+    return higher_is_better ? pct : -pct;
+}
+
+static int compare_record(const std::string &base, const std::string &now, const std::string &key, float tolerance)
+{
+    static const struct
+    {
+        const char *name;
+        bool higher_is_better;
+    } metrics[] = {{"prefill_tok_s", true}, {"decode_tok_s", true}, {"ttft_ms", false}};
+    int regressions = 0;
+    for (const auto &m : metrics)
+    {
+        double b, n;
+        if (json_get_number(base, m.name, &b) != 0 || json_get_number(now, m.name, &n) != 0)
+        {
+            continue;
+        }
+        float pct = change_pct(b, n, m.higher_is_better);
+        if (pct < -tolerance)
+        {
+            printf("REGRESSION %s %s: %.2f -> %.2f (%+.1f%%)\n", key.c_str(), m.name, b, n,
+                   (float)((n - b) * 100.0 / b));
+            regressions++;
+        }
+    }
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    bench_args_t args;
+    if (parse_args(argc, argv, args) != 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    signal(SIGINT, exit_handler);
+
+    std::map<std::string, std::string> baseline;
+    if (!args.compare_path.empty() && load_baseline(args.compare_path, baseline) != 0)
+    {
+        return 1;
+    }
+    FILE *csv = NULL, *json = NULL;
+    if (!args.csv_path.empty())
+    {
+        csv = fopen(args.csv_path.c_str(), "w");
+        if (csv == NULL)
+        {
+            printf("open %s fail!\n", args.csv_path.c_str());
+            return 1;
+        }
+        fputs(CSV_HEADER, csv);
+    }
+    if (!args.json_path.empty())
+    {
+        json = fopen(args.json_path.c_str(), "w");
+        if (json == NULL)
+        {
+            printf("open %s fail!\n", args.json_path.c_str());
+            if (csv != NULL)
+            {
+                fclose(csv);
+            }
+            return 1;
+        }
+    }
+
+    printf("%s", CSV_HEADER);
+    int ret = 0, regressions = 0, compared = 0;
+    bench_config_t c;
+    for (int max_new_tokens : args.max_new_tokens)
+    for (int top_k : args.top_k)
+    for (float top_p : args.top_p)
+    for (float temperature : args.temperature)
+    for (const bench_cpus_t &cpus : args.cpus)
+    for (int embed_flash : args.embed_flash)
+    {
+        if (g_stop)
+        {
+            break;
+        }
+        c.max_new_tokens = max_new_tokens;
+        c.top_k = top_k;
+        c.top_p = top_p;
+        c.temperature = temperature;
+        c.cpus = cpus;
+        c.embed_flash = embed_flash;
+
+        // the load time parameters need their own handle
+        LLMHandle handle = NULL;
+        time_point_t t0 = std::chrono::steady_clock::now();
+        if (init_model(&handle, args, c) != 0)
+        {
+            printf("rkllm init failed, mask 0x%x num %d embed_flash %d\n", cpus.mask, cpus.num, embed_flash);
+            ret = 1;
+            continue;
+        }
+        float init_ms = elapsed_ms(t0, std::chrono::steady_clock::now());
+
+        for (int prompt_len : args.prompt_lens)
+        {
+            if (g_stop)
+            {
+                break;
+            }
+            c.prompt_len = prompt_len;
+            if (prompt_len <= 0 || prompt_len + max_new_tokens > args.max_context_len)
+            {
+                printf("skip prompt_len %d, with max_new_tokens %d it does not fit max_context_len %d\n", prompt_len,
+                       max_new_tokens, args.max_context_len);
+                continue;
+            }
+            bench_result_t r;
+            memset(&r, 0, sizeof(bench_result_t));
+            r.init_ms = init_ms;
+            if (run_config(handle, args, c, &r) != 0)
+            {
+                ret = 1;
+                continue;
+            }
+            std::string row = csv_record(args, c, r);
+            std::string record = json_record(args, c, r);
+            printf("%s", row.c_str());
+            if (csv != NULL)
+            {
+                fputs(row.c_str(), csv);
+            }
+            if (json != NULL)
+            {
+                fputs(record.c_str(), json);
+            }
+            auto it = baseline.find(config_key(c));
+            if (it != baseline.end())
+            {
+                compared++;
+                regressions += compare_record(it->second, record, it->first, args.tolerance);
+            }
+        }
+        rkllm_destroy(handle);
+    }
+
+    if (csv != NULL)
+    {
+        fclose(csv);
+    }
+    if (json != NULL)
+    {
+        fclose(json);
+    }
+    if (!args.compare_path.empty())
+    {
+        printf("compared %d configs with %s, %d regressions over %.1f%%\n", compared, args.compare_path.c_str(),
+               regressions, args.tolerance);
+        if (regressions > 0)
+        {
+            return 2;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,213 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <vector>
+
+#include "llm_embed.h"
+
+#define MAX_EMBED_BATCH 16
+
+// one rkllm_run, slot i pools into out + i * dim
+typedef struct
+{
+    float *out;
+    int n;
+    int dim;                    // 0: probe run, only embd_size is wanted
+    llm_pooling_t pooling;
+    int done;                   // slots pooled
+    int embd_size;
+    bool error;
+} embed_job_t;
+
+static void pool_hidden_states(const RKLLMResultLastHiddenLayer *hl, llm_pooling_t pooling, float *out)
+{
+    int dim = hl->embd_size;
+    if (pooling == LLM_POOL_LAST || hl->num_tokens == 1)
+    {
+        memcpy(out, hl->hidden_states + (size_t)(hl->num_tokens - 1) * dim, dim * sizeof(float));
+    }
+    else
+    {
+        memset(out, 0, dim * sizeof(float));
+        for (int t = 0; t < hl->num_tokens; t++)
+        {
+            const float *h = hl->hidden_states + (size_t)t * dim;
+            for (int i = 0; i < dim; i++)
+            {
+                out[i] += h[i];
+            }
+        }
+    }
+    // the mean's 1 / num_tokens goes away with the normalization
+    double norm = 0;
+    for (int i = 0; i < dim; i++)
+    {
+        norm += out[i] * out[i];
+    }
+    float scale = norm > 0 ? (float)(1.0 / sqrt(norm)) : 0.0f;
+    for (int i = 0; i < dim; i++)
+    {
+        out[i] *= scale;
+    }
+}
+
+// result holds one RKLLMResult per batch slot, the hidden states are only valid in here
+static int embed_callback(RKLLMResult *result, void *userdata, LLMCallState state)
+{
+    embed_job_t *job = (embed_job_t *)userdata;
+    if (job == NULL)
+    {
+        return 0;
+    }
+    if (state == RKLLM_RUN_ERROR)
+    {
+        job->error = true;
+        return 0;
+    }
+    if (state != RKLLM_RUN_NORMAL)
+    {
+        return 0;
+    }
+    for (int i = 0; i < job->n; i++)
+    {
+        const RKLLMResultLastHiddenLayer *hl = &result[i].last_hidden_layer;
+        if (hl->hidden_states == NULL || hl->num_tokens <= 0 || hl->embd_size <= 0)
+        {
+            continue;
+        }
+        job->embd_size = hl->embd_size;
+        if (job->dim == 0)
+        {
+            continue;
+        }
+        if (hl->embd_size != job->dim)
+        {
+            job->error = true;
+            continue;
+        }
+        pool_hidden_states(hl, job->pooling, job->out + (size_t)i * job->dim);
+        job->done++;
+    }
+    return 0;
+}
+
+static int run_job(llm_embedder_t *emb, const char *const *texts, embed_job_t *job)
+{
+    RKLLMInput inputs[MAX_EMBED_BATCH];
+    for (int i = 0; i < emb->n_batch; i++)
+    {
+        memset(&inputs[i], 0, sizeof(RKLLMInput));
+        inputs[i].input_type = RKLLM_INPUT_PROMPT;
+        inputs[i].role = "user";
+        // unused slots of the batch get a copy of the first text
+        inputs[i].prompt_input = texts[i < job->n ? i : 0];
+    }
+
+    RKLLMInferParam infer_params;
+    memset(&infer_params, 0, sizeof(RKLLMInferParam));
+    infer_params.mode = RKLLM_INFER_GET_LAST_HIDDEN_LAYER;
+    infer_params.keep_history = 0;
+
+    job->done = 0;
+    job->embd_size = 0;
+    job->error = false;
+    int ret = rkllm_run(emb->handle, inputs, &infer_params, job);
+    if (ret != 0 || job->error)
+    {
+        printf("rkllm_run fail! ret=%d\n", ret);
+        return -1;
+    }
+    return 0;
+}
+
+int llm_embedder_init(llm_embedder_t *emb, const char *model_path, int max_context_len, int n_batch,
+                      llm_pooling_t pooling)
+{
+    memset(emb, 0, sizeof(llm_embedder_t));
+    if (n_batch < 1 || n_batch > MAX_EMBED_BATCH)
+    {
+        printf("n_batch must be 1 to %d\n", MAX_EMBED_BATCH);
+        return -1;
+    }
+
+    RKLLMParam param = rkllm_createDefaultParam();
+    param.model_path = model_path;
+    param.max_context_len = max_context_len;
+    param.max_new_tokens = 1;
+    param.skip_special_token = true;
+    param.extend_param.base_domain_id = 0;
+    param.extend_param.embed_flash = 1;
+    param.extend_param.n_batch = n_batch;
+    int ret = rkllm_init(&emb->handle, &param, embed_callback);
+    if (ret != 0 && n_batch > 1)
+    {
+        printf("rkllm init with n_batch %d failed, embedding one text per run\n", n_batch);
+        n_batch = 1;
+        param.extend_param.n_batch = 1;
+        ret = rkllm_init(&emb->handle, &param, embed_callback);
+    }
+    if (ret != 0)
+    {
+        printf("rkllm init failed\n");
+        emb->handle = nullptr;
+        return -1;
+    }
+    emb->n_batch = n_batch;
+    emb->pooling = pooling;
+    rkllm_set_chat_template(emb->handle, "", "", "");
+
+    // the embedding size is what the model reports for any text
+    const char *probe = "hello";
+    embed_job_t job;
+    memset(&job, 0, sizeof(embed_job_t));
+    job.n = 1;
+    if (run_job(emb, &probe, &job) != 0 || job.embd_size <= 0)
+    {
+        printf("no last hidden layer from %s\n", model_path);
+        llm_embedder_release(emb);
+        return -1;
+    }
+    emb->dim = job.embd_size;
+    return 0;
+}
+
+void llm_embedder_release(llm_embedder_t *emb)
+{
+    if (emb->handle != nullptr)
+    {
+        rkllm_destroy(emb->handle);
+        emb->handle = nullptr;
+    }
+}
+
+int llm_embed(llm_embedder_t *emb, const char *const *texts, int n, float *out)
+{
+    embed_job_t job;
+    memset(&job, 0, sizeof(embed_job_t));
+    job.dim = emb->dim;
+    job.pooling = emb->pooling;
+    for (int i = 0; i < n; i += emb->n_batch)
+    {
+        job.n = n - i < emb->n_batch ? n - i : emb->n_batch;
+        job.out = out + (size_t)i * emb->dim;
+        if (run_job(emb, texts + i, &job) != 0 || job.done != job.n)
+        {
+            printf("embed texts %d..%d fail!\n", i, i + job.n - 1);
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef _RKLLM_EMBED_H_
+#define _RKLLM_EMBED_H_
+
+#include "rkllm.h"
+
+/*
+ * Sentence embeddings from the last hidden layer (RKLLM_INFER_GET_LAST_HIDDEN_LAYER).
+ *
+ * The embedder has its own LLMHandle, the callback pools the hidden states of every
+ * text straight into the caller's buffer while the runtime still owns them, nothing
+ * goes through a file. Texts go in back to back, n_batch of them per rkllm_run when
+ * the runtime supports batched inference. The chat template is set empty, the text
+ * is embedded as it is. Vectors are L2 normalized, cosine similarity is a dot product.
+ */
+
+typedef enum
+{
+    LLM_POOL_MEAN = 0,          // mean of the hidden states of all tokens
+    LLM_POOL_LAST = 1,          // hidden state of the last token
+} llm_pooling_t;
+
+typedef struct
+{
+    LLMHandle handle;
+    int n_batch;
+    int dim;                    // embd_size of the model, known after init
+    llm_pooling_t pooling;
+} llm_embedder_t;
+
+/**
+ * @brief Init the runtime for embeddings and probe the embedding size
+ *
+ * @param n_batch texts per rkllm_run, falls back to 1 if the runtime refuses it
+ * @return int 0: success; -1: error
+ */
+int llm_embedder_init(llm_embedder_t *emb, const char *model_path, int max_context_len, int n_batch,
+                      llm_pooling_t pooling);
+
+void llm_embedder_release(llm_embedder_t *emb);
+
+/**
+ * @brief Embed n texts
+ *
+ * @param out n * emb->dim floats, row i is the normalized embedding of texts[i]
+ * @return int 0: success; -1: error
+ */
+int llm_embed(llm_embedder_t *emb, const char *const *texts, int n, float *out);
+
+#endif //_RKLLM_EMBED_H_
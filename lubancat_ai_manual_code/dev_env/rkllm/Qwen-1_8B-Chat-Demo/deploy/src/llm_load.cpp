@@ -0,0 +1,262 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Synthetic load for llm_server.
+ *
+ * For every concurrency level, that many clients each send requests back to back
+ * (closed loop) and the run prints one CSV line:
+ *
+ *   concurrency,requests,errors,seconds,tokens_per_s,requests_per_s,
+ *   ttft_p50_ms,ttft_p95_ms,latency_p50_ms,latency_p95_ms,mean_batch
+ *
+ * tokens_per_s against latency over the levels is the throughput / latency curve of
+ * the server, run it once with n_batch 1 and once with batching to compare.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json_line.h"
+
+#define DEFAULT_SOCKET_PATH "/tmp/rkllm.sock"
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+typedef struct
+{
+    float ttft_ms;
+    float latency_ms;
+    int tokens;
+    int batch;
+    bool ok;
+} load_result_t;
+
+static const char *g_topics[] = {"rivers", "the moon", "bread", "trains", "music", "winter", "bees", "glass"};
+
+static float elapsed_ms(time_point_t from, time_point_t to)
+{
+    return std::chrono::duration<float, std::milli>(to - from).count();
+}
+
+static int connect_socket(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        printf("connect %s fail! %s\n", path, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+// one request on fd, read until its done or error line
+static int run_request(int fd, const std::string &prompt, load_result_t *res)
+{
+    std::string line = "{\"id\": 0, \"prompt\": ";
+    json_append_string(line, prompt.data(), prompt.size());
+    line += "}\n";
+    memset(res, 0, sizeof(load_result_t));
+    time_point_t start = std::chrono::steady_clock::now();
+    if (send(fd, line.data(), line.size(), MSG_NOSIGNAL) != (ssize_t)line.size())
+    {
+        return -1;
+    }
+
+    std::string buf;
+    char chunk[4096];
+    bool first = true;
+    while (true)
+    {
+        size_t eol;
+        while ((eol = buf.find('\n')) == std::string::npos)
+        {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return -1;
+            }
+            buf.append(chunk, n);
+        }
+        line = buf.substr(0, eol);
+        buf.erase(0, eol + 1);
+        std::string text;
+        double num;
+        if (json_get_string(line, "token", text) == 0)
+        {
+            if (first)
+            {
+                res->ttft_ms = elapsed_ms(start, std::chrono::steady_clock::now());
+                first = false;
+            }
+        }
+        else if (json_get_string(line, "error", text) == 0)
+        {
+            printf("error: %s\n", text.c_str());
+            return -1;
+        }
+        else if (json_get_number(line, "tokens", &num) == 0)
+        {
+            res->latency_ms = elapsed_ms(start, std::chrono::steady_clock::now());
+            res->tokens = (int)num;
+            res->batch = json_get_number(line, "batch", &num) == 0 ? (int)num : 1;
+            res->ok = true;
+            return 0;
+        }
+    }
+}
+
+static void client_thread(const char *socket_path, int client, int requests, int prompt_words,
+                          std::vector<load_result_t> *results, std::mutex *lock)
+{
+    int fd = connect_socket(socket_path);
+    for (int r = 0; r < requests; r++)
+    {
+        // different lengths and texts, so the replies are not all the same
+        std::string prompt = "Tell me about " + std::string(g_topics[(client + r) % 8]);
+        int words = prompt_words / 2 + (client * 7 + r * 3) % (prompt_words / 2 + 1);
+        for (int w = 0; w < words; w++)
+        {
+            prompt += w % 2 ? " please" : " briefly";
+        }
+        load_result_t res;
+        if (fd < 0 || run_request(fd, prompt, &res) != 0)
+        {
+            memset(&res, 0, sizeof(load_result_t));
+        }
+        std::lock_guard<std::mutex> lk(*lock);
+        results->push_back(res);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+static float percentile(std::vector<float> v, float p)
+{
+    if (v.empty())
+    {
+        return 0.0f;
+    }
+    std::sort(v.begin(), v.end());
+    size_t i = std::min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5f));
+    return v[i];
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s concurrency_list [requests_per_client] [prompt_words] [socket_path]\n", prog);
+    fprintf(stderr, "  e.g. %s 1,2,4,8 8 16\n", prog);
+}
+
+// comma separated positive integers, nothing else
+static int parse_concurrency(const char *list, std::vector<int> &levels)
+{
+    for (const char *p = list;;)
+    {
+        char *end;
+        errno = 0;
+        long v = strtol(p, &end, 10);
+        if (end == p || !isdigit((unsigned char)*p) || errno != 0 || v <= 0 || v > INT_MAX ||
+            (*end != ',' && *end != '\0'))
+        {
+            fprintf(stderr, "invalid concurrency list %s\n", list);
+            return -1;
+        }
+        levels.push_back((int)v);
+        if (*end == '\0')
+        {
+            return 0;
+        }
+        p = end + 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> levels;
+    if (argc < 2 || parse_concurrency(argv[1], levels) != 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    int requests = argc > 2 ? atoi(argv[2]) : 8;
+    int prompt_words = argc > 3 ? atoi(argv[3]) : 16;
+    const char *socket_path = argc > 4 ? argv[4] : DEFAULT_SOCKET_PATH;
+
+    printf("concurrency,requests,errors,seconds,tokens_per_s,requests_per_s,ttft_p50_ms,ttft_p95_ms,"
+           "latency_p50_ms,latency_p95_ms,mean_batch\n");
+    for (int concurrency : levels)
+    {
+        std::vector<load_result_t> results;
+        std::mutex lock;
+        std::vector<std::thread> clients;
+        time_point_t start = std::chrono::steady_clock::now();
+        for (int c = 0; c < concurrency; c++)
+        {
+            clients.emplace_back(client_thread, socket_path, c, requests, prompt_words, &results, &lock);
+        }
+        for (std::thread &t : clients)
+        {
+            t.join();
+        }
+        float seconds = elapsed_ms(start, std::chrono::steady_clock::now()) / 1000.0f;
+
+        std::vector<float> ttft, latency;
+        long long tokens = 0, batch = 0;
+        int errors = 0;
+        for (const load_result_t &r : results)
+        {
+            if (!r.ok)
+            {
+                errors++;
+                continue;
+            }
+            ttft.push_back(r.ttft_ms);
+            latency.push_back(r.latency_ms);
+            tokens += r.tokens;
+            batch += r.batch;
+        }
+        int ok = (int)ttft.size();
+        printf("%d,%zu,%d,%.2f,%.2f,%.2f,%.1f,%.1f,%.1f,%.1f,%.2f\n", concurrency, results.size(), errors, seconds,
+               tokens / seconds, ok / seconds, percentile(ttft, 0.5f), percentile(ttft, 0.95f),
+               percentile(latency, 0.5f), percentile(latency, 0.95f), ok > 0 ? (float)batch / ok : 0.0f);
+    }
+    return 0;
+}
@@ -0,0 +1,658 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Local serving daemon around one LLMHandle.
+ *
+ * Clients connect to a Unix domain socket and send one JSON object per line:
+ *
+ *   {"id": "a1", "prompt": "...", "session": "alice"}      session is optional
+ *
+ * and get back, one object per line:
+ *
+ *   {"id": "a1", "token": "..."}                           for every token
+ *   {"id": "a1", "done": true, "tokens": 42, "queue_ms": 0.1, "ttft_ms": 180.5,
+ *    "prefill_tokens": 20, "prefill_ms": 160.2, "reused_tokens": 310,
+ *    "evicted_turns": 0, "tokens_per_s": 14.8}
+ *   {"id": "a1", "error": "..."}                           instead of done
+ *
+ * Requests of all clients go through one queue and run one at a time. The rkllm
+ * callback only formats the line and pushes it into a lock free ring, a streamer
+ * thread writes it to the client, so a slow client never holds the NPU (until the
+ * ring is full). The system prompt is prefilled once at startup and saved with
+ * save_prompt_cache, then loaded with rkllm_load_prompt_cache, so no request
+ * prefills it again. Requests with a session continue that conversation, see
+ * llm_session.h; reused_tokens is the prefill the kv cache saved them.
+ *
+ * With n_batch > 1 the worker waits up to batch_window_ms after a request for
+ * others and runs up to n_batch of them in one batched rkllm_run (an array of
+ * n_batch inputs, the callback gets one result per slot), unused slots get an
+ * empty prompt, whose chat template is still prefilled. It does not wait when
+ * every connected client already has its request in the batch, so a lone client
+ * runs at once. Batched runs are stateless: the runtime applies the chat template,
+ * there is no prompt cache and requests with a session are refused. If the runtime
+ * cannot init with n_batch, the server falls back to n_batch 1 and sequential runs.
+ * "batch" in the done line is the number of requests in the run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "rkllm.h"
+#include "json_line.h"
+#include "token_ring.h"
+#include "llm_session.h"
+
+#define SYSTEM_PROMPT "<|im_start|>system \nYou are a helpful assistant. <|im_end|>"
+#define PROMPT_PREFIX "<|im_start|>user \n"
+#define PROMPT_POSTFIX "<|im_end|><|im_start|>assistant"
+
+#define DEFAULT_SOCKET_PATH "/tmp/rkllm.sock"
+#define DEFAULT_CACHE_DIR "./rkllm_cache"
+#define DEFAULT_BATCH_WINDOW_MS 10
+#define MAX_BATCH 16
+#define MAX_QUEUED_REQUESTS 32
+#define MAX_LINE_SIZE (64 * 1024)
+#define RING_SIZE (256 * 1024)
+
+// ring record tags
+#define RECORD_LINE 0
+#define RECORD_LAST 1       // last line of a request, the streamer frees it
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+typedef struct
+{
+    int fd;
+    std::atomic<int> refs;          // reader thread + requests in flight
+    std::atomic<bool> broken;       // a write failed, pending requests are dropped
+    std::mutex write_lock;
+} client_t;
+
+typedef struct
+{
+    client_t *client;
+    std::string id;                 // as JSON, echoed in every reply line
+    std::string prompt;
+    std::string session;
+    llm_turn_info_t turn;
+    time_point_t received;
+    time_point_t started;
+    time_point_t first_token;
+    int tokens;
+} llm_request_t;
+
+// the requests of one rkllm_run, slot i of the batch is reqs[i]
+typedef struct
+{
+    int n;
+    llm_request_t *reqs[MAX_BATCH];
+    bool finished[MAX_BATCH];       // the last line is pushed, the request is not ours any more
+    bool ok;                        // got to RKLLM_RUN_FINISH
+    std::string reply;              // text of slot 0, for its session
+} llm_batch_t;
+
+static LLMHandle llmHandle = nullptr;
+static std::string g_socket_path;
+static token_ring_t g_ring;
+static int g_n_batch = 1;
+static int g_batch_window_ms = DEFAULT_BATCH_WINDOW_MS;
+static llm_session_manager_t g_sessions;
+
+static std::mutex g_queue_lock;
+static std::condition_variable g_queue_cond;
+static std::deque<llm_request_t *> g_queue;
+static int g_clients = 0;           // connected clients, under g_queue_lock
+
+static float elapsed_ms(time_point_t from, time_point_t to)
+{
+    return std::chrono::duration<float, std::milli>(to - from).count();
+}
+
+static void exit_handler(int signal)
+{
+    if (!g_socket_path.empty())
+    {
+        unlink(g_socket_path.c_str());
+    }
+    if (llmHandle != nullptr)
+    {
+        LLMHandle _tmp = llmHandle;
+        llmHandle = nullptr;
+        rkllm_destroy(_tmp);
+    }
+    exit(signal);
+}
+
+static void client_release(client_t *client)
+{
+    if (client->refs.fetch_sub(1) == 1)
+    {
+        close(client->fd);
+        delete client;
+    }
+}
+
+static int write_all(client_t *client, const char *data, size_t size)
+{
+    std::lock_guard<std::mutex> lk(client->write_lock);
+    while (size > 0)
+    {
+        ssize_t n = send(client->fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            client->broken = true;
+            return -1;
+        }
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+static void reply_error(client_t *client, const std::string &id, const char *message)
+{
+    std::string line = "{\"id\": " + id + ", \"error\": ";
+    json_append_string(line, message, strlen(message));
+    line += "}\n";
+    write_all(client, line.data(), line.size());
+}
+
+// producer side, called from the rkllm callback (or the worker once the run is over)
+static void push_line(llm_request_t *req, const std::string &line, uint32_t tag)
+{
+    std::string record((const char *)&req, sizeof(req));
+    record += line;
+    if (token_ring_push(&g_ring, tag, record.data(), record.size()) != 0)
+    {
+        // far too long for the ring, the client gets an error instead
+        std::string err = "{\"id\": " + req->id + ", \"error\": \"reply line too long\"}\n";
+        record.resize(sizeof(req));
+        record += err;
+        token_ring_push(&g_ring, tag, record.data(), record.size());
+    }
+}
+
+// the request of slot i is done with this line
+static void finish_slot(llm_batch_t *batch, int i, const std::string &line)
+{
+    batch->finished[i] = true;
+    push_line(batch->reqs[i], line, RECORD_LAST);
+}
+
+static void finish_request(llm_batch_t *batch, int i, const RKLLMPerfStat *perf)
+{
+    llm_request_t *req = batch->reqs[i];
+    time_point_t now = std::chrono::steady_clock::now();
+    float decode_ms = req->tokens > 1 ? elapsed_ms(req->first_token, now) : 0.0f;
+    float tokens_per_s = decode_ms > 0 ? (req->tokens - 1) * 1000.0f / decode_ms : 0.0f;
+    float ttft_ms = req->tokens > 0 ? elapsed_ms(req->received, req->first_token) : 0.0f;
+    char stats[256];
+    snprintf(stats, sizeof(stats),
+             ", \"done\": true, \"tokens\": %d, \"queue_ms\": %.1f, \"ttft_ms\": %.1f, \"prefill_tokens\": %d, "
+             "\"prefill_ms\": %.1f, \"reused_tokens\": %d, \"evicted_turns\": %d, \"batch\": %d, "
+             "\"tokens_per_s\": %.2f}\n",
+             req->tokens, elapsed_ms(req->received, req->started), ttft_ms, perf->prefill_tokens, perf->prefill_time_ms,
+             req->turn.reused_tokens, req->turn.evicted_turns, batch->n, tokens_per_s);
+    printf("request %s%s%s: %d tokens, queue %.1f ms, ttft %.1f ms, prefill %d tokens %.1f ms, reused %d tokens%s, "
+           "batch %d, %.2f tokens/s\n",
+           req->id.c_str(), req->session.empty() ? "" : " session ", req->session.c_str(), req->tokens,
+           elapsed_ms(req->received, req->started), ttft_ms, perf->prefill_tokens, perf->prefill_time_ms,
+           req->turn.reused_tokens,
+           req->turn.restored ? " (restored)" : req->turn.rebuilt ? " (rebuilt)" : "", batch->n, tokens_per_s);
+    finish_slot(batch, i, "{\"id\": " + req->id + stats);
+}
+
+// result holds one RKLLMResult per batch slot
+static int callback(RKLLMResult *result, void *userdata, LLMCallState state)
+{
+    llm_batch_t *batch = (llm_batch_t *)userdata;
+    if (batch == NULL)
+    {
+        // system prompt warm up, stop as soon as the prefill is done
+        return state == RKLLM_RUN_NORMAL ? 1 : 0;
+    }
+    if (state == RKLLM_RUN_FINISH)
+    {
+        batch->ok = true;
+        for (int i = 0; i < batch->n; i++)
+        {
+            if (!batch->finished[i])
+            {
+                finish_request(batch, i, &result[i].perf);
+            }
+        }
+    }
+    else if (state == RKLLM_RUN_ERROR)
+    {
+        for (int i = 0; i < batch->n; i++)
+        {
+            if (!batch->finished[i])
+            {
+                finish_slot(batch, i, "{\"id\": " + batch->reqs[i]->id + ", \"error\": \"run error\"}\n");
+            }
+        }
+    }
+    else if (state == RKLLM_RUN_NORMAL)
+    {
+        int listening = 0;
+        for (int i = 0; i < batch->n; i++)
+        {
+            llm_request_t *req = batch->reqs[i];
+            if (req->client->broken)
+            {
+                continue;
+            }
+            listening++;
+            if (result[i].text == NULL)
+            {
+                continue;
+            }
+            if (req->tokens++ == 0)
+            {
+                req->first_token = std::chrono::steady_clock::now();
+            }
+            if (i == 0)
+            {
+                batch->reply += result[i].text;
+            }
+            std::string line = "{\"id\": " + req->id + ", \"token\": ";
+            json_append_string(line, result[i].text, strlen(result[i].text));
+            line += "}\n";
+            push_line(req, line, RECORD_LINE);
+        }
+        if (listening == 0)
+        {
+            // nobody is listening, pause the run, the worker drops the requests
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// consumer side of the ring, writes the lines to the clients
+static void streamer_thread()
+{
+    std::string record(token_ring_max_record(&g_ring), '\0');
+    while (true)
+    {
+        uint32_t tag;
+        int size = token_ring_pop(&g_ring, &tag, &record[0]);
+        llm_request_t *req;
+        memcpy(&req, record.data(), sizeof(req));
+        if (!req->client->broken && size > (int)sizeof(req))
+        {
+            write_all(req->client, record.data() + sizeof(req), size - sizeof(req));
+        }
+        if (tag == RECORD_LAST)
+        {
+            client_release(req->client);
+            delete req;
+        }
+    }
+}
+
+static void reader_thread(client_t *client)
+{
+    std::string buf;
+    char chunk[4096];
+    int seq = 0;
+    while (true)
+    {
+        ssize_t n = recv(client->fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        buf.append(chunk, n);
+        size_t eol;
+        while ((eol = buf.find('\n')) != std::string::npos)
+        {
+            std::string line = buf.substr(0, eol);
+            buf.erase(0, eol + 1);
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+
+            llm_request_t *req = new llm_request_t();
+            req->client = client;
+            req->received = std::chrono::steady_clock::now();
+            req->tokens = 0;
+            std::string id;
+            double num;
+            if (json_get_string(line, "id", id) == 0)
+            {
+                json_append_string(req->id, id.data(), id.size());
+            }
+            else if (json_get_number(line, "id", &num) == 0)
+            {
+                char s[32];
+                snprintf(s, sizeof(s), "%.17g", num);
+                req->id = s;
+            }
+            else
+            {
+                req->id = std::to_string(seq);
+            }
+            seq++;
+
+            if (json_get_string(line, "prompt", req->prompt) != 0)
+            {
+                reply_error(client, req->id, "no prompt");
+                delete req;
+                continue;
+            }
+            json_get_string(line, "session", req->session);
+            if (!req->session.empty() && g_n_batch > 1)
+            {
+                reply_error(client, req->id, "sessions need n_batch 1");
+                delete req;
+                continue;
+            }
+            bool queued = false;
+            {
+                std::lock_guard<std::mutex> lk(g_queue_lock);
+                if (g_queue.size() < MAX_QUEUED_REQUESTS)
+                {
+                    client->refs++;
+                    g_queue.push_back(req);
+                    queued = true;
+                }
+            }
+            if (!queued)
+            {
+                reply_error(client, req->id, "queue full");
+                delete req;
+                continue;
+            }
+            g_queue_cond.notify_one();
+        }
+        if (buf.size() > MAX_LINE_SIZE)
+        {
+            reply_error(client, "null", "line too long");
+            break;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lk(g_queue_lock);
+        g_clients--;
+    }
+    client_release(client);
+}
+
+static void accept_thread(int listen_fd)
+{
+    while (true)
+    {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            printf("accept fail! %s\n", strerror(errno));
+            return;
+        }
+        client_t *client = new client_t();
+        client->fd = fd;
+        client->refs = 1;
+        client->broken = false;
+        {
+            std::lock_guard<std::mutex> lk(g_queue_lock);
+            g_clients++;
+        }
+        std::thread(reader_thread, client).detach();
+    }
+}
+
+static int listen_socket(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        printf("socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0)
+    {
+        printf("bind %s fail! %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// clients with a request in the batch, g_queue_lock held
+static int batch_clients(const llm_batch_t *batch)
+{
+    int n = 0;
+    for (int i = 0; i < batch->n; i++)
+    {
+        bool seen = false;
+        for (int j = 0; j < i; j++)
+        {
+            seen = seen || batch->reqs[j]->client == batch->reqs[i]->client;
+        }
+        n += !seen;
+    }
+    return n;
+}
+
+// next requests to run: the oldest one, and with n_batch > 1 whatever else arrives within the window
+static void collect_batch(llm_batch_t *batch)
+{
+    std::unique_lock<std::mutex> lk(g_queue_lock);
+    g_queue_cond.wait(lk, [] { return !g_queue.empty(); });
+    batch->n = 0;
+    time_point_t deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(g_batch_window_ms);
+    while (true)
+    {
+        while (!g_queue.empty() && batch->n < g_n_batch)
+        {
+            batch->reqs[batch->n++] = g_queue.front();
+            g_queue.pop_front();
+        }
+        // nobody else to wait for: every connected client is waiting on this batch
+        if (batch->n == g_n_batch || batch_clients(batch) >= g_clients ||
+            !g_queue_cond.wait_until(lk, deadline, [] { return !g_queue.empty(); }))
+        {
+            break;
+        }
+    }
+}
+
+static void run_batch(llm_batch_t *batch)
+{
+    RKLLMInput inputs[MAX_BATCH];
+    RKLLMInferParam infer_params;
+    time_point_t now = std::chrono::steady_clock::now();
+    int live = 0;
+    for (int i = 0; i < batch->n; i++)
+    {
+        batch->reqs[i]->started = now;
+        batch->finished[i] = false;
+        live += !batch->reqs[i]->client->broken;
+    }
+    batch->ok = false;
+    batch->reply.clear();
+    if (live == 0)
+    {
+        return;
+    }
+
+    if (g_n_batch == 1)
+    {
+        llm_request_t *req = batch->reqs[0];
+        llm_session_begin_turn(&g_sessions, req->session.c_str(), req->prompt, &inputs[0], &infer_params, &req->turn);
+        rkllm_run(llmHandle, inputs, &infer_params, batch);
+        // a paused run leaves the kv cache half way, the session layer rebuilds it
+        llm_session_end_turn(&g_sessions, batch->reply, batch->ok);
+        return;
+    }
+
+    for (int i = 0; i < g_n_batch; i++)
+    {
+        memset(&inputs[i], 0, sizeof(RKLLMInput));
+        inputs[i].input_type = RKLLM_INPUT_PROMPT;
+        inputs[i].role = "user";
+        inputs[i].prompt_input = i < batch->n ? batch->reqs[i]->prompt.c_str() : "";
+    }
+    memset(&infer_params, 0, sizeof(RKLLMInferParam));
+    infer_params.mode = RKLLM_INFER_GENERATE;
+    infer_params.keep_history = 0;
+    if (rkllm_run(llmHandle, inputs, &infer_params, batch) != 0 || !batch->ok)
+    {
+        rkllm_clear_kv_cache(llmHandle, 0, nullptr, nullptr);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr,
+                "Usage: %s model_path max_new_tokens max_context_len [socket_path] [cache_dir] [n_batch] "
+                "[batch_window_ms]\n"
+                "  n_batch > 1 runs up to n_batch requests in one rkllm_run, waiting up to batch_window_ms\n"
+                "  (default %d) for them; it gives up sessions and the system prompt cache, every request\n"
+                "  is stateless and prefilled in full\n",
+                argv[0], DEFAULT_BATCH_WINDOW_MS);
+        return 1;
+    }
+    const char *socket_path = argc > 4 ? argv[4] : DEFAULT_SOCKET_PATH;
+    const char *cache_dir = argc > 5 ? argv[5] : DEFAULT_CACHE_DIR;
+    g_n_batch = argc > 6 ? std::atoi(argv[6]) : 1;
+    g_batch_window_ms = argc > 7 ? std::atoi(argv[7]) : DEFAULT_BATCH_WINDOW_MS;
+    if (g_n_batch < 1 || g_n_batch > MAX_BATCH)
+    {
+        fprintf(stderr, "n_batch must be 1 to %d\n", MAX_BATCH);
+        return 1;
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    signal(SIGINT, exit_handler);
+    signal(SIGTERM, exit_handler);
+    signal(SIGPIPE, SIG_IGN);
+    printf("rkllm init start\n");
+
+    RKLLMParam param = rkllm_createDefaultParam();
+    param.model_path = argv[1];
+    param.top_k = 1;
+    param.top_p = 0.95;
+    param.temperature = 0.8;
+    param.repeat_penalty = 1.1;
+    param.frequency_penalty = 0.0;
+    param.presence_penalty = 0.0;
+    param.max_new_tokens = std::atoi(argv[2]);
+    param.max_context_len = std::atoi(argv[3]);
+    param.skip_special_token = true;
+    param.extend_param.base_domain_id = 0;
+    param.extend_param.embed_flash = 1;
+    param.extend_param.n_batch = g_n_batch;
+
+    int ret = rkllm_init(&llmHandle, &param, callback);
+    if (ret != 0 && g_n_batch > 1)
+    {
+        // older runtimes and some models have no batched inference
+        printf("rkllm init with n_batch %d failed, falling back to sequential runs\n", g_n_batch);
+        g_n_batch = 1;
+        param.extend_param.n_batch = 1;
+        ret = rkllm_init(&llmHandle, &param, callback);
+    }
+    if (ret != 0)
+    {
+        printf("rkllm init failed\n");
+        return -1;
+    }
+    printf("rkllm init success, n_batch %d\n", g_n_batch);
+
+    if (g_n_batch == 1)
+    {
+        ret = llm_session_manager_init(&g_sessions, llmHandle, cache_dir, SYSTEM_PROMPT, PROMPT_PREFIX,
+                                       PROMPT_POSTFIX, param.max_context_len, param.max_new_tokens);
+        if (ret != 0)
+        {
+            printf("llm_session_manager_init fail! ret=%d\n", ret);
+            exit_handler(-1);
+        }
+    }
+    else
+    {
+        rkllm_set_chat_template(llmHandle, SYSTEM_PROMPT, PROMPT_PREFIX, PROMPT_POSTFIX);
+    }
+
+    if (token_ring_init(&g_ring, RING_SIZE) != 0)
+    {
+        printf("token_ring_init fail!\n");
+        exit_handler(-1);
+    }
+    int listen_fd = listen_socket(socket_path);
+    if (listen_fd < 0)
+    {
+        exit_handler(-1);
+    }
+    g_socket_path = socket_path;
+    std::thread(streamer_thread).detach();
+    std::thread(accept_thread, listen_fd).detach();
+    printf("listening on %s\n", socket_path);
+
+    llm_batch_t batch;
+    while (true)
+    {
+        collect_batch(&batch);
+        run_batch(&batch);
+        for (int i = 0; i < batch.n; i++)
+        {
+            if (!batch.finished[i])
+            {
+                // paused for a gone client, or failed without a callback
+                llm_request_t *req = batch.reqs[i];
+                push_line(req, req->client->broken ? "" : "{\"id\": " + req->id + ", \"error\": \"run failed\"}\n",
+                          RECORD_LAST);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,356 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "llm_session.h"
+
+#define SESSION_FILE_TAG "rkllm_session"
+#define SESSION_FILE_VERSION 2
+#define MAX_BATCH 256
+
+static std::string hash_name(const std::string &s)
+{
+    uint32_t h = 2166136261u;
+    for (unsigned char c : s)
+    {
+        h = (h ^ c) * 16777619u;
+    }
+    char name[16];
+    snprintf(name, sizeof(name), "%08x", h);
+    return name;
+}
+
+static int kv_cache_size(llm_session_manager_t *mgr)
+{
+    int sizes[MAX_BATCH] = {0};
+    return rkllm_get_kv_cache_size(mgr->handle, sizes) == 0 ? sizes[0] : -1;
+}
+
+// no tokenizer here, one token per character is on the safe side for both CJK and latin text
+static int estimate_tokens(const std::string &s)
+{
+    int n = 0;
+    for (unsigned char c : s)
+    {
+        n += (c & 0xC0) != 0x80;
+    }
+    return n;
+}
+
+static std::string turn_text(const llm_session_manager_t *mgr, const llm_turn_t &t)
+{
+    return mgr->prompt_prefix + t.user + mgr->prompt_postfix + t.reply;
+}
+
+static int save_transcript(const llm_session_t *s)
+{
+    std::string path = s->file_base + ".turns";
+    std::string tmp_path = path + ".tmp";
+    FILE *fp = fopen(tmp_path.c_str(), "wb");
+    if (fp == NULL)
+    {
+        printf("open %s fail!\n", tmp_path.c_str());
+        return -1;
+    }
+    fprintf(fp, "%s %d %zu\n%s\n", SESSION_FILE_TAG, SESSION_FILE_VERSION, s->id.size(), s->id.c_str());
+    for (const llm_turn_t &t : s->turns)
+    {
+        fprintf(fp, "%zu %zu\n", t.user.size(), t.reply.size());
+        fwrite(t.user.data(), 1, t.user.size(), fp);
+        fwrite(t.reply.data(), 1, t.reply.size(), fp);
+        fputc('\n', fp);
+    }
+    bool ok = !ferror(fp);
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        printf("write %s fail!\n", path.c_str());
+        unlink(tmp_path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+static int read_string(FILE *fp, size_t size, std::string &s)
+{
+    s.resize(size);
+    return size == 0 || fread(&s[0], 1, size, fp) == size ? 0 : -1;
+}
+
+static void load_transcript(llm_session_t *s)
+{
+    FILE *fp = fopen((s->file_base + ".turns").c_str(), "rb");
+    if (fp == NULL)
+    {
+        return;
+    }
+    char tag[32];
+    int version;
+    size_t id_size;
+    std::string id;
+    if (fscanf(fp, "%31s %d %zu", tag, &version, &id_size) == 3 && strcmp(tag, SESSION_FILE_TAG) == 0 &&
+        version == SESSION_FILE_VERSION && fgetc(fp) == '\n' && read_string(fp, id_size, id) == 0 && id == s->id &&
+        fgetc(fp) == '\n')
+    {
+        llm_turn_t t;
+        size_t user_size, reply_size;
+        while (fscanf(fp, "%zu %zu", &user_size, &reply_size) == 2 && fgetc(fp) == '\n' &&
+               read_string(fp, user_size, t.user) == 0 && read_string(fp, reply_size, t.reply) == 0 &&
+               fgetc(fp) == '\n')
+        {
+            s->turns.push_back(t);
+        }
+    }
+    fclose(fp);
+    s->has_cache = !s->turns.empty() && access((s->file_base + ".cache").c_str(), R_OK) == 0;
+    printf("session %s: %zu turns restored%s\n", s->id.c_str(), s->turns.size(), s->has_cache ? " with kv cache" : "");
+}
+
+static llm_session_t *get_session(llm_session_manager_t *mgr, const std::string &id)
+{
+    auto it = mgr->sessions.find(id);
+    if (it != mgr->sessions.end())
+    {
+        return it->second;
+    }
+    llm_session_t *s = new llm_session_t();
+    s->id = id;
+    s->file_base = mgr->dir + "/session_" + hash_name(id);
+    s->has_cache = false;
+    load_transcript(s);
+    mgr->sessions[id] = s;
+    return s;
+}
+
+static void drop_cache(llm_session_t *s)
+{
+    unlink((s->file_base + ".cache").c_str());
+    s->has_cache = false;
+}
+
+// kv cache back to the system prompt, returns the text that still has to be prefilled for it
+static std::string back_to_base(llm_session_manager_t *mgr)
+{
+    mgr->active = NULL;
+    mgr->kv_known = true;
+    if (mgr->system_cache_ok && rkllm_load_prompt_cache(mgr->handle, mgr->system_cache_path.c_str()) == 0)
+    {
+        return "";
+    }
+    mgr->system_cache_ok = false;
+    rkllm_clear_kv_cache(mgr->handle, 0, nullptr, nullptr);
+    return mgr->system_prompt;
+}
+
+int llm_session_manager_init(llm_session_manager_t *mgr, LLMHandle handle, const char *dir, const char *system_prompt,
+                             const char *prompt_prefix, const char *prompt_postfix, int max_context_len,
+                             int max_new_tokens)
+{
+    mgr->handle = handle;
+    mgr->dir = dir;
+    mgr->system_prompt = system_prompt;
+    mgr->prompt_prefix = prompt_prefix;
+    mgr->prompt_postfix = prompt_postfix;
+    mgr->max_context_len = max_context_len;
+    mgr->max_new_tokens = max_new_tokens;
+    mgr->active = NULL;
+    mgr->current = NULL;
+    mgr->kv_known = true;
+    mgr->total_reused_tokens = 0;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+    {
+        printf("mkdir %s fail! %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    // the template is applied by the session layer
+    int ret = rkllm_set_chat_template(handle, "", "", "");
+    if (ret != 0)
+    {
+        printf("rkllm_set_chat_template fail! ret=%d\n", ret);
+        return -1;
+    }
+
+    // the system prompt is prefilled once, the file name follows the prompt
+    mgr->system_cache_path = mgr->dir + "/system_" + hash_name(mgr->system_prompt) + ".cache";
+    if (access(mgr->system_cache_path.c_str(), R_OK) != 0)
+    {
+        RKLLMInput input;
+        memset(&input, 0, sizeof(RKLLMInput));
+        input.input_type = RKLLM_INPUT_PROMPT;
+        input.role = "user";
+        input.prompt_input = mgr->system_prompt.c_str();
+
+        RKLLMInferParam infer;
+        memset(&infer, 0, sizeof(RKLLMInferParam));
+        infer.mode = RKLLM_INFER_GENERATE;
+        infer.keep_history = 0;
+        mgr->cache_params.save_prompt_cache = 1;
+        mgr->cache_params.prompt_cache_path = mgr->system_cache_path.c_str();
+        infer.prompt_cache_params = &mgr->cache_params;
+        ret = rkllm_run(handle, &input, &infer, NULL);
+        if (ret != 0 || access(mgr->system_cache_path.c_str(), R_OK) != 0)
+        {
+            printf("save prompt cache fail! ret=%d path=%s\n", ret, mgr->system_cache_path.c_str());
+        }
+    }
+    mgr->system_cache_ok = true;
+    if (!back_to_base(mgr).empty())
+    {
+        printf("no system prompt cache, it is prefilled with every new conversation\n");
+    }
+    return 0;
+}
+
+void llm_session_manager_release(llm_session_manager_t *mgr)
+{
+    for (auto &it : mgr->sessions)
+    {
+        delete it.second;
+    }
+    mgr->sessions.clear();
+    mgr->active = NULL;
+    mgr->current = NULL;
+}
+
+int llm_session_begin_turn(llm_session_manager_t *mgr, const char *session_id, const std::string &user,
+                           RKLLMInput *input, RKLLMInferParam *infer, llm_turn_info_t *info)
+{
+    memset(info, 0, sizeof(llm_turn_info_t));
+    memset(input, 0, sizeof(RKLLMInput));
+    memset(infer, 0, sizeof(RKLLMInferParam));
+    input->input_type = RKLLM_INPUT_PROMPT;
+    input->role = "user";
+    infer->mode = RKLLM_INFER_GENERATE;
+    mgr->current = NULL;
+    mgr->user = user;
+    std::string message = mgr->prompt_prefix + user + mgr->prompt_postfix;
+
+    std::string head;       // prefilled ahead of the new message
+    if (session_id == NULL || session_id[0] == '\0')
+    {
+        if (mgr->active != NULL || !mgr->kv_known)
+        {
+            head = back_to_base(mgr);
+        }
+        else
+        {
+            head = mgr->system_cache_ok ? "" : mgr->system_prompt;
+        }
+        infer->keep_history = 0;
+    }
+    else
+    {
+        llm_session_t *s = get_session(mgr, session_id);
+        if (mgr->active == s && mgr->kv_known)
+        {
+            // still in the kv cache
+        }
+        else if (s->has_cache && rkllm_load_prompt_cache(mgr->handle, (s->file_base + ".cache").c_str()) == 0)
+        {
+            // the cache ends with the prompt of the last turn
+            head = s->turns.back().reply;
+            info->restored = true;
+        }
+        else
+        {
+            head = back_to_base(mgr);
+            info->rebuilt = !s->turns.empty();
+        }
+        mgr->active = s;
+        mgr->kv_known = true;
+
+        // a range rkllm_clear_kv_cache only works in a paused keep_history = 0 run, a session that
+        // no longer fits is prefilled again from the transcript without its oldest turns
+        if (!info->rebuilt &&
+            kv_cache_size(mgr) > mgr->max_context_len - mgr->max_new_tokens - estimate_tokens(head + message))
+        {
+            head = back_to_base(mgr);
+            mgr->active = s;
+            info->rebuilt = true;
+            info->restored = false;
+        }
+        if (info->rebuilt)
+        {
+            // history from the transcript, oldest turns left out as needed
+            int budget = mgr->max_context_len - mgr->max_new_tokens - kv_cache_size(mgr) -
+                         estimate_tokens(head + message);
+            std::vector<int> tokens(s->turns.size());
+            int total = 0;
+            for (size_t i = 0; i < s->turns.size(); i++)
+            {
+                tokens[i] = estimate_tokens(turn_text(mgr, s->turns[i]));
+                total += tokens[i];
+            }
+            size_t k = 0;
+            while (k < s->turns.size() && total > budget)
+            {
+                total -= tokens[k++];
+            }
+            s->turns.erase(s->turns.begin(), s->turns.begin() + k);
+            info->evicted_turns = (int)k;
+            for (const llm_turn_t &t : s->turns)
+            {
+                head += turn_text(mgr, t);
+            }
+        }
+
+        // the kv cache after this prefill replaces the session's prompt cache
+        infer->keep_history = 1;
+        s->has_cache = false;
+        mgr->cache_path = s->file_base + ".cache";
+        mgr->cache_params.save_prompt_cache = 1;
+        mgr->cache_params.prompt_cache_path = mgr->cache_path.c_str();
+        infer->prompt_cache_params = &mgr->cache_params;
+        mgr->current = s;
+    }
+
+    int kv = kv_cache_size(mgr);
+    info->reused_tokens = kv > 0 ? kv : 0;
+    mgr->total_reused_tokens += info->reused_tokens;
+    mgr->prompt = head + message;
+    input->prompt_input = mgr->prompt.c_str();
+    return 0;
+}
+
+void llm_session_end_turn(llm_session_manager_t *mgr, const std::string &reply, bool ok)
+{
+    llm_session_t *s = mgr->current;
+    mgr->current = NULL;
+    if (!ok)
+    {
+        // whatever the run left in the kv cache is not a known state
+        mgr->kv_known = false;
+        if (s != NULL)
+        {
+            drop_cache(s);
+        }
+        return;
+    }
+    if (s == NULL)
+    {
+        return;
+    }
+
+    llm_turn_t t;
+    t.user = mgr->user;
+    t.reply = reply;
+    s->turns.push_back(t);
+    s->has_cache = access((s->file_base + ".cache").c_str(), R_OK) == 0;
+    save_transcript(s);
+}
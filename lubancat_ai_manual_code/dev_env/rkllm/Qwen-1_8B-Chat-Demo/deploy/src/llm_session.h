@@ -0,0 +1,114 @@
+#ifndef _RKLLM_SESSION_H_
+#define _RKLLM_SESSION_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "rkllm.h"
+
+/*
+ * Conversations sharing one LLMHandle, which has one kv cache.
+ *
+ * The session that ran last owns the kv cache and its next turn only prefills the new
+ * message (keep_history = 1). Every turn saves the kv cache after its prefill to the
+ * session's prompt cache file, so a session that was switched away from is restored
+ * with rkllm_load_prompt_cache and prefills just its last reply and the new message.
+ * Without a usable prompt cache the history is prefilled again from the transcript.
+ * Before a turn would overflow max_context_len its oldest turns are dropped: the kv cache
+ * goes back to the system prompt and the turns that are left are prefilled again.
+ *
+ * The chat template is applied here (the runtime's is set empty) so that history,
+ * replies and new messages can be fed in pieces. Files, in dir:
+ *
+ *   system_<hash>.cache     the system prompt, the starting point of stateless requests
+ *                           and new sessions
+ *   session_<hash>.cache    prompt cache of the session, up to the prompt of its last turn
+ *   session_<hash>.turns    transcript, sessions outlive the process
+ *
+ * Not thread safe, use it from the thread that calls rkllm_run.
+ */
+
+typedef struct
+{
+    std::string user;
+    std::string reply;
+} llm_turn_t;
+
+typedef struct
+{
+    std::string id;
+    std::string file_base;      // dir/session_<hash>
+    std::vector<llm_turn_t> turns;
+    bool has_cache;             // file_base.cache holds the kv cache up to the last prompt
+} llm_session_t;
+
+typedef struct
+{
+    int reused_tokens;          // kv cache positions reused, prefill saved by the session layer
+    int evicted_turns;          // oldest turns dropped to fit max_context_len
+    bool restored;              // the session came back from its prompt cache
+    bool rebuilt;               // the session history was prefilled from the transcript
+} llm_turn_info_t;
+
+typedef struct
+{
+    LLMHandle handle;
+    std::string dir;
+    std::string system_prompt;
+    std::string prompt_prefix;
+    std::string prompt_postfix;
+    int max_context_len;
+    int max_new_tokens;
+
+    std::string system_cache_path;
+    bool system_cache_ok;
+    std::map<std::string, llm_session_t *> sessions;
+    llm_session_t *active;      // the session in the kv cache, NULL: only the system prompt (or nothing)
+    bool kv_known;              // false after a failed run, the kv cache is rebuilt before the next one
+
+    // the turn between llm_session_begin_turn and llm_session_end_turn
+    llm_session_t *current;
+    std::string prompt;
+    std::string user;
+    std::string cache_path;
+    RKLLMPromptCacheParam cache_params;
+
+    long long total_reused_tokens;
+} llm_session_manager_t;
+
+/**
+ * @brief Set the empty chat template on handle and save / load the system prompt cache
+ *
+ * The warm up run calls the rkllm callback with userdata NULL, the callback has to
+ * return 1 for RKLLM_RUN_NORMAL then, to stop after the prefill.
+ *
+ * @param dir directory of the cache files, created if needed
+ * @return int 0: success; -1: error
+ */
+int llm_session_manager_init(llm_session_manager_t *mgr, LLMHandle handle, const char *dir, const char *system_prompt,
+                             const char *prompt_prefix, const char *prompt_postfix, int max_context_len,
+                             int max_new_tokens);
+
+void llm_session_manager_release(llm_session_manager_t *mgr);
+
+/**
+ * @brief Get the kv cache ready for a turn and fill the rkllm_run arguments
+ *
+ * @param session_id the conversation, NULL or "" for a stateless request
+ * @param input filled with the prompt, valid until llm_session_end_turn
+ * @param infer filled with keep_history and prompt cache parameters
+ * @return int 0: success; -1: error
+ */
+int llm_session_begin_turn(llm_session_manager_t *mgr, const char *session_id, const std::string &user,
+                           RKLLMInput *input, RKLLMInferParam *infer, llm_turn_info_t *info);
+
+/**
+ * @brief Record the turn after rkllm_run returned
+ *
+ * @param reply the generated text
+ * @param ok false if the run failed or was cut short, the turn is dropped
+ */
+void llm_session_end_turn(llm_session_manager_t *mgr, const std::string &reply, bool ok);
+
+#endif //_RKLLM_SESSION_H_
@@ -0,0 +1,111 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <thread>
+
+#include "token_ring.h"
+
+#define RECORD_HEADER_SIZE 8
+
+static inline size_t record_span(uint32_t size)
+{
+    return (RECORD_HEADER_SIZE + size + 7) & ~(size_t)7;
+}
+
+// copy in / out of the ring across the wrap
+static void ring_write(token_ring_t *ring, size_t pos, const void *data, size_t size)
+{
+    size_t off = pos & (ring->capacity - 1);
+    size_t first = size < ring->capacity - off ? size : ring->capacity - off;
+    memcpy(ring->buf + off, data, first);
+    memcpy(ring->buf, (const uint8_t *)data + first, size - first);
+}
+
+static void ring_read(const token_ring_t *ring, size_t pos, void *data, size_t size)
+{
+    size_t off = pos & (ring->capacity - 1);
+    size_t first = size < ring->capacity - off ? size : ring->capacity - off;
+    memcpy(data, ring->buf + off, first);
+    memcpy((uint8_t *)data + first, ring->buf, size - first);
+}
+
+int token_ring_init(token_ring_t *ring, size_t capacity)
+{
+    size_t c = 64;
+    while (c < capacity)
+    {
+        c <<= 1;
+    }
+    ring->buf = (uint8_t *)malloc(c);
+    if (ring->buf == NULL)
+    {
+        return -1;
+    }
+    ring->capacity = c;
+    ring->head = 0;
+    ring->tail = 0;
+    return sem_init(&ring->records, 0, 0);
+}
+
+void token_ring_release(token_ring_t *ring)
+{
+    free(ring->buf);
+    ring->buf = NULL;
+    sem_destroy(&ring->records);
+}
+
+size_t token_ring_max_record(const token_ring_t *ring)
+{
+    return ring->capacity - RECORD_HEADER_SIZE;
+}
+
+int token_ring_push(token_ring_t *ring, uint32_t tag, const void *data, uint32_t size)
+{
+    size_t span = record_span(size);
+    if (span > ring->capacity)
+    {
+        return -1;
+    }
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    while (head + span - ring->tail.load(std::memory_order_acquire) > ring->capacity)
+    {
+        std::this_thread::yield();
+    }
+    uint32_t header[2] = {tag, size};
+    ring_write(ring, head, header, RECORD_HEADER_SIZE);
+    ring_write(ring, head + RECORD_HEADER_SIZE, data, size);
+    ring->head.store(head + span, std::memory_order_release);
+    sem_post(&ring->records);
+    return 0;
+}
+
+int token_ring_pop(token_ring_t *ring, uint32_t *tag, void *data)
+{
+    while (sem_wait(&ring->records) != 0 && errno == EINTR)
+    {
+    }
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    while (ring->head.load(std::memory_order_acquire) == tail)
+    {
+        std::this_thread::yield();
+    }
+    uint32_t header[2];
+    ring_read(ring, tail, header, RECORD_HEADER_SIZE);
+    ring_read(ring, tail + RECORD_HEADER_SIZE, data, header[1]);
+    ring->tail.store(tail + record_span(header[1]), std::memory_order_release);
+    *tag = header[0];
+    return (int)header[1];
+}
@@ -0,0 +1,50 @@
+#ifndef _RKLLM_TOKEN_RING_H_
+#define _RKLLM_TOKEN_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <semaphore.h>
+
+#include <atomic>
+
+/*
+ * Single producer / single consumer ring of variable size records. The producer is
+ * the rkllm callback and never takes a lock, a full ring makes it yield until the
+ * consumer catches up. The consumer sleeps on a semaphore posted once per record.
+ *
+ * record: uint32_t tag, uint32_t size, size bytes of data, padded to 8 bytes
+ */
+typedef struct
+{
+    uint8_t *buf;
+    size_t capacity;                // power of two
+    std::atomic<size_t> head;       // written by the producer
+    std::atomic<size_t> tail;       // written by the consumer
+    sem_t records;
+} token_ring_t;
+
+/**
+ * @return int 0: success; -1: error
+ */
+int token_ring_init(token_ring_t *ring, size_t capacity);
+
+void token_ring_release(token_ring_t *ring);
+
+/**
+ * @brief Producer side, waits while the ring is full
+ *
+ * @return int 0: success; -1: the record can never fit
+ */
+int token_ring_push(token_ring_t *ring, uint32_t tag, const void *data, uint32_t size);
+
+/**
+ * @brief Consumer side, blocks until a record is there
+ *
+ * @param data receives the record, at least token_ring_max_record bytes
+ * @return int size of the record
+ */
+int token_ring_pop(token_ring_t *ring, uint32_t *tag, void *data);
+
+size_t token_ring_max_record(const token_ring_t *ring);
+
+#endif //_RKLLM_TOKEN_RING_H_
@@ -0,0 +1,223 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "vector_store.h"
+
+#define INITIAL_CAPACITY 1024
+
+static size_t file_size(uint32_t dim, uint64_t capacity)
+{
+    return sizeof(vector_store_header_t) + (size_t)capacity * dim * sizeof(float);
+}
+
+static int map_file(vector_store_t *store, size_t size)
+{
+    int prot = store->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *p = mmap(NULL, size, prot, MAP_SHARED, store->fd, 0);
+    if (p == MAP_FAILED)
+    {
+        printf("mmap fail! %s\n", strerror(errno));
+        return -1;
+    }
+    store->map_size = size;
+    store->header = (vector_store_header_t *)p;
+    store->vectors = (float *)((char *)p + sizeof(vector_store_header_t));
+    return 0;
+}
+
+static void unmap_file(vector_store_t *store)
+{
+    if (store->header != NULL)
+    {
+        munmap(store->header, store->map_size);
+        store->header = NULL;
+        store->vectors = NULL;
+    }
+}
+
+int vector_store_open(vector_store_t *store, const char *path, uint32_t dim, bool writable)
+{
+    memset(store, 0, sizeof(vector_store_t));
+    store->writable = writable;
+    store->fd = open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (store->fd < 0)
+    {
+        printf("open %s fail! %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    fstat(store->fd, &st);
+    if (st.st_size == 0 && writable && dim > 0)
+    {
+        vector_store_header_t header;
+        memset(&header, 0, sizeof(header));
+        header.magic = VECTOR_STORE_MAGIC;
+        header.version = VECTOR_STORE_VERSION;
+        header.dim = dim;
+        header.capacity = INITIAL_CAPACITY;
+        if (ftruncate(store->fd, file_size(dim, header.capacity)) != 0 ||
+            pwrite(store->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+        {
+            printf("create %s fail! %s\n", path, strerror(errno));
+            vector_store_close(store);
+            return -1;
+        }
+        st.st_size = file_size(dim, header.capacity);
+    }
+
+    vector_store_header_t header;
+    if ((size_t)st.st_size < sizeof(header) || pread(store->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != VECTOR_STORE_MAGIC || header.version != VECTOR_STORE_VERSION || header.dim == 0 ||
+        header.count > header.capacity || (size_t)st.st_size < file_size(header.dim, header.capacity))
+    {
+        printf("%s is not a vector store\n", path);
+        vector_store_close(store);
+        return -1;
+    }
+    if (dim > 0 && header.dim != dim)
+    {
+        printf("%s holds %u-d vectors, not %u-d\n", path, header.dim, dim);
+        vector_store_close(store);
+        return -1;
+    }
+    if (map_file(store, file_size(header.dim, header.capacity)) != 0)
+    {
+        vector_store_close(store);
+        return -1;
+    }
+    return 0;
+}
+
+void vector_store_close(vector_store_t *store)
+{
+    if (store->writable && store->header != NULL)
+    {
+        msync(store->header, store->map_size, MS_SYNC);
+    }
+    unmap_file(store);
+    if (store->fd >= 0)
+    {
+        close(store->fd);
+        store->fd = -1;
+    }
+}
+
+int vector_store_add(vector_store_t *store, const float *vectors, size_t n)
+{
+    if (!store->writable)
+    {
+        return -1;
+    }
+    vector_store_header_t *h = store->header;
+    if (h->count + n > h->capacity)
+    {
+        uint32_t dim = h->dim;
+        uint64_t capacity = h->capacity * 2;
+        while (capacity < h->count + n)
+        {
+            capacity *= 2;
+        }
+        // the old mapping stays until the new one is there, a failed grow leaves the store as it was
+        void *old_map = store->header;
+        size_t old_size = store->map_size;
+        if (ftruncate(store->fd, file_size(dim, capacity)) != 0 || map_file(store, file_size(dim, capacity)) != 0)
+        {
+            printf("grow vector store fail! %s\n", strerror(errno));
+            return -1;
+        }
+        munmap(old_map, old_size);
+        h = store->header;
+        h->capacity = capacity;
+    }
+    memcpy(store->vectors + h->count * h->dim, vectors, n * h->dim * sizeof(float));
+    // count last, a reader never sees a half written row
+    __atomic_store_n(&h->count, h->count + n, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static inline float dot(const float *a, const float *b, int n)
+{
+    int i = 0;
+    float sum = 0.0f;
+#if defined(__ARM_NEON)
+    // four accumulators keep the multiply-add pipeline busy
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    float32x4_t acc2 = vdupq_n_f32(0.0f);
+    float32x4_t acc3 = vdupq_n_f32(0.0f);
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        acc2 = vmlaq_f32(acc2, vld1q_f32(a + i + 8), vld1q_f32(b + i + 8));
+        acc3 = vmlaq_f32(acc3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+    }
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float32x4_t acc = vaddq_f32(vaddq_f32(acc0, acc1), vaddq_f32(acc2, acc3));
+    float32x2_t s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+    for (; i < n; i++)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+int vector_store_search(const vector_store_t *store, const float *query, int k, int64_t *ids, float *scores)
+{
+    const vector_store_header_t *h = store->header;
+    uint64_t count = __atomic_load_n(&h->count, __ATOMIC_ACQUIRE);
+    // a writer may have grown the file past this mapping
+    uint64_t mapped = (store->map_size - sizeof(vector_store_header_t)) / (h->dim * sizeof(float));
+    count = count < mapped ? count : mapped;
+    int found = 0;
+    if (k <= 0)
+    {
+        return 0;
+    }
+    for (uint64_t id = 0; id < count; id++)
+    {
+        float score = dot(query, store->vectors + id * h->dim, (int)h->dim);
+        if (found == k && score <= scores[k - 1])
+        {
+            continue;
+        }
+        // k is small, insertion into the sorted list beats a heap
+        int pos = found < k ? found++ : k - 1;
+        while (pos > 0 && scores[pos - 1] < score)
+        {
+            scores[pos] = scores[pos - 1];
+            ids[pos] = ids[pos - 1];
+            pos--;
+        }
+        scores[pos] = score;
+        ids[pos] = (int64_t)id;
+    }
+    return found;
+}
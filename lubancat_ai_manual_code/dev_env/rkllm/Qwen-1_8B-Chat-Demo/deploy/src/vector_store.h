@@ -0,0 +1,64 @@
+#ifndef _RKLLM_VECTOR_STORE_H_
+#define _RKLLM_VECTOR_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Append only store of normalized float vectors in one memory mapped file:
+ *
+ *   vector_store_header_t, then capacity * dim floats, row i is vector id i
+ *
+ * The file grows by doubling, a search reads the mapping directly (no load step, the
+ * page cache is shared between processes). Scores are dot products, cosine
+ * similarity for normalized vectors.
+ */
+
+#define VECTOR_STORE_MAGIC 0x53564b52      // "RKVS"
+#define VECTOR_STORE_VERSION 1
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dim;
+    uint32_t tag;               // free for the writer, e.g. the pooling of the embeddings
+    uint64_t count;
+    uint64_t capacity;
+} vector_store_header_t;
+
+typedef struct
+{
+    int fd;
+    bool writable;
+    size_t map_size;
+    vector_store_header_t *header;
+    float *vectors;
+} vector_store_t;
+
+/**
+ * @brief Open a store, a writable open creates it if needed
+ *
+ * @param dim vector size of a new store, 0 to take the one in the file
+ * @return int 0: success; -1: error (missing file, dim mismatch)
+ */
+int vector_store_open(vector_store_t *store, const char *path, uint32_t dim, bool writable);
+
+void vector_store_close(vector_store_t *store);
+
+/**
+ * @brief Append n vectors, their ids are count .. count + n - 1
+ *
+ * @return int 0: success; -1: error
+ */
+int vector_store_add(vector_store_t *store, const float *vectors, size_t n);
+
+/**
+ * @brief Top k vectors by dot product with query, best first
+ *
+ * @param ids, scores k entries each
+ * @return int number of results, min(k, count)
+ */
+int vector_store_search(const vector_store_t *store, const float *query, int k, int64_t *ids, float *scores);
+
+#endif //_RKLLM_VECTOR_STORE_H_
@@ -0,0 +1,580 @@
+/*
+ * Host stub of librkllmrt, built from rkllm.h.
+ *
+ * There is no model. The reply to a prompt is the prompt itself, token by token, so
+ * a test can tell which request a stream belongs to. Prefill and decode sleep for a
+ * configurable time per token, which is enough to exercise serving code (queues,
+ * streaming, prompt cache reuse, TTFT and tokens/s accounting) on an x86 Linux box.
+ *
+ * tokens: every run of ascii letters / digits and every other utf-8 character is one
+ * token, ascii spaces are not tokens. Each id of RKLLM_INPUT_TOKEN is one token.
+ *
+ * prefill of a run: the system prompt of rkllm_set_chat_template if the kv cache is
+ * empty, then prefix, the input and postfix. A run with save_prompt_cache writes the
+ * kv cache after the prefill to the given path, rkllm_load_prompt_cache puts it back
+ * in the kv cache. keep_history == 0 rolls the kv cache back to the loaded prompt
+ * cache (or empties it) after the run, keep_history == 1 keeps prompt and reply.
+ * rkllm_clear_kv_cache with a range removes those positions.
+ *
+ * extend_param.n_batch > 1: rkllm_run takes an array of n_batch inputs and the
+ * callback gets an array of n_batch results, one per slot, each slot has its own kv
+ * cache. The slots decode in lock step, a slot that is done gets text NULL until the
+ * last one is; RKLLM_RUN_FINISH comes once for the batch. A prompt cache is loaded
+ * into every slot.
+ *
+ * environment:
+ *   RKLLM_STUB_PREFILL_MS    per prompt token (default 2)
+ *   RKLLM_STUB_DECODE_MS     per generated token (default 20)
+ *   RKLLM_STUB_REPLY_TOKENS  reply length, the prompt is repeated to fill it
+ *                            (default: the prompt once, capped at max_new_tokens)
+ *   RKLLM_STUB_EMBD_SIZE     hidden size for RKLLM_INFER_GET_LAST_HIDDEN_LAYER (default 1024)
+ *   RKLLM_STUB_VOCAB_SIZE    vocab size for RKLLM_INFER_GET_LOGITS and token ids (default 32000)
+ *   RKLLM_STUB_BATCH_COST    decode step cost of every extra active slot, as a fraction
+ *                            of a single slot step (default 0.1)
+ *   RKLLM_STUB_MAX_BATCH     largest n_batch rkllm_init accepts (default 8)
+ *   RKLLM_STUB_VERBOSE
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rkllm.h"
+
+#define STUB_MAGIC 0x4c4c4b52
+#define STUB_PROMPT_CACHE_TAG "rkllm_stub_prompt_cache"
+
+typedef struct {
+    uint32_t magic;
+    RKLLMParam param;
+    std::string model_path;
+    LLMResultCallback callback;
+
+    std::string system_prompt;
+    std::string prompt_prefix;
+    std::string prompt_postfix;
+
+    std::vector<int> kv_size;   // tokens in the kv cache of each batch slot
+    int cached_tokens;          // kv cache of a loaded prompt cache, where keep_history == 0 rolls back to
+
+    std::mutex run_lock;        // one run at a time, like on the board
+    std::atomic<bool> running;
+    std::atomic<bool> abort;
+    std::thread async_worker;
+} stub_llm_t;
+
+static int env_int(const char* name, int def)
+{
+    const char* v = getenv(name);
+    return v != NULL && v[0] != '\0' ? atoi(v) : def;
+}
+
+static double env_double(const char* name, double def)
+{
+    const char* v = getenv(name);
+    return v != NULL && v[0] != '\0' ? atof(v) : def;
+}
+
+static bool verbose()
+{
+    static int v = env_int("RKLLM_STUB_VERBOSE", 0);
+    return v != 0;
+}
+
+static stub_llm_t* get_llm(LLMHandle handle)
+{
+    stub_llm_t* llm = (stub_llm_t*)handle;
+    return llm != NULL && llm->magic == STUB_MAGIC ? llm : NULL;
+}
+
+static void tokenize(const char* text, std::vector<std::string>& tokens)
+{
+    if (text == NULL) {
+        return;
+    }
+    const unsigned char* p = (const unsigned char*)text;
+    while (*p != '\0') {
+        if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+            p++;
+            continue;
+        }
+        const unsigned char* start = p;
+        if (isalnum(*p)) {
+            while (isalnum(*p)) {
+                p++;
+            }
+        } else {
+            int n = (*p & 0xE0) == 0xC0 ? 2 : (*p & 0xF0) == 0xE0 ? 3 : (*p & 0xF8) == 0xF0 ? 4 : 1;
+            for (int i = 0; i < n && *p != '\0'; i++) {
+                p++;
+            }
+        }
+        tokens.emplace_back((const char*)start, p - start);
+    }
+}
+
+static int count_tokens(const std::string& text)
+{
+    std::vector<std::string> tokens;
+    tokenize(text.c_str(), tokens);
+    return (int)tokens.size();
+}
+
+static int32_t token_id(const std::string& token)
+{
+    uint32_t h = 2166136261u;
+    for (unsigned char c : token) {
+        h = (h ^ c) * 16777619u;
+    }
+    return (int32_t)(h % (uint32_t)env_int("RKLLM_STUB_VOCAB_SIZE", 32000));
+}
+
+static void sleep_ms(double ms)
+{
+    if (ms > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(ms * 1000)));
+    }
+}
+
+static double now_ms()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int write_prompt_cache(const char* path, int tokens)
+{
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) {
+        printf("rkllm_stub: open %s fail!\n", path);
+        return -1;
+    }
+    fprintf(fp, "%s %d\n", STUB_PROMPT_CACHE_TAG, tokens);
+    fclose(fp);
+    return 0;
+}
+
+// the input of one batch slot
+typedef struct {
+    std::vector<std::string> tokens;
+    int prefill;
+    int reply;
+} stub_slot_t;
+
+static void read_input(stub_llm_t* llm, int slot, const RKLLMInput* input, stub_slot_t* s)
+{
+    std::string prompt;
+    int extra_tokens = 0;
+    switch (input->input_type) {
+    case RKLLM_INPUT_PROMPT:
+        prompt = input->prompt_input != NULL ? input->prompt_input : "";
+        break;
+    case RKLLM_INPUT_MULTIMODAL:
+        prompt = input->multimodal_input.prompt != NULL ? input->multimodal_input.prompt : "";
+        extra_tokens = (int)(input->multimodal_input.n_image * input->multimodal_input.n_image_tokens);
+        break;
+    case RKLLM_INPUT_TOKEN:
+        break;
+    case RKLLM_INPUT_EMBED:
+        extra_tokens = (int)input->embed_input.n_tokens;
+        break;
+    }
+    tokenize(prompt.c_str(), s->tokens);
+    if (input->input_type == RKLLM_INPUT_TOKEN) {
+        // the ids are the tokens, the reply repeats them like it repeats a text prompt
+        for (size_t i = 0; i < input->token_input.n_tokens; i++) {
+            s->tokens.push_back(std::to_string(input->token_input.input_ids[i]));
+        }
+    }
+
+    // what is not in the kv cache yet is prefilled
+    s->prefill = (llm->kv_size[slot] > 0 ? 0 : count_tokens(llm->system_prompt)) + count_tokens(llm->prompt_prefix) +
+                 (int)s->tokens.size() + extra_tokens + count_tokens(llm->prompt_postfix);
+    s->reply = 0;
+}
+
+// a unit vector per token from its id, the same text gives the same states
+static void hidden_states(const std::vector<std::string>& tokens, int embd, std::vector<float>& states)
+{
+    int n = std::max(1, (int)tokens.size());
+    states.resize((size_t)n * embd);
+    for (int t = 0; t < n; t++) {
+        uint32_t s = tokens.empty() ? 1u : (uint32_t)token_id(tokens[t]) * 2654435761u + 1u;
+        double norm = 0;
+        for (int i = 0; i < embd; i++) {
+            s = s * 1664525u + 1013904223u;
+            states[(size_t)t * embd + i] = (float)((s >> 8) / 16777216.0 - 0.5);
+            norm += states[(size_t)t * embd + i] * states[(size_t)t * embd + i];
+        }
+        for (int i = 0; i < embd; i++) {
+            states[(size_t)t * embd + i] /= (float)sqrt(norm);
+        }
+    }
+}
+
+static int run_locked(stub_llm_t* llm, RKLLMInput* input, RKLLMInferParam* infer, void* userdata)
+{
+    int n_batch = (int)llm->kv_size.size();
+    std::vector<stub_slot_t> slots(n_batch);
+    std::vector<RKLLMResult> results(n_batch);
+    memset(results.data(), 0, sizeof(RKLLMResult) * n_batch);
+    int prefill = 0;
+    for (int b = 0; b < n_batch; b++) {
+        read_input(llm, b, &input[b], &slots[b]);
+        if (llm->kv_size[b] + slots[b].prefill > llm->param.max_context_len) {
+            printf("rkllm_stub: %d tokens exceed max_context_len %d\n", llm->kv_size[b] + slots[b].prefill,
+                   llm->param.max_context_len);
+            llm->callback(results.data(), userdata, RKLLM_RUN_ERROR);
+            return -1;
+        }
+        prefill += slots[b].prefill;
+    }
+
+    // the batch is prefilled in one go, the cost is the sum of its tokens
+    double t0 = now_ms();
+    sleep_ms(prefill * env_double("RKLLM_STUB_PREFILL_MS", 2.0));
+    float prefill_ms = (float)(now_ms() - t0);
+    for (int b = 0; b < n_batch; b++) {
+        llm->kv_size[b] += slots[b].prefill;
+        results[b].perf.prefill_tokens = slots[b].prefill;
+        results[b].perf.prefill_time_ms = prefill_ms;
+    }
+    if (verbose()) {
+        printf("rkllm_stub: prefill %d tokens in %d slots, kv %d\n", prefill, n_batch, llm->kv_size[0]);
+    }
+
+    if (infer->prompt_cache_params != NULL && infer->prompt_cache_params->save_prompt_cache &&
+        infer->prompt_cache_params->prompt_cache_path != NULL) {
+        write_prompt_cache(infer->prompt_cache_params->prompt_cache_path, llm->kv_size[0]);
+    }
+
+    int ret = 0;
+    if (infer->mode == RKLLM_INFER_GET_LAST_HIDDEN_LAYER) {
+        int embd = env_int("RKLLM_STUB_EMBD_SIZE", 1024);
+        std::vector<std::vector<float>> states(n_batch);
+        for (int b = 0; b < n_batch; b++) {
+            hidden_states(slots[b].tokens, embd, states[b]);
+            results[b].last_hidden_layer.hidden_states = states[b].data();
+            results[b].last_hidden_layer.embd_size = embd;
+            results[b].last_hidden_layer.num_tokens = (int)(states[b].size() / embd);
+        }
+        llm->callback(results.data(), userdata, RKLLM_RUN_NORMAL);
+        for (int b = 0; b < n_batch; b++) {
+            memset(&results[b].last_hidden_layer, 0, sizeof(results[b].last_hidden_layer));
+        }
+    } else if (infer->mode == RKLLM_INFER_GET_LOGITS) {
+        int vocab = env_int("RKLLM_STUB_VOCAB_SIZE", 32000);
+        std::vector<std::vector<float>> logits(n_batch, std::vector<float>(vocab, 0.0f));
+        for (int b = 0; b < n_batch; b++) {
+            if (!slots[b].tokens.empty()) {
+                logits[b][token_id(slots[b].tokens.back())] = 1.0f;
+            }
+            results[b].logits.logits = logits[b].data();
+            results[b].logits.vocab_size = vocab;
+            results[b].logits.num_tokens = 1;
+        }
+        llm->callback(results.data(), userdata, RKLLM_RUN_NORMAL);
+        for (int b = 0; b < n_batch; b++) {
+            memset(&results[b].logits, 0, sizeof(results[b].logits));
+        }
+    } else {
+        int steps = 0;
+        for (int b = 0; b < n_batch; b++) {
+            int reply = env_int("RKLLM_STUB_REPLY_TOKENS", (int)slots[b].tokens.size());
+            reply = std::min(reply, llm->param.max_new_tokens);
+            reply = std::min(reply, llm->param.max_context_len - llm->kv_size[b]);
+            slots[b].reply = slots[b].tokens.empty() ? 0 : reply;
+            steps = std::max(steps, slots[b].reply);
+        }
+        // decode is bound by reading the weights, an extra slot costs a fraction of a step
+        double decode_ms = env_double("RKLLM_STUB_DECODE_MS", 20.0);
+        double batch_cost = env_double("RKLLM_STUB_BATCH_COST", 0.1);
+        double t1 = now_ms();
+        std::vector<std::string> texts(n_batch);
+        for (int i = 0; i < steps; i++) {
+            if (llm->abort.load()) {
+                break;
+            }
+            int active = 0;
+            for (int b = 0; b < n_batch; b++) {
+                active += i < slots[b].reply;
+            }
+            sleep_ms(decode_ms * (1.0 + batch_cost * (active - 1)));
+            for (int b = 0; b < n_batch; b++) {
+                // a slot that is done gets text NULL until the whole batch is
+                results[b].text = NULL;
+                results[b].token_id = -1;
+                if (i >= slots[b].reply) {
+                    continue;
+                }
+                const std::string& token = slots[b].tokens[i % slots[b].tokens.size()];
+                texts[b] = i > 0 && isalnum((unsigned char)token[0]) ? " " + token : token;
+                results[b].text = texts[b].c_str();
+                results[b].token_id = token_id(token);
+                llm->kv_size[b]++;
+                results[b].perf.generate_tokens = i + 1;
+                results[b].perf.generate_time_ms = (float)(now_ms() - t1);
+            }
+            if (llm->callback(results.data(), userdata, RKLLM_RUN_NORMAL) == 1) {
+                // paused, a later rkllm_run goes on from here
+                return 0;
+            }
+        }
+        for (int b = 0; b < n_batch; b++) {
+            results[b].text = NULL;
+            results[b].token_id = -1;
+        }
+    }
+
+    for (int b = 0; b < n_batch; b++) {
+        results[b].perf.memory_usage_mb = 1.0f + llm->kv_size[b] / 1024.0f;
+    }
+    llm->callback(results.data(), userdata, RKLLM_RUN_FINISH);
+    if (infer->keep_history == 0) {
+        std::fill(llm->kv_size.begin(), llm->kv_size.end(), llm->cached_tokens);
+    }
+    return ret;
+}
+
+extern "C" {
+
+RKLLMParam rkllm_createDefaultParam()
+{
+    RKLLMParam param;
+    memset(&param, 0, sizeof(param));
+    param.max_context_len = 512;
+    param.max_new_tokens = 512;
+    param.top_k = 1;
+    param.top_p = 0.9f;
+    param.temperature = 0.8f;
+    param.repeat_penalty = 1.1f;
+    param.skip_special_token = true;
+    param.extend_param.n_batch = 1;
+    return param;
+}
+
+int rkllm_init(LLMHandle* handle, RKLLMParam* param, LLMResultCallback callback)
+{
+    if (handle == NULL || param == NULL || callback == NULL) {
+        return -1;
+    }
+    if (param->model_path == NULL) {
+        printf("rkllm_stub: no model_path\n");
+        return -1;
+    }
+    FILE* fp = fopen(param->model_path, "rb");
+    if (fp == NULL) {
+        printf("rkllm_stub: open %s fail!\n", param->model_path);
+        return -1;
+    }
+    fclose(fp);
+
+    int n_batch = std::max(1, (int)param->extend_param.n_batch);
+    if (n_batch > env_int("RKLLM_STUB_MAX_BATCH", 8)) {
+        printf("rkllm_stub: n_batch %d is not supported\n", n_batch);
+        return -1;
+    }
+
+    stub_llm_t* llm = new stub_llm_t();
+    llm->magic = STUB_MAGIC;
+    llm->param = *param;
+    llm->model_path = param->model_path;
+    llm->param.model_path = llm->model_path.c_str();
+    llm->callback = callback;
+    llm->kv_size.assign(n_batch, 0);
+    llm->cached_tokens = 0;
+    llm->running = false;
+    llm->abort = false;
+    *handle = llm;
+    if (verbose()) {
+        printf("rkllm_stub: init %s max_context_len %d max_new_tokens %d n_batch %d\n", param->model_path,
+               param->max_context_len, param->max_new_tokens, n_batch);
+    }
+    return 0;
+}
+
+int rkllm_load_lora(LLMHandle handle, RKLLMLoraAdapter* lora_adapter)
+{
+    return get_llm(handle) != NULL && lora_adapter != NULL ? 0 : -1;
+}
+
+int rkllm_load_prompt_cache(LLMHandle handle, const char* prompt_cache_path)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL || prompt_cache_path == NULL) {
+        return -1;
+    }
+    FILE* fp = fopen(prompt_cache_path, "r");
+    if (fp == NULL) {
+        printf("rkllm_stub: open %s fail!\n", prompt_cache_path);
+        return -1;
+    }
+    char tag[64];
+    int tokens = 0;
+    int n = fscanf(fp, "%63s %d", tag, &tokens);
+    fclose(fp);
+    if (n != 2 || strcmp(tag, STUB_PROMPT_CACHE_TAG) != 0) {
+        printf("rkllm_stub: %s is not a prompt cache\n", prompt_cache_path);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lk(llm->run_lock);
+    llm->cached_tokens = tokens;
+    std::fill(llm->kv_size.begin(), llm->kv_size.end(), tokens);
+    return 0;
+}
+
+int rkllm_release_prompt_cache(LLMHandle handle)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lk(llm->run_lock);
+    llm->cached_tokens = 0;
+    return 0;
+}
+
+int rkllm_destroy(LLMHandle handle)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL) {
+        return -1;
+    }
+    llm->abort = true;
+    if (llm->async_worker.joinable()) {
+        llm->async_worker.join();
+    }
+    llm->magic = 0;
+    delete llm;
+    return 0;
+}
+
+int rkllm_run(LLMHandle handle, RKLLMInput* rkllm_input, RKLLMInferParam* rkllm_infer_params, void* userdata)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL || rkllm_input == NULL || rkllm_infer_params == NULL) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lk(llm->run_lock);
+    llm->running = true;
+    llm->abort = false;
+    int ret = run_locked(llm, rkllm_input, rkllm_infer_params, userdata);
+    llm->running = false;
+    return ret;
+}
+
+int rkllm_run_async(LLMHandle handle, RKLLMInput* rkllm_input, RKLLMInferParam* rkllm_infer_params, void* userdata)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL || rkllm_input == NULL || rkllm_infer_params == NULL) {
+        return -1;
+    }
+    if (llm->async_worker.joinable()) {
+        llm->async_worker.join();
+    }
+    // the caller's structures may be gone before the run starts
+    int n_batch = (int)llm->kv_size.size();
+    std::shared_ptr<std::vector<std::string>> prompts = std::make_shared<std::vector<std::string>>(n_batch);
+    std::vector<RKLLMInput> inputs(rkllm_input, rkllm_input + n_batch);
+    for (int b = 0; b < n_batch; b++) {
+        if (inputs[b].input_type == RKLLM_INPUT_PROMPT && inputs[b].prompt_input != NULL) {
+            (*prompts)[b] = inputs[b].prompt_input;
+        }
+    }
+    RKLLMInferParam infer = *rkllm_infer_params;
+    infer.prompt_cache_params = NULL;
+    llm->running = true;
+    llm->async_worker = std::thread([=]() mutable {
+        for (int b = 0; b < n_batch; b++) {
+            if (inputs[b].input_type == RKLLM_INPUT_PROMPT) {
+                inputs[b].prompt_input = (*prompts)[b].c_str();
+            }
+        }
+        rkllm_run(llm, inputs.data(), &infer, userdata);
+    });
+    return 0;
+}
+
+int rkllm_abort(LLMHandle handle)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL) {
+        return -1;
+    }
+    llm->abort = true;
+    return 0;
+}
+
+int rkllm_is_running(LLMHandle handle)
+{
+    stub_llm_t* llm = get_llm(handle);
+    return llm != NULL && llm->running.load() ? 0 : 1;
+}
+
+int rkllm_clear_kv_cache(LLMHandle handle, int keep_system_prompt, int* start_pos, int* end_pos)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL) {
+        return -1;
+    }
+    if (start_pos != NULL && end_pos != NULL) {
+        for (size_t b = 0; b < llm->kv_size.size(); b++) {
+            int end = std::min(end_pos[b], llm->kv_size[b]);
+            llm->kv_size[b] -= std::max(0, end - start_pos[b]);
+        }
+        return 0;
+    }
+    for (int& kv : llm->kv_size) {
+        kv = keep_system_prompt && kv > 0 ? count_tokens(llm->system_prompt) : 0;
+    }
+    return 0;
+}
+
+int rkllm_get_kv_cache_size(LLMHandle handle, int* cache_sizes)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL || cache_sizes == NULL) {
+        return -1;
+    }
+    std::copy(llm->kv_size.begin(), llm->kv_size.end(), cache_sizes);
+    return 0;
+}
+
+int rkllm_set_chat_template(LLMHandle handle, const char* system_prompt, const char* prompt_prefix,
+                            const char* prompt_postfix)
+{
+    stub_llm_t* llm = get_llm(handle);
+    if (llm == NULL) {
+        return -1;
+    }
+    llm->system_prompt = system_prompt != NULL ? system_prompt : "";
+    llm->prompt_prefix = prompt_prefix != NULL ? prompt_prefix : "";
+    llm->prompt_postfix = prompt_postfix != NULL ? prompt_postfix : "";
+    std::fill(llm->kv_size.begin(), llm->kv_size.end(), 0);
+    return 0;
+}
+
+int rkllm_set_function_tools(LLMHandle handle, const char* system_prompt, const char* tools, const char* tool_response_str)
+{
+    (void)tools;
+    (void)tool_response_str;
+    return rkllm_set_chat_template(handle, system_prompt, NULL, NULL);
+}
+
+int rkllm_set_cross_attn_params(LLMHandle handle, RKLLMCrossAttnParam* cross_attn_params)
+{
+    return get_llm(handle) != NULL && cross_attn_params != NULL ? 0 : -1;
+}
+
+}
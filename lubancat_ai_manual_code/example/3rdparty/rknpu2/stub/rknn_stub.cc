@@ -0,0 +1,1460 @@
+/*
+ * Host stub of librknnrt, built from rknn_api.h / rknn_matmul_api.h.
+ *
+ * It does not run the model. Tensor attributes come from a text sidecar, outputs
+ * are recorded frames or synthetic data, and rknn_run sleeps for a configurable
+ * time while holding the simulated NPU cores. Threading, buffer handling,
+ * pre/post process and end-to-end throughput of the demos can be profiled on an
+ * x86 Linux box.
+ *
+ * sidecar, one item per line, '#' starts a comment:
+ *
+ *   latency_ms 22.5                      # time of one rknn_run on one core
+ *   core_latency_ms 22.5 22.5 30         # optional, per core, also sets the core count
+ *   custom_string <text>                 # optional, RKNN_QUERY_CUSTOM_STRING
+ *   layer  <op_type> <target> <weight> [name]   # optional, repeated, RKNN_QUERY_PERF_DETAIL
+ *   mem_size <weight_bytes> <internal_bytes>   # optional, RKNN_QUERY_MEM_SIZE
+ *   input  <name> <dims> <fmt> <type> <qnt> <zp> <scale>
+ *   output <name> <dims> <fmt> <type> <qnt> <zp> <scale> [data_file]
+ *
+ *   dims: 1,640,640,3   fmt: NCHW NHWC NC1HWC2 UNDEFINED
+ *   type: FP32 FP16 INT8 UINT8 INT16 UINT16 INT32 UINT32 INT64 BOOL
+ *   qnt:  NONE DFP AFFINE
+ *
+ * data_file holds one or more frames of the output in its native type (attr.size
+ * bytes each), relative paths are resolved against the sidecar directory. The
+ * frames are returned in turn, one per rknn_run. Without data_file the output is
+ * zero with sparse pseudo random values (RKNN_STUB_DENSITY, default 0.001).
+ *
+ * rknn_init finds the sidecar as follows:
+ *   - size == 0 (model is a path): "<path>.stub", then the path itself
+ *   - model buffer starting with "# rknn_stub": the buffer itself, so a demo can be
+ *     started with the sidecar in place of the .rknn file
+ *   - otherwise $RKNN_STUB_SIDECAR
+ *
+ * environment: RKNN_STUB_SIDECAR, RKNN_STUB_DATA_DIR (base of relative data
+ * files for buffer-loaded sidecars), RKNN_STUB_LATENCY_MS (overrides all cores),
+ * RKNN_STUB_CORES, RKNN_STUB_DENSITY, RKNN_STUB_VERBOSE.
+ *
+ * Cores are a shared resource of the process: RKNN_NPU_CORE_AUTO takes any free
+ * core, a fixed mask waits for exactly those cores, multi-core masks divide the
+ * latency by the core count. Runs of one context are serialized like on the board.
+ *
+ * RKNN_FLAG_ASYNC_MASK: rknn_run returns at once, rknn_outputs_get does not wait for
+ * the run in flight but returns the outputs of the frame before it (frame_id in
+ * rknn_output_extend). Only right after the first run it waits for that run.
+ *
+ * RKNN_FLAG_FENCE_IN_OUTSIDE: the run starts once rknn_run_extend.fence_fd is
+ * readable (a sync_file or an eventfd CPU fence), rknn_run does not wait for it if
+ * the run is non-blocking. RKNN_FLAG_FENCE_OUT_OUTSIDE: rknn_run returns at once
+ * and hands out an eventfd in fence_fd that is signaled when the outputs are written.
+ * The caller keeps and closes its fences, the stub works on copies.
+ *
+ * RKNN_FLAG_COLLECT_PERF_MASK: RKNN_QUERY_PERF_DETAIL returns the layer table of the
+ * runtime for the last run, the run time split over the sidecar layers by weight
+ * (one "Model" layer without them).
+ *
+ * RKNN_QUERY_MEM_SIZE: the sidecar weight / internal sizes; the DMA total adds the
+ * input and output tensors, and leaves out the weight of a context that shares it
+ * (rknn_dup_context, RKNN_FLAG_SHARE_WEIGHT_MEM). A context initialized with
+ * RKNN_FLAG_COLLECT_MODEL_INFO_ONLY allocates nothing, its DMA total is 0.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rknn_api.h"
+#include "rknn_matmul_api.h"
+#include "rknn_custom_op.h"
+#include "Float16.h"
+
+#define STUB_MAX_CORES 8
+#define STUB_MAGIC_MODEL 0x52534d44
+#define STUB_MAGIC_MATMUL 0x52534d4d
+#define STUB_SIDECAR_TAG "# rknn_stub"
+#define STUB_SYNTH_FRAMES 4
+
+typedef struct {
+    rknn_tensor_attr attr;
+    std::vector<uint8_t> frames;   // n_frames * attr.size
+    uint32_t n_frames;
+} stub_tensor_t;
+
+typedef struct {
+    std::string op_type;
+    std::string target;     // NPU / CPU
+    std::string name;
+    double weight;          // share of the run time
+} stub_layer_t;
+
+typedef struct {
+    std::vector<stub_tensor_t> inputs;
+    std::vector<stub_tensor_t> outputs;
+    double core_latency_ms[STUB_MAX_CORES];
+    int n_cores;
+    std::string custom_string;
+    std::vector<stub_layer_t> layers;
+    uint32_t weight_size;
+    uint32_t internal_size;
+} stub_model_t;
+
+typedef struct {
+    uint32_t magic;
+    std::shared_ptr<stub_model_t> model;
+    uint32_t flag;
+    rknn_core_mask core_mask;
+
+    std::vector<rknn_tensor_attr> input_attrs;   // current shapes, rknn_set_input_shapes
+    std::vector<std::vector<uint8_t>> input_bufs;
+    std::vector<rknn_tensor_mem*> input_mems;
+    std::vector<rknn_tensor_mem*> output_mems;
+    std::vector<rknn_tensor_attr> output_mem_attrs;
+
+    std::mutex run_mutex;
+    std::thread worker;           // in flight non-blocking run
+    uint64_t frame_id;            // frame of the last finished run
+    uint64_t submitted;           // frame of the last rknn_run
+    int64_t run_duration_us;
+    bool weight_shared;           // rknn_dup_context / RKNN_FLAG_SHARE_WEIGHT_MEM
+    std::string perf_detail;      // RKNN_QUERY_PERF_DETAIL, valid until the next query
+} stub_ctx_t;
+
+typedef struct {
+    uint32_t magic;
+    rknn_matmul_info info;
+    rknn_matmul_io_attr io_attr;
+    rknn_tensor_mem* A;
+    rknn_tensor_mem* B;
+    rknn_tensor_mem* C;
+    rknn_core_mask core_mask;
+} stub_matmul_t;
+
+/*-------------------------------------------
+                 NPU cores
+-------------------------------------------*/
+
+static struct {
+    std::mutex lock;
+    std::condition_variable cv;
+    bool busy[STUB_MAX_CORES];
+} g_npu;
+
+static std::mutex g_ctx_lock;
+static std::set<void*> g_contexts;
+
+static int env_int(const char* name, int def)
+{
+    const char* v = getenv(name);
+    return v != NULL && v[0] != '\0' ? atoi(v) : def;
+}
+
+static double env_double(const char* name, double def)
+{
+    const char* v = getenv(name);
+    return v != NULL && v[0] != '\0' ? atof(v) : def;
+}
+
+static bool verbose()
+{
+    static int v = env_int("RKNN_STUB_VERBOSE", 0);
+    return v != 0;
+}
+
+// bit mask of the cores the run has to hold, 0 means any single free core
+static uint32_t cores_of_mask(rknn_core_mask mask, int n_cores)
+{
+    uint32_t all = (1u << n_cores) - 1;
+    if (mask == RKNN_NPU_CORE_AUTO) {
+        return 0;
+    }
+    if (mask == RKNN_NPU_CORE_ALL) {
+        return all;
+    }
+    // masks naming only cores the stub does not have fall back to any core
+    return (uint32_t)mask & all;
+}
+
+static uint32_t acquire_cores(uint32_t wanted, int n_cores)
+{
+    std::unique_lock<std::mutex> lk(g_npu.lock);
+    uint32_t got = 0;
+    g_npu.cv.wait(lk, [&] {
+        if (wanted == 0) {
+            for (int i = 0; i < n_cores; i++) {
+                if (!g_npu.busy[i]) {
+                    got = 1u << i;
+                    return true;
+                }
+            }
+            return false;
+        }
+        for (int i = 0; i < n_cores; i++) {
+            if ((wanted & (1u << i)) && g_npu.busy[i]) {
+                return false;
+            }
+        }
+        got = wanted;
+        return true;
+    });
+    for (int i = 0; i < n_cores; i++) {
+        if (got & (1u << i)) {
+            g_npu.busy[i] = true;
+        }
+    }
+    return got;
+}
+
+static void release_cores(uint32_t cores, int n_cores)
+{
+    {
+        std::lock_guard<std::mutex> lk(g_npu.lock);
+        for (int i = 0; i < n_cores; i++) {
+            if (cores & (1u << i)) {
+                g_npu.busy[i] = false;
+            }
+        }
+    }
+    g_npu.cv.notify_all();
+}
+
+// hold the cores for the simulated time, returns the elapsed time in us
+static int64_t simulate_npu(const double* core_latency_ms, int n_cores, rknn_core_mask mask)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint32_t cores = acquire_cores(cores_of_mask(mask, n_cores), n_cores);
+    double latency_ms = 0;
+    int used = 0;
+    for (int i = 0; i < n_cores; i++) {
+        if (cores & (1u << i)) {
+            latency_ms = core_latency_ms[i] > latency_ms ? core_latency_ms[i] : latency_ms;
+            used++;
+        }
+    }
+    if (used > 1) {
+        latency_ms /= used;
+    }
+    if (latency_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(latency_ms * 1000)));
+    }
+    release_cores(cores, n_cores);
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*-------------------------------------------
+                 sidecar
+-------------------------------------------*/
+
+static uint32_t type_size(rknn_tensor_type type)
+{
+    switch (type) {
+    case RKNN_TENSOR_FLOAT32:
+    case RKNN_TENSOR_INT32:
+    case RKNN_TENSOR_UINT32:
+        return 4;
+    case RKNN_TENSOR_FLOAT16:
+    case RKNN_TENSOR_INT16:
+    case RKNN_TENSOR_UINT16:
+    case RKNN_TENSOR_BFLOAT16:
+        return 2;
+    case RKNN_TENSOR_INT64:
+        return 8;
+    default:
+        return 1;
+    }
+}
+
+static int parse_type(const std::string& s, rknn_tensor_type* type)
+{
+    static const struct { const char* name; rknn_tensor_type type; } types[] = {
+        {"FP32", RKNN_TENSOR_FLOAT32}, {"FLOAT32", RKNN_TENSOR_FLOAT32}, {"FP16", RKNN_TENSOR_FLOAT16},
+        {"FLOAT16", RKNN_TENSOR_FLOAT16}, {"INT8", RKNN_TENSOR_INT8}, {"UINT8", RKNN_TENSOR_UINT8},
+        {"INT16", RKNN_TENSOR_INT16}, {"UINT16", RKNN_TENSOR_UINT16}, {"INT32", RKNN_TENSOR_INT32},
+        {"UINT32", RKNN_TENSOR_UINT32}, {"INT64", RKNN_TENSOR_INT64}, {"BOOL", RKNN_TENSOR_BOOL},
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (s == types[i].name) {
+            *type = types[i].type;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int parse_fmt(const std::string& s, rknn_tensor_format* fmt)
+{
+    if (s == "NCHW") {
+        *fmt = RKNN_TENSOR_NCHW;
+    } else if (s == "NHWC") {
+        *fmt = RKNN_TENSOR_NHWC;
+    } else if (s == "NC1HWC2") {
+        *fmt = RKNN_TENSOR_NC1HWC2;
+    } else if (s == "UNDEFINED") {
+        *fmt = RKNN_TENSOR_UNDEFINED;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static int parse_qnt(const std::string& s, rknn_tensor_qnt_type* qnt)
+{
+    if (s == "NONE") {
+        *qnt = RKNN_TENSOR_QNT_NONE;
+    } else if (s == "DFP") {
+        *qnt = RKNN_TENSOR_QNT_DFP;
+    } else if (s == "AFFINE") {
+        *qnt = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static void update_attr_size(rknn_tensor_attr* attr)
+{
+    attr->n_elems = 1;
+    for (uint32_t i = 0; i < attr->n_dims; i++) {
+        attr->n_elems *= attr->dims[i];
+    }
+    attr->size = attr->n_elems * type_size(attr->type);
+    attr->size_with_stride = attr->size;
+    attr->w_stride = 0;
+    attr->h_stride = 0;
+}
+
+// the value 0.0 in the tensor type, the background of synthetic outputs
+static void fill_zero(const rknn_tensor_attr* attr, uint8_t* buf)
+{
+    if ((attr->type == RKNN_TENSOR_INT8 || attr->type == RKNN_TENSOR_UINT8) &&
+        attr->qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC) {
+        memset(buf, (uint8_t)attr->zp, attr->size);
+    } else {
+        memset(buf, 0, attr->size);
+    }
+}
+
+static void make_synthetic(stub_tensor_t* t)
+{
+    const rknn_tensor_attr* attr = &t->attr;
+    double density = env_double("RKNN_STUB_DENSITY", 0.001);
+    uint32_t hits = (uint32_t)(attr->n_elems * density);
+    uint32_t elem = type_size(attr->type);
+    uint32_t seed = 0x9e3779b9u ^ (attr->index * 0x85ebca6bu);
+
+    t->n_frames = STUB_SYNTH_FRAMES;
+    t->frames.resize((size_t)attr->size * t->n_frames);
+    for (uint32_t f = 0; f < t->n_frames; f++) {
+        uint8_t* buf = t->frames.data() + (size_t)attr->size * f;
+        fill_zero(attr, buf);
+        for (uint32_t h = 0; h < hits; h++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            uint32_t pos = seed % attr->n_elems;
+            float v = (float)((seed >> 8) & 0xffff) / 65535.0f;   // [0, 1]
+            uint8_t* p = buf + (size_t)pos * elem;
+            switch (attr->type) {
+            case RKNN_TENSOR_FLOAT32:
+                *(float*)p = v * 8.0f - 4.0f;
+                break;
+            case RKNN_TENSOR_FLOAT16:
+                *(rknpu2::float16*)p = rknpu2::float16(v * 8.0f - 4.0f);
+                break;
+            default:
+                for (uint32_t b = 0; b < elem; b++) {
+                    p[b] = (uint8_t)(seed >> (b * 8));
+                }
+                break;
+            }
+        }
+    }
+}
+
+static int load_frames(stub_tensor_t* t, const std::string& path)
+{
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        printf("rknn_stub: open %s fail!\n", path.c_str());
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (t->attr.size == 0 || file_size < (long)t->attr.size) {
+        printf("rknn_stub: %s has %ld bytes, one frame of %s needs %u\n", path.c_str(), file_size, t->attr.name,
+               t->attr.size);
+        fclose(fp);
+        return -1;
+    }
+    t->n_frames = (uint32_t)(file_size / t->attr.size);
+    t->frames.resize((size_t)t->n_frames * t->attr.size);
+    size_t n = fread(t->frames.data(), 1, t->frames.size(), fp);
+    fclose(fp);
+    if (n != t->frames.size()) {
+        printf("rknn_stub: read %s fail!\n", path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+static int parse_tensor(std::istringstream& ss, uint32_t index, const std::string& base_dir, stub_tensor_t* t,
+                        bool is_output)
+{
+    std::string name, dims, fmt, type, qnt, file;
+    double zp = 0, scale = 1;
+    if (!(ss >> name >> dims >> fmt >> type >> qnt >> zp >> scale)) {
+        return -1;
+    }
+    memset(&t->attr, 0, sizeof(rknn_tensor_attr));
+    t->attr.index = index;
+    strncpy(t->attr.name, name.c_str(), RKNN_MAX_NAME_LEN - 1);
+    std::istringstream ds(dims);
+    std::string d;
+    while (std::getline(ds, d, ',') && t->attr.n_dims < RKNN_MAX_DIMS) {
+        t->attr.dims[t->attr.n_dims++] = (uint32_t)atoi(d.c_str());
+    }
+    if (t->attr.n_dims == 0 || parse_fmt(fmt, &t->attr.fmt) != 0 || parse_type(type, &t->attr.type) != 0 ||
+        parse_qnt(qnt, &t->attr.qnt_type) != 0) {
+        return -1;
+    }
+    t->attr.zp = (int32_t)zp;
+    t->attr.scale = (float)scale;
+    update_attr_size(&t->attr);
+
+    t->n_frames = 0;
+    if (!is_output) {
+        return 0;
+    }
+    if (ss >> file) {
+        if (file[0] != '/' && !base_dir.empty()) {
+            file = base_dir + "/" + file;
+        }
+        return load_frames(t, file);
+    }
+    make_synthetic(t);
+    return 0;
+}
+
+static int parse_sidecar(const std::string& text, const std::string& base_dir, stub_model_t* model)
+{
+    std::istringstream in(text);
+    std::string line;
+    int line_no = 0;
+    double latency_ms = 0;
+
+    model->n_cores = 0;
+    model->weight_size = 0;
+    model->internal_size = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.resize(hash);
+        }
+        std::istringstream ss(line);
+        std::string key;
+        if (!(ss >> key)) {
+            continue;
+        }
+        int ret = 0;
+        if (key == "latency_ms") {
+            ret = (ss >> latency_ms) ? 0 : -1;
+        } else if (key == "core_latency_ms") {
+            double v;
+            while (model->n_cores < STUB_MAX_CORES && ss >> v) {
+                model->core_latency_ms[model->n_cores++] = v;
+            }
+            ret = model->n_cores > 0 ? 0 : -1;
+        } else if (key == "custom_string") {
+            std::getline(ss >> std::ws, model->custom_string);
+        } else if (key == "layer") {
+            stub_layer_t l;
+            ret = (ss >> l.op_type >> l.target >> l.weight) && l.weight >= 0 ? 0 : -1;
+            if (!(ss >> l.name)) {
+                l.name = l.op_type + ":" + std::to_string(model->layers.size() + 1);
+            }
+            model->layers.push_back(l);
+        } else if (key == "mem_size") {
+            ret = (ss >> model->weight_size >> model->internal_size) ? 0 : -1;
+        } else if (key == "input") {
+            stub_tensor_t t;
+            ret = parse_tensor(ss, (uint32_t)model->inputs.size(), base_dir, &t, false);
+            model->inputs.push_back(t);
+        } else if (key == "output") {
+            stub_tensor_t t;
+            ret = parse_tensor(ss, (uint32_t)model->outputs.size(), base_dir, &t, true);
+            model->outputs.push_back(t);
+        } else {
+            ret = -1;
+        }
+        if (ret != 0) {
+            printf("rknn_stub: sidecar line %d invalid: %s\n", line_no, line.c_str());
+            return -1;
+        }
+    }
+    if (model->inputs.empty() || model->outputs.empty()) {
+        printf("rknn_stub: sidecar needs at least one input and one output\n");
+        return -1;
+    }
+
+    if (model->n_cores == 0) {
+        model->n_cores = env_int("RKNN_STUB_CORES", 3);
+        if (model->n_cores < 1 || model->n_cores > STUB_MAX_CORES) {
+            model->n_cores = 3;
+        }
+        for (int i = 0; i < model->n_cores; i++) {
+            model->core_latency_ms[i] = latency_ms;
+        }
+    }
+    double env_latency = env_double("RKNN_STUB_LATENCY_MS", -1);
+    if (env_latency >= 0) {
+        for (int i = 0; i < model->n_cores; i++) {
+            model->core_latency_ms[i] = env_latency;
+        }
+    }
+    return 0;
+}
+
+static bool read_text_file(const std::string& path, std::string* text)
+{
+    std::ifstream f(path.c_str());
+    if (!f) {
+        return false;
+    }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    *text = ss.str();
+    return true;
+}
+
+static std::string dir_of(const std::string& path)
+{
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+static int load_model(void* model, uint32_t size, stub_model_t* out)
+{
+    std::string text;
+    std::string path;
+    if (size == 0) {
+        path = (const char*)model;
+        if (!read_text_file(path + ".stub", &text)) {
+            if (!read_text_file(path, &text) || text.compare(0, strlen(STUB_SIDECAR_TAG), STUB_SIDECAR_TAG) != 0) {
+                printf("rknn_stub: no sidecar %s.stub\n", path.c_str());
+                return -1;
+            }
+        } else {
+            path += ".stub";
+        }
+    } else if (size >= strlen(STUB_SIDECAR_TAG) && memcmp(model, STUB_SIDECAR_TAG, strlen(STUB_SIDECAR_TAG)) == 0) {
+        text.assign((const char*)model, size);
+        const char* data_dir = getenv("RKNN_STUB_DATA_DIR");
+        path = std::string(data_dir != NULL ? data_dir : ".") + "/";
+    } else {
+        const char* sidecar = getenv("RKNN_STUB_SIDECAR");
+        if (sidecar == NULL || !read_text_file(sidecar, &text)) {
+            printf("rknn_stub: model is not a sidecar, set RKNN_STUB_SIDECAR=<model>.stub\n");
+            return -1;
+        }
+        path = sidecar;
+    }
+    return parse_sidecar(text, dir_of(path), out);
+}
+
+/*-------------------------------------------
+                 contexts
+-------------------------------------------*/
+
+static void register_ctx(void* p)
+{
+    std::lock_guard<std::mutex> lk(g_ctx_lock);
+    g_contexts.insert(p);
+}
+
+static void unregister_ctx(void* p)
+{
+    std::lock_guard<std::mutex> lk(g_ctx_lock);
+    g_contexts.erase(p);
+}
+
+static stub_ctx_t* get_ctx(rknn_context context)
+{
+    void* p = (void*)(uintptr_t)context;
+    std::lock_guard<std::mutex> lk(g_ctx_lock);
+    if (g_contexts.count(p) == 0 || ((stub_ctx_t*)p)->magic != STUB_MAGIC_MODEL) {
+        return NULL;
+    }
+    return (stub_ctx_t*)p;
+}
+
+static stub_matmul_t* get_matmul(rknn_matmul_ctx context)
+{
+    void* p = (void*)(uintptr_t)context;
+    std::lock_guard<std::mutex> lk(g_ctx_lock);
+    if (g_contexts.count(p) == 0 || ((stub_matmul_t*)p)->magic != STUB_MAGIC_MATMUL) {
+        return NULL;
+    }
+    return (stub_matmul_t*)p;
+}
+
+static stub_ctx_t* create_ctx(std::shared_ptr<stub_model_t> model, uint32_t flag)
+{
+    stub_ctx_t* ctx = new stub_ctx_t();
+    ctx->magic = STUB_MAGIC_MODEL;
+    ctx->model = model;
+    ctx->flag = flag;
+    ctx->core_mask = RKNN_NPU_CORE_AUTO;
+    ctx->frame_id = 0;
+    ctx->submitted = 0;
+    ctx->run_duration_us = 0;
+    ctx->weight_shared = false;
+    for (size_t i = 0; i < model->inputs.size(); i++) {
+        ctx->input_attrs.push_back(model->inputs[i].attr);
+        ctx->input_bufs.push_back(std::vector<uint8_t>(model->inputs[i].attr.size));
+    }
+    ctx->input_mems.assign(model->inputs.size(), NULL);
+    ctx->output_mems.assign(model->outputs.size(), NULL);
+    ctx->output_mem_attrs.resize(model->outputs.size());
+    register_ctx(ctx);
+    return ctx;
+}
+
+static float to_float(const rknn_tensor_attr* attr, const uint8_t* p)
+{
+    switch (attr->type) {
+    case RKNN_TENSOR_FLOAT32:
+        return *(const float*)p;
+    case RKNN_TENSOR_FLOAT16:
+        return (float)*(const rknpu2::float16*)p;
+    case RKNN_TENSOR_INT8:
+        if (attr->qnt_type == RKNN_TENSOR_QNT_DFP) {
+            return ldexpf((float)*(const int8_t*)p, -attr->fl);
+        }
+        return ((float)*(const int8_t*)p - attr->zp) * attr->scale;
+    case RKNN_TENSOR_UINT8:
+        return ((float)*p - attr->zp) * attr->scale;
+    case RKNN_TENSOR_INT16:
+        return (float)*(const int16_t*)p;
+    case RKNN_TENSOR_UINT16:
+        return (float)*(const uint16_t*)p;
+    case RKNN_TENSOR_INT32:
+        return (float)*(const int32_t*)p;
+    case RKNN_TENSOR_UINT32:
+        return (float)*(const uint32_t*)p;
+    case RKNN_TENSOR_INT64:
+        return (float)*(const int64_t*)p;
+    default:
+        return (float)*p;
+    }
+}
+
+// copy one output into a user buffer, dequantized when want_float
+static void copy_output(const rknn_tensor_attr* attr, const uint8_t* src, void* dst, uint32_t dst_size,
+                        bool want_float)
+{
+    if (!want_float || attr->type == RKNN_TENSOR_FLOAT32) {
+        memcpy(dst, src, dst_size < attr->size ? dst_size : attr->size);
+        return;
+    }
+    uint32_t n = dst_size / sizeof(float) < attr->n_elems ? dst_size / sizeof(float) : attr->n_elems;
+    uint32_t elem = type_size(attr->type);
+    float* out = (float*)dst;
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = to_float(attr, src + (size_t)i * elem);
+    }
+}
+
+static const uint8_t* output_frame(const stub_model_t* model, uint32_t index, uint64_t frame_id)
+{
+    const stub_tensor_t* t = &model->outputs[index];
+    return t->frames.data() + (size_t)((frame_id - 1) % t->n_frames) * t->attr.size;
+}
+
+// one inference: hold the cores, then write the bound output memories
+static void run_once(stub_ctx_t* ctx)
+{
+    const stub_model_t* model = ctx->model.get();
+    int64_t us = simulate_npu(model->core_latency_ms, model->n_cores, ctx->core_mask);
+    uint64_t frame_id = ctx->frame_id + 1;
+    for (size_t i = 0; i < model->outputs.size(); i++) {
+        rknn_tensor_mem* mem = ctx->output_mems[i];
+        if (mem == NULL || mem->virt_addr == NULL) {
+            continue;
+        }
+        const rknn_tensor_attr* attr = &model->outputs[i].attr;
+        bool want_float = ctx->output_mem_attrs[i].type == RKNN_TENSOR_FLOAT32;
+        copy_output(attr, output_frame(model, (uint32_t)i, frame_id), (uint8_t*)mem->virt_addr + mem->offset,
+                    mem->size, want_float);
+    }
+    ctx->run_duration_us = us;
+    ctx->frame_id = frame_id;
+    if (verbose()) {
+        printf("rknn_stub: ctx %p frame %llu run %lld us\n", (void*)ctx, (unsigned long long)frame_id, (long long)us);
+    }
+}
+
+static void wait_fence(int fd)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR) {
+    }
+}
+
+// run_once between the fence of the input producer and the fence handed out
+static void run_fenced(stub_ctx_t* ctx, int in_fence, int out_fence)
+{
+    if (in_fence >= 0) {
+        wait_fence(in_fence);
+        close(in_fence);
+    }
+    run_once(ctx);
+    if (out_fence >= 0) {
+        uint64_t one = 1;
+        if (write(out_fence, &one, sizeof(one)) != sizeof(one)) {
+            printf("rknn_stub: signal fence fail! %s\n", strerror(errno));
+        }
+        close(out_fence);
+    }
+}
+
+static void wait_ctx(stub_ctx_t* ctx)
+{
+    if (ctx->worker.joinable()) {
+        ctx->worker.join();
+    }
+}
+
+static int query_attr(const std::vector<rknn_tensor_attr>& attrs, void* info, uint32_t size)
+{
+    if (size < sizeof(rknn_tensor_attr)) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    rknn_tensor_attr* attr = (rknn_tensor_attr*)info;
+    if (attr->index >= attrs.size()) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    *attr = attrs[attr->index];
+    return RKNN_SUCC;
+}
+
+// same columns as the table of librknnrt 2.x, shapes and cycles are not modeled
+static std::string format_perf_detail(const stub_model_t* model, int64_t run_us)
+{
+    std::vector<stub_layer_t> layers = model->layers;
+    if (layers.empty()) {
+        stub_layer_t l = {"Model", "NPU", "Model:stub", 1.0};
+        layers.push_back(l);
+    }
+    double total_weight = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        total_weight += layers[i].weight;
+    }
+    std::string line(120, '-');
+    std::ostringstream out;
+    char row[512];
+    out << line << "\n" << "                              Network Layer Information Table\n" << line << "\n";
+    snprintf(row, sizeof(row), "%-5s%-17s%-9s%-7s%-12s%-12s%-25s%-13s%-13s%-21s%-13s%s\n", "ID", "OpType", "DataType",
+             "Target", "InputShape", "OutputShape", "Cycles(DDR/NPU/Total)", "Time(us)", "MacUsage(%)",
+             "WorkLoad(0/1/2)", "RW(KB)", "FullName");
+    out << row << line << "\n";
+    int64_t total_us = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        int64_t us = total_weight > 0 ? (int64_t)(run_us * layers[i].weight / total_weight + 0.5) : 0;
+        total_us += us;
+        snprintf(row, sizeof(row), "%-5zu%-17s%-9s%-7s%-12s%-12s%-25s%-13lld%-13s%-21s%-13s%s\n", i + 1,
+                 layers[i].op_type.c_str(), "INT8", layers[i].target.c_str(), "\\", "\\", "0/0/0", (long long)us,
+                 "\\", "100.0%/0.0%/0.0%", "0", layers[i].name.c_str());
+        out << row;
+    }
+    out << line << "\n" << "Total Operator Elapsed Per Frame Time(us): " << total_us << "\n" << line << "\n";
+    return out.str();
+}
+
+/*-------------------------------------------
+                 rknn_api.h
+-------------------------------------------*/
+
+int rknn_init(rknn_context* context, void* model, uint32_t size, uint32_t flag, rknn_init_extend* extend)
+{
+    if (context == NULL || model == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    std::shared_ptr<stub_model_t> m = std::make_shared<stub_model_t>();
+    if (load_model(model, size, m.get()) != 0) {
+        return RKNN_ERR_MODEL_INVALID;
+    }
+    stub_ctx_t* ctx = create_ctx(m, flag);
+    ctx->weight_shared = (flag & RKNN_FLAG_SHARE_WEIGHT_MEM) && extend != NULL && get_ctx(extend->ctx) != NULL;
+    *context = (rknn_context)(uintptr_t)ctx;
+    if (verbose()) {
+        printf("rknn_stub: init ctx %p, %zu inputs, %zu outputs, %d cores\n", (void*)ctx, m->inputs.size(),
+               m->outputs.size(), m->n_cores);
+    }
+    return RKNN_SUCC;
+}
+
+int rknn_dup_context(rknn_context* context_in, rknn_context* context_out)
+{
+    if (context_in == NULL || context_out == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    stub_ctx_t* src = get_ctx(*context_in);
+    if (src == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    stub_ctx_t* ctx = create_ctx(src->model, src->flag);
+    ctx->weight_shared = true;
+    *context_out = (rknn_context)(uintptr_t)ctx;
+    return RKNN_SUCC;
+}
+
+int rknn_destroy(rknn_context context)
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    unregister_ctx(ctx);
+    wait_ctx(ctx);
+    delete ctx;
+    return RKNN_SUCC;
+}
+
+int rknn_query(rknn_context context, rknn_query_cmd cmd, void* info, uint32_t size)
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    if (info == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    const stub_model_t* model = ctx->model.get();
+    std::vector<rknn_tensor_attr> output_attrs;
+    for (size_t i = 0; i < model->outputs.size(); i++) {
+        output_attrs.push_back(model->outputs[i].attr);
+    }
+
+    switch (cmd) {
+    case RKNN_QUERY_IN_OUT_NUM: {
+        if (size < sizeof(rknn_input_output_num)) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        rknn_input_output_num* num = (rknn_input_output_num*)info;
+        num->n_input = (uint32_t)model->inputs.size();
+        num->n_output = (uint32_t)model->outputs.size();
+        return RKNN_SUCC;
+    }
+    // the stub keeps every tensor in its sidecar layout, native == normal
+    case RKNN_QUERY_INPUT_ATTR:
+    case RKNN_QUERY_NATIVE_INPUT_ATTR:
+    case RKNN_QUERY_NATIVE_NHWC_INPUT_ATTR:
+    case RKNN_QUERY_CURRENT_INPUT_ATTR:
+    case RKNN_QUERY_CURRENT_NATIVE_INPUT_ATTR:
+        return query_attr(ctx->input_attrs, info, size);
+    case RKNN_QUERY_OUTPUT_ATTR:
+    case RKNN_QUERY_NATIVE_OUTPUT_ATTR:
+    case RKNN_QUERY_NATIVE_NHWC_OUTPUT_ATTR:
+    case RKNN_QUERY_CURRENT_OUTPUT_ATTR:
+    case RKNN_QUERY_CURRENT_NATIVE_OUTPUT_ATTR:
+        return query_attr(output_attrs, info, size);
+    case RKNN_QUERY_PERF_RUN: {
+        if (size < sizeof(rknn_perf_run)) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        ((rknn_perf_run*)info)->run_duration = ctx->run_duration_us;
+        return RKNN_SUCC;
+    }
+    case RKNN_QUERY_PERF_DETAIL: {
+        if (size < sizeof(rknn_perf_detail)) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        if (!(ctx->flag & RKNN_FLAG_COLLECT_PERF_MASK)) {
+            printf("rknn_stub: RKNN_QUERY_PERF_DETAIL needs RKNN_FLAG_COLLECT_PERF_MASK at rknn_init\n");
+            return RKNN_ERR_FAIL;
+        }
+        ctx->perf_detail = format_perf_detail(model, ctx->run_duration_us);
+        rknn_perf_detail* detail = (rknn_perf_detail*)info;
+        detail->perf_data = (char*)ctx->perf_detail.c_str();
+        detail->data_len = ctx->perf_detail.size();
+        return RKNN_SUCC;
+    }
+    case RKNN_QUERY_SDK_VERSION: {
+        if (size < sizeof(rknn_sdk_version)) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        rknn_sdk_version* version = (rknn_sdk_version*)info;
+        snprintf(version->api_version, sizeof(version->api_version), "stub (rknn_api.h)");
+        snprintf(version->drv_version, sizeof(version->drv_version), "stub");
+        return RKNN_SUCC;
+    }
+    case RKNN_QUERY_MEM_SIZE: {
+        if (size < sizeof(rknn_mem_size)) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        rknn_mem_size* mem = (rknn_mem_size*)info;
+        memset(mem, 0, sizeof(rknn_mem_size));
+        mem->total_weight_size = model->weight_size;
+        mem->total_internal_size = model->internal_size;
+        if (!(ctx->flag & RKNN_FLAG_COLLECT_MODEL_INFO_ONLY)) {
+            uint64_t io_size = 0;
+            for (size_t i = 0; i < model->inputs.size(); i++) {
+                io_size += model->inputs[i].attr.size;
+            }
+            for (size_t i = 0; i < model->outputs.size(); i++) {
+                io_size += model->outputs[i].attr.size;
+            }
+            mem->total_dma_allocated_size =
+                (ctx->weight_shared ? 0 : (uint64_t)model->weight_size) + model->internal_size + io_size;
+        }
+        return RKNN_SUCC;
+    }
+    case RKNN_QUERY_CUSTOM_STRING: {
+        if (size < sizeof(rknn_custom_string)) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        rknn_custom_string* custom = (rknn_custom_string*)info;
+        snprintf(custom->string, sizeof(custom->string), "%s", model->custom_string.c_str());
+        return RKNN_SUCC;
+    }
+    default:
+        return RKNN_ERR_PARAM_INVALID;
+    }
+}
+
+int rknn_inputs_set(rknn_context context, uint32_t n_inputs, rknn_input inputs[])
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    if (inputs == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    for (uint32_t i = 0; i < n_inputs; i++) {
+        if (inputs[i].index >= ctx->input_bufs.size() || inputs[i].buf == NULL) {
+            printf("rknn_stub: invalid input %u\n", inputs[i].index);
+            return RKNN_ERR_INPUT_INVALID;
+        }
+        // no type / layout conversion, the copy stands in for the upload to the NPU
+        std::vector<uint8_t>& buf = ctx->input_bufs[inputs[i].index];
+        if (buf.size() < inputs[i].size) {
+            buf.resize(inputs[i].size);
+        }
+        memcpy(buf.data(), inputs[i].buf, inputs[i].size);
+    }
+    return RKNN_SUCC;
+}
+
+int rknn_set_batch_core_num(rknn_context context, int core_num)
+{
+    (void)core_num;
+    return get_ctx(context) != NULL ? RKNN_SUCC : RKNN_ERR_CTX_INVALID;
+}
+
+int rknn_set_core_mask(rknn_context context, rknn_core_mask core_mask)
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    ctx->core_mask = core_mask;
+    return RKNN_SUCC;
+}
+
+int rknn_run(rknn_context context, rknn_run_extend* extend)
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    std::lock_guard<std::mutex> lk(ctx->run_mutex);
+    wait_ctx(ctx);
+    bool non_block = (extend != NULL && extend->non_block != 0) ||
+                     (ctx->flag & (RKNN_FLAG_ASYNC_MASK | RKNN_FLAG_FENCE_OUT_OUTSIDE));
+    int in_fence = -1;
+    if ((ctx->flag & RKNN_FLAG_FENCE_IN_OUTSIDE) && extend != NULL && extend->fence_fd >= 0) {
+        in_fence = dup(extend->fence_fd);
+        if (in_fence < 0) {
+            printf("rknn_stub: dup fence %d fail! %s\n", extend->fence_fd, strerror(errno));
+            return RKNN_ERR_PARAM_INVALID;
+        }
+    }
+    int out_fence = -1;
+    if ((ctx->flag & RKNN_FLAG_FENCE_OUT_OUTSIDE) && extend != NULL) {
+        extend->fence_fd = eventfd(0, EFD_CLOEXEC);
+        out_fence = extend->fence_fd >= 0 ? dup(extend->fence_fd) : -1;
+        if (out_fence < 0) {
+            printf("rknn_stub: create fence fail! %s\n", strerror(errno));
+            if (extend->fence_fd >= 0) {
+                close(extend->fence_fd);
+            }
+            extend->fence_fd = -1;
+            if (in_fence >= 0) {
+                close(in_fence);
+            }
+            return RKNN_ERR_FAIL;
+        }
+    }
+    ctx->submitted = ctx->frame_id + 1;
+    if (extend != NULL) {
+        extend->frame_id = ctx->submitted;
+    }
+    if (non_block) {
+        // finished by rknn_wait / rknn_outputs_get, or the out fence
+        ctx->worker = std::thread(run_fenced, ctx, in_fence, out_fence);
+    } else {
+        run_fenced(ctx, in_fence, out_fence);
+    }
+    return RKNN_SUCC;
+}
+
+int rknn_wait(rknn_context context, rknn_run_extend* extend)
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    std::lock_guard<std::mutex> lk(ctx->run_mutex);
+    wait_ctx(ctx);
+    if (extend != NULL) {
+        extend->frame_id = ctx->frame_id;
+    }
+    return RKNN_SUCC;
+}
+
+int rknn_outputs_get(rknn_context context, uint32_t n_outputs, rknn_output outputs[], rknn_output_extend* extend)
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    if (outputs == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    std::lock_guard<std::mutex> lk(ctx->run_mutex);
+    uint64_t frame_id;
+    if ((ctx->flag & RKNN_FLAG_ASYNC_MASK) && ctx->submitted > 1) {
+        // the previous frame is done, runs of a context are serialized
+        frame_id = ctx->submitted - 1;
+    } else {
+        wait_ctx(ctx);
+        frame_id = ctx->frame_id;
+    }
+    if (frame_id == 0) {
+        printf("rknn_stub: rknn_outputs_get before rknn_run\n");
+        return RKNN_ERR_OUTPUT_INVALID;
+    }
+    const stub_model_t* model = ctx->model.get();
+    for (uint32_t i = 0; i < n_outputs; i++) {
+        uint32_t index = outputs[i].index;
+        if (index >= model->outputs.size()) {
+            return RKNN_ERR_OUTPUT_INVALID;
+        }
+        const rknn_tensor_attr* attr = &model->outputs[index].attr;
+        uint32_t size = outputs[i].want_float ? attr->n_elems * (uint32_t)sizeof(float) : attr->size;
+        if (!outputs[i].is_prealloc) {
+            outputs[i].buf = malloc(size);
+            if (outputs[i].buf == NULL) {
+                return RKNN_ERR_MALLOC_FAIL;
+            }
+            outputs[i].size = size;
+        } else if (outputs[i].buf == NULL) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        copy_output(attr, output_frame(model, index, frame_id), outputs[i].buf, outputs[i].size,
+                    outputs[i].want_float != 0);
+    }
+    if (extend != NULL) {
+        extend->frame_id = frame_id;
+    }
+    return RKNN_SUCC;
+}
+
+int rknn_outputs_release(rknn_context context, uint32_t n_ouputs, rknn_output outputs[])
+{
+    if (get_ctx(context) == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    if (outputs == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    for (uint32_t i = 0; i < n_ouputs; i++) {
+        if (!outputs[i].is_prealloc && outputs[i].buf != NULL) {
+            free(outputs[i].buf);
+            outputs[i].buf = NULL;
+        }
+    }
+    return RKNN_SUCC;
+}
+
+static rknn_tensor_mem* new_mem(void* virt_addr, uint64_t phys_addr, int32_t fd, int32_t offset, uint32_t size,
+                                uint32_t flags)
+{
+    rknn_tensor_mem* mem = (rknn_tensor_mem*)calloc(1, sizeof(rknn_tensor_mem));
+    if (mem == NULL) {
+        return NULL;
+    }
+    mem->virt_addr = virt_addr;
+    mem->phys_addr = phys_addr;
+    mem->fd = fd;
+    mem->offset = offset;
+    mem->size = size;
+    mem->flags = flags;
+    return mem;
+}
+
+rknn_tensor_mem* rknn_create_mem_from_phys(rknn_context ctx, uint64_t phys_addr, void* virt_addr, uint32_t size)
+{
+    (void)ctx;
+    return virt_addr != NULL ? new_mem(virt_addr, phys_addr, -1, 0, size, RKNN_TENSOR_MEMORY_FLAGS_FROM_PHYS) : NULL;
+}
+
+rknn_tensor_mem* rknn_create_mem_from_fd(rknn_context ctx, int32_t fd, void* virt_addr, uint32_t size, int32_t offset)
+{
+    (void)ctx;
+    if (virt_addr == NULL) {
+        printf("rknn_stub: rknn_create_mem_from_fd needs the mapped virt_addr\n");
+        return NULL;
+    }
+    return new_mem(virt_addr, 0, fd, offset, size, RKNN_TENSOR_MEMORY_FLAGS_FROM_FD);
+}
+
+rknn_tensor_mem* rknn_create_mem_from_mb_blk(rknn_context ctx, void* mb_blk, int32_t offset)
+{
+    (void)ctx;
+    (void)mb_blk;
+    (void)offset;
+    printf("rknn_stub: rknn_create_mem_from_mb_blk not supported\n");
+    return NULL;
+}
+
+rknn_tensor_mem* rknn_create_mem2(rknn_context ctx, uint64_t size, uint64_t alloc_flags)
+{
+    (void)ctx;
+    (void)alloc_flags;
+    void* buf = calloc(1, (size_t)size);
+    if (buf == NULL) {
+        return NULL;
+    }
+    rknn_tensor_mem* mem = new_mem(buf, (uint64_t)(uintptr_t)buf, -1, 0, (uint32_t)size,
+                                   RKNN_TENSOR_MEMORY_FLAGS_ALLOC_INSIDE);
+    if (mem == NULL) {
+        free(buf);
+    }
+    return mem;
+}
+
+rknn_tensor_mem* rknn_create_mem(rknn_context ctx, uint32_t size)
+{
+    return rknn_create_mem2(ctx, size, RKNN_FLAG_MEMORY_FLAGS_DEFAULT);
+}
+
+int rknn_destroy_mem(rknn_context ctx, rknn_tensor_mem* mem)
+{
+    (void)ctx;
+    if (mem == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    if (mem->flags == RKNN_TENSOR_MEMORY_FLAGS_ALLOC_INSIDE) {
+        free(mem->virt_addr);
+    }
+    free(mem);
+    return RKNN_SUCC;
+}
+
+int rknn_set_weight_mem(rknn_context ctx, rknn_tensor_mem* mem)
+{
+    (void)mem;
+    return get_ctx(ctx) != NULL ? RKNN_SUCC : RKNN_ERR_CTX_INVALID;
+}
+
+int rknn_set_internal_mem(rknn_context ctx, rknn_tensor_mem* mem)
+{
+    (void)mem;
+    return get_ctx(ctx) != NULL ? RKNN_SUCC : RKNN_ERR_CTX_INVALID;
+}
+
+int rknn_set_io_mem(rknn_context context, rknn_tensor_mem* mem, rknn_tensor_attr* attr)
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    if (mem == NULL || attr == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    // the attr comes from an input or output query, look it up by name
+    for (size_t i = 0; i < ctx->input_attrs.size(); i++) {
+        if (strcmp(ctx->input_attrs[i].name, attr->name) == 0 && attr->index == i) {
+            ctx->input_mems[i] = mem;
+            return RKNN_SUCC;
+        }
+    }
+    const stub_model_t* model = ctx->model.get();
+    for (size_t i = 0; i < model->outputs.size(); i++) {
+        if (strcmp(model->outputs[i].attr.name, attr->name) == 0 && attr->index == i) {
+            ctx->output_mems[i] = mem;
+            ctx->output_mem_attrs[i] = *attr;
+            return RKNN_SUCC;
+        }
+    }
+    printf("rknn_stub: rknn_set_io_mem unknown tensor %s\n", attr->name);
+    return RKNN_ERR_PARAM_INVALID;
+}
+
+int rknn_set_input_shape(rknn_context ctx, rknn_tensor_attr* attr)
+{
+    return rknn_set_input_shapes(ctx, 1, attr);
+}
+
+int rknn_set_input_shapes(rknn_context context, uint32_t n_inputs, rknn_tensor_attr attr[])
+{
+    stub_ctx_t* ctx = get_ctx(context);
+    if (ctx == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    if (attr == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    for (uint32_t i = 0; i < n_inputs; i++) {
+        if (attr[i].index >= ctx->input_attrs.size()) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        rknn_tensor_attr* cur = &ctx->input_attrs[attr[i].index];
+        cur->n_dims = attr[i].n_dims;
+        memcpy(cur->dims, attr[i].dims, sizeof(cur->dims));
+        cur->fmt = attr[i].fmt;
+        update_attr_size(cur);
+        ctx->input_bufs[attr[i].index].resize(cur->size);
+    }
+    return RKNN_SUCC;
+}
+
+int rknn_mem_sync(rknn_context context, rknn_tensor_mem* mem, rknn_mem_sync_mode mode)
+{
+    (void)context;
+    (void)mode;
+    return mem != NULL ? RKNN_SUCC : RKNN_ERR_PARAM_INVALID;
+}
+
+/*-------------------------------------------
+                 rknn_custom_op.h
+-------------------------------------------*/
+
+int rknn_register_custom_ops(rknn_context ctx, rknn_custom_op* op, uint32_t custom_op_num)
+{
+    (void)op;
+    (void)custom_op_num;
+    return get_ctx(ctx) != NULL ? RKNN_SUCC : RKNN_ERR_CTX_INVALID;
+}
+
+/*-------------------------------------------
+                 rknn_matmul_api.h
+-------------------------------------------*/
+
+static void set_matmul_attr(rknn_matmul_tensor_attr* attr, const char* name, uint32_t d0, uint32_t d1,
+                            rknn_tensor_type type)
+{
+    memset(attr, 0, sizeof(rknn_matmul_tensor_attr));
+    strncpy(attr->name, name, RKNN_MAX_NAME_LEN - 1);
+    attr->n_dims = 2;
+    attr->dims[0] = d0;
+    attr->dims[1] = d1;
+    attr->type = type;
+    attr->size = d0 * d1 * type_size(type);
+}
+
+int rknn_matmul_create(rknn_matmul_ctx* ctx, rknn_matmul_info* info, rknn_matmul_io_attr* io_attr)
+{
+    if (ctx == NULL || info == NULL || io_attr == NULL || info->M <= 0 || info->K <= 0 || info->N <= 0) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    rknn_tensor_type a_type, b_type, c_type;
+    switch (info->type) {
+    case RKNN_FLOAT16_MM_FLOAT16_TO_FLOAT32:
+        a_type = RKNN_TENSOR_FLOAT16, b_type = RKNN_TENSOR_FLOAT16, c_type = RKNN_TENSOR_FLOAT32;
+        break;
+    case RKNN_FLOAT16_MM_FLOAT16_TO_FLOAT16:
+        a_type = RKNN_TENSOR_FLOAT16, b_type = RKNN_TENSOR_FLOAT16, c_type = RKNN_TENSOR_FLOAT16;
+        break;
+    case RKNN_INT8_MM_INT8_TO_INT32:
+        a_type = RKNN_TENSOR_INT8, b_type = RKNN_TENSOR_INT8, c_type = RKNN_TENSOR_INT32;
+        break;
+    case RKNN_INT8_MM_INT8_TO_FLOAT32:
+        a_type = RKNN_TENSOR_INT8, b_type = RKNN_TENSOR_INT8, c_type = RKNN_TENSOR_FLOAT32;
+        break;
+    default:
+        printf("rknn_stub: matmul type %s not supported\n", get_matmul_type_string(info->type));
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    if (info->B_layout != RKNN_MM_LAYOUT_NORM || info->AC_layout != RKNN_MM_LAYOUT_NORM) {
+        printf("rknn_stub: matmul only supports the normal layout\n");
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    stub_matmul_t* mm = new stub_matmul_t();
+    mm->magic = STUB_MAGIC_MATMUL;
+    mm->info = *info;
+    set_matmul_attr(&io_attr->A, "A", info->M, info->K, a_type);
+    set_matmul_attr(&io_attr->B, "B", info->K, info->N, b_type);
+    set_matmul_attr(&io_attr->C, "C", info->M, info->N, c_type);
+    mm->io_attr = *io_attr;
+    mm->A = mm->B = mm->C = NULL;
+    mm->core_mask = RKNN_NPU_CORE_AUTO;
+    register_ctx(mm);
+    *ctx = (rknn_matmul_ctx)(uintptr_t)mm;
+    return RKNN_SUCC;
+}
+
+int rknn_matmul_create_dynamic_shape(rknn_matmul_ctx* ctx, rknn_matmul_info* info, int shape_num,
+                                     rknn_matmul_shape dynamic_shapes[], rknn_matmul_io_attr io_attrs[])
+{
+    (void)ctx;
+    (void)info;
+    (void)shape_num;
+    (void)dynamic_shapes;
+    (void)io_attrs;
+    printf("rknn_stub: rknn_matmul_create_dynamic_shape not supported\n");
+    return RKNN_ERR_FAIL;
+}
+
+int rknn_matmul_set_io_mem(rknn_matmul_ctx ctx, rknn_tensor_mem* mem, rknn_matmul_tensor_attr* attr)
+{
+    stub_matmul_t* mm = get_matmul(ctx);
+    if (mm == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    if (mem == NULL || attr == NULL || mem->size < attr->size) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    if (strcmp(attr->name, "A") == 0) {
+        mm->A = mem;
+    } else if (strcmp(attr->name, "B") == 0) {
+        mm->B = mem;
+    } else if (strcmp(attr->name, "C") == 0) {
+        mm->C = mem;
+    } else {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    return RKNN_SUCC;
+}
+
+int rknn_matmul_set_core_mask(rknn_matmul_ctx context, rknn_core_mask core_mask)
+{
+    stub_matmul_t* mm = get_matmul(context);
+    if (mm == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    mm->core_mask = core_mask;
+    return RKNN_SUCC;
+}
+
+int rknn_matmul_set_quant_params(rknn_matmul_ctx context, rknn_quant_params* params)
+{
+    (void)params;
+    return get_matmul(context) != NULL ? RKNN_SUCC : RKNN_ERR_CTX_INVALID;
+}
+
+int rknn_matmul_get_quant_params(rknn_matmul_ctx ctx, rknn_quant_params* params, float* scale)
+{
+    (void)params;
+    if (scale != NULL) {
+        *scale = 1.0f;
+    }
+    return get_matmul(ctx) != NULL ? RKNN_SUCC : RKNN_ERR_CTX_INVALID;
+}
+
+int rknn_matmul_set_dynamic_shape(rknn_matmul_ctx ctx, rknn_matmul_shape* shape)
+{
+    (void)ctx;
+    (void)shape;
+    return RKNN_ERR_FAIL;
+}
+
+// the product is computed on the CPU, this also is the simulated NPU time
+int rknn_matmul_run(rknn_matmul_ctx ctx)
+{
+    stub_matmul_t* mm = get_matmul(ctx);
+    if (mm == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    if (mm->A == NULL || mm->B == NULL || mm->C == NULL) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    int M = mm->info.M, K = mm->info.K, N = mm->info.N;
+    const rknn_matmul_io_attr* io = &mm->io_attr;
+    const uint8_t* a = (const uint8_t*)mm->A->virt_addr + mm->A->offset;
+    const uint8_t* b = (const uint8_t*)mm->B->virt_addr + mm->B->offset;
+    uint8_t* c = (uint8_t*)mm->C->virt_addr + mm->C->offset;
+    bool is_int8 = io->A.type == RKNN_TENSOR_INT8;
+
+    std::vector<float> row(N);
+    std::vector<int32_t> irow(N);
+    for (int m = 0; m < M; m++) {
+        std::fill(row.begin(), row.end(), 0.0f);
+        std::fill(irow.begin(), irow.end(), 0);
+        for (int k = 0; k < K; k++) {
+            if (is_int8) {
+                int32_t av = ((const int8_t*)a)[m * K + k];
+                const int8_t* bk = (const int8_t*)b + (size_t)k * N;
+                for (int n = 0; n < N; n++) {
+                    irow[n] += av * bk[n];
+                }
+            } else {
+                float av = (float)((const rknpu2::float16*)a)[m * K + k];
+                const rknpu2::float16* bk = (const rknpu2::float16*)b + (size_t)k * N;
+                for (int n = 0; n < N; n++) {
+                    row[n] += av * (float)bk[n];
+                }
+            }
+        }
+        for (int n = 0; n < N; n++) {
+            size_t i = (size_t)m * N + n;
+            switch (io->C.type) {
+            case RKNN_TENSOR_INT32:
+                ((int32_t*)c)[i] = irow[n];
+                break;
+            case RKNN_TENSOR_FLOAT16:
+                ((rknpu2::float16*)c)[i] = rknpu2::float16(row[n]);
+                break;
+            default:
+                ((float*)c)[i] = is_int8 ? (float)irow[n] : row[n];
+                break;
+            }
+        }
+    }
+    return RKNN_SUCC;
+}
+
+int rknn_matmul_destroy(rknn_matmul_ctx ctx)
+{
+    stub_matmul_t* mm = get_matmul(ctx);
+    if (mm == NULL) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    unregister_ctx(mm);
+    delete mm;
+    return RKNN_SUCC;
+}
@@ -1,19 +1,24 @@
 #ifndef _RKNN_DEMO_TIMER_H_
 #define _RKNN_DEMO_TIMER_H_
 
-#include <sys/time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <chrono>
 
 // Define this macro to disable timing logs
 // #define TIMING_DISABLED // if you don't need to print the time used, uncomment this line of code
 
+// the stage profiler (stage_profiler.h) reports the same stages with percentiles, keep the output clean
+#if defined(ENABLE_STAGE_PROFILER) && !defined(TIMING_DISABLED)
+#define TIMING_DISABLED
+#endif
+
 class TIMER
 {
 private:
-    struct timeval start_time, stop_time;
-    double __get_us(struct timeval t) { return (t.tv_sec * 1000000 + t.tv_usec); }
+    // steady_clock is monotonic, gettimeofday jumps with NTP / manual clock changes
+    std::chrono::steady_clock::time_point start_time, stop_time;
     char indent[40] = "-- ";
 
 public:
@@ -31,12 +36,12 @@ public:
 
     void tik()
     {
-        gettimeofday(&start_time, NULL);
+        start_time = std::chrono::steady_clock::now();
     }
 
     void tok()
     {
-        gettimeofday(&stop_time, NULL);
+        stop_time = std::chrono::steady_clock::now();
     }
 
 #ifdef TIMING_DISABLED
@@ -63,8 +68,8 @@ public:
 
     float get_time()
     {
-        return (__get_us(stop_time) - __get_us(start_time)) / 1000;
+        return std::chrono::duration<float, std::milli>(stop_time - start_time).count();
     }
 };
 
-#endif // _RKNN_DEMO_TIMER_H_
\ No newline at end of file
+#endif // _RKNN_DEMO_TIMER_H_
@@ -0,0 +1,354 @@
+#ifndef _RKNN_DEMO_STAGE_PROFILER_H_
+#define _RKNN_DEMO_STAGE_PROFILER_H_
+
+/*
+ * Low overhead stage profiler
+ *
+ *   PROFILE_SCOPE("post_process");          // time the enclosing scope, nests inside outer scopes
+ *   PROFILE_REPORT();                        // count/avg/p50/p95/p99/max per stage
+ *   PROFILE_EXPORT_TRACE("trace.json");      // Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+ *
+ * Everything expands to nothing unless ENABLE_STAGE_PROFILER is defined
+ * (cmake -DENABLE_STAGE_PROFILER=ON). When enabled, the report is printed at
+ * exit and the trace is written to $STAGE_PROFILER_TRACE if it is set.
+ *
+ * Each thread records into its own ring buffer and histograms, so recording
+ * takes no lock; reports read them without stopping the writers, so call
+ * them when the worker threads are idle for exact numbers.
+ */
+
+#ifdef ENABLE_STAGE_PROFILER
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+namespace stage_profiler {
+
+static const int kRingSize = 4096;              // events kept per thread for the trace, power of 2
+static const int kMaxStages = 48;               // distinct stage names per thread
+static const int kSubBucketBits = 3;            // histogram: 8 linear sub-buckets per power of 2 (<= 12.5% error)
+static const int kSubBuckets = 1 << kSubBucketBits;
+static const int kBuckets = 64 * kSubBuckets;
+
+typedef struct {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+    uint32_t depth;
+} stage_event_t;
+
+// written by the owner thread only, relaxed atomics just make the concurrent reads well defined
+struct StageHist {
+    std::atomic<const char*> name;
+    std::atomic<uint32_t> depth;
+    std::atomic<uint64_t> first_ns;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<uint32_t> buckets[kBuckets];
+};
+
+struct ThreadLog {
+    uint32_t tid;
+    int depth;
+    std::atomic<uint64_t> head;
+    stage_event_t ring[kRingSize];
+    StageHist stages[kMaxStages];
+    ThreadLog* next;
+};
+
+void report(FILE* fp);
+int export_chrome_trace(const char* path);
+
+struct Registry {
+    std::atomic<ThreadLog*> logs;
+    std::atomic<uint32_t> next_tid;
+    std::atomic<uint64_t> epoch_ns;
+
+    Registry() : logs(nullptr), next_tid(0), epoch_ns(0) {}
+    ~Registry()
+    {
+        if (logs.load(std::memory_order_acquire) == nullptr) {
+            return;
+        }
+        const char* trace_path = getenv("STAGE_PROFILER_TRACE");
+        if (trace_path != NULL && trace_path[0] != '\0') {
+            export_chrome_trace(trace_path);
+        }
+        report(stdout);
+    }
+};
+
+inline uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+inline ThreadLog* thread_log()
+{
+    static thread_local ThreadLog* log = nullptr;
+    if (log == nullptr) {
+        Registry& r = registry();
+        ThreadLog* l = new ThreadLog();
+        l->tid = r.next_tid.fetch_add(1, std::memory_order_relaxed);
+        uint64_t expected = 0;
+        // first thread to record fixes the trace epoch
+        r.epoch_ns.compare_exchange_strong(expected, now_ns());
+        ThreadLog* old_head = r.logs.load(std::memory_order_relaxed);
+        do {
+            l->next = old_head;
+        } while (!r.logs.compare_exchange_weak(old_head, l, std::memory_order_release, std::memory_order_relaxed));
+        log = l;
+    }
+    return log;
+}
+
+inline int bucket_index(uint64_t ns)
+{
+    if (ns < (uint64_t)kSubBuckets) {
+        return (int)ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - kSubBucketBits;
+    int sub = (int)((ns >> shift) & (kSubBuckets - 1));
+    return (shift + 1) * kSubBuckets + sub;
+}
+
+// midpoint of the bucket range
+inline uint64_t bucket_value(int index)
+{
+    if (index < kSubBuckets) {
+        return (uint64_t)index;
+    }
+    int shift = index / kSubBuckets - 1;
+    uint64_t lower = (uint64_t)(kSubBuckets + index % kSubBuckets) << shift;
+    return lower + (((uint64_t)1 << shift) >> 1);
+}
+
+inline StageHist* find_stage(ThreadLog* log, const char* name, uint32_t depth, uint64_t start_ns)
+{
+    uintptr_t h = (uintptr_t)name;
+    int slot = (int)((h >> 3) % kMaxStages);
+    for (int i = 0; i < kMaxStages; i++) {
+        StageHist* s = &log->stages[(slot + i) % kMaxStages];
+        const char* n = s->name.load(std::memory_order_relaxed);
+        if (n == name) {
+            return s;
+        }
+        if (n == nullptr) {
+            s->depth.store(depth, std::memory_order_relaxed);
+            s->first_ns.store(start_ns, std::memory_order_relaxed);
+            s->name.store(name, std::memory_order_release);
+            return s;
+        }
+    }
+    return nullptr;
+}
+
+inline void record(ThreadLog* log, const char* name, uint64_t start_ns, uint64_t dur_ns, uint32_t depth)
+{
+    uint64_t h = log->head.load(std::memory_order_relaxed);
+    stage_event_t* e = &log->ring[h & (kRingSize - 1)];
+    e->name = name;
+    e->start_ns = start_ns;
+    e->dur_ns = dur_ns;
+    e->depth = depth;
+    log->head.store(h + 1, std::memory_order_release);
+
+    StageHist* s = find_stage(log, name, depth, start_ns);
+    if (s == nullptr) {
+        return;
+    }
+    s->count.store(s->count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    s->total_ns.store(s->total_ns.load(std::memory_order_relaxed) + dur_ns, std::memory_order_relaxed);
+    if (dur_ns > s->max_ns.load(std::memory_order_relaxed)) {
+        s->max_ns.store(dur_ns, std::memory_order_relaxed);
+    }
+    std::atomic<uint32_t>& b = s->buckets[bucket_index(dur_ns)];
+    b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+class ScopedStage {
+public:
+    explicit ScopedStage(const char* name) : log_(thread_log()), name_(name)
+    {
+        depth_ = (uint32_t)log_->depth++;
+        start_ns_ = now_ns();
+    }
+    ~ScopedStage()
+    {
+        uint64_t end_ns = now_ns();
+        log_->depth--;
+        record(log_, name_, start_ns_, end_ns - start_ns_, depth_);
+    }
+
+private:
+    ScopedStage(const ScopedStage&);
+    ScopedStage& operator=(const ScopedStage&);
+
+    ThreadLog* log_;
+    const char* name_;
+    uint32_t depth_;
+    uint64_t start_ns_;
+};
+
+struct StageSummary {
+    const char* name;
+    uint32_t depth;
+    uint64_t first_ns;
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    std::vector<uint64_t> buckets;
+};
+
+inline uint64_t percentile(const StageSummary& s, double p)
+{
+    uint64_t target = (uint64_t)(p * (double)s.count + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += s.buckets[i];
+        if (seen >= target) {
+            uint64_t v = bucket_value(i);
+            return v < s.max_ns ? v : s.max_ns;
+        }
+    }
+    return s.max_ns;
+}
+
+// merge all threads by stage name, ordered by first use so nested stages follow their parent
+inline void report(FILE* fp)
+{
+    std::vector<StageSummary> stages;
+    for (ThreadLog* l = registry().logs.load(std::memory_order_acquire); l != nullptr; l = l->next) {
+        for (int i = 0; i < kMaxStages; i++) {
+            StageHist* h = &l->stages[i];
+            const char* name = h->name.load(std::memory_order_acquire);
+            if (name == nullptr) {
+                continue;
+            }
+            StageSummary* s = nullptr;
+            for (size_t j = 0; j < stages.size(); j++) {
+                if (strcmp(stages[j].name, name) == 0) {
+                    s = &stages[j];
+                    break;
+                }
+            }
+            if (s == nullptr) {
+                StageSummary n;
+                n.name = name;
+                n.depth = h->depth.load(std::memory_order_relaxed);
+                n.first_ns = h->first_ns.load(std::memory_order_relaxed);
+                n.count = n.total_ns = n.max_ns = 0;
+                n.buckets.assign(kBuckets, 0);
+                stages.push_back(n);
+                s = &stages.back();
+            }
+            uint64_t first_ns = h->first_ns.load(std::memory_order_relaxed);
+            if (first_ns < s->first_ns) {
+                s->first_ns = first_ns;
+            }
+            s->count += h->count.load(std::memory_order_relaxed);
+            s->total_ns += h->total_ns.load(std::memory_order_relaxed);
+            uint64_t max_ns = h->max_ns.load(std::memory_order_relaxed);
+            s->max_ns = max_ns > s->max_ns ? max_ns : s->max_ns;
+            for (int k = 0; k < kBuckets; k++) {
+                s->buckets[k] += h->buckets[k].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    std::sort(stages.begin(), stages.end(),
+              [](const StageSummary& a, const StageSummary& b) { return a.first_ns < b.first_ns; });
+
+    fprintf(fp, "%-40s %8s %10s %10s %10s %10s %10s\n", "stage (ms)", "count", "avg", "p50", "p95", "p99", "max");
+    for (size_t i = 0; i < stages.size(); i++) {
+        const StageSummary& s = stages[i];
+        if (s.count == 0) {
+            continue;
+        }
+        char label[64];
+        int indent = s.depth > 8 ? 8 : (int)s.depth;
+        snprintf(label, sizeof(label), "%*s%s", indent * 2, "", s.name);
+        fprintf(fp, "%-40s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f\n", label, (unsigned long long)s.count,
+                s.total_ns / 1e6 / s.count, percentile(s, 0.50) / 1e6, percentile(s, 0.95) / 1e6,
+                percentile(s, 0.99) / 1e6, s.max_ns / 1e6);
+    }
+}
+
+inline void write_json_string(FILE* fp, const char* s)
+{
+    fputc('"', fp);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', fp);
+        }
+        if ((unsigned char)*s >= 0x20) {
+            fputc(*s, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+// only the last kRingSize events of every thread are kept
+inline int export_chrome_trace(const char* path)
+{
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) {
+        printf("open %s fail!\n", path);
+        return -1;
+    }
+    uint64_t epoch_ns = registry().epoch_ns.load(std::memory_order_relaxed);
+    bool first = true;
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (ThreadLog* l = registry().logs.load(std::memory_order_acquire); l != nullptr; l = l->next) {
+        uint64_t head = l->head.load(std::memory_order_acquire);
+        uint64_t begin = head > (uint64_t)kRingSize ? head - kRingSize : 0;
+        for (uint64_t i = begin; i < head; i++) {
+            const stage_event_t* e = &l->ring[i & (kRingSize - 1)];
+            fprintf(fp, "%s{\"name\":", first ? "" : ",\n");
+            write_json_string(fp, e->name);
+            fprintf(fp, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", l->tid,
+                    (e->start_ns - epoch_ns) / 1e3, e->dur_ns / 1e3);
+            first = false;
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    printf("stage profiler trace saved to %s\n", path);
+    return 0;
+}
+
+}  // namespace stage_profiler
+
+#define STAGE_PROFILER_CONCAT_(a, b) a##b
+#define STAGE_PROFILER_CONCAT(a, b) STAGE_PROFILER_CONCAT_(a, b)
+
+#define PROFILE_SCOPE(name) ::stage_profiler::ScopedStage STAGE_PROFILER_CONCAT(_stage_scope_, __LINE__)(name)
+#define PROFILE_REPORT() ::stage_profiler::report(stdout)
+#define PROFILE_EXPORT_TRACE(path) ::stage_profiler::export_chrome_trace(path)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_REPORT()
+#define PROFILE_EXPORT_TRACE(path)
+
+#endif // ENABLE_STAGE_PROFILER
+
+#endif // _RKNN_DEMO_STAGE_PROFILER_H_
@@ -0,0 +1,61 @@
+/*
+ * sense-voice audio_preprocess: fbank, LFR and CMVN of one CHUNK_LENGTH chunk.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sensevoice.h"
+#include "bench.h"
+
+typedef struct {
+    audio_buffer_t audio;
+    CMVNData cmvn;
+    std::vector<float> features;
+    int len;
+} audio_bench_t;
+
+// speech-like test signal: a slow chirp with harmonics and a bit of noise
+static void make_audio(audio_buffer_t* audio, float* data, int num_frames)
+{
+    unsigned int seed = 0x2545f491;
+    for (int i = 0; i < num_frames; i++) {
+        float t = (float)i / SAMPLE_RATE;
+        float f0 = 120.0f + 60.0f * sinf(2.0f * (float)M_PI * 0.5f * t);
+        float v = 0.3f * sinf(2.0f * (float)M_PI * f0 * t) + 0.1f * sinf(2.0f * (float)M_PI * 3 * f0 * t);
+        seed = seed * 1664525u + 1013904223u;
+        v += 0.01f * ((float)(seed >> 8) / 16777216.0f - 0.5f);
+        data[i] = v;
+    }
+    audio->data = data;
+    audio->num_frames = num_frames;
+    audio->num_channels = 1;
+    audio->sample_rate = SAMPLE_RATE;
+}
+
+static void run_audio_preprocess(void* arg)
+{
+    audio_bench_t* b = (audio_bench_t*)arg;
+    audio_preprocess(&b->audio, b->len, b->cmvn, b->features);
+    bench_do_not_optimize(b->features.data());
+}
+
+int main(int argc, char** argv)
+{
+    bench_options_t opts;
+    if (bench_parse_args(argc, argv, "audio_preprocess", &opts) != 0) {
+        return -1;
+    }
+
+    // synthetic only, reading wav files would pull in libsndfile
+    static audio_bench_t bench;
+    std::vector<float> samples(SAMPLE_RATE * CHUNK_LENGTH);
+    make_audio(&bench.audio, samples.data(), (int)samples.size());
+    // identity normalization, same cost as the real am.mvn
+    bench.cmvn.means.assign(FEATURES_LEN, 0.0f);
+    bench.cmvn.vars.assign(FEATURES_LEN, 1.0f);
+
+    bench_run("audio_preprocess/7s_16k", run_audio_preprocess, &bench);
+    return bench_finish();
+}
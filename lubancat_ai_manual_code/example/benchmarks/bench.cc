@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+#include "bench.h"
+
+/*
+ * Allocation counting: malloc and friends are interposed in the executable and
+ * forwarded to glibc, operator new goes through malloc so C++ allocations are
+ * counted as well. Other C libraries only get operator new counted.
+ */
+static std::atomic<uint64_t> g_alloc_count(0);
+static std::atomic<uint64_t> g_alloc_bytes(0);
+
+static inline void count_alloc(size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+    count_alloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+    count_alloc(n * size);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    count_alloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    count_alloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    count_alloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    count_alloc(size);
+    void* p = __libc_memalign(alignment, size);
+    if (p == NULL) {
+        return ENOMEM;
+    }
+    *ptr = p;
+    return 0;
+}
+
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+}
+#else
+#include <new>
+void* operator new(size_t size)
+{
+    count_alloc(size);
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+#endif
+
+void bench_alloc_counters(uint64_t* count, uint64_t* bytes)
+{
+    *count = g_alloc_count.load(std::memory_order_relaxed);
+    *bytes = g_alloc_bytes.load(std::memory_order_relaxed);
+}
+
+void bench_do_not_optimize(const void* p)
+{
+    __asm__ __volatile__("" : : "r"(p) : "memory");
+}
+
+static bench_options_t g_opts;
+static bench_result_t g_results[BENCH_MAX_RESULTS];
+static int g_result_count = 0;
+
+static void print_usage(const char* prog)
+{
+    printf("Usage: %s [--filter str] [--min-time ms] [--samples n] [--json out.json]\n"
+           "          [--compare baseline.json] [--tolerance percent] [--input path]\n", prog);
+}
+
+int bench_parse_args(int argc, char** argv, const char* suite, bench_options_t* opts)
+{
+    memset(opts, 0, sizeof(bench_options_t));
+    opts->suite = suite;
+    opts->min_time_ms = 100;
+    opts->samples = 5;
+    opts->tolerance = 10;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return -1;
+        }
+        if (val == NULL) {
+            printf("missing value for %s\n", arg);
+            print_usage(argv[0]);
+            return -1;
+        }
+        if (strcmp(arg, "--filter") == 0) {
+            opts->filter = val;
+        } else if (strcmp(arg, "--min-time") == 0) {
+            opts->min_time_ms = atof(val);
+        } else if (strcmp(arg, "--samples") == 0) {
+            opts->samples = atoi(val);
+        } else if (strcmp(arg, "--json") == 0) {
+            opts->json_path = val;
+        } else if (strcmp(arg, "--compare") == 0) {
+            opts->compare_path = val;
+        } else if (strcmp(arg, "--tolerance") == 0) {
+            opts->tolerance = atof(val);
+        } else if (strcmp(arg, "--input") == 0) {
+            opts->input = val;
+        } else {
+            printf("unknown option %s\n", arg);
+            print_usage(argv[0]);
+            return -1;
+        }
+        i++;
+    }
+    if (opts->samples <= 0) {
+        opts->samples = 1;
+    }
+    g_opts = *opts;
+    return 0;
+}
+
+static inline int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int bench_run(const char* name, bench_fn fn, void* arg)
+{
+    if (g_opts.filter != NULL && strstr(name, g_opts.filter) == NULL) {
+        return 0;
+    }
+    if (g_result_count >= BENCH_MAX_RESULTS) {
+        printf("too many benchmark cases, max %d\n", BENCH_MAX_RESULTS);
+        return -1;
+    }
+
+    // warm up: first call pays for lazy init, page faults and caches
+    int64_t start = now_ns();
+    fn(arg);
+    int64_t once_ns = now_ns() - start;
+    if (once_ns <= 0) {
+        once_ns = 1;
+    }
+
+    // batch size so that one sample takes at least min_time_ms
+    long long batch = (long long)(g_opts.min_time_ms * 1e6 / once_ns);
+    if (batch < 1) {
+        batch = 1;
+    }
+    for (;;) {
+        start = now_ns();
+        for (long long i = 0; i < batch; i++) {
+            fn(arg);
+        }
+        int64_t elapsed = now_ns() - start;
+        if (elapsed >= g_opts.min_time_ms * 1e6 * 0.5 || batch >= (1LL << 40)) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    std::vector<double> sample_ns(g_opts.samples);
+    uint64_t count0, bytes0, count1, bytes1;
+    bench_alloc_counters(&count0, &bytes0);
+    for (int s = 0; s < g_opts.samples; s++) {
+        start = now_ns();
+        for (long long i = 0; i < batch; i++) {
+            fn(arg);
+        }
+        sample_ns[s] = (double)(now_ns() - start) / batch;
+    }
+    bench_alloc_counters(&count1, &bytes1);
+    std::sort(sample_ns.begin(), sample_ns.end());
+
+    bench_result_t* r = &g_results[g_result_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->iterations = batch * g_opts.samples;
+    r->ns_per_op = sample_ns[g_opts.samples / 2];
+    r->allocs_per_op = (double)(count1 - count0) / r->iterations;
+    r->bytes_per_op = (double)(bytes1 - bytes0) / r->iterations;
+
+    printf("%-48s %14.1f ns/op %10.1f allocs/op %12.1f B/op %10lld iters\n", r->name, r->ns_per_op,
+           r->allocs_per_op, r->bytes_per_op, r->iterations);
+    return 0;
+}
+
+static int save_json(const char* path)
+{
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) {
+        printf("open %s fail!\n", path);
+        return -1;
+    }
+    // one result per line, read back by load_baseline
+    fprintf(fp, "{\n  \"suite\": \"%s\",\n  \"results\": [\n", g_opts.suite);
+    for (int i = 0; i < g_result_count; i++) {
+        bench_result_t* r = &g_results[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f, \"iterations\": %lld}%s\n",
+                r->name, r->ns_per_op, r->allocs_per_op, r->bytes_per_op, r->iterations, i + 1 < g_result_count ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+    printf("results saved to %s\n", path);
+    return 0;
+}
+
+static int load_baseline(const char* path, std::vector<bench_result_t>& results)
+{
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        printf("open %s fail!\n", path);
+        return -1;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        const char* p = strstr(line, "{\"name\"");
+        if (p == NULL) {
+            continue;
+        }
+        bench_result_t r;
+        memset(&r, 0, sizeof(r));
+        if (sscanf(p, "{\"name\": \"%127[^\"]\", \"ns_per_op\": %lf, \"allocs_per_op\": %lf, \"bytes_per_op\": %lf, \"iterations\": %lld",
+                   r.name, &r.ns_per_op, &r.allocs_per_op, &r.bytes_per_op, &r.iterations) == 5) {
+            results.push_back(r);
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int compare_baseline(const char* path)
+{
+    std::vector<bench_result_t> baseline;
+    if (load_baseline(path, baseline) != 0) {
+        return -1;
+    }
+    int regressions = 0;
+    printf("\ncompare with %s (tolerance %.1f%%)\n", path, g_opts.tolerance);
+    for (int i = 0; i < g_result_count; i++) {
+        bench_result_t* r = &g_results[i];
+        const bench_result_t* base = NULL;
+        for (size_t j = 0; j < baseline.size(); j++) {
+            if (strcmp(baseline[j].name, r->name) == 0) {
+                base = &baseline[j];
+                break;
+            }
+        }
+        if (base == NULL) {
+            printf("%-48s %14s\n", r->name, "new");
+            continue;
+        }
+        double delta = base->ns_per_op > 0 ? (r->ns_per_op / base->ns_per_op - 1.0) * 100.0 : 0.0;
+        // allocation counts are deterministic, any increase is a regression
+        bool slower = delta > g_opts.tolerance;
+        bool more_allocs = r->allocs_per_op > base->allocs_per_op + 0.5;
+        printf("%-48s %+13.1f%% %+10.1f allocs/op  %s\n", r->name, delta, r->allocs_per_op - base->allocs_per_op,
+               (slower || more_allocs) ? "REGRESSION" : "ok");
+        if (slower || more_allocs) {
+            regressions++;
+        }
+    }
+    if (regressions > 0) {
+        printf("%d regression(s)\n", regressions);
+        return 1;
+    }
+    return 0;
+}
+
+int bench_finish()
+{
+    int ret = 0;
+    if (g_opts.json_path != NULL) {
+        if (save_json(g_opts.json_path) != 0) {
+            ret = -1;
+        }
+    }
+    if (g_opts.compare_path != NULL) {
+        int cmp = compare_baseline(g_opts.compare_path);
+        if (cmp != 0) {
+            ret = cmp;
+        }
+    }
+    return ret;
+}
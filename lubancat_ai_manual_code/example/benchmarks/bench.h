@@ -0,0 +1,69 @@
+#ifndef _RKNN_DEMO_BENCH_H_
+#define _RKNN_DEMO_BENCH_H_
+
+#include <stdint.h>
+
+#define BENCH_NAME_MAX_SIZE 128
+#define BENCH_MAX_RESULTS 64
+
+typedef struct {
+    const char* suite;          // benchmark executable name, written into the json
+    const char* filter;         // only run cases whose name contains this string
+    double min_time_ms;         // minimum duration of one sample
+    int samples;                // samples per case, ns/op is the median
+    const char* json_path;      // save results here
+    const char* compare_path;   // baseline json to compare against
+    double tolerance;           // allowed ns/op slowdown in percent before it counts as a regression
+    const char* input;          // recorded input (tensor dir / image / vocab), NULL for synthetic data
+} bench_options_t;
+
+typedef struct {
+    char name[BENCH_NAME_MAX_SIZE];
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+    long long iterations;
+} bench_result_t;
+
+typedef void (*bench_fn)(void* arg);
+
+/**
+ * @brief Parse the common command line options
+ *
+ *   --filter <str> --min-time <ms> --samples <n> --json <out.json>
+ *   --compare <baseline.json> --tolerance <percent> --input <path>
+ *
+ * @param suite [in] Suite name
+ * @param opts [out] Options, also kept by the harness
+ * @return int 0: success; -1: error (usage printed)
+ */
+int bench_parse_args(int argc, char** argv, const char* suite, bench_options_t* opts);
+
+/**
+ * @brief Time fn(arg) and record ns/op, allocations/op and allocated bytes/op
+ *
+ * fn runs once untimed as warm up, then in batches long enough to reach min_time_ms.
+ *
+ * @param name [in] Case name, e.g. "post_process/int8"
+ * @return int 0: ran or filtered out; -1: error
+ */
+int bench_run(const char* name, bench_fn fn, void* arg);
+
+/**
+ * @brief Save the json and compare with the baseline
+ *
+ * @return int 0: ok; 1: regression against the baseline; -1: error
+ */
+int bench_finish();
+
+/**
+ * @brief Allocation counters since start (malloc/calloc/realloc/new), for ad-hoc checks
+ */
+void bench_alloc_counters(uint64_t* count, uint64_t* bytes);
+
+/**
+ * @brief Keep the compiler from optimizing a result away
+ */
+void bench_do_not_optimize(const void* p);
+
+#endif //_RKNN_DEMO_BENCH_H_
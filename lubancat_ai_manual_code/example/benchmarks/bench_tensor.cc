@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bench_tensor.h"
+#include "Float16.h"
+#include "file_utils.h"
+
+unsigned int bench_rand(unsigned int* state)
+{
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static int8_t quantize(float f, int32_t zp, float scale)
+{
+    float v = roundf(f / scale) + zp;
+    if (v < -128) {
+        v = -128;
+    }
+    if (v > 127) {
+        v = 127;
+    }
+    return (int8_t)v;
+}
+
+static int load_raw(const char* input_dir, int index, rknn_output* output)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/output_%d.bin", input_dir, index);
+    char* data = NULL;
+    int size = read_data_from_file(path, &data);
+    if (data == NULL || size <= 0) {
+        printf("read %s fail!\n", path);
+        return -1;
+    }
+    if ((uint32_t)size != output->size) {
+        printf("%s: size %d does not match the expected %u bytes\n", path, size, output->size);
+        free(data);
+        return -1;
+    }
+    memcpy(output->buf, data, size);
+    free(data);
+    return 0;
+}
+
+int bench_make_outputs(const bench_tensor_spec_t* specs, int n, rknn_tensor_type type, const char* input_dir,
+                       rknn_tensor_attr* attrs, rknn_output* outputs)
+{
+    int elem_size = type == RKNN_TENSOR_INT8 ? 1 : (type == RKNN_TENSOR_FLOAT16 ? 2 : 4);
+    unsigned int seed = 0x12345678;
+
+    memset(attrs, 0, n * sizeof(rknn_tensor_attr));
+    memset(outputs, 0, n * sizeof(rknn_output));
+    for (int i = 0; i < n; i++) {
+        const bench_tensor_spec_t* spec = &specs[i];
+        rknn_tensor_attr* attr = &attrs[i];
+        attr->index = i;
+        attr->n_dims = spec->n_dims;
+        attr->n_elems = 1;
+        for (int d = 0; d < spec->n_dims; d++) {
+            attr->dims[d] = spec->dims[d];
+            attr->n_elems *= spec->dims[d];
+        }
+        snprintf(attr->name, RKNN_MAX_NAME_LEN, "output%d", i);
+        attr->fmt = RKNN_TENSOR_NCHW;
+        attr->type = type;
+        attr->size = attr->n_elems * elem_size;
+        attr->size_with_stride = attr->size;
+        if (type == RKNN_TENSOR_INT8) {
+            attr->qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+            attr->scale = (spec->hi - spec->lo) / 255.0f;
+            if (attr->scale <= 0) {
+                attr->scale = 1.0f;
+            }
+            attr->zp = (int32_t)roundf(-128.0f - spec->lo / attr->scale);
+        } else {
+            attr->qnt_type = RKNN_TENSOR_QNT_NONE;
+            attr->scale = 1.0f;
+        }
+
+        rknn_output* output = &outputs[i];
+        output->index = i;
+        output->want_float = type != RKNN_TENSOR_INT8;
+        output->size = attr->size;
+        output->buf = malloc(attr->size);
+        if (output->buf == NULL) {
+            printf("malloc output buffer fail!\n");
+            bench_release_outputs(outputs, i);
+            return -1;
+        }
+
+        if (input_dir != NULL) {
+            if (load_raw(input_dir, i, output) != 0) {
+                bench_release_outputs(outputs, i + 1);
+                return -1;
+            }
+            continue;
+        }
+
+        unsigned int threshold = (unsigned int)(spec->hit_ratio * 4294967295.0);
+        for (uint32_t e = 0; e < attr->n_elems; e++) {
+            float v = bench_rand(&seed) < threshold ? spec->fg : spec->bg;
+            if (type == RKNN_TENSOR_INT8) {
+                ((int8_t*)output->buf)[e] = quantize(v, attr->zp, attr->scale);
+            } else if (type == RKNN_TENSOR_FLOAT16) {
+                rknpu2::float16 h(v);
+                memcpy((uint16_t*)output->buf + e, &h, sizeof(uint16_t));
+            } else {
+                ((float*)output->buf)[e] = v;
+            }
+        }
+    }
+    return 0;
+}
+
+void bench_release_outputs(rknn_output* outputs, int n)
+{
+    for (int i = 0; i < n; i++) {
+        if (outputs[i].buf != NULL) {
+            free(outputs[i].buf);
+            outputs[i].buf = NULL;
+        }
+    }
+}
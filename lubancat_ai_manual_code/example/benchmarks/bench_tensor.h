@@ -0,0 +1,47 @@
+#ifndef _RKNN_DEMO_BENCH_TENSOR_H_
+#define _RKNN_DEMO_BENCH_TENSOR_H_
+
+#include "rknn_api.h"
+
+/**
+ * @brief Synthetic model output
+ *
+ * Every element is bg, a hit_ratio fraction of the elements (chosen with a fixed
+ * seed) is fg. Values are in dequantized units, [lo, hi] sets the int8
+ * quantization range so the data looks like a real affine quantized head.
+ */
+typedef struct {
+    int n_dims;
+    int dims[4];
+    float lo;
+    float hi;
+    float bg;
+    float fg;
+    float hit_ratio;
+} bench_tensor_spec_t;
+
+/**
+ * @brief Build output attrs and buffers the way rknn_outputs_get would return them
+ *
+ * With input_dir set the buffers are loaded from <input_dir>/output_<i>.bin (raw
+ * tensor data in the given type, e.g. dumped from an on-device run) instead.
+ *
+ * @param specs [in] Output shapes and synthetic value distribution
+ * @param n [in] Number of outputs
+ * @param type [in] RKNN_TENSOR_INT8 / RKNN_TENSOR_FLOAT16 / RKNN_TENSOR_FLOAT32
+ * @param input_dir [in] Recorded tensors, NULL for synthetic data
+ * @param attrs [out] n output attributes
+ * @param outputs [out] n outputs, free with bench_release_outputs
+ * @return int 0: success; -1: error
+ */
+int bench_make_outputs(const bench_tensor_spec_t* specs, int n, rknn_tensor_type type, const char* input_dir,
+                       rknn_tensor_attr* attrs, rknn_output* outputs);
+
+void bench_release_outputs(rknn_output* outputs, int n);
+
+/**
+ * @brief Deterministic pseudo random numbers (xorshift32)
+ */
+unsigned int bench_rand(unsigned int* state);
+
+#endif //_RKNN_DEMO_BENCH_TENSOR_H_
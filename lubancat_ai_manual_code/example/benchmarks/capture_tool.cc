@@ -0,0 +1,208 @@
+/*
+ * Inspect a librknncapture file or turn it into rknn_stub / bench input.
+ *
+ *   capture_tool info <capture>
+ *   capture_tool export <capture> <dir> [ctx]
+ *
+ * export writes <dir>/model.stub with output_<i>.bin / input_<i>.bin holding the
+ * frames of one context back to back, so the stub replays the recorded outputs
+ * run after run, and the *_postprocess_bench --input <dir> picks up the first frame.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "tensor_capture.h"
+
+static const char* type_name(rknn_tensor_type type)
+{
+    switch (type) {
+    case RKNN_TENSOR_FLOAT32: return "FP32";
+    case RKNN_TENSOR_FLOAT16: return "FP16";
+    case RKNN_TENSOR_INT8: return "INT8";
+    case RKNN_TENSOR_UINT8: return "UINT8";
+    case RKNN_TENSOR_INT16: return "INT16";
+    case RKNN_TENSOR_UINT16: return "UINT16";
+    case RKNN_TENSOR_INT32: return "INT32";
+    case RKNN_TENSOR_UINT32: return "UINT32";
+    case RKNN_TENSOR_INT64: return "INT64";
+    case RKNN_TENSOR_BOOL: return "BOOL";
+    default: return "UNKNOWN";
+    }
+}
+
+static const char* fmt_name(rknn_tensor_format fmt)
+{
+    switch (fmt) {
+    case RKNN_TENSOR_NCHW: return "NCHW";
+    case RKNN_TENSOR_NHWC: return "NHWC";
+    case RKNN_TENSOR_NC1HWC2: return "NC1HWC2";
+    default: return "UNDEFINED";
+    }
+}
+
+static const char* qnt_name(rknn_tensor_qnt_type qnt)
+{
+    switch (qnt) {
+    case RKNN_TENSOR_QNT_DFP: return "DFP";
+    case RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC: return "AFFINE";
+    default: return "NONE";
+    }
+}
+
+static std::string dims_str(const rknn_tensor_attr* attr)
+{
+    std::string s;
+    for (uint32_t i = 0; i < attr->n_dims; i++) {
+        if (i > 0) {
+            s += ",";
+        }
+        s += std::to_string(attr->dims[i]);
+    }
+    return s;
+}
+
+// data of want_float outputs is float32 whatever the model type
+static rknn_tensor_type data_type(const tensor_capture_tensor_t* t)
+{
+    return t->want_float ? RKNN_TENSOR_FLOAT32 : t->attr.type;
+}
+
+static int info(tensor_capture_t* cap)
+{
+    uint64_t n_frames, n_written, n_dropped;
+    tensor_capture_stats(cap, &n_frames, &n_written, &n_dropped);
+    printf("%llu frames (%llu written, %llu overwritten)\n", (unsigned long long)n_frames,
+           (unsigned long long)n_written, (unsigned long long)n_dropped);
+
+    static tensor_capture_frame_t frame;
+    uint64_t first_ts = 0, last_ts = 0, last_ctx = 0;
+    int got, index = 0;
+    while ((got = tensor_capture_next(cap, &frame)) == 1) {
+        if (index == 0) {
+            first_ts = frame.timestamp_ns;
+        }
+        last_ts = frame.timestamp_ns;
+        // print the layout once per context
+        if (index == 0 || frame.ctx != last_ctx) {
+            printf("ctx 0x%llx, frame %llu:\n", (unsigned long long)frame.ctx, (unsigned long long)frame.frame_id);
+            for (int i = 0; i < frame.n_tensors; i++) {
+                const tensor_capture_tensor_t* t = &frame.tensors[i];
+                printf("  %-6s %-24s %-16s %-8s %-5s zp=%d scale=%f %u bytes\n",
+                       t->kind == TENSOR_CAPTURE_INPUT ? "input" : "output", t->attr.name, dims_str(&t->attr).c_str(),
+                       fmt_name(t->attr.fmt), type_name(data_type(t)), t->attr.zp, t->attr.scale, t->size);
+            }
+        }
+        last_ctx = frame.ctx;
+        index++;
+    }
+    if (index > 1) {
+        printf("%.3f s from the first to the last frame\n", (last_ts - first_ts) / 1e9);
+    }
+    return got < 0 ? -1 : 0;
+}
+
+static int export_stub(tensor_capture_t* cap, const char* dir, uint64_t ctx)
+{
+    static tensor_capture_frame_t frame;
+    static tensor_capture_frame_t layout;
+    FILE* files[TENSOR_CAPTURE_MAX_TENSORS] = {NULL};
+    int n_frames = 0;
+    int got;
+    int ret = 0;
+    while (ret == 0 && (got = tensor_capture_next(cap, &frame)) == 1) {
+        if (ctx != 0 ? frame.ctx != ctx : n_frames > 0 && frame.ctx != layout.ctx) {
+            continue;
+        }
+        if (n_frames == 0) {
+            layout = frame;
+            int n_in = 0, n_out = 0;
+            for (int i = 0; i < frame.n_tensors; i++) {
+                const tensor_capture_tensor_t* t = &frame.tensors[i];
+                char path[512];
+                snprintf(path, sizeof(path), "%s/%s_%d.bin", dir, t->kind == TENSOR_CAPTURE_INPUT ? "input" : "output",
+                         t->kind == TENSOR_CAPTURE_INPUT ? n_in++ : n_out++);
+                files[i] = fopen(path, "wb");
+                if (files[i] == NULL) {
+                    printf("open %s fail!\n", path);
+                    ret = -1;
+                    break;
+                }
+            }
+            if (ret != 0) {
+                break;
+            }
+        } else if (frame.n_tensors != layout.n_tensors) {
+            // the model of this context changed its inputs (e.g. RKNN_CAPTURE_INPUTS), stop here
+            break;
+        }
+        for (int i = 0; i < frame.n_tensors; i++) {
+            if (fwrite(frame.tensors[i].data, 1, frame.tensors[i].size, files[i]) != frame.tensors[i].size) {
+                printf("write %s fail!\n", dir);
+                ret = -1;
+                break;
+            }
+        }
+        n_frames++;
+    }
+    for (int i = 0; i < TENSOR_CAPTURE_MAX_TENSORS; i++) {
+        if (files[i] != NULL) {
+            fclose(files[i]);
+        }
+    }
+    if (ret != 0 || got < 0) {
+        return -1;
+    }
+    if (n_frames == 0) {
+        printf("no frames to export\n");
+        return -1;
+    }
+
+    std::string stub_path = std::string(dir) + "/model.stub";
+    FILE* fp = fopen(stub_path.c_str(), "w");
+    if (fp == NULL) {
+        printf("open %s fail!\n", stub_path.c_str());
+        return -1;
+    }
+    fprintf(fp, "# rknn_stub exported from a capture, %d frames of ctx 0x%llx\n", n_frames,
+            (unsigned long long)layout.ctx);
+    int n_in = 0, n_out = 0;
+    for (int i = 0; i < layout.n_tensors; i++) {
+        const tensor_capture_tensor_t* t = &layout.tensors[i];
+        int is_input = t->kind == TENSOR_CAPTURE_INPUT;
+        fprintf(fp, "%s %s %s %s %s %s %d %f", is_input ? "input " : "output", t->attr.name, dims_str(&t->attr).c_str(),
+                fmt_name(t->attr.fmt), type_name(data_type(t)), qnt_name(t->attr.qnt_type), t->attr.zp, t->attr.scale);
+        if (is_input) {
+            n_in++;
+            fprintf(fp, "\n");
+        } else {
+            fprintf(fp, " output_%d.bin\n", n_out++);
+        }
+    }
+    fclose(fp);
+    printf("exported %d frames to %s\n", n_frames, stub_path.c_str());
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3 || (strcmp(argv[1], "info") != 0 && strcmp(argv[1], "export") != 0) ||
+        (strcmp(argv[1], "export") == 0 && argc < 4)) {
+        printf("Usage: %s info <capture>\n", argv[0]);
+        printf("       %s export <capture> <dir> [ctx]\n", argv[0]);
+        return -1;
+    }
+    tensor_capture_t cap;
+    if (tensor_capture_open(argv[2], &cap) != 0) {
+        return -1;
+    }
+    int ret;
+    if (strcmp(argv[1], "info") == 0) {
+        ret = info(&cap);
+    } else {
+        ret = export_stub(&cap, argv[3], argc > 4 ? strtoull(argv[4], NULL, 0) : 0);
+    }
+    tensor_capture_close(&cap);
+    return ret;
+}
@@ -0,0 +1,120 @@
+/*
+ * CPU image preprocess (convert_image_cpu), the fallback path of convert_image
+ * when RGA is disabled or the width is not aligned.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image_utils.h"
+#include "bench.h"
+
+typedef struct {
+    image_buffer_t src;
+    image_buffer_t dst;
+    image_rect_t dst_box;
+    bool use_dst_box;
+} image_bench_t;
+
+static int alloc_image(image_buffer_t* img, int width, int height, image_format_t format)
+{
+    memset(img, 0, sizeof(image_buffer_t));
+    img->width = width;
+    img->height = height;
+    img->width_stride = width;
+    img->height_stride = height;
+    img->format = format;
+    img->size = get_image_size(img);
+    img->virt_addr = (unsigned char*)malloc(img->size);
+    if (img->virt_addr == NULL) {
+        printf("malloc image buffer fail!\n");
+        return -1;
+    }
+    return 0;
+}
+
+// gradient with some texture, the content does not change the cost of bilinear scaling
+static void fill_image(image_buffer_t* img)
+{
+    for (int i = 0; i < img->size; i++) {
+        img->virt_addr[i] = (unsigned char)((i * 7) ^ (i >> 9));
+    }
+}
+
+static int setup(image_bench_t* b, const image_buffer_t* src, int dst_width, int dst_height, bool letterbox)
+{
+    memset(b, 0, sizeof(image_bench_t));
+    b->src = *src;
+    if (alloc_image(&b->dst, dst_width, dst_height, src->format) != 0) {
+        return -1;
+    }
+    if (letterbox) {
+        // same box as convert_image_with_letterbox: keep aspect ratio, center, align to 4 / 2
+        float scale_w = (float)dst_width / src->width;
+        float scale_h = (float)dst_height / src->height;
+        float scale = scale_w < scale_h ? scale_w : scale_h;
+        int resize_w = (int)(src->width * scale);
+        int resize_h = (int)(src->height * scale);
+        resize_w -= resize_w % 4;
+        resize_h -= resize_h % 2;
+        b->dst_box.left = (dst_width - resize_w) / 2;
+        b->dst_box.top = (dst_height - resize_h) / 2;
+        b->dst_box.top -= b->dst_box.top % 2;
+        b->dst_box.right = b->dst_box.left + resize_w - 1;
+        b->dst_box.bottom = b->dst_box.top + resize_h - 1;
+        b->use_dst_box = true;
+    }
+    return 0;
+}
+
+static void run_convert(void* arg)
+{
+    image_bench_t* b = (image_bench_t*)arg;
+    convert_image_cpu(&b->src, &b->dst, NULL, b->use_dst_box ? &b->dst_box : NULL, 114);
+    bench_do_not_optimize(b->dst.virt_addr);
+}
+
+int main(int argc, char** argv)
+{
+    bench_options_t opts;
+    if (bench_parse_args(argc, argv, "image_preprocess", &opts) != 0) {
+        return -1;
+    }
+
+    image_buffer_t rgb;
+    image_buffer_t nv12;
+    memset(&rgb, 0, sizeof(image_buffer_t));
+    if (opts.input != NULL) {
+        if (read_image(opts.input, &rgb) != 0 || rgb.format != IMAGE_FORMAT_RGB888) {
+            printf("read RGB888 image %s fail!\n", opts.input);
+            return -1;
+        }
+    } else {
+        if (alloc_image(&rgb, 1920, 1080, IMAGE_FORMAT_RGB888) != 0) {
+            return -1;
+        }
+        fill_image(&rgb);
+    }
+    if (alloc_image(&nv12, rgb.width, rgb.height, IMAGE_FORMAT_YUV420SP_NV12) != 0) {
+        return -1;
+    }
+    fill_image(&nv12);
+
+    image_bench_t bench;
+    if (setup(&bench, &rgb, 640, 640, true) == 0) {
+        bench_run("convert_image_cpu/rgb888_letterbox_640", run_convert, &bench);
+        free(bench.dst.virt_addr);
+    }
+    if (setup(&bench, &rgb, 640, 640, false) == 0) {
+        bench_run("convert_image_cpu/rgb888_resize_640", run_convert, &bench);
+        free(bench.dst.virt_addr);
+    }
+    if (setup(&bench, &nv12, 640, 640, true) == 0) {
+        bench_run("convert_image_cpu/nv12_letterbox_640", run_convert, &bench);
+        free(bench.dst.virt_addr);
+    }
+
+    free(rgb.virt_addr);
+    free(nv12.virt_addr);
+    return bench_finish();
+}
@@ -0,0 +1,217 @@
+/*
+ * melotts middle_process: durations to the decoder alignment. The dense reference is the
+ * implementation before the sparse rewrite, both are checked for identical output first.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+
+#include "process.h"
+#include "bench.h"
+
+typedef struct {
+    std::vector<float> log_w;
+    std::vector<float> x_mask;
+    std::vector<float> attn;
+    std::vector<float> y_mask;
+    std::vector<int> frame_phone;       // sparse path, reused across runs like the pipeline's
+    float speed;
+    int frames;
+} middle_bench_t;
+
+// reference: dense masks and index matrices of PREDICTED_LENGTHS_MAX x MAX_LENGTH
+static void compute_output_padding_mask(std::vector<float> &output_padding_mask, int predicted_lengths_max_real, int predicted_lengths_max)
+{
+    int index = 0;
+    std::transform(output_padding_mask.begin(), output_padding_mask.end(), output_padding_mask.begin(),
+                   [&index, predicted_lengths_max_real](int i)
+                   {
+                       float result = (float)(index < predicted_lengths_max_real) ;
+                       ++index;
+                       return result;
+                   });
+}
+
+static void compute_attn_mask(std::vector<float> &output_padding_mask, std::vector<float> &input_padding_mask,
+                              std::vector<int> &attn_mask, int predicted_lengths_max, int input_padding_mask_size)
+{
+    int index = 0;
+    std::transform(attn_mask.begin(), attn_mask.end(), attn_mask.begin(),
+                    [&index, &output_padding_mask, &input_padding_mask, predicted_lengths_max, input_padding_mask_size](int k)
+                    {
+                        int i = index / predicted_lengths_max;
+                        int j = index % predicted_lengths_max;
+                        ++index;
+                        return int(output_padding_mask[j] * input_padding_mask[i]);
+                    });
+}
+
+static void compute_duration(const std::vector<float> &exp_log_duration, const std::vector<float> &input_padding_mask,
+                             std::vector<float> &duration, float length_scale)
+{
+    std::transform(exp_log_duration.begin(), exp_log_duration.end(), input_padding_mask.begin(), duration.begin(),
+                   [length_scale](float exp_log_val, float mask_val)
+                   {
+                       return ceil(exp_log_val * mask_val * length_scale);
+                   });
+}
+
+static void compute_valid_indices(const std::vector<float> &cum_duration, std::vector<int> &valid_indices, int input_padding_mask_size, int predicted_lengths_max)
+{
+    std::vector<int> indices(valid_indices.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::for_each(indices.begin(), indices.end(),
+                  [cum_duration, &valid_indices, predicted_lengths_max](int index)
+                  {
+                      int i = index / predicted_lengths_max;
+                      int j = index % predicted_lengths_max;
+                      valid_indices[index] = j < cum_duration[i] ? 1 : 0;
+                  });
+}
+
+static std::vector<float> exp_vector(const std::vector<float> &vec)
+{
+    std::vector<float> result(vec.size());
+    std::transform(vec.begin(), vec.end(), result.begin(), [](float v)
+                   { return exp(v); });
+    return result;
+}
+
+static std::vector<float> cumsum(const std::vector<float> &vec)
+{
+    std::vector<float> result(vec.size());
+    std::partial_sum(vec.begin(), vec.end(), result.begin());
+    return result;
+}
+
+static void transpose_mul(const std::vector<int> &input, int input_rows, int input_cols, std::vector<int> attn_mask, std::vector<float> &output)
+{
+    std::vector<int> indices(input.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::for_each(indices.begin(), indices.end(),
+                  [&input, &attn_mask, &output, input_rows, input_cols](int index)
+                  {
+                    int i = index / input_cols;
+                    int j = index % input_cols;
+                    output[j * input_rows + i] = (float)(input[index] * attn_mask[index]);
+                  });
+}
+
+static void compute_pad_indices(const std::vector<int> &valid_indices, std::vector<int> &sliced_indices, int input_length, int output_length)
+{
+    int padded_length = input_length + 1;
+    std::vector<int> padded_indices(padded_length * output_length, 0);
+
+    std::copy(valid_indices.begin(), valid_indices.end(), padded_indices.begin() + output_length);
+
+    std::copy(padded_indices.begin(), padded_indices.begin() + input_length * output_length, sliced_indices.begin());
+
+    std::transform(valid_indices.begin(), valid_indices.end(), sliced_indices.begin(),
+                   sliced_indices.begin(), std::minus<int>());
+}
+
+static void middle_process_dense(std::vector<float> log_w, std::vector<float> x_mask, std::vector<float> &attn,
+                    std::vector<float> &y_mask, float speed, int &predicted_lengths_max_real)
+{
+    float length_scale = 1.0f / speed;
+    std::vector<float> w(LOG_DURATION_SIZE);
+
+    std::vector<float> exp_log_w = exp_vector(log_w);
+    compute_duration(exp_log_w, x_mask, w, length_scale);
+    float predicted_length_sum = std::accumulate(w.begin(), w.end(), 0.0f);
+    predicted_lengths_max_real = std::max(1.0f, predicted_length_sum);
+    int predicted_lengths_max = PREDICTED_LENGTHS_MAX;
+    if(predicted_lengths_max_real > predicted_lengths_max)
+    {
+        predicted_lengths_max_real = predicted_lengths_max;
+    }
+    compute_output_padding_mask(y_mask, predicted_lengths_max_real, predicted_lengths_max);
+    int x_mask_size = MAX_LENGTH;
+    std::vector<int> attn_mask(predicted_lengths_max * x_mask_size);
+    compute_attn_mask(y_mask, x_mask, attn_mask, predicted_lengths_max, x_mask_size);
+    std::vector<float> cum_duration = cumsum(w);
+    std::vector<int> valid_indices(x_mask_size * predicted_lengths_max, 0);
+    compute_valid_indices(cum_duration, valid_indices, x_mask_size, predicted_lengths_max);
+    std::vector<int> padded_indices(x_mask_size * predicted_lengths_max, 0);
+    compute_pad_indices(valid_indices, padded_indices, x_mask_size, predicted_lengths_max);
+    transpose_mul(padded_indices, x_mask_size, predicted_lengths_max, attn_mask, attn);
+}
+
+// n_phones valid phones with durations of 1..6 frames
+static void make_input(middle_bench_t* b, int n_phones, float speed, unsigned int seed)
+{
+    b->log_w.assign(LOGW_SIZE, 0.0f);
+    b->x_mask.assign(X_MASK_SIZE, 0.0f);
+    for (int i = 0; i < n_phones && i < MAX_LENGTH; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        b->log_w[i] = logf(0.5f + 5.0f * (float)(seed >> 8) / 16777216.0f);
+        b->x_mask[i] = 1.0f;
+    }
+    b->attn.assign(ATTN_SIZE, 0.0f);
+    b->y_mask.assign(Y_MASK_SIZE, 0.0f);
+    b->speed = speed;
+}
+
+static int check_same(int n_phones, float speed, unsigned int seed)
+{
+    middle_bench_t a, b;
+    make_input(&a, n_phones, speed, seed);
+    make_input(&b, n_phones, speed, seed);
+    // stale values from a previous sentence must not leak into the sparse output
+    std::fill(b.attn.begin(), b.attn.end(), 1.0f);
+    std::fill(b.y_mask.begin(), b.y_mask.end(), 1.0f);
+    middle_process_dense(a.log_w, a.x_mask, a.attn, a.y_mask, a.speed, a.frames);
+    middle_process(b.log_w, b.x_mask, b.attn, b.y_mask, b.speed, b.frames, b.frame_phone);
+    if (a.frames != b.frames || a.attn != b.attn || a.y_mask != b.y_mask) {
+        printf("middle_process differs from the dense reference: phones=%d speed=%.2f frames %d / %d\n", n_phones, speed,
+               a.frames, b.frames);
+        return -1;
+    }
+    return 0;
+}
+
+static void run_dense(void* arg)
+{
+    middle_bench_t* b = (middle_bench_t*)arg;
+    middle_process_dense(b->log_w, b->x_mask, b->attn, b->y_mask, b->speed, b->frames);
+    bench_do_not_optimize(b->attn.data());
+}
+
+static void run_sparse(void* arg)
+{
+    middle_bench_t* b = (middle_bench_t*)arg;
+    middle_process(b->log_w, b->x_mask, b->attn, b->y_mask, b->speed, b->frames, b->frame_phone);
+    bench_do_not_optimize(b->attn.data());
+}
+
+int main(int argc, char** argv)
+{
+    bench_options_t opts;
+    if (bench_parse_args(argc, argv, "melotts_middle", &opts) != 0) {
+        return -1;
+    }
+
+    const int phones[] = {1, 20, 60, 120, 256};
+    const float speeds[] = {0.5f, 1.0f, 1.7f};
+    for (int p : phones) {
+        for (float s : speeds) {
+            if (check_same(p, s, 0x9e3779b9u + p) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    static middle_bench_t short_input, long_input;
+    make_input(&short_input, 40, 1.0f, 1);
+    make_input(&long_input, 120, 1.0f, 2);
+    bench_run("middle_process/dense_reference/40_phones", run_dense, &short_input);
+    bench_run("middle_process/sparse/40_phones", run_sparse, &short_input);
+    bench_run("middle_process/dense_reference/120_phones", run_dense, &long_input);
+    bench_run("middle_process/sparse/120_phones", run_sparse, &long_input);
+    return bench_finish();
+}
@@ -0,0 +1,95 @@
+/*
+ * ppocrv4 detection (dbnet_postprocess) and recognition (rec_postprocess, CTC
+ * greedy decode) post process.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "ppocr_system.h"
+#include "bench.h"
+
+#define DET_WIDTH 480
+#define DET_HEIGHT 480
+#define DET_TEXT_LINES 24
+#define REC_SEQ_LEN 80
+
+typedef struct {
+    std::vector<float> det_output;
+    std::vector<float> rec_output;
+    std::string score_mode;
+    std::string box_type;
+    ppocr_det_result det_result;
+    ppocr_rec_result rec_result;
+} ppocr_bench_t;
+
+// probability map with a few text lines of different length, the rest is background
+static void make_det_output(std::vector<float>& map)
+{
+    map.assign(DET_WIDTH * DET_HEIGHT, 0.02f);
+    int line_height = DET_HEIGHT / DET_TEXT_LINES;
+    for (int l = 0; l < DET_TEXT_LINES; l++) {
+        int top = l * line_height + line_height / 4;
+        int bottom = top + line_height / 2;
+        int left = 10 + (l * 37) % 60;
+        int right = DET_WIDTH - 10 - (l * 53) % (DET_WIDTH / 2);
+        for (int y = top; y < bottom; y++) {
+            for (int x = left; x < right; x++) {
+                map[y * DET_WIDTH + x] = 0.9f;
+            }
+        }
+    }
+}
+
+// per step one dominant class, blank every other step
+static void make_rec_output(std::vector<float>& logits)
+{
+    logits.assign(REC_SEQ_LEN * MODEL_OUT_CHANNEL, 0.0f);
+    for (int t = 0; t < REC_SEQ_LEN; t++) {
+        int cls = t % 2 == 0 ? 0 : 1 + (t * 131) % (MODEL_OUT_CHANNEL - 1);
+        logits[t * MODEL_OUT_CHANNEL + cls] = 0.95f;
+    }
+}
+
+static void run_dbnet(void* arg)
+{
+    ppocr_bench_t* b = (ppocr_bench_t*)arg;
+    dbnet_postprocess(b->det_output.data(), DET_WIDTH, DET_HEIGHT, 0.3f, 0.6f, false, b->score_mode, 1.5f, b->box_type,
+                      1.0f, 1.0f, &b->det_result);
+    bench_do_not_optimize(&b->det_result);
+}
+
+static void run_rec(void* arg)
+{
+    ppocr_bench_t* b = (ppocr_bench_t*)arg;
+    rec_postprocess(b->rec_output.data(), MODEL_OUT_CHANNEL, REC_SEQ_LEN, &b->rec_result);
+    bench_do_not_optimize(&b->rec_result);
+}
+
+int main(int argc, char** argv)
+{
+    bench_options_t opts;
+    if (bench_parse_args(argc, argv, "ppocr_postprocess", &opts) != 0) {
+        return -1;
+    }
+
+    static ppocr_bench_t bench;
+    make_det_output(bench.det_output);
+    make_rec_output(bench.rec_output);
+
+    const char* score_modes[2] = {"slow", "fast"};
+    const char* box_types[2] = {"poly", "quad"};
+    for (int i = 0; i < 2; i++) {
+        bench.score_mode = score_modes[i];
+        bench.box_type = box_types[i];
+        memset(&bench.det_result, 0, sizeof(ppocr_det_result));
+        run_dbnet(&bench);
+        printf("dbnet %s/%s: %d boxes\n", score_modes[i], box_types[i], bench.det_result.count);
+        std::string name = std::string("dbnet_postprocess/") + score_modes[i] + "_" + box_types[i];
+        bench_run(name.c_str(), run_dbnet, &bench);
+    }
+
+    bench_run("rec_postprocess/ctc_greedy", run_rec, &bench);
+    return bench_finish();
+}
@@ -0,0 +1,101 @@
+/*
+ * ppseg post_process: argmax on the native output type, label map upsample and
+ * palette colorize / blend.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ppseg.h"
+#include "bench.h"
+#include "bench_tensor.h"
+
+#define MODEL_WIDTH 1024
+#define MODEL_HEIGHT 512
+
+typedef struct {
+    rknn_app_context_t app_ctx;
+    rknn_tensor_attr attr;
+    rknn_output output;
+    image_buffer_t result_img;
+} ppseg_bench_t;
+
+static int setup(ppseg_bench_t* b, rknn_tensor_type type, const char* input_dir, int result_width, int result_height)
+{
+    // every class score drawn from the same distribution, the argmax is data dependent
+    const bench_tensor_spec_t spec = {4, {1, SEG_CLASS_NUM, MODEL_HEIGHT, MODEL_WIDTH}, -10.0f, 10.0f, -2.0f, 4.0f, 0.1f};
+
+    memset(b, 0, sizeof(ppseg_bench_t));
+    if (bench_make_outputs(&spec, 1, type, input_dir, &b->attr, &b->output) != 0) {
+        return -1;
+    }
+    b->app_ctx.model_channel = 3;
+    b->app_ctx.model_width = MODEL_WIDTH;
+    b->app_ctx.model_height = MODEL_HEIGHT;
+    if (init_post_process(&b->app_ctx) != 0) {
+        return -1;
+    }
+    b->result_img.width = result_width;
+    b->result_img.height = result_height;
+    b->result_img.format = IMAGE_FORMAT_RGB888;
+    b->result_img.size = get_image_size(&b->result_img);
+    return 0;
+}
+
+static void release(ppseg_bench_t* b)
+{
+    deinit_post_process(&b->app_ctx);
+    bench_release_outputs(&b->output, 1);
+    if (b->result_img.virt_addr != NULL) {
+        free(b->result_img.virt_addr);
+    }
+}
+
+static void run_argmax(void* arg)
+{
+    ppseg_bench_t* b = (ppseg_bench_t*)arg;
+    segment_argmax(&b->attr, b->output.buf, b->app_ctx.label_map);
+    bench_do_not_optimize(b->app_ctx.label_map);
+}
+
+static void run_post_process(void* arg)
+{
+    ppseg_bench_t* b = (ppseg_bench_t*)arg;
+    post_process(&b->app_ctx, &b->attr, b->output.buf, &b->result_img);
+    bench_do_not_optimize(b->result_img.virt_addr);
+}
+
+int main(int argc, char** argv)
+{
+    bench_options_t opts;
+    if (bench_parse_args(argc, argv, "ppseg_postprocess", &opts) != 0) {
+        return -1;
+    }
+
+    static ppseg_bench_t bench;
+    const rknn_tensor_type types[3] = {RKNN_TENSOR_INT8, RKNN_TENSOR_FLOAT16, RKNN_TENSOR_FLOAT32};
+    const char* names[3] = {"segment_argmax/int8", "segment_argmax/fp16", "segment_argmax/fp32"};
+    for (int i = 0; i < 3; i++) {
+        if (opts.input != NULL && types[i] != RKNN_TENSOR_INT8) {
+            continue;
+        }
+        if (setup(&bench, types[i], opts.input, MODEL_WIDTH, MODEL_HEIGHT) != 0) {
+            return -1;
+        }
+        bench_run(names[i], run_argmax, &bench);
+        release(&bench);
+    }
+
+    if (setup(&bench, RKNN_TENSOR_INT8, opts.input, MODEL_WIDTH, MODEL_HEIGHT) == 0) {
+        bench_run("post_process/int8_model_size", run_post_process, &bench);
+        release(&bench);
+    }
+    if (setup(&bench, RKNN_TENSOR_INT8, opts.input, 1920, 1080) == 0) {
+        bench.app_ctx.blend_alpha = 0.5f;
+        // post_process blends onto the current content of the result image
+        run_post_process(&bench);
+        bench_run("post_process/int8_1080p_blend", run_post_process, &bench);
+        release(&bench);
+    }
+    return bench_finish();
+}
@@ -0,0 +1,276 @@
+/*
+ * Replay the outputs recorded by librknncapture through a demo post_process.
+ *
+ *   yolov5_replay cap.rkcap [--loops n] [--hashes out.txt] [--expect hashes.txt]
+ *
+ * Every frame is post-processed with the recorded output attrs (type, zp, scale),
+ * so the result is what the board produced for that frame. The result of every
+ * frame is hashed: --hashes saves them, --expect compares against a saved file and
+ * returns 1 on the first difference, which makes a capture a bit-exact regression
+ * test for post_process changes. --loops repeats the capture for a steady fps.
+ *
+ * Built once per model like yolo_postprocess_bench.cc, with BENCH_PPSEG for ppseg.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#if defined(BENCH_YOLOV5)
+#include "yolov5.h"
+#elif defined(BENCH_YOLOV8)
+#include "yolov8.h"
+#elif defined(BENCH_YOLO11)
+#include "yolo11.h"
+#elif defined(BENCH_YOLOV10)
+#include "yolov10.h"
+#elif defined(BENCH_YOLOV8_OBB)
+#include "yolov8_obb.h"
+#elif defined(BENCH_YOLOV8_POSE)
+#include "yolov8_pose.h"
+#elif defined(BENCH_PPSEG)
+#include "ppseg.h"
+#else
+#error "define one of BENCH_YOLOV5 / BENCH_YOLOV8 / BENCH_YOLO11 / BENCH_YOLOV10 / BENCH_YOLOV8_OBB / BENCH_YOLOV8_POSE / BENCH_PPSEG"
+#endif
+
+#include "tensor_capture.h"
+#include "easy_timer.h"
+
+typedef struct {
+    rknn_app_context_t app_ctx;
+    rknn_tensor_attr input_attr;
+    rknn_tensor_attr output_attrs[TENSOR_CAPTURE_MAX_TENSORS];
+    rknn_output outputs[TENSOR_CAPTURE_MAX_TENSORS];
+#if defined(BENCH_PPSEG)
+    image_buffer_t result_img;
+#else
+    letterbox_t letter_box;
+    object_detect_result_list od_results;
+#endif
+} replay_t;
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// output attrs and the rknn_output list of one frame, data used in place from the mapping
+static int load_frame(replay_t* r, const tensor_capture_frame_t* frame)
+{
+    int n_output = 0;
+    for (int i = 0; i < frame->n_tensors; i++) {
+        const tensor_capture_tensor_t* t = &frame->tensors[i];
+        if (t->kind == TENSOR_CAPTURE_INPUT) {
+            r->input_attr = t->attr;
+            continue;
+        }
+        rknn_tensor_attr* attr = &r->output_attrs[n_output];
+        *attr = t->attr;
+        if (t->want_float) {
+            attr->type = RKNN_TENSOR_FLOAT32;
+        }
+        rknn_output* out = &r->outputs[n_output];
+        memset(out, 0, sizeof(rknn_output));
+        out->index = attr->index;
+        out->want_float = t->want_float;
+        out->size = t->size;
+        out->buf = (void*)t->data;
+        n_output++;
+    }
+    if (n_output == 0) {
+        return -1;
+    }
+    r->app_ctx.io_num.n_input = 1;
+    r->app_ctx.io_num.n_output = n_output;
+    r->app_ctx.input_attrs = &r->input_attr;
+    r->app_ctx.output_attrs = r->output_attrs;
+#if !defined(BENCH_PPSEG)
+    int want_float = 0;
+    for (int i = 0; i < n_output; i++) {
+        want_float |= r->outputs[i].want_float;
+    }
+    r->app_ctx.is_quant = !want_float && r->output_attrs[0].type == RKNN_TENSOR_INT8;
+#endif
+    return 0;
+}
+
+static void set_model_size(const tensor_capture_frame_t* frame, int* width, int* height)
+{
+    *width = 0;
+    *height = 0;
+    for (int i = 0; i < frame->n_tensors; i++) {
+        const rknn_tensor_attr* attr = &frame->tensors[i].attr;
+        if (frame->tensors[i].kind != TENSOR_CAPTURE_INPUT || attr->n_dims != 4) {
+            continue;
+        }
+        if (attr->fmt == RKNN_TENSOR_NCHW) {
+            *height = attr->dims[2];
+            *width = attr->dims[3];
+        } else {
+            *height = attr->dims[1];
+            *width = attr->dims[2];
+        }
+        return;
+    }
+}
+
+static uint64_t run_frame(replay_t* r)
+{
+    uint64_t hash = 1469598103934665603ull;
+#if defined(BENCH_PPSEG)
+    post_process(&r->app_ctx, &r->output_attrs[0], r->outputs[0].buf, &r->result_img);
+    hash = fnv1a(hash, r->app_ctx.label_map, r->app_ctx.model_width * r->app_ctx.model_height);
+#else
+    post_process(&r->app_ctx, r->outputs, &r->letter_box, BOX_THRESH, NMS_THRESH, &r->od_results);
+    hash = fnv1a(hash, &r->od_results.count, sizeof(r->od_results.count));
+    hash = fnv1a(hash, r->od_results.results, sizeof(r->od_results.results[0]) * r->od_results.count);
+#endif
+    return hash;
+}
+
+static void usage(const char* name)
+{
+    printf("Usage: %s <capture> [--loops n] [--hashes out.txt] [--expect hashes.txt]\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return -1;
+    }
+    const char* capture_path = argv[1];
+    const char* hashes_path = NULL;
+    const char* expect_path = NULL;
+    int loops = 1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hashes") == 0 && i + 1 < argc) {
+            hashes_path = argv[++i];
+        } else if (strcmp(argv[i], "--expect") == 0 && i + 1 < argc) {
+            expect_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    tensor_capture_t cap;
+    if (tensor_capture_open(capture_path, &cap) != 0) {
+        return -1;
+    }
+
+    std::vector<unsigned long long> expected;
+    if (expect_path != NULL) {
+        FILE* fp = fopen(expect_path, "r");
+        if (fp == NULL) {
+            printf("open %s fail!\n", expect_path);
+            tensor_capture_close(&cap);
+            return -1;
+        }
+        unsigned long long frame_id, hash;
+        while (fscanf(fp, "%llu %llx", &frame_id, &hash) == 2) {
+            expected.push_back(hash);
+        }
+        fclose(fp);
+    }
+    FILE* hashes_fp = NULL;
+    if (hashes_path != NULL && (hashes_fp = fopen(hashes_path, "w")) == NULL) {
+        printf("open %s fail!\n", hashes_path);
+        tensor_capture_close(&cap);
+        return -1;
+    }
+
+    static replay_t r;
+    static tensor_capture_frame_t frame;
+    memset(&r, 0, sizeof(replay_t));
+#if !defined(BENCH_PPSEG)
+    r.letter_box.scale = 1.0f;
+#endif
+    int ret = 0;
+    int n_frames = 0;
+    int n_mismatch = 0;
+    double total_ms = 0;
+    TIMER timer;
+    for (int loop = 0; loop < loops && ret == 0; loop++) {
+        tensor_capture_rewind(&cap);
+        int index = 0;
+        int got;
+        while ((got = tensor_capture_next(&cap, &frame)) == 1) {
+            if (load_frame(&r, &frame) != 0) {
+                continue;
+            }
+            if (r.app_ctx.model_width == 0) {
+                set_model_size(&frame, &r.app_ctx.model_width, &r.app_ctx.model_height);
+                r.app_ctx.model_channel = 3;
+#if defined(BENCH_PPSEG)
+                if (r.app_ctx.model_width == 0) {
+                    // no input recorded, ppseg output is [1, classes, h, w]
+                    r.app_ctx.model_height = r.output_attrs[0].dims[2];
+                    r.app_ctx.model_width = r.output_attrs[0].dims[3];
+                }
+                if (init_post_process(&r.app_ctx) != 0) {
+                    ret = -1;
+                    break;
+                }
+                r.result_img.width = r.app_ctx.model_width;
+                r.result_img.height = r.app_ctx.model_height;
+#endif
+            }
+            timer.tik();
+            uint64_t hash = run_frame(&r);
+            timer.tok();
+            total_ms += timer.get_time();
+            n_frames++;
+
+            if (loop == 0 && hashes_fp != NULL) {
+                fprintf(hashes_fp, "%llu %016llx\n", (unsigned long long)frame.frame_id, (unsigned long long)hash);
+            }
+            if (loop == 0 && expect_path != NULL) {
+                if (index >= (int)expected.size() || expected[index] != hash) {
+                    printf("frame %llu: result differs from %s\n", (unsigned long long)frame.frame_id, expect_path);
+                    n_mismatch++;
+                }
+            }
+            index++;
+        }
+        if (got < 0) {
+            ret = -1;
+        }
+        if (loop == 0 && expect_path != NULL && index != (int)expected.size()) {
+            printf("%d frames replayed, %d expected\n", index, (int)expected.size());
+            n_mismatch++;
+        }
+    }
+
+    if (hashes_fp != NULL) {
+        fclose(hashes_fp);
+    }
+#if defined(BENCH_PPSEG)
+    deinit_post_process(&r.app_ctx);
+    if (r.result_img.virt_addr != NULL) {
+        free(r.result_img.virt_addr);
+    }
+#endif
+    tensor_capture_close(&cap);
+
+    if (n_frames > 0) {
+        printf("replayed %d frames, post_process %.3f ms/frame, %.1f fps\n", n_frames, total_ms / n_frames,
+               total_ms > 0 ? n_frames * 1000.0 / total_ms : 0.0);
+    }
+    if (ret != 0) {
+        return ret;
+    }
+    if (n_mismatch > 0) {
+        printf("%d mismatches\n", n_mismatch);
+        return 1;
+    }
+    return 0;
+}
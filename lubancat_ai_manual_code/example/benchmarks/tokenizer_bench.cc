@@ -0,0 +1,90 @@
+/*
+ * Text tokenizers of the clip demos: ChineseCLIPTokenizer (wordpiece, cn_clip)
+ * and, when clip_vocab.h is available, CLIPTokenizer (bpe, clip / yolo_world / owl-vit).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "cn_clip_tokenizer.h"
+#if defined(BENCH_WITH_CLIP_BPE)
+#include "clip_tokenizer.h"
+#endif
+#include "bench.h"
+
+#define SEQUENCE_LEN 52
+
+static const char* cn_texts[] = {
+    "一只可爱的小狗在草地上奔跑",
+    "a photo of a cat sitting on the sofa",
+    "夕阳下的海边，几个人在散步",
+    "红色的汽车停在路边",
+};
+
+static const char* en_texts[] = {
+    "a photo of a dog running on the grass",
+    "a diagram of the memory hierarchy, with caches, DRAM and the NPU",
+    "person, bicycle, car, motorcycle, airplane, bus, train, truck",
+    "an extraordinarily photogenic sunset over mountainous coastlines",
+};
+
+typedef struct {
+    ChineseCLIPTokenizer* cn_tokenizer;
+#if defined(BENCH_WITH_CLIP_BPE)
+    CLIPTokenizer* clip_tokenizer;
+#endif
+    std::vector<int> ids;
+} tokenizer_bench_t;
+
+static void run_cn_clip(void* arg)
+{
+    tokenizer_bench_t* b = (tokenizer_bench_t*)arg;
+    for (size_t i = 0; i < sizeof(cn_texts) / sizeof(cn_texts[0]); i++) {
+        b->ids = b->cn_tokenizer->tokenize(cn_texts[i]);
+    }
+    bench_do_not_optimize(b->ids.data());
+}
+
+#if defined(BENCH_WITH_CLIP_BPE)
+static void run_clip(void* arg)
+{
+    tokenizer_bench_t* b = (tokenizer_bench_t*)arg;
+    for (size_t i = 0; i < sizeof(en_texts) / sizeof(en_texts[0]); i++) {
+        b->ids = b->clip_tokenizer->tokenize(en_texts[i], SEQUENCE_LEN, false);
+    }
+    bench_do_not_optimize(b->ids.data());
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    bench_options_t opts;
+    if (bench_parse_args(argc, argv, "tokenizer", &opts) != 0) {
+        return -1;
+    }
+
+    const char* vocab_path = opts.input != NULL ? opts.input : BENCH_CN_CLIP_VOCAB;
+    FILE* fp = fopen(vocab_path, "r");
+    if (fp == NULL) {
+        printf("open vocab %s fail! pass --input <vocab.txt>\n", vocab_path);
+        return -1;
+    }
+    fclose(fp);
+
+    static tokenizer_bench_t bench;
+    bench.cn_tokenizer = new ChineseCLIPTokenizer(vocab_path, SEQUENCE_LEN);
+    bench_run("cn_clip_tokenize/4_texts", run_cn_clip, &bench);
+    delete bench.cn_tokenizer;
+
+#if defined(BENCH_WITH_CLIP_BPE)
+    bench.clip_tokenizer = new CLIPTokenizer();
+    bench_run("clip_tokenize/4_texts", run_clip, &bench);
+    delete bench.clip_tokenizer;
+#else
+    (void)en_texts;
+    printf("clip_vocab.h not found, skip clip_tokenize\n");
+#endif
+    return bench_finish();
+}
@@ -0,0 +1,138 @@
+/*
+ * post_process of the yolo demos on synthetic or recorded heads.
+ *
+ * Every demo defines its own rknn_app_context_t / post_process, so this file is
+ * built once per model with one of BENCH_YOLOV5 / BENCH_YOLOV8 / BENCH_YOLO11 /
+ * BENCH_YOLOV10 / BENCH_YOLOV8_OBB / BENCH_YOLOV8_POSE defined.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(BENCH_YOLOV5)
+#include "yolov5.h"
+#define BENCH_SUITE "yolov5_postprocess"
+#elif defined(BENCH_YOLOV8)
+#include "yolov8.h"
+#define BENCH_SUITE "yolov8_postprocess"
+#elif defined(BENCH_YOLO11)
+#include "yolo11.h"
+#define BENCH_SUITE "yolo11_postprocess"
+#elif defined(BENCH_YOLOV10)
+#include "yolov10.h"
+#define BENCH_SUITE "yolov10_postprocess"
+#elif defined(BENCH_YOLOV8_OBB)
+#include "yolov8_obb.h"
+#define BENCH_SUITE "yolov8_obb_postprocess"
+#elif defined(BENCH_YOLOV8_POSE)
+#include "yolov8_pose.h"
+#define BENCH_SUITE "yolov8_pose_postprocess"
+#else
+#error "define one of BENCH_YOLOV5 / BENCH_YOLOV8 / BENCH_YOLO11 / BENCH_YOLOV10 / BENCH_YOLOV8_OBB / BENCH_YOLOV8_POSE"
+#endif
+
+#include "bench.h"
+#include "bench_tensor.h"
+
+#define MODEL_SIZE 640
+#define MAX_OUTPUTS 9
+
+static const int grids[3] = {MODEL_SIZE / 8, MODEL_SIZE / 16, MODEL_SIZE / 32};
+
+// output heads of the rknn_model_zoo exports at 640x640
+static int make_specs(bench_tensor_spec_t* specs)
+{
+    int n = 0;
+#if defined(BENCH_YOLOV5)
+    // 3 x [1, 3 * (5 + 80), h, w], sigmoid already applied
+    for (int i = 0; i < 3; i++) {
+        specs[n++] = {4, {1, 3 * PROP_BOX_SIZE, grids[i], grids[i]}, 0.0f, 1.0f, 0.02f, 0.9f, 0.01f};
+    }
+#elif defined(BENCH_YOLOV8) || defined(BENCH_YOLO11) || defined(BENCH_YOLOV10)
+    // per branch: dfl box [1, 64, h, w], class scores [1, 80, h, w], score sum [1, 1, h, w]
+    for (int i = 0; i < 3; i++) {
+        specs[n++] = {4, {1, 64, grids[i], grids[i]}, -8.0f, 8.0f, 0.0f, 4.0f, 0.05f};
+        specs[n++] = {4, {1, OBJ_CLASS_NUM, grids[i], grids[i]}, 0.0f, 1.0f, 0.0f, 0.9f, 0.002f};
+        specs[n++] = {4, {1, 1, grids[i], grids[i]}, 0.0f, 1.0f, 0.0f, 1.0f, 0.2f};
+    }
+#elif defined(BENCH_YOLOV8_OBB)
+    // 3 x [1, 64 + classes, h, w] logits, angle [1, 1, 8400]
+    // rotated nms is quadratic, keep the candidates at a few hundred like a real aerial image
+    int anchors = 0;
+    for (int i = 0; i < 3; i++) {
+        specs[n++] = {4, {1, 64 + OBJ_CLASS_NUM, grids[i], grids[i]}, -10.0f, 10.0f, -6.0f, 3.0f, 0.0005f};
+        anchors += grids[i] * grids[i];
+    }
+    specs[n++] = {3, {1, 1, anchors}, 0.0f, 1.0f, 0.25f, 0.25f, 0.0f};
+#elif defined(BENCH_YOLOV8_POSE)
+    // 3 x [1, 64 + 1, h, w] logits, keypoints [1, 17, 3, 8400]
+    int anchors = 0;
+    for (int i = 0; i < 3; i++) {
+        specs[n++] = {4, {1, 64 + OBJ_CLASS_NUM, grids[i], grids[i]}, -10.0f, 10.0f, -6.0f, 3.0f, 0.01f};
+        anchors += grids[i] * grids[i];
+    }
+    specs[n++] = {4, {1, 17, 3, anchors}, 0.0f, (float)MODEL_SIZE, 320.0f, 320.0f, 0.0f};
+#endif
+    return n;
+}
+
+typedef struct {
+    rknn_app_context_t app_ctx;
+    rknn_tensor_attr attrs[MAX_OUTPUTS];
+    rknn_output outputs[MAX_OUTPUTS];
+    int n_output;
+    letterbox_t letter_box;
+    object_detect_result_list od_results;
+} yolo_bench_t;
+
+static int setup(yolo_bench_t* b, rknn_tensor_type type, const char* input_dir)
+{
+    bench_tensor_spec_t specs[MAX_OUTPUTS];
+    memset(b, 0, sizeof(yolo_bench_t));
+    b->n_output = make_specs(specs);
+    if (bench_make_outputs(specs, b->n_output, type, input_dir, b->attrs, b->outputs) != 0) {
+        return -1;
+    }
+    b->app_ctx.io_num.n_input = 1;
+    b->app_ctx.io_num.n_output = b->n_output;
+    b->app_ctx.output_attrs = b->attrs;
+    b->app_ctx.model_channel = 3;
+    b->app_ctx.model_width = MODEL_SIZE;
+    b->app_ctx.model_height = MODEL_SIZE;
+    b->app_ctx.is_quant = type == RKNN_TENSOR_INT8;
+    b->letter_box.scale = 1.0f;
+    return 0;
+}
+
+static void run_post_process(void* arg)
+{
+    yolo_bench_t* b = (yolo_bench_t*)arg;
+    post_process(&b->app_ctx, b->outputs, &b->letter_box, BOX_THRESH, NMS_THRESH, &b->od_results);
+    bench_do_not_optimize(&b->od_results);
+}
+
+int main(int argc, char** argv)
+{
+    bench_options_t opts;
+    if (bench_parse_args(argc, argv, BENCH_SUITE, &opts) != 0) {
+        return -1;
+    }
+
+    static yolo_bench_t bench;
+    const rknn_tensor_type types[2] = {RKNN_TENSOR_INT8, RKNN_TENSOR_FLOAT32};
+    const char* names[2] = {"post_process/int8", "post_process/fp32"};
+    for (int i = 0; i < 2; i++) {
+        // recorded heads are dumped from the quantized model only
+        if (opts.input != NULL && types[i] != RKNN_TENSOR_INT8) {
+            continue;
+        }
+        if (setup(&bench, types[i], opts.input) != 0) {
+            return -1;
+        }
+        run_post_process(&bench);
+        printf("%s: %d objects\n", names[i], bench.od_results.count);
+        bench_run(names[i], run_post_process, &bench);
+        bench_release_outputs(bench.outputs, bench.n_output);
+    }
+    return bench_finish();
+}
@@ -19,6 +19,7 @@
 #include <arm_neon.h>
 
 #include "clip.h"
+#include "stage_profiler.h"
 
 typedef struct {
     float value;
@@ -170,6 +171,7 @@ static char *readLine(FILE *fp, char *buffer, int *len)
 
 int post_process(rknn_app_context_t* app_ctx, float* img_output, float* text_output, clip_res* out_res)
 {
+    PROFILE_SCOPE("post_process");
     int out_size = app_ctx->input_img_num * app_ctx->input_text_num;
     float* matmul_out = (float*)malloc(out_size * sizeof(float));
 
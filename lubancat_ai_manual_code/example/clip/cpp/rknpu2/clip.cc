@@ -20,6 +20,7 @@
 #include "common.h"
 #include "file_utils.h"
 #include "image_utils.h"
+#include "stage_profiler.h"
 
 int init_clip_model(const char* img_model_path, const char* text_model_path, rknn_app_context_t* app_ctx)
 {
@@ -58,6 +59,7 @@ int release_clip_model(rknn_app_context_t* app_ctx)
 
 int inference_clip_model(rknn_app_context_t* app_ctx, image_buffer_t* img, char** input_texts, int text_num, clip_res* out_res)
 {
+    PROFILE_SCOPE("inference_clip_model");
     int ret;
     int* tokens;
     if ((!app_ctx) || (!img))
@@ -18,6 +18,7 @@
 #include "common.h"
 #include "file_utils.h"
 #include "image_utils.h"
+#include "stage_profiler.h"
 
 #define VOCAB_TXT_PATH "./model/vocab.txt"
 
@@ -55,6 +56,7 @@ int release_cn_clip_model(rknn_app_context_t* app_ctx)
 
 int inference_cn_clip_model(rknn_app_context_t* app_ctx, image_buffer_t* img, char** input_texts, int text_num, clip_res* out_res)
 {
+    PROFILE_SCOPE("inference_cn_clip_model");
     int ret;
     int* tokens;
 
@@ -21,6 +21,7 @@
 #include "common.h"
 #include "file_utils.h"
 #include "image_utils.h"
+#include "stage_profiler.h"
 
 
 static void dump_tensor_attr(rknn_tensor_attr* attr)
@@ -152,6 +153,7 @@ int release_clip_model_utils(rknn_clip_context* clip_ctx)
 
 int inference_clip_image_model_utils(rknn_clip_context* clip_ctx, image_buffer_t* img, float img_output[])
 {
+    PROFILE_SCOPE("inference_clip_image_model_utils");
     int ret;
     image_buffer_t dst_img;
     rknn_input inputs[1];
@@ -215,8 +217,10 @@ int inference_clip_image_model_utils(rknn_clip_context* clip_ctx, image_buffer_t
     }
 
     // Run
-    // printf("rknn_run\n");
-    ret = rknn_run(clip_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(clip_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -249,6 +253,7 @@ out:
 
 int inference_clip_text_model_utils(rknn_clip_context* clip_ctx, int* tokens, int* attention_mask, float text_output[])
 {
+    PROFILE_SCOPE("inference_clip_text_model_utils");
     int ret;
     rknn_input inputs[clip_ctx->io_num.n_input];
     rknn_output outputs[1];
@@ -287,8 +292,10 @@ int inference_clip_text_model_utils(rknn_clip_context* clip_ctx, int* tokens, in
     }
 
     // Run
-    // printf("rknn_run\n");
-    ret = rknn_run(clip_ctx->rknn_ctx, NULL);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(clip_ctx->rknn_ctx, NULL);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -315,6 +322,7 @@ int inference_clip_text_model_utils(rknn_clip_context* clip_ctx, int* tokens, in
 
 int inference_cn_clip_text_model_utils(rknn_clip_context* clip_ctx, int* tokens, float text_output[])
 {
+    PROFILE_SCOPE("inference_cn_clip_text_model_utils");
     int ret;
     rknn_input inputs[1];
     rknn_output outputs[1];
@@ -343,8 +351,10 @@ int inference_cn_clip_text_model_utils(rknn_clip_context* clip_ctx, int* tokens,
     }
 
     // Run
-    // printf("rknn_run\n");
-    ret = rknn_run(clip_ctx->rknn_ctx, NULL);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(clip_ctx->rknn_ctx, NULL);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
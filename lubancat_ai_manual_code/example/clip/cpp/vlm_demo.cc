@@ -0,0 +1,115 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*-------------------------------------------
+                Includes
+-------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "vlm_pipeline.h"
+#include "file_utils.h"
+
+#define DEFAULT_MAX_NEW_TOKENS 128
+#define DEFAULT_MAX_CONTEXT_LEN 1024
+#define EMBED_CACHE_CAPACITY 16
+
+static void print_token(int index, const char *text, void *userdata)
+{
+    int *current = (int *)userdata;
+    if (*current != index)
+    {
+        printf("\n[%d] ", index);
+        *current = index;
+    }
+    printf("%s", text);
+    fflush(stdout);
+}
+
+/*-------------------------------------------
+                  Main Function
+-------------------------------------------*/
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        printf("%s <image_model_path> <rkllm_model_path> <requests_path> [max_new_tokens] [max_context_len]\n",
+               argv[0]);
+        printf("  requests_path: one request per line, <image_path>\\t<question>\n");
+        return -1;
+    }
+    const char *img_model_path = argv[1];
+    const char *llm_model_path = argv[2];
+    const char *requests_path = argv[3];
+    int max_new_tokens = argc > 4 ? atoi(argv[4]) : DEFAULT_MAX_NEW_TOKENS;
+    int max_context_len = argc > 5 ? atoi(argv[5]) : DEFAULT_MAX_CONTEXT_LEN;
+
+    int line_count;
+    char **lines = read_lines_from_file(requests_path, &line_count);
+    if (lines == NULL)
+    {
+        printf("read requests fail! requests_path=%s\n", requests_path);
+        return -1;
+    }
+    std::vector<vlm_request_t> requests;
+    for (int i = 0; i < line_count; i++)
+    {
+        const char *tab = lines[i] != NULL ? strchr(lines[i], '\t') : NULL;
+        if (tab == NULL)
+        {
+            continue;
+        }
+        vlm_request_t req;
+        req.image_path.assign(lines[i], tab - lines[i]);
+        req.prompt = tab + 1;
+        requests.push_back(req);
+    }
+    free_lines(lines, line_count);
+
+    vlm_pipeline_t vlm;
+    int ret = vlm_pipeline_init(&vlm, img_model_path, llm_model_path, max_new_tokens, max_context_len,
+                                EMBED_CACHE_CAPACITY);
+    if (ret != 0)
+    {
+        printf("vlm_pipeline_init fail! ret=%d\n", ret);
+        return -1;
+    }
+
+    int current = -1;
+    std::vector<vlm_stage_stats_t> stats;
+    auto start = std::chrono::steady_clock::now();
+    ret = vlm_pipeline_run(&vlm, requests, print_token, &current, stats);
+    float total_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("\n");
+
+    // per stage latency, serial is what running the stages one after the other would take
+    printf("\n  #  read_ms decode_ms encode_ms  wait_ms  ttft_ms prefill_ms(tok) generate_ms(tok)  cache\n");
+    float serial_ms = 0;
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        const vlm_stage_stats_t &s = stats[i];
+        printf("%3zu %8.1f %9.1f %9.1f %8.1f %8.1f %10.1f(%3d) %11.1f(%3d)  %s%s\n", i, s.read_ms, s.decode_ms,
+               s.encode_ms, s.wait_ms, s.ttft_ms, s.prefill_ms, s.prefill_tokens, s.generate_ms, s.generate_tokens,
+               s.cache_hit ? "hit" : "miss", s.ok ? "" : " FAILED");
+        serial_ms += s.read_ms + s.decode_ms + s.encode_ms + s.prefill_ms + s.generate_ms;
+    }
+    printf("%zu requests in %.1f ms, %.1f ms with the stages run serially, embedding cache %d hits %d misses\n",
+           stats.size(), total_ms, serial_ms, vlm.cache.hits, vlm.cache.misses);
+
+    vlm_pipeline_release(&vlm);
+    return ret;
+}
@@ -0,0 +1,346 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+#include "vlm_pipeline.h"
+#include "image_utils.h"
+#include "file_utils.h"
+
+// images encoded ahead of the LLM: the next one, and one more so a slow decode does not stall it
+#define MAX_ENCODED_AHEAD 2
+
+// Qwen2-VL markers around the image embedding
+#define IMG_START "<|vision_start|>"
+#define IMG_END "<|vision_end|>"
+#define IMG_CONTENT "<|image_pad|>"
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+typedef struct
+{
+    int index;
+    vlm_embed_ptr embed;            // NULL: the image could not be encoded
+} encoded_image_t;
+
+// between the vision thread and the LLM
+typedef struct
+{
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<encoded_image_t> ready;
+    bool stop;
+} encoded_queue_t;
+
+// userdata of one rkllm_run
+typedef struct
+{
+    int index;
+    time_point_t start;
+    bool first;
+    vlm_stage_stats_t *stats;
+    vlm_token_callback callback;
+    void *userdata;
+} llm_job_t;
+
+static float elapsed_ms(time_point_t from, time_point_t to)
+{
+    return std::chrono::duration<float, std::milli>(to - from).count();
+}
+
+static uint64_t hash_bytes(const char *data, int size)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (int i = 0; i < size; i++)
+    {
+        h = (h ^ (unsigned char)data[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+static vlm_embed_ptr cache_lookup(vlm_embed_cache_t *cache, uint64_t key)
+{
+    std::lock_guard<std::mutex> lk(cache->lock);
+    auto it = cache->map.find(key);
+    if (it == cache->map.end())
+    {
+        cache->misses++;
+        return NULL;
+    }
+    cache->hits++;
+    cache->lru.splice(cache->lru.begin(), cache->lru, it->second.second);
+    return it->second.first;
+}
+
+static void cache_insert(vlm_embed_cache_t *cache, uint64_t key, vlm_embed_ptr embed)
+{
+    std::lock_guard<std::mutex> lk(cache->lock);
+    if (cache->capacity == 0 || cache->map.count(key) != 0)
+    {
+        return;
+    }
+    // an evicted embedding lives on while a request still holds it
+    while (cache->map.size() >= cache->capacity)
+    {
+        cache->map.erase(cache->lru.back());
+        cache->lru.pop_back();
+    }
+    cache->lru.push_front(key);
+    cache->map[key] = std::make_pair(embed, cache->lru.begin());
+}
+
+static int llm_callback(RKLLMResult *result, void *userdata, LLMCallState state)
+{
+    llm_job_t *job = (llm_job_t *)userdata;
+    if (job == NULL)
+    {
+        return 0;
+    }
+    if (state == RKLLM_RUN_FINISH)
+    {
+        job->stats->prefill_ms = result->perf.prefill_time_ms;
+        job->stats->prefill_tokens = result->perf.prefill_tokens;
+        job->stats->generate_ms = result->perf.generate_time_ms;
+        job->stats->generate_tokens = result->perf.generate_tokens;
+        job->stats->ok = true;
+    }
+    else if (state == RKLLM_RUN_ERROR)
+    {
+        printf("rkllm run error, request %d\n", job->index);
+    }
+    else if (state == RKLLM_RUN_NORMAL && result->text != NULL)
+    {
+        if (job->first)
+        {
+            job->stats->ttft_ms = elapsed_ms(job->start, std::chrono::steady_clock::now());
+            job->first = false;
+        }
+        if (job->callback != NULL)
+        {
+            job->callback(job->index, result->text, job->userdata);
+        }
+    }
+    return 0;
+}
+
+// read, hash, decode and encode one image; NULL on failure
+static vlm_embed_ptr encode_image(vlm_pipeline_t *vlm, const std::string &path, vlm_stage_stats_t *stats)
+{
+    time_point_t t0 = std::chrono::steady_clock::now();
+    char *data = NULL;
+    int size = read_data_from_file(path.c_str(), &data);
+    if (size <= 0 || data == NULL)
+    {
+        printf("read %s fail!\n", path.c_str());
+        return NULL;
+    }
+    uint64_t key = hash_bytes(data, size);
+    time_point_t t1 = std::chrono::steady_clock::now();
+    stats->read_ms = elapsed_ms(t0, t1);
+
+    vlm_embed_ptr embed = cache_lookup(&vlm->cache, key);
+    if (embed != NULL)
+    {
+        free(data);
+        stats->cache_hit = true;
+        return embed;
+    }
+
+    // decoded from the bytes that were hashed, the file is read once
+    image_buffer_t img;
+    memset(&img, 0, sizeof(image_buffer_t));
+    int ret = decode_image(path.c_str(), (const unsigned char *)data, size, &img);
+    free(data);
+    if (ret != 0)
+    {
+        printf("decode image fail! image_path=%s\n", path.c_str());
+        return NULL;
+    }
+    time_point_t t2 = std::chrono::steady_clock::now();
+    stats->decode_ms = elapsed_ms(t1, t2);
+
+    std::shared_ptr<std::vector<float>> out =
+        std::make_shared<std::vector<float>>((size_t)vlm->n_image_tokens * vlm->embed_len);
+    ret = inference_clip_image_model_utils(&vlm->encoder, &img, out->data());
+    free(img.virt_addr);
+    stats->encode_ms = elapsed_ms(t2, std::chrono::steady_clock::now());
+    if (ret < 0)
+    {
+        printf("inference image encoder fail! ret=%d\n", ret);
+        return NULL;
+    }
+    cache_insert(&vlm->cache, key, out);
+    return out;
+}
+
+static void vision_thread(vlm_pipeline_t *vlm, const std::vector<vlm_request_t> *requests,
+                          std::vector<vlm_stage_stats_t> *stats, encoded_queue_t *queue)
+{
+    for (int i = 0; i < (int)requests->size(); i++)
+    {
+        {
+            std::unique_lock<std::mutex> lk(queue->lock);
+            queue->cond.wait(lk, [&] { return queue->stop || queue->ready.size() < MAX_ENCODED_AHEAD; });
+            if (queue->stop)
+            {
+                return;
+            }
+        }
+        encoded_image_t item;
+        item.index = i;
+        item.embed = encode_image(vlm, (*requests)[i].image_path, &(*stats)[i]);
+        {
+            std::lock_guard<std::mutex> lk(queue->lock);
+            queue->ready.push_back(item);
+        }
+        queue->cond.notify_all();
+    }
+}
+
+int vlm_pipeline_init(vlm_pipeline_t *vlm, const char *encoder_path, const char *llm_path, int max_new_tokens,
+                      int max_context_len, size_t cache_capacity)
+{
+    vlm->cache.capacity = cache_capacity;
+    vlm->cache.hits = 0;
+    vlm->cache.misses = 0;
+    vlm->llm = nullptr;
+    memset(&vlm->encoder, 0, sizeof(rknn_clip_context));
+
+    int ret = init_clip_model_utils(&vlm->encoder, encoder_path);
+    if (ret != 0)
+    {
+        printf("init image encoder fail! ret=%d model_path=%s\n", ret, encoder_path);
+        return -1;
+    }
+    // [.., n_image_tokens, embed_len], a CLIP image encoder gives one token
+    const rknn_tensor_attr *out = &vlm->encoder.output_attrs[0];
+    vlm->embed_len = out->dims[out->n_dims - 1];
+    vlm->n_image_tokens = out->n_dims >= 3 ? out->dims[out->n_dims - 2] : 1;
+    printf("image embedding: %d tokens x %d\n", vlm->n_image_tokens, vlm->embed_len);
+
+    RKLLMParam param = rkllm_createDefaultParam();
+    param.model_path = llm_path;
+    param.top_k = 1;
+    param.top_p = 0.95;
+    param.temperature = 0.8;
+    param.repeat_penalty = 1.1;
+    param.max_new_tokens = max_new_tokens;
+    param.max_context_len = max_context_len;
+    param.skip_special_token = true;
+    param.img_start = IMG_START;
+    param.img_end = IMG_END;
+    param.img_content = IMG_CONTENT;
+    // the image encoder is in iommu domain 0, the LLM weights get their own
+    param.extend_param.base_domain_id = 1;
+    param.extend_param.embed_flash = 1;
+    ret = rkllm_init(&vlm->llm, &param, llm_callback);
+    if (ret != 0)
+    {
+        printf("rkllm init fail! ret=%d model_path=%s\n", ret, llm_path);
+        vlm->llm = nullptr;
+        vlm_pipeline_release(vlm);
+        return -1;
+    }
+    return 0;
+}
+
+void vlm_pipeline_release(vlm_pipeline_t *vlm)
+{
+    if (vlm->llm != nullptr)
+    {
+        rkllm_destroy(vlm->llm);
+        vlm->llm = nullptr;
+    }
+    release_clip_model_utils(&vlm->encoder);
+    vlm->cache.map.clear();
+    vlm->cache.lru.clear();
+}
+
+int vlm_pipeline_run(vlm_pipeline_t *vlm, const std::vector<vlm_request_t> &requests, vlm_token_callback callback,
+                     void *userdata, std::vector<vlm_stage_stats_t> &stats)
+{
+    stats.assign(requests.size(), vlm_stage_stats_t());
+    encoded_queue_t queue;
+    queue.stop = false;
+    std::thread vision(vision_thread, vlm, &requests, &stats, &queue);
+
+    RKLLMInferParam infer_params;
+    memset(&infer_params, 0, sizeof(RKLLMInferParam));
+    infer_params.mode = RKLLM_INFER_GENERATE;
+    infer_params.keep_history = 0;
+
+    int failed = 0;
+    for (int i = 0; i < (int)requests.size(); i++)
+    {
+        time_point_t t0 = std::chrono::steady_clock::now();
+        encoded_image_t item;
+        {
+            std::unique_lock<std::mutex> lk(queue.lock);
+            queue.cond.wait(lk, [&] { return !queue.ready.empty(); });
+            item = queue.ready.front();
+            queue.ready.pop_front();
+        }
+        queue.cond.notify_all();
+        stats[i].wait_ms = elapsed_ms(t0, std::chrono::steady_clock::now());
+        if (item.embed == NULL)
+        {
+            failed++;
+            continue;
+        }
+
+        std::string prompt = requests[i].prompt;
+        if (prompt.find(VLM_IMAGE_TAG) == std::string::npos)
+        {
+            prompt = VLM_IMAGE_TAG + prompt;
+        }
+        RKLLMInput input;
+        memset(&input, 0, sizeof(RKLLMInput));
+        input.input_type = RKLLM_INPUT_MULTIMODAL;
+        input.role = "user";
+        input.multimodal_input.prompt = (char *)prompt.c_str();
+        // the runtime only reads the embedding
+        input.multimodal_input.image_embed = (float *)item.embed->data();
+        input.multimodal_input.n_image_tokens = vlm->n_image_tokens;
+        input.multimodal_input.n_image = 1;
+        input.multimodal_input.image_width = vlm->encoder.model_width;
+        input.multimodal_input.image_height = vlm->encoder.model_height;
+
+        llm_job_t job;
+        job.index = i;
+        job.start = std::chrono::steady_clock::now();
+        job.first = true;
+        job.stats = &stats[i];
+        job.callback = callback;
+        job.userdata = userdata;
+        int ret = rkllm_run(vlm->llm, &input, &infer_params, &job);
+        if (ret != 0 || !stats[i].ok)
+        {
+            printf("rkllm_run fail! ret=%d request %d\n", ret, i);
+            failed++;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(queue.lock);
+        queue.stop = true;
+    }
+    queue.cond.notify_all();
+    vision.join();
+    return failed == 0 ? 0 : -1;
+}
@@ -0,0 +1,97 @@
+#ifndef _RKNN_DEMO_VLM_PIPELINE_H_
+#define _RKNN_DEMO_VLM_PIPELINE_H_
+
+#include <stdint.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rkllm.h"
+#include "rknn_clip_utils.h"
+
+/*
+ * Image + question -> answer, with the image encoder on rknn and the language model
+ * on rkllm (RKLLM_INPUT_MULTIMODAL).
+ *
+ * The encoder output is the image embedding handed to rkllm: [n_image_tokens,
+ * embed_len] for a VLM vision tower, [1, embed_len] for a CLIP image encoder. A
+ * vision thread reads, hashes and encodes the images on its own rknn context while
+ * the LLM generates the answer to the previous one; embeddings are kept in an LRU
+ * keyed by the hash of the image file, a repeated image skips decode and encoder.
+ */
+
+#define VLM_IMAGE_TAG "<image>"
+
+typedef struct
+{
+    std::string image_path;
+    std::string prompt;             // VLM_IMAGE_TAG is put in front if it has none
+} vlm_request_t;
+
+typedef struct
+{
+    float read_ms;                  // read and hash the image file
+    float decode_ms;                // image decode, 0 for a cached embedding
+    float encode_ms;                // vision encoder, 0 for a cached embedding
+    float wait_ms;                  // LLM idle, waiting for the embedding
+    float ttft_ms;                  // LLM start to first token
+    float prefill_ms;
+    float generate_ms;
+    int prefill_tokens;
+    int generate_tokens;
+    bool cache_hit;
+    bool ok;
+} vlm_stage_stats_t;
+
+typedef std::shared_ptr<const std::vector<float>> vlm_embed_ptr;
+
+typedef struct
+{
+    size_t capacity;                // embeddings kept
+    std::list<uint64_t> lru;        // front: most recently used
+    std::unordered_map<uint64_t, std::pair<vlm_embed_ptr, std::list<uint64_t>::iterator>> map;
+    std::mutex lock;
+    int hits;
+    int misses;
+} vlm_embed_cache_t;
+
+/**
+ * @brief Called with every generated piece of text of request index
+ */
+typedef void (*vlm_token_callback)(int index, const char *text, void *userdata);
+
+typedef struct
+{
+    rknn_clip_context encoder;
+    int n_image_tokens;
+    int embed_len;
+    LLMHandle llm;
+    vlm_embed_cache_t cache;
+} vlm_pipeline_t;
+
+/**
+ * @brief Init the image encoder and the language model
+ *
+ * @param cache_capacity image embeddings kept, 0 disables the cache
+ * @return int 0: success; -1: error
+ */
+int vlm_pipeline_init(vlm_pipeline_t *vlm, const char *encoder_path, const char *llm_path, int max_new_tokens,
+                      int max_context_len, size_t cache_capacity);
+
+void vlm_pipeline_release(vlm_pipeline_t *vlm);
+
+/**
+ * @brief Answer the requests in order, the vision encoder of request i + 1 runs
+ *        during the generation of request i
+ *
+ * @param stats one entry per request
+ * @return int 0: all requests answered; -1: some failed, see stats[i].ok
+ */
+int vlm_pipeline_run(vlm_pipeline_t *vlm, const std::vector<vlm_request_t> &requests, vlm_token_callback callback,
+                     void *userdata, std::vector<vlm_stage_stats_t> &stats);
+
+#endif //_RKNN_DEMO_VLM_PIPELINE_H_
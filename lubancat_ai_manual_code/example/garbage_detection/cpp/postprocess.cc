@@ -27,6 +27,7 @@
 #include "drm_alloc.hpp"
 #include "Float16.h"
 #include "easy_timer.h"
+#include "stage_profiler.h"
 
 #include <set>
 #include <vector>
@@ -789,6 +790,7 @@ static int process_fp32(rknn_output *all_input, int input_id, int grid_h, int gr
 
 int post_process(rknn_app_context_t *app_ctx, rknn_output *outputs, letterbox_t *letter_box, float conf_threshold, float nms_threshold, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("post_process");
 
     std::vector<float> filterBoxes;
     std::vector<float> objProbs;
@@ -0,0 +1,510 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+#include "lexicon_bin.h"
+
+typedef struct
+{
+    std::vector<int> phones;
+    std::vector<int> tones;
+} lexicon_entry_t;
+
+// split on single spaces like the text Lexicon, "a  b" has an empty field, a trailing space has none
+static void split_line(const char *line, std::vector<std::string> &fields)
+{
+    fields.clear();
+    const char *p = line;
+    while (*p != '\0')
+    {
+        const char *q = strchr(p, ' ');
+        if (q == NULL)
+        {
+            fields.emplace_back(p);
+            break;
+        }
+        fields.emplace_back(p, q - p);
+        p = q + 1;
+    }
+}
+
+static int read_lines(const char *path, std::vector<std::vector<std::string>> &lines)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        printf("open %s fail!\n", path);
+        return -1;
+    }
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    std::vector<std::string> fields;
+    while ((len = getline(&line, &cap, fp)) >= 0)
+    {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        {
+            line[--len] = '\0';
+        }
+        if (len == 0)
+        {
+            continue;
+        }
+        split_line(line, fields);
+        lines.push_back(fields);
+    }
+    free(line);
+    fclose(fp);
+    return 0;
+}
+
+// sorted keys to a double array, children of a node are placed at base + byte
+static int build_double_array(const std::vector<std::pair<std::string, int>> &keys, std::vector<int32_t> &base,
+                              std::vector<int32_t> &check, std::vector<int32_t> &value)
+{
+    typedef struct
+    {
+        int node;
+        int lo;
+        int hi;
+        int depth;
+    } range_t;
+
+    // free slots are chained in order so the base search steps over the filled stretches,
+    // the chain ends at used.size() and everything past the arrays is free
+    std::vector<char> used;
+    std::vector<int> next_free, prev_free;
+    int first_free = 0;
+    int last_free = -1;
+    auto grow = [&](int size) {
+        int old = (int)used.size();
+        used.resize(size, 0);
+        base.resize(size, 0);
+        check.resize(size, -1);
+        value.resize(size, -1);
+        next_free.resize(size);
+        prev_free.resize(size);
+        for (int i = old; i < size; i++)
+        {
+            prev_free[i] = i == old ? last_free : i - 1;
+            next_free[i] = i + 1;
+        }
+        last_free = size - 1;
+    };
+    auto take = [&](int t) {
+        used[t] = 1;
+        int p = prev_free[t];
+        int n = next_free[t];
+        if (p >= 0)
+        {
+            next_free[p] = n;
+        }
+        else
+        {
+            first_free = n;
+        }
+        if (n < (int)used.size())
+        {
+            prev_free[n] = p;
+        }
+        else
+        {
+            last_free = p;
+        }
+    };
+    grow(1024);
+    take(0);
+    check[0] = 0;
+    int num_nodes = 1;
+
+    std::vector<range_t> stack;
+    stack.push_back({0, 0, (int)keys.size(), 0});
+    std::vector<uint8_t> labels;
+    std::vector<range_t> children;
+    while (!stack.empty())
+    {
+        range_t r = stack.back();
+        stack.pop_back();
+
+        labels.clear();
+        children.clear();
+        for (int k = r.lo; k < r.hi;)
+        {
+            const std::string &key = keys[k].first;
+            if ((int)key.size() == r.depth)
+            {
+                value[r.node] = keys[k].second;     // the shortest key of the range, sorted first
+                k++;
+                continue;
+            }
+            uint8_t c = (uint8_t)key[r.depth];
+            int end = k + 1;
+            while (end < r.hi && (uint8_t)keys[end].first[r.depth] == c)
+            {
+                end++;
+            }
+            labels.push_back(c);
+            children.push_back({0, k, end, r.depth + 1});
+            k = end;
+        }
+        if (labels.empty())
+        {
+            continue;
+        }
+
+        // first base where every child slot is free, trying the free slots for the first label
+        int b;
+        for (int pos = first_free;; pos = pos < (int)used.size() ? next_free[pos] : pos + 1)
+        {
+            b = pos - labels[0];
+            if (b < 1)
+            {
+                continue;
+            }
+            int need = b + labels.back() + 1;
+            if (need > (int)used.size())
+            {
+                grow(std::max(need, (int)used.size() * 2));
+            }
+            size_t i = 0;
+            while (i < labels.size() && !used[b + labels[i]])
+            {
+                i++;
+            }
+            if (i == labels.size())
+            {
+                break;
+            }
+        }
+        base[r.node] = b;
+        for (size_t i = 0; i < labels.size(); i++)
+        {
+            int t = b + labels[i];
+            take(t);
+            check[t] = r.node;
+            num_nodes = std::max(num_nodes, t + 1);
+            children[i].node = t;
+            stack.push_back(children[i]);
+        }
+    }
+    base.resize(num_nodes);
+    check.resize(num_nodes);
+    value.resize(num_nodes);
+    return num_nodes;
+}
+
+int lexicon_bin_build(const char *lexicon_path, const char *tokens_path, std::vector<uint8_t> &blob)
+{
+    std::vector<std::vector<std::string>> lines;
+    if (read_lines(tokens_path, lines) != 0)
+    {
+        return -1;
+    }
+    std::unordered_map<std::string, int> tokens;
+    for (const auto &f : lines)
+    {
+        if (f.size() >= 2)
+        {
+            tokens.insert({f[0], atoi(f[1].c_str())});
+        }
+    }
+    auto token_id = [&tokens](const std::string &s) {
+        auto it = tokens.find(s);
+        return it == tokens.end() ? 0 : it->second;
+    };
+
+    lines.clear();
+    if (read_lines(lexicon_path, lines) != 0)
+    {
+        return -1;
+    }
+    std::map<std::string, lexicon_entry_t> words;
+    for (const auto &f : lines)
+    {
+        if (words.count(f[0]) != 0)
+        {
+            continue;
+        }
+        size_t phone_tone_len = f.size() - 1;
+        size_t half_len = phone_tone_len / 2;
+        lexicon_entry_t e;
+        for (size_t i = 0; i < phone_tone_len; i++)
+        {
+            if (i < half_len)
+            {
+                e.phones.push_back(token_id(f[i + 1]));
+            }
+            else
+            {
+                e.tones.push_back(atoi(f[i + 1].c_str()));
+            }
+        }
+        words[f[0]] = e;
+    }
+    words["呣"] = words["母"];
+    words["嗯"] = words["恩"];
+    const char *punctuation[] = {"!", "?", "…", ",", ".", "'", "-"};
+    for (const char *p : punctuation)
+    {
+        words[p] = {{token_id(p)}, {0}};
+    }
+    words[" "] = {{token_id("_")}, {0}};
+
+    // std::map iterates in byte order, the order the double array construction needs
+    std::vector<std::pair<std::string, int>> keys;
+    std::vector<uint32_t> offsets(1, 0);
+    std::vector<uint16_t> phones;
+    std::vector<int8_t> tones;
+    int blank_entry = -1;
+    for (const auto &w : words)
+    {
+        const lexicon_entry_t &e = w.second;
+        for (size_t i = 0; i < e.phones.size(); i++)
+        {
+            int tone = i < e.tones.size() ? e.tones[i] : 0;
+            if (e.phones[i] < 0 || e.phones[i] > UINT16_MAX || tone < INT8_MIN || tone > INT8_MAX)
+            {
+                printf("lexicon_bin_build: phone %d / tone %d of %s out of range\n", e.phones[i], tone, w.first.c_str());
+                return -1;
+            }
+            phones.push_back((uint16_t)e.phones[i]);
+            tones.push_back((int8_t)tone);
+        }
+        if (w.first == " ")
+        {
+            blank_entry = (int)keys.size();
+        }
+        keys.push_back({w.first, (int)keys.size()});
+        offsets.push_back((uint32_t)phones.size());
+    }
+
+    std::vector<int32_t> base, check, value;
+    int num_nodes = build_double_array(keys, base, check, value);
+
+    lexicon_bin_header_t header;
+    header.magic = LEXICON_BIN_MAGIC;
+    header.version = LEXICON_BIN_VERSION;
+    header.num_nodes = num_nodes;
+    header.num_entries = (int32_t)keys.size();
+    header.num_phones = (int32_t)phones.size();
+    header.blank_entry = blank_entry;
+
+    blob.clear();
+    auto append = [&blob](const void *data, size_t size) {
+        blob.insert(blob.end(), (const uint8_t *)data, (const uint8_t *)data + size);
+    };
+    append(&header, sizeof(header));
+    append(base.data(), num_nodes * sizeof(int32_t));
+    append(check.data(), num_nodes * sizeof(int32_t));
+    append(value.data(), num_nodes * sizeof(int32_t));
+    append(offsets.data(), offsets.size() * sizeof(uint32_t));
+    append(phones.data(), phones.size() * sizeof(uint16_t));
+    append(tones.data(), tones.size() * sizeof(int8_t));
+    printf("lexicon: %d words, %d trie nodes, %d phones, %.2f MB\n", header.num_entries, num_nodes, header.num_phones,
+           blob.size() / 1048576.0);
+    return 0;
+}
+
+static int lexicon_bin_attach(const uint8_t *data, size_t size, lexicon_bin_t *lex)
+{
+    const lexicon_bin_header_t *h = (const lexicon_bin_header_t *)data;
+    if (size < sizeof(lexicon_bin_header_t) || h->magic != LEXICON_BIN_MAGIC || h->version != LEXICON_BIN_VERSION)
+    {
+        printf("lexicon_bin: not a compiled lexicon, or of another version\n");
+        return -1;
+    }
+    size_t expected = sizeof(lexicon_bin_header_t) + 3 * (size_t)h->num_nodes * sizeof(int32_t) +
+                      ((size_t)h->num_entries + 1) * sizeof(uint32_t) + (size_t)h->num_phones * (sizeof(uint16_t) + 1);
+    if (h->num_nodes < 1 || h->num_entries < 1 || h->num_phones < 0 || size != expected || h->blank_entry < 0 ||
+        h->blank_entry >= h->num_entries)
+    {
+        printf("lexicon_bin: truncated or corrupt, %zu bytes, expected %zu\n", size, expected);
+        return -1;
+    }
+    const uint8_t *p = data + sizeof(lexicon_bin_header_t);
+    lex->header = h;
+    lex->base = (const int32_t *)p;
+    lex->check = lex->base + h->num_nodes;
+    lex->value = lex->check + h->num_nodes;
+    lex->offsets = (const uint32_t *)(lex->value + h->num_nodes);
+    lex->phones = (const uint16_t *)(lex->offsets + h->num_entries + 1);
+    lex->tones = (const int8_t *)(lex->phones + h->num_phones);
+    return 0;
+}
+
+int lexicon_bin_load(const char *path, lexicon_bin_t *lex)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        printf("mmap %s fail!\n", path);
+        return -1;
+    }
+    if (lexicon_bin_attach((const uint8_t *)map, st.st_size, lex) != 0)
+    {
+        munmap(map, st.st_size);
+        return -1;
+    }
+    lex->map = map;
+    lex->map_size = st.st_size;
+    return 0;
+}
+
+int lexicon_bin_open_memory(std::vector<uint8_t> &blob, lexicon_bin_t *lex)
+{
+    lex->memory.swap(blob);
+    lex->map = NULL;
+    lex->map_size = 0;
+    return lexicon_bin_attach(lex->memory.data(), lex->memory.size(), lex);
+}
+
+void lexicon_bin_release(lexicon_bin_t *lex)
+{
+    if (lex->map != NULL)
+    {
+        munmap(lex->map, lex->map_size);
+        lex->map = NULL;
+    }
+    lex->memory.clear();
+    lex->header = NULL;
+}
+
+static inline int next_node(const lexicon_bin_t *lex, int node, uint8_t c)
+{
+    int t = lex->base[node] + c;
+    return t < lex->header->num_nodes && lex->check[t] == node ? t : -1;
+}
+
+static void append_entry(const lexicon_bin_t *lex, int entry, std::vector<int> &phones, std::vector<int> &tones)
+{
+    for (uint32_t i = lex->offsets[entry]; i < lex->offsets[entry + 1]; i++)
+    {
+        phones.push_back(lex->phones[i]);
+        tones.push_back(lex->tones[i]);
+    }
+}
+
+static inline int utf8_char_len(unsigned char c)
+{
+    if ((c & 0xE0) == 0xC0)
+    {
+        return 2;
+    }
+    if ((c & 0xF0) == 0xE0)
+    {
+        return 3;
+    }
+    if ((c & 0xF8) == 0xF0)
+    {
+        return 4;
+    }
+    return 1;
+}
+
+static inline bool is_ascii_letter(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+void lexicon_bin_convert(const lexicon_bin_t *lex, const std::string &text, std::vector<int> &phones,
+                         std::vector<int> &tones)
+{
+    // full width punctuation reads as its ascii entry
+    static const char *full_width[][2] = {{"，", ","}, {"。", "."}, {"！", "!"}, {"？", "?"}};
+    std::string s;
+    s.reserve(text.size());
+    for (size_t i = 0; i < text.size();)
+    {
+        int n = std::min(utf8_char_len((unsigned char)text[i]), (int)(text.size() - i));
+        const char *replace = NULL;
+        for (const auto &fw : full_width)
+        {
+            if (n == 3 && text.compare(i, 3, fw[0]) == 0)
+            {
+                replace = fw[1];
+            }
+        }
+        if (replace != NULL)
+        {
+            s += replace;
+        }
+        else
+        {
+            s.append(text, i, n);
+        }
+        i += n;
+    }
+
+    for (size_t i = 0; i < s.size();)
+    {
+        int entry = -1;
+        if (is_ascii_letter(s[i]))
+        {
+            // an english word, exact lower case lookup
+            int node = 0;
+            size_t j = i;
+            for (; j < s.size() && is_ascii_letter(s[j]); j++)
+            {
+                if (node >= 0)
+                {
+                    node = next_node(lex, node, (uint8_t)tolower((unsigned char)s[j]));
+                }
+            }
+            entry = node >= 0 ? lex->value[node] : -1;
+            i = j;
+        }
+        else
+        {
+            // longest entry from here, entries are whole utf-8 strings so every match ends on a character
+            size_t match_end = i;
+            int node = 0;
+            for (size_t j = i; j < s.size(); j++)
+            {
+                node = next_node(lex, node, (uint8_t)s[j]);
+                if (node < 0)
+                {
+                    break;
+                }
+                if (lex->value[node] >= 0)
+                {
+                    entry = lex->value[node];
+                    match_end = j + 1;
+                }
+            }
+            i = entry >= 0 ? match_end : i + std::min((size_t)utf8_char_len((unsigned char)s[i]), s.size() - i);
+        }
+        append_entry(lex, entry >= 0 ? entry : lex->header->blank_entry, phones, tones);
+    }
+}
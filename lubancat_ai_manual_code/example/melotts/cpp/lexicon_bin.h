@@ -0,0 +1,84 @@
+#ifndef _MELOTTS_LEXICON_BIN_H_
+#define _MELOTTS_LEXICON_BIN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define LEXICON_BIN_MAGIC 0x58454c4d    // "MLEX"
+#define LEXICON_BIN_VERSION 1
+
+/*
+ * Compiled lexicon, one blob that is used in place after mmap:
+ *
+ *   lexicon_bin_header_t
+ *   int32_t  base[num_nodes], check[num_nodes], value[num_nodes]   double-array trie over utf-8 bytes
+ *   uint32_t offsets[num_entries + 1]                              phones / tones of entry e at [offsets[e], offsets[e + 1])
+ *   uint16_t phones[num_phones]                                    token ids
+ *   int8_t   tones[num_phones]
+ *
+ * value[node] is the entry of the word ending at node, -1 if none.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t num_nodes;
+    int32_t num_entries;
+    int32_t num_phones;
+    int32_t blank_entry;    // the phones of " ", used for anything not in the lexicon
+} lexicon_bin_header_t;
+
+typedef struct
+{
+    const lexicon_bin_header_t *header;
+    const int32_t *base;
+    const int32_t *check;
+    const int32_t *value;
+    const uint32_t *offsets;
+    const uint16_t *phones;
+    const int8_t *tones;
+
+    void *map;                      // mmap of the file, or NULL
+    size_t map_size;
+    std::vector<uint8_t> memory;    // blob built at load time when there is no compiled file
+} lexicon_bin_t;
+
+/**
+ * @brief Compile lexicon.txt / tokens.txt into a blob
+ *
+ * Same rules as the text Lexicon: the first line of a word wins, unknown phones are
+ * token 0, 呣 / 嗯 read as 母 / 恩, punctuation maps to its token and " " to "_".
+ *
+ * @return int 0: success; -1: error
+ */
+int lexicon_bin_build(const char *lexicon_path, const char *tokens_path, std::vector<uint8_t> &blob);
+
+/**
+ * @brief Map a compiled lexicon file, nothing is parsed
+ *
+ * @return int 0: success; -1: error
+ */
+int lexicon_bin_load(const char *path, lexicon_bin_t *lex);
+
+/**
+ * @brief Use a blob from lexicon_bin_build, the lexicon takes it over
+ *
+ * @return int 0: success; -1: error
+ */
+int lexicon_bin_open_memory(std::vector<uint8_t> &blob, lexicon_bin_t *lex);
+
+void lexicon_bin_release(lexicon_bin_t *lex);
+
+/**
+ * @brief Text to phones and tones
+ *
+ * Runs of ascii letters are looked up as one lower case word, everything else by
+ * the longest lexicon entry starting at the current character. Unknown words and
+ * characters give the blank phone.
+ */
+void lexicon_bin_convert(const lexicon_bin_t *lex, const std::string &text, std::vector<int> &phones,
+                         std::vector<int> &tones);
+
+#endif //_MELOTTS_LEXICON_BIN_H_
@@ -0,0 +1,55 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+
+#include "lexicon_bin.h"
+
+// lexicon.txt + tokens.txt -> lexicon.bin, mapped by the demo at startup
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        printf("%s <lexicon.txt> <tokens.txt> <lexicon.bin>\n", argv[0]);
+        return -1;
+    }
+
+    std::vector<uint8_t> blob;
+    if (lexicon_bin_build(argv[1], argv[2], blob) != 0)
+    {
+        return -1;
+    }
+
+    FILE *fp = fopen(argv[3], "wb");
+    if (fp == NULL)
+    {
+        printf("open %s fail!\n", argv[3]);
+        return -1;
+    }
+    size_t written = fwrite(blob.data(), 1, blob.size(), fp);
+    fclose(fp);
+    if (written != blob.size())
+    {
+        printf("write %s fail!\n", argv[3]);
+        return -1;
+    }
+
+    // the file must map back
+    lexicon_bin_t lex = {};
+    if (lexicon_bin_load(argv[3], &lex) != 0)
+    {
+        return -1;
+    }
+    lexicon_bin_release(&lex);
+    printf("saved %s\n", argv[3]);
+    return 0;
+}
@@ -20,9 +20,11 @@
 #include <map>
 
 #include "melotts.h"
+#include "tts_pipeline.h"
+#include "tts_cache.h"
 #include "parse_args.h"
 
-#include "lexicon.hpp"
+#include "lexicon_bin.h"
 #include "split.hpp"
 
 static std::vector<int64_t> intersperse(const std::vector<int>& lst, int item) {
@@ -42,6 +44,14 @@ static std::vector<int64_t> pad_or_trim(std::vector<int64_t>& vec, int max_size)
     return vec;
 }
 
+// audio goes to the wav file as soon as it is decoded
+static int write_chunk(int sentence, const float *data, int num_samples, void *userdata)
+{
+    audio_writer_t *writer = (audio_writer_t *)userdata;
+    printf("sentence %d: %.2f s of audio\n", sentence, (float)num_samples / SAMPLE_RATE);
+    return audio_writer_write(writer, data, num_samples);
+}
+
 const std::map<std::string, int> language_id_map = { 
     {"ZH", 0},
     {"JP", 1},
@@ -65,7 +75,13 @@ int main(int argc, char **argv)
     float audio_length = 0.0;
     float rtf = 0.0;
 
-    std::vector<float> output_wav_data;
+    std::vector<tts_sentence_t> inputs;
+    tts_pipeline_options_t pipeline_opts;
+    tts_pipeline_stats_t stats;
+    audio_writer_t writer;
+    memset(&writer, 0, sizeof(audio_writer_t));
+    lexicon_bin_t lexicon = {};
+    tts_cache_t cache;
 
     Args args = parse_args(argc, argv);
     const char *encoder_path = args.encoder_path.c_str();
@@ -81,8 +97,17 @@ int main(int argc, char **argv)
 
     // Load lexicon
     timer.tik();
-    // Lexicon lexicon(LEXICON_EN_FILE, TOKENS_EN_FILE);
-    Lexicon lexicon(LEXICON_ZH_FILE, TOKENS_ZH_FILE);
+    if (lexicon_bin_load(LEXICON_BIN_FILE, &lexicon) != 0)
+    {
+        printf("%s not found, compiling %s (run melotts_lexicon_compile once to skip this)\n", LEXICON_BIN_FILE,
+               LEXICON_ZH_FILE);
+        std::vector<uint8_t> blob;
+        if (lexicon_bin_build(LEXICON_ZH_FILE, TOKENS_ZH_FILE, blob) != 0 || lexicon_bin_open_memory(blob, &lexicon) != 0)
+        {
+            printf("load lexicon fail!\n");
+            return -1;
+        }
+    }
     timer.tok();
     timer.print_time("Lexicon init");
 
@@ -129,63 +154,84 @@ int main(int argc, char **argv)
         std::cout << "disable bert model" << std::endl;
     }
 
-    // inference
-    timer.tik();
+    // text to phones for every sentence, cheap next to the models
     for (auto& s : sentences) {
         printf("Split sentence: %s\n", s.c_str());
-        std::vector<float> output_data(PREDICTED_LENGTHS_MAX*PREDICTED_BATCH); 
+        std::string text = args.language + "|" + s;
 
  	    // Convert sentence to phones and tones
         s = "_" + s + "_";
         std::vector<int> phones_bef, tones_bef;
-        lexicon.convert(s, phones_bef, tones_bef);
+        lexicon_bin_convert(&lexicon, s, phones_bef, tones_bef);
 
         std::vector<int> lang_ids_bef(phones_bef.size(), value);
 
         // Add blank between words
-        auto phones = intersperse(phones_bef, 0);
-        auto tones = intersperse(tones_bef, 0);
-        auto lang_ids = intersperse(lang_ids_bef, 0);
+        tts_sentence_t input;
+        input.phones = intersperse(phones_bef, 0);
+        input.tones = intersperse(tones_bef, 0);
+        input.lang_ids = intersperse(lang_ids_bef, 0);
 
-        int64_t phone_len = phones.size();
+        input.phone_len = input.phones.size();
+        input.text = text;
 
         // pad or trim
-        pad_or_trim(tones, MAX_LENGTH);
-        pad_or_trim(phones, MAX_LENGTH);
-        pad_or_trim(lang_ids, MAX_LENGTH);
+        pad_or_trim(input.tones, MAX_LENGTH);
+        pad_or_trim(input.phones, MAX_LENGTH);
+        pad_or_trim(input.lang_ids, MAX_LENGTH);
+        inputs.push_back(input);
+    }
+
+    ret = audio_writer_open(&writer, audio_save_path, SAMPLE_RATE, 1);
+    if (ret != 0)
+    {
+        printf("audio_writer_open fail! ret=%d\n", ret);
+        goto out;
+    }
 
-        int output_lengths = inference_melotts_model(&rknn_app_ctx, phones, phone_len, tones, lang_ids, args.speak_id, args.speed, args.disable_bert, output_data);
-        if (output_lengths < 0)
+    // inference, the encoder of sentence n+1 runs while sentence n is decoded and written
+    pipeline_opts.speaker_id = args.speak_id;
+    pipeline_opts.speed = args.speed;
+    pipeline_opts.disable_bert = args.disable_bert;
+    pipeline_opts.callback = write_chunk;
+    pipeline_opts.userdata = &writer;
+    pipeline_opts.cache = NULL;
+    if (args.cache_mb > 0)
+    {
+        ret = tts_cache_init(&cache, args.cache_dir.c_str(), (size_t)args.cache_mb << 20);
+        if (ret != 0)
         {
-            printf("inference_melotts_model fail! ret=%d\n", output_lengths);
+            printf("tts_cache_init fail! ret=%d cache_dir=%s\n", ret, args.cache_dir.c_str());
             goto out;
         }
-
-        int actual_size = output_lengths * PREDICTED_BATCH;
-        output_wav_data.insert(output_wav_data.end(), output_data.begin(), output_data.begin() + actual_size);
+        pipeline_opts.cache = &cache;
     }
-    timer.tok();
-    timer.print_time("inference ");
+    ret = run_melotts_pipeline(&rknn_app_ctx, inputs, &pipeline_opts, &stats);
+    if (ret != 0)
+    {
+        printf("run_melotts_pipeline fail! ret=%d\n", ret);
+        goto out;
+    }
+    printf("inference: %.2f ms, first audio after %.2f ms\n", stats.total_ms, stats.first_chunk_ms);
 
-    infer_time = timer.get_time() / 1000.0; // sec
-    std::cout << "output_wav_data size:" <<  output_wav_data.size()  <<  std::endl;
-    audio_length = (float)output_wav_data.size() / SAMPLE_RATE;        // sec
+    infer_time = stats.total_ms / 1000.0; // sec
+    std::cout << "output_wav_data size:" <<  stats.num_samples  <<  std::endl;
+    audio_length = (float)stats.num_samples / SAMPLE_RATE;        // sec
     printf("audio_length: %f", audio_length);
     rtf = infer_time / audio_length;
     printf("\nReal Time Factor (RTF): %.3f / %.3f = %.3f\n", infer_time, audio_length, rtf);
-    printf("\nThe output wav file is saved: %s\n", audio_save_path);
-
-    timer.tik();
-    ret = save_audio(audio_save_path, output_wav_data.data(), output_wav_data.size(), SAMPLE_RATE, 1);
-    if (ret != 0)
+    printf("First chunk latency: %.3f s\n", stats.first_chunk_ms / 1000.0);
+    if (pipeline_opts.cache != NULL)
     {
-        printf("save_audio fail! ret=%d\n", ret);
-        return ret;
+        printf("sentences from cache: %d / %zu\n", stats.cached, inputs.size());
     }
-    timer.tok();
-    timer.print_time("save_audio");
+    printf("\nThe output wav file is saved: %s\n", audio_save_path);
 
 out:
+    audio_writer_close(&writer);
+    lexicon_bin_release(&lexicon);
+    tts_cache_release(&cache);
+
     // release model
     ret = release_melotts_model(&rknn_app_ctx.encoder_context);
     if (ret != 0)
@@ -19,6 +19,7 @@
 #include "process.h"
 #include "melotts.h"
 #include "file_utils.h"
+#include "stage_profiler.h"
 
 static void dump_input_dynamic_range(rknn_input_range *dyn_range)
 {
@@ -158,6 +159,7 @@ int inference_encoder_model(rknn_app_context_t *app_ctx, std::vector<int64_t> &x
     std::vector<float> &ja_bert, std::vector<float> &logw, std::vector<float> &x_mask,
     std::vector<float> &g, std::vector<float> &m_p, std::vector<float> &logs_p)
 {
+    PROFILE_SCOPE("inference_encoder_model");
     int ret;
     int n_input = 8;
     int n_output = 5;
@@ -233,7 +235,10 @@ int inference_encoder_model(rknn_app_context_t *app_ctx, std::vector<int64_t> &x
     }
 
     // Run
-    ret = rknn_run(app_ctx->rknn_ctx, NULL);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, NULL);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -278,6 +283,7 @@ out:
 int inference_decoder_model(rknn_app_context_t *app_ctx, std::vector<float> &attn, std::vector<float> &y_mask, std::vector<float> &g, 
     std::vector<float> &m_p, std::vector<float> &logs_p, int &predicted_lengths_max_real, std::vector<float> &output_wav_data)
 {
+    PROFILE_SCOPE("inference_decoder_model");
     int ret;
     int n_input = 6;
     int n_output = 1;
@@ -335,7 +341,10 @@ int inference_decoder_model(rknn_app_context_t *app_ctx, std::vector<float> &att
 
     // Run
     // std::cout << "inference_decoder_model rknn_run : " << std::endl;
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -368,17 +377,18 @@ out:
     return ret;
 }
 
-int inference_melotts_model(rknn_melotts_context_t *app_ctx, std::vector<int64_t> &phones,
+int encode_melotts_model(rknn_melotts_context_t *app_ctx, std::vector<int64_t> &phones,
     int64_t phone_len, std::vector<int64_t> &tones, std::vector<int64_t> &lang_ids,
-    int64_t speaker_id, float speed, bool disable_bert, std::vector<float> &output_wav_data)
+    int64_t speaker_id, float speed, bool disable_bert, melotts_latent_t *latent)
 {
+    PROFILE_SCOPE("encode_melotts_model");
     int ret;
     TIMER timer;
     std::vector<float> logw(LOGW_SIZE);
-    std::vector<float> m_p(M_P_SIZE);
-    std::vector<float> logs_p(LOGS_P_SIZE);
     std::vector<float> x_mask(X_MASK_SIZE);
-    std::vector<float> g(G_SIZE);
+    latent->g.resize(G_SIZE);
+    latent->m_p.resize(M_P_SIZE);
+    latent->logs_p.resize(LOGS_P_SIZE);
 
     // std::vector<float> bert(1*1024*256, 0.0f);
     std::vector<float> ja_bert;
@@ -394,7 +404,8 @@ int inference_melotts_model(rknn_melotts_context_t *app_ctx, std::vector<int64_t
 
     // encoder
     timer.tik();
-    ret = inference_encoder_model(&app_ctx->encoder_context, phones, phone_len, speaker_id, tones, lang_ids, ja_bert, logw,  x_mask, g, m_p, logs_p);
+    ret = inference_encoder_model(&app_ctx->encoder_context, phones, phone_len, speaker_id, tones, lang_ids, ja_bert, logw,  x_mask,
+                                  latent->g, latent->m_p, latent->logs_p);
     if (ret != 0)
     {
         printf("inference_encoder_model fail! ret=%d\n", ret);
@@ -405,24 +416,88 @@ int inference_melotts_model(rknn_melotts_context_t *app_ctx, std::vector<int64_t
 
     // middle
     timer.tik();
-    int predicted_lengths_max_real = 0;
-    std::vector<float> y_mask(Y_MASK_SIZE, 0.0f);
-    std::vector<float> attn(ATTN_SIZE, 0.0f);
-    middle_process(logw, x_mask, attn, y_mask, speed, predicted_lengths_max_real);
+    latent->x_mask = x_mask;
+    latent->predicted_lengths = compute_alignment(logw, x_mask, speed, latent->frame_phone);
     timer.tok();
     timer.print_time("middle_process");
 
-    // decoder
-    timer.tik();
-    ret = inference_decoder_model(&app_ctx->decoder_context, attn, y_mask, g, m_p, logs_p, predicted_lengths_max_real, output_wav_data);
-    if (ret != 0)
+    return 0;
+}
+
+int decode_melotts_model(rknn_melotts_context_t *app_ctx, melotts_latent_t *latent, melotts_audio_callback_t callback,
+    void *userdata)
+{
+    PROFILE_SCOPE("decode_melotts_model");
+    TIMER timer;
+    int total = latent->predicted_lengths;
+    int stride = PREDICTED_LENGTHS_MAX - DECODER_OVERLAP_FRAMES;
+    int overlap = DECODER_OVERLAP_FRAMES * PREDICTED_BATCH;
+    std::vector<float> window(PREDICTED_LENGTHS_MAX * PREDICTED_BATCH);
+    std::vector<float> tail(overlap);       // end of the previous window, faded out under the next one
+    latent->attn.resize(ATTN_SIZE);
+    latent->y_mask.resize(Y_MASK_SIZE);
+
+    for (int start = 0; ; start += stride)
     {
-        printf("inference_decoder_model fail! ret=%d\n", ret);
-        return ret;
+        timer.tik();
+        int frames = fill_alignment_window(latent->frame_phone, latent->x_mask, start, latent->attn, latent->y_mask);
+        int ret = inference_decoder_model(&app_ctx->decoder_context, latent->attn, latent->y_mask, latent->g, latent->m_p,
+                                          latent->logs_p, frames, window);
+        if (ret != 0)
+        {
+            printf("inference_decoder_model fail! ret=%d\n", ret);
+            return ret;
+        }
+        timer.tok();
+        timer.print_time("inference_decoder_model");
+
+        int num_samples = frames * PREDICTED_BATCH;
+        int last = start + frames >= total;
+        if (start > 0)
+        {
+            // raised cosine crossfade over the overlapping frames
+            for (int k = 0; k < overlap; k++)
+            {
+                float w = 0.5f - 0.5f * cosf((float)M_PI * (k + 0.5f) / overlap);
+                window[k] = tail[k] * (1.0f - w) + window[k] * w;
+            }
+        }
+        if (!last)
+        {
+            num_samples -= overlap;
+            memcpy(tail.data(), window.data() + num_samples, overlap * sizeof(float));
+        }
+        if (callback(window.data(), num_samples, userdata) != 0)
+        {
+            return -1;
+        }
+        if (last)
+        {
+            break;
+        }
     }
-    timer.tok();
-    timer.print_time("inference_decoder_model");
 
-    return predicted_lengths_max_real;
+    return total;
+}
+
+static int append_audio(const float *data, int num_samples, void *userdata)
+{
+    std::vector<float> *output = (std::vector<float> *)userdata;
+    output->insert(output->end(), data, data + num_samples);
+    return 0;
 }
 
+int inference_melotts_model(rknn_melotts_context_t *app_ctx, std::vector<int64_t> &phones,
+    int64_t phone_len, std::vector<int64_t> &tones, std::vector<int64_t> &lang_ids,
+    int64_t speaker_id, float speed, bool disable_bert, std::vector<float> &output_wav_data)
+{
+    PROFILE_SCOPE("inference_melotts_model");
+    melotts_latent_t latent;
+    int ret = encode_melotts_model(app_ctx, phones, phone_len, tones, lang_ids, speaker_id, speed, disable_bert, &latent);
+    if (ret != 0)
+    {
+        return ret;
+    }
+    output_wav_data.clear();
+    return decode_melotts_model(app_ctx, &latent, append_audio, &output_wav_data);
+}
@@ -36,6 +36,26 @@ typedef struct
     rknn_app_context_t decoder_context;
 } rknn_melotts_context_t;
 
+// encoder output and alignment of one sentence, the decoder input
+typedef struct
+{
+    std::vector<float> g;
+    std::vector<float> m_p;
+    std::vector<float> logs_p;
+    std::vector<float> x_mask;
+    std::vector<int> frame_phone;   // alignment, may be longer than one decoder window
+    int predicted_lengths;          // frames of PREDICTED_BATCH samples
+    std::vector<float> attn;        // decoder input of the current window
+    std::vector<float> y_mask;
+} melotts_latent_t;
+
+/**
+ * @brief Receives the audio of a sentence window by window
+ *
+ * @return int 0 to go on, anything else stops decoding
+ */
+typedef int (*melotts_audio_callback_t)(const float *data, int num_samples, void *userdata);
+
 int init_melotts_model(const char *model_path, rknn_app_context_t *app_ctx);
 int release_melotts_model(rknn_app_context_t *app_ctx);
 
@@ -47,6 +67,17 @@ int inference_encoder_model(rknn_app_context_t *app_ctx, std::vector<int64_t> &x
 int inference_decoder_model(rknn_app_context_t *app_ctx, std::vector<float> &attn, std::vector<float> &y_mask, std::vector<float> &g, 
         std::vector<float> &m_p, std::vector<float> &logs_p, int &predicted_lengths_max_real, std::vector<float> &output_wav_data);
 
+// encoder and decoder use separate contexts, encode_melotts_model of the next sentence may run
+// while decode_melotts_model of the previous one does
+int encode_melotts_model(rknn_melotts_context_t *app_ctx, std::vector<int64_t> &phones,
+    int64_t phone_len, std::vector<int64_t> &tones, std::vector<int64_t> &lang_ids,
+    int64_t speaker_id, float speed, bool disable_bert, melotts_latent_t *latent);
+
+// alignments longer than PREDICTED_LENGTHS_MAX run through the decoder in overlapping windows, the
+// callback gets the crossfaded audio of every window as soon as it is decoded
+int decode_melotts_model(rknn_melotts_context_t *app_ctx, melotts_latent_t *latent, melotts_audio_callback_t callback,
+    void *userdata);
+
 int inference_melotts_model(rknn_melotts_context_t *app_ctx, std::vector<int64_t> &phones,
     int64_t phone_len, std::vector<int64_t> &tones, std::vector<int64_t> &lang_ids,
     int64_t speaker_id, float speed, bool disable_bert, std::vector<float> &output_wav_data);
@@ -24,6 +24,9 @@ struct Args {
 
     std::string middle_path     = "model/middle_ZH_MIX_EN.onnx";
     std::string bert_path     = "model/bert.rknn";
+
+    std::string cache_dir = "";   // synthesized sentences kept on disk, empty: memory only
+    int cache_mb = 64;            // memory cache size, 0: no cache
 };
 
 inline void usage(const std::string& prog) {
@@ -37,7 +40,9 @@ inline void usage(const std::string& prog) {
               << "  --speed                 Specifies the speed of output audio (default: 1.0).\n"
               << "  --speak_id              (default: 1.0).                                         \n"
               << "  --disable_bert          Indicates whether to disable the BERT model inference (default: ture).\n"
-              << "  --language              Specifies the language (ZH_MIX_EN / ZH / EN) for TTS (default: ZH).\n";
+              << "  --language              Specifies the language (ZH_MIX_EN / ZH / EN) for TTS (default: ZH).\n"
+              << "  --cache_dir             Directory keeping synthesized sentences across runs (default: memory only).\n"
+              << "  --cache_mb              Memory cache of synthesized sentences in MB, 0 disables the cache (default: 64).\n";
 }
 
 static bool to_bool(const std::string& s) {
@@ -73,6 +78,10 @@ inline Args parse_args(const std::vector<std::string>& argv) {
             args.disable_bert = to_bool(argv[++i]);
         } else if (arg == "--language") {
             args.language = argv[++i];
+        } else if (arg == "--cache_dir") {
+            args.cache_dir = argv[++i];
+        } else if (arg == "--cache_mb") {
+            args.cache_mb = std::stoi(argv[++i]);
         } else {
             usage(argv[0]);
             throw std::runtime_error("Unknown argument: " + arg);
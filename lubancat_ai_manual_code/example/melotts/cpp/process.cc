@@ -13,6 +13,7 @@
 // Modify from https://github.com/airockchip/rknn_model_zoo/blob/main/examples/mms_tts/cpp/process.cc
 
 #include "melotts.h"
+#include "stage_profiler.h"
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -24,122 +25,71 @@
 #include <algorithm>
 #include <numeric>
 
-static void compute_output_padding_mask(std::vector<float> &output_padding_mask, int predicted_lengths_max_real, int predicted_lengths_max)
+int compute_alignment(const std::vector<float> &log_w, const std::vector<float> &x_mask, float speed,
+                      std::vector<int> &frame_phone)
 {
-    int index = 0;
-    std::transform(output_padding_mask.begin(), output_padding_mask.end(), output_padding_mask.begin(),
-                   [&index, predicted_lengths_max_real](int i)
-                   {
-                       float result = (float)(index < predicted_lengths_max_real) ;
-                       ++index;
-                       return result;
-                   });
-}
-
-static void compute_attn_mask(std::vector<float> &output_padding_mask, std::vector<float> &input_padding_mask,
-                              std::vector<int> &attn_mask, int predicted_lengths_max, int input_padding_mask_size)
-{
-    int index = 0;
-    std::transform(attn_mask.begin(), attn_mask.end(), attn_mask.begin(),
-                    [&index, &output_padding_mask, &input_padding_mask, predicted_lengths_max, input_padding_mask_size](int k)
-                    {
-                        int i = index / predicted_lengths_max;
-                        int j = index % predicted_lengths_max;
-                        ++index;
-                        return int(output_padding_mask[j] * input_padding_mask[i]);
-                    });
-}
-
-static void compute_duration(const std::vector<float> &exp_log_duration, const std::vector<float> &input_padding_mask,
-                             std::vector<float> &duration, float length_scale)
-{
-    std::transform(exp_log_duration.begin(), exp_log_duration.end(), input_padding_mask.begin(), duration.begin(),
-                   [length_scale](float exp_log_val, float mask_val)
-                   {
-                       return ceil(exp_log_val * mask_val * length_scale);
-                   });
-}
+    PROFILE_SCOPE("compute_alignment");
+    float length_scale = 1.0f / speed;
+    int x_mask_size = MAX_LENGTH;
 
-static void compute_valid_indices(const std::vector<float> &cum_duration, std::vector<int> &valid_indices, int input_padding_mask_size, int predicted_lengths_max)
-{
-    std::vector<int> indices(valid_indices.size());
-    std::iota(indices.begin(), indices.end(), 0);
-    std::for_each(indices.begin(), indices.end(),
-                  [cum_duration, &valid_indices, predicted_lengths_max](int index)
-                  {
-                      int i = index / predicted_lengths_max;
-                      int j = index % predicted_lengths_max;
-                      valid_indices[index] = j < cum_duration[i] ? 1 : 0;
-                  });
-}
+    // durations are whole frames, the float sums match the old accumulate / partial_sum
+    float durations[MAX_LENGTH];
+    float predicted_length_sum = 0.0f;
+    for (int i = 0; i < x_mask_size; i++)
+    {
+        float exp_log_w = exp(log_w[i]);
+        durations[i] = ceil(exp_log_w * x_mask[i] * length_scale);
+        predicted_length_sum += durations[i];
+    }
+    int frames = std::max(1.0f, std::min(predicted_length_sum, (float)ALIGNMENT_FRAMES_MAX));
+    if (predicted_length_sum > ALIGNMENT_FRAMES_MAX)
+    {
+        printf("predicted length %.0f > ALIGNMENT_FRAMES_MAX, truncated\n", predicted_length_sum);
+    }
 
-static std::vector<float> exp_vector(const std::vector<float> &vec)
-{
-    std::vector<float> result(vec.size());
-    std::transform(vec.begin(), vec.end(), result.begin(), [](float v)
-                   { return exp(v); });
-    return result;
+    // monotonic alignment, every frame belongs to the phone whose duration covers it
+    frame_phone.assign(frames, -1);
+    float cum_duration = 0.0f;
+    int frame = 0;
+    for (int i = 0; i < x_mask_size && frame < frames; i++)
+    {
+        cum_duration += durations[i];
+        for (; frame < cum_duration && frame < frames; frame++)
+        {
+            frame_phone[frame] = i;
+        }
+    }
+    return frames;
 }
 
-static std::vector<float> cumsum(const std::vector<float> &vec)
+int fill_alignment_window(const std::vector<int> &frame_phone, const std::vector<float> &x_mask, int start,
+                          std::vector<float> &attn, std::vector<float> &y_mask)
 {
-    std::vector<float> result(vec.size());
-    std::partial_sum(vec.begin(), vec.end(), result.begin());
-    return result;
-}
+    int x_mask_size = MAX_LENGTH;
+    int predicted_lengths_max = PREDICTED_LENGTHS_MAX;
+    int frames = std::min((int)frame_phone.size() - start, predicted_lengths_max);
 
-static void transpose_mul(const std::vector<int> &input, int input_rows, int input_cols, std::vector<int> attn_mask, std::vector<float> &output)
-{
-    std::vector<int> indices(input.size());
-    std::iota(indices.begin(), indices.end(), 0);
+    std::fill(y_mask.begin(), y_mask.begin() + predicted_lengths_max, 0.0f);
+    std::fill(y_mask.begin(), y_mask.begin() + frames, 1.0f);
 
-    std::for_each(indices.begin(), indices.end(),
-                  [&input, &attn_mask, &output, input_rows, input_cols](int index)
-                  {
-                    int i = index / input_cols;
-                    int j = index % input_cols;
-                    output[j * input_rows + i] = (float)(input[index] * attn_mask[index]);
-                  });
+    // one entry per real frame, the rest of the dense decoder input stays zero
+    std::fill(attn.begin(), attn.begin() + predicted_lengths_max * x_mask_size, 0.0f);
+    for (int j = 0; j < frames; j++)
+    {
+        int i = frame_phone[start + j];
+        if (i >= 0)
+        {
+            attn[j * x_mask_size + i] = (float)int(x_mask[i]);     // y_mask * x_mask truncated to int, y_mask is 1 here
+        }
+    }
+    return frames;
 }
 
-static void compute_pad_indices(const std::vector<int> &valid_indices, std::vector<int> &sliced_indices, int input_length, int output_length)
+void middle_process(const std::vector<float> &log_w, const std::vector<float> &x_mask, std::vector<float> &attn,
+                    std::vector<float> &y_mask, float speed, int &predicted_lengths_max_real,
+                    std::vector<int> &frame_phone)
 {
-    int padded_length = input_length + 1;
-    std::vector<int> padded_indices(padded_length * output_length, 0);
-
-    std::copy(valid_indices.begin(), valid_indices.end(), padded_indices.begin() + output_length);
-
-    std::copy(padded_indices.begin(), padded_indices.begin() + input_length * output_length, sliced_indices.begin());
-
-    std::transform(valid_indices.begin(), valid_indices.end(), sliced_indices.begin(),
-                   sliced_indices.begin(), std::minus<int>());
+    PROFILE_SCOPE("middle_process");
+    compute_alignment(log_w, x_mask, speed, frame_phone);
+    predicted_lengths_max_real = fill_alignment_window(frame_phone, x_mask, 0, attn, y_mask);
 }
-
-void middle_process(std::vector<float> log_w, std::vector<float> x_mask, std::vector<float> &attn,
-                    std::vector<float> &y_mask, float speed, int &predicted_lengths_max_real)
-{
-    float length_scale = 1.0f / speed;
-    std::vector<float> w(LOG_DURATION_SIZE);
-
-    std::vector<float> exp_log_w = exp_vector(log_w);
-    compute_duration(exp_log_w, x_mask, w, length_scale);
-    float predicted_length_sum = std::accumulate(w.begin(), w.end(), 0.0f);
-    predicted_lengths_max_real = std::max(1.0f, predicted_length_sum);
-    int predicted_lengths_max = PREDICTED_LENGTHS_MAX;
-    if(predicted_lengths_max_real > predicted_lengths_max)
-    {
-        //TODO
-        printf("predicted_lengths_max_real > PREDICTED_LENGTHS_MAX \n");
-        predicted_lengths_max_real = predicted_lengths_max;
-    }
-    compute_output_padding_mask(y_mask, predicted_lengths_max_real, predicted_lengths_max);
-    int x_mask_size = MAX_LENGTH;
-    std::vector<int> attn_mask(predicted_lengths_max * x_mask_size);
-    compute_attn_mask(y_mask, x_mask, attn_mask, predicted_lengths_max, x_mask_size);
-    std::vector<float> cum_duration = cumsum(w);
-    std::vector<int> valid_indices(x_mask_size * predicted_lengths_max, 0);
-    compute_valid_indices(cum_duration, valid_indices, x_mask_size, predicted_lengths_max);
-    std::vector<int> padded_indices(x_mask_size * predicted_lengths_max, 0);
-    compute_pad_indices(valid_indices, padded_indices, x_mask_size, predicted_lengths_max);
-    transpose_mul(padded_indices, x_mask_size, predicted_lengths_max, attn_mask, attn);
-}
\ No newline at end of file
@@ -11,6 +11,11 @@
 #define PREDICTED_LENGTHS_MAX MAX_LENGTH*2
 #define PREDICTED_BATCH 512
 
+// longer alignments are decoded in windows of PREDICTED_LENGTHS_MAX frames overlapping by
+// DECODER_OVERLAP_FRAMES, the seams are crossfaded
+#define DECODER_OVERLAP_FRAMES 32
+#define ALIGNMENT_FRAMES_MAX (PREDICTED_LENGTHS_MAX * 64)
+
 #define INPUT_SIZE 1 * MAX_LENGTH
 #define LOGW_SIZE 1 * 1 * MAX_LENGTH
 #define X_MASK_SIZE 1 * 1 * MAX_LENGTH
@@ -23,6 +28,8 @@
 
 #define LEXICON_ZH_FILE "model/lexicon.txt"
 #define TOKENS_ZH_FILE "model/tokens.txt"
+// lexicon.txt / tokens.txt compiled by melotts_lexicon_compile
+#define LEXICON_BIN_FILE "model/lexicon.bin"
 
 #define LEXICON_EN_FILE "model/lexicon_en.txt"
 #define TOKENS_EN_FILE "model/tokens_en.txt"
@@ -31,7 +38,40 @@
 #define NOISE_SCALE 0.6 
 #define NOISE_SCALE_W 0.8
 
-void middle_process(std::vector<float> log_duration, std::vector<float> input_padding_mask, 
-    std::vector<float> &attn, std::vector<float> &output_padding_mask, float speed, int &predicted_lengths_max_real);
+/**
+ * @brief Durations from the encoder to the phone of every output frame
+ *
+ * @param frame_phone [out] Phone index per frame, -1 past the last phone
+ * @return int Frames, at least 1 and at most ALIGNMENT_FRAMES_MAX
+ */
+int compute_alignment(const std::vector<float> &log_duration, const std::vector<float> &input_padding_mask, float speed,
+                      std::vector<int> &frame_phone);
+
+/**
+ * @brief Dense decoder input for the PREDICTED_LENGTHS_MAX frames from start
+ *
+ * @param attn [out] PREDICTED_LENGTHS_MAX x MAX_LENGTH
+ * @param output_padding_mask [out] PREDICTED_LENGTHS_MAX
+ * @return int Real frames in the window
+ */
+int fill_alignment_window(const std::vector<int> &frame_phone, const std::vector<float> &input_padding_mask, int start,
+                          std::vector<float> &attn, std::vector<float> &output_padding_mask);
+
+/**
+ * @brief Durations from the encoder to the monotonic phone / frame alignment of the decoder, the
+ *        first PREDICTED_LENGTHS_MAX frames of it
+ *
+ * @param log_duration [in] logw, MAX_LENGTH
+ * @param input_padding_mask [in] x_mask, MAX_LENGTH
+ * @param attn [out] PREDICTED_LENGTHS_MAX x MAX_LENGTH, 1 where a frame belongs to a phone
+ * @param output_padding_mask [out] y_mask, PREDICTED_LENGTHS_MAX
+ * @param speed [in] > 1 speaks faster
+ * @param predicted_lengths_max_real [out] Frames of audio, at most PREDICTED_LENGTHS_MAX
+ * @param frame_phone [out] The whole alignment, see compute_alignment; kept by the caller so the
+ *        buffer is reused from one sentence to the next
+ */
+void middle_process(const std::vector<float> &log_duration, const std::vector<float> &input_padding_mask,
+    std::vector<float> &attn, std::vector<float> &output_padding_mask, float speed, int &predicted_lengths_max_real,
+    std::vector<int> &frame_phone);
 
 #endif
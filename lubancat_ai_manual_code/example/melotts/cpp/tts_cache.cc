@@ -0,0 +1,199 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tts_cache.h"
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t key_len;
+    uint32_t num_samples;
+} tts_cache_file_header_t;
+
+static std::string cache_file_path(const tts_cache_t *cache, const std::string &key)
+{
+    // fnv-1a, the key stored in the file settles collisions
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key)
+    {
+        h = (h ^ c) * 0x100000001b3ULL;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.pcm", (unsigned long long)h);
+    return cache->dir + name;
+}
+
+static int read_cache_file(const tts_cache_t *cache, const std::string &key, std::vector<float> &pcm)
+{
+    std::string path = cache_file_path(cache, key);
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == NULL)
+    {
+        return -1;
+    }
+    int ret = -1;
+    tts_cache_file_header_t h;
+    std::string stored;
+    if (fread(&h, sizeof(h), 1, fp) == 1 && h.magic == TTS_CACHE_MAGIC && h.version == TTS_CACHE_VERSION &&
+        h.key_len == key.size())
+    {
+        stored.resize(h.key_len);
+        if (fread(&stored[0], 1, h.key_len, fp) == h.key_len && stored == key)
+        {
+            pcm.resize(h.num_samples);
+            if (fread(pcm.data(), sizeof(float), h.num_samples, fp) == h.num_samples)
+            {
+                ret = 0;
+            }
+        }
+    }
+    fclose(fp);
+    return ret;
+}
+
+static int write_cache_file(const tts_cache_t *cache, const std::string &key, const float *pcm, int num_samples)
+{
+    // written aside and renamed, a reader never sees half a file
+    std::string path = cache_file_path(cache, key);
+    std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+    FILE *fp = fopen(tmp_path.c_str(), "wb");
+    if (fp == NULL)
+    {
+        printf("open %s fail!\n", tmp_path.c_str());
+        return -1;
+    }
+    tts_cache_file_header_t h;
+    h.magic = TTS_CACHE_MAGIC;
+    h.version = TTS_CACHE_VERSION;
+    h.key_len = key.size();
+    h.num_samples = num_samples;
+    bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 && fwrite(key.data(), 1, key.size(), fp) == key.size() &&
+              fwrite(pcm, sizeof(float), num_samples, fp) == (size_t)num_samples;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        printf("write %s fail!\n", path.c_str());
+        unlink(tmp_path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+// caller holds the lock
+static void put_entry(tts_cache_t *cache, const std::string &key, const float *pcm, int num_samples)
+{
+    size_t bytes = num_samples * sizeof(float);
+    if (cache->index.count(key) != 0 || bytes > cache->capacity)
+    {
+        return;
+    }
+    while (cache->size + bytes > cache->capacity && !cache->lru.empty())
+    {
+        tts_cache_entry_t &last = cache->lru.back();
+        cache->size -= last.pcm.size() * sizeof(float);
+        cache->index.erase(last.key);
+        cache->lru.pop_back();
+    }
+    cache->lru.push_front({key, std::vector<float>(pcm, pcm + num_samples)});
+    cache->index[key] = cache->lru.begin();
+    cache->size += bytes;
+}
+
+int tts_cache_init(tts_cache_t *cache, const char *dir, size_t capacity)
+{
+    cache->dir = dir != NULL ? dir : "";
+    cache->capacity = capacity;
+    cache->size = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    if (!cache->dir.empty() && mkdir(cache->dir.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        printf("mkdir %s fail! %s\n", cache->dir.c_str(), strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+void tts_cache_release(tts_cache_t *cache)
+{
+    std::lock_guard<std::mutex> lk(cache->lock);
+    cache->lru.clear();
+    cache->index.clear();
+    cache->size = 0;
+}
+
+std::string tts_cache_key(const std::string &text, int64_t speaker_id, float speed)
+{
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%lld|%.3f|", (long long)speaker_id, speed);
+    std::string key = prefix;
+    bool space = false;
+    for (char c : text)
+    {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        {
+            space = true;
+            continue;
+        }
+        if (space && key.size() > strlen(prefix))
+        {
+            key += ' ';
+        }
+        space = false;
+        key += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+    return key;
+}
+
+int tts_cache_lookup(tts_cache_t *cache, const std::string &key, std::vector<float> &pcm)
+{
+    {
+        std::lock_guard<std::mutex> lk(cache->lock);
+        auto it = cache->index.find(key);
+        if (it != cache->index.end())
+        {
+            cache->lru.splice(cache->lru.begin(), cache->lru, it->second);
+            pcm = it->second->pcm;
+            cache->hits++;
+            return 0;
+        }
+    }
+
+    int ret = cache->dir.empty() ? -1 : read_cache_file(cache, key, pcm);
+    std::lock_guard<std::mutex> lk(cache->lock);
+    if (ret == 0)
+    {
+        put_entry(cache, key, pcm.data(), pcm.size());
+        cache->hits++;
+    }
+    else
+    {
+        cache->misses++;
+    }
+    return ret;
+}
+
+int tts_cache_insert(tts_cache_t *cache, const std::string &key, const float *pcm, int num_samples)
+{
+    {
+        std::lock_guard<std::mutex> lk(cache->lock);
+        put_entry(cache, key, pcm, num_samples);
+    }
+    return cache->dir.empty() ? 0 : write_cache_file(cache, key, pcm, num_samples);
+}
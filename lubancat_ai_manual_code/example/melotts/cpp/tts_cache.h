@@ -0,0 +1,75 @@
+#ifndef _MELOTTS_TTS_CACHE_H_
+#define _MELOTTS_TTS_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define TTS_CACHE_MAGIC 0x43535454      // "TTSC"
+#define TTS_CACHE_VERSION 1
+
+typedef struct
+{
+    std::string key;
+    std::vector<float> pcm;
+} tts_cache_entry_t;
+
+/*
+ * Synthesized audio of whole sentences, keyed by tts_cache_key. The most recently used
+ * entries stay in memory up to capacity bytes of pcm, every entry is also written to
+ * dir as <fnv1a64 of key>.pcm so the cache survives restarts:
+ *
+ *   uint32_t magic, version, key_len, num_samples
+ *   char     key[key_len]          checked on load, a hash collision is a miss
+ *   float    pcm[num_samples]
+ *
+ * The disk store belongs to one encoder / decoder pair, use one dir per model.
+ */
+typedef struct
+{
+    std::string dir;                // empty: memory only
+    size_t capacity;
+    size_t size;
+    std::list<tts_cache_entry_t> lru;       // most recent first
+    std::unordered_map<std::string, std::list<tts_cache_entry_t>::iterator> index;
+    std::mutex lock;
+    int hits;
+    int misses;
+} tts_cache_t;
+
+/**
+ * @brief Set up the cache, creating dir if needed
+ *
+ * @param dir directory of the disk store, NULL or "" for memory only
+ * @param capacity bytes of pcm kept in memory
+ * @return int 0: success; -1: error
+ */
+int tts_cache_init(tts_cache_t *cache, const char *dir, size_t capacity);
+
+void tts_cache_release(tts_cache_t *cache);
+
+/**
+ * @brief Key of one sentence: the text with ascii lower cased and runs of white space
+ *        folded to one space, the speaker and the speed
+ */
+std::string tts_cache_key(const std::string &text, int64_t speaker_id, float speed);
+
+/**
+ * @brief Copy the audio of key to pcm, from memory or else from the disk store
+ *
+ * @return int 0: hit; -1: miss
+ */
+int tts_cache_lookup(tts_cache_t *cache, const std::string &key, std::vector<float> &pcm);
+
+/**
+ * @brief Add the audio of key, evicting the least recently used entries from memory
+ *
+ * @return int 0: success; -1: the disk store could not be written, the entry is still in memory
+ */
+int tts_cache_insert(tts_cache_t *cache, const std::string &key, const float *pcm, int num_samples);
+
+#endif //_MELOTTS_TTS_CACHE_H_
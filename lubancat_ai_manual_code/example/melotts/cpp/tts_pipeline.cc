@@ -0,0 +1,195 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "tts_pipeline.h"
+#include "stage_profiler.h"
+
+// latents in flight: one being decoded, one encoded ahead
+#define PIPELINE_DEPTH 2
+
+typedef struct
+{
+    melotts_latent_t slots[PIPELINE_DEPTH];
+    std::vector<std::vector<float>> cached;     // audio of the sentences found in the cache
+    std::vector<char> hit;
+    int encoded;            // sentences with a latent ready, slot = index % PIPELINE_DEPTH
+    int decoded;            // sentences done by the decoder, their slots are free again
+    int failed;
+    std::mutex lock;
+    std::condition_variable cond;
+} pipeline_queue_t;
+
+typedef struct
+{
+    const tts_pipeline_options_t *opts;
+    tts_pipeline_stats_t *stats;
+    std::chrono::steady_clock::time_point start;
+    int sentence;
+    std::vector<float> *record;     // the audio of the sentence for the cache, or NULL
+} chunk_context_t;
+
+// every decoder window of a long sentence is handed on as soon as it is out
+static int forward_chunk(const float *data, int num_samples, void *userdata)
+{
+    chunk_context_t *c = (chunk_context_t *)userdata;
+    if (c->stats->num_samples == 0)
+    {
+        c->stats->first_chunk_ms =
+            std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - c->start).count();
+    }
+    c->stats->num_samples += num_samples;
+    if (c->record != NULL)
+    {
+        c->record->insert(c->record->end(), data, data + num_samples);
+    }
+    if (c->opts->callback != NULL)
+    {
+        return c->opts->callback(c->sentence, data, num_samples, c->opts->userdata);
+    }
+    return 0;
+}
+
+static void encoder_thread(rknn_melotts_context_t *app_ctx, std::vector<tts_sentence_t> *sentences,
+                           const tts_pipeline_options_t *opts, pipeline_queue_t *q)
+{
+    for (int i = 0; i < (int)sentences->size(); i++)
+    {
+        {
+            std::unique_lock<std::mutex> lk(q->lock);
+            q->cond.wait(lk, [&] { return q->failed || i - q->decoded < PIPELINE_DEPTH; });
+            if (q->failed)
+            {
+                return;
+            }
+        }
+
+        // the slot is not touched by the decoder until encoded moves past it, neither is cached[i]
+        tts_sentence_t &s = (*sentences)[i];
+        int ret = 0;
+        if (opts->cache != NULL && !s.text.empty() &&
+            tts_cache_lookup(opts->cache, tts_cache_key(s.text, opts->speaker_id, opts->speed), q->cached[i]) == 0)
+        {
+            q->hit[i] = 1;
+        }
+        else
+        {
+            ret = encode_melotts_model(app_ctx, s.phones, s.phone_len, s.tones, s.lang_ids, opts->speaker_id,
+                                       opts->speed, opts->disable_bert, &q->slots[i % PIPELINE_DEPTH]);
+        }
+
+        std::lock_guard<std::mutex> lk(q->lock);
+        if (ret != 0)
+        {
+            printf("encode_melotts_model fail! ret=%d sentence=%d\n", ret, i);
+            q->failed = 1;
+        }
+        else
+        {
+            q->encoded = i + 1;
+        }
+        q->cond.notify_all();
+        if (q->failed)
+        {
+            return;
+        }
+    }
+}
+
+int run_melotts_pipeline(rknn_melotts_context_t *app_ctx, std::vector<tts_sentence_t> &sentences,
+                         const tts_pipeline_options_t *opts, tts_pipeline_stats_t *stats)
+{
+    PROFILE_SCOPE("run_melotts_pipeline");
+    auto start = std::chrono::steady_clock::now();
+    stats->first_chunk_ms = 0.0f;
+    stats->total_ms = 0.0f;
+    stats->num_samples = 0;
+    stats->cached = 0;
+
+    pipeline_queue_t q;
+    q.encoded = 0;
+    q.decoded = 0;
+    q.failed = 0;
+    q.cached.resize(sentences.size());
+    q.hit.assign(sentences.size(), 0);
+    std::thread encoder(encoder_thread, app_ctx, &sentences, opts, &q);
+
+    chunk_context_t chunk_ctx;
+    chunk_ctx.opts = opts;
+    chunk_ctx.stats = stats;
+    chunk_ctx.start = start;
+    std::vector<float> record;
+    int ret = 0;
+    for (int i = 0; i < (int)sentences.size(); i++)
+    {
+        {
+            std::unique_lock<std::mutex> lk(q.lock);
+            q.cond.wait(lk, [&] { return q.failed || q.encoded > i; });
+            if (q.failed)
+            {
+                ret = -1;
+                break;
+            }
+        }
+
+        chunk_ctx.sentence = i;
+        const tts_sentence_t &s = sentences[i];
+        if (q.hit[i])
+        {
+            // same samples as when it was decoded, sentences are joined without a crossfade either way
+            std::vector<float> &pcm = q.cached[i];
+            chunk_ctx.record = NULL;
+            ret = forward_chunk(pcm.data(), pcm.size(), &chunk_ctx) != 0 ? -1 : 0;
+            std::vector<float>().swap(pcm);
+            stats->cached++;
+        }
+        else
+        {
+            record.clear();
+            chunk_ctx.record = opts->cache != NULL && !s.text.empty() ? &record : NULL;
+            int output_lengths = decode_melotts_model(app_ctx, &q.slots[i % PIPELINE_DEPTH], forward_chunk, &chunk_ctx);
+            if (output_lengths < 0)
+            {
+                printf("decode_melotts_model fail! ret=%d sentence=%d\n", output_lengths, i);
+                ret = -1;
+            }
+            else if (chunk_ctx.record != NULL)
+            {
+                tts_cache_insert(opts->cache, tts_cache_key(s.text, opts->speaker_id, opts->speed), record.data(),
+                                 record.size());
+            }
+        }
+        if (ret == 0)
+        {
+            std::lock_guard<std::mutex> lk(q.lock);
+            q.decoded = i + 1;
+            q.cond.notify_all();
+        }
+        if (ret != 0)
+        {
+            std::lock_guard<std::mutex> lk(q.lock);
+            q.failed = 1;
+            q.cond.notify_all();
+            break;
+        }
+    }
+    encoder.join();
+
+    stats->total_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ret;
+}
@@ -0,0 +1,62 @@
+#ifndef _MELOTTS_TTS_PIPELINE_H_
+#define _MELOTTS_TTS_PIPELINE_H_
+
+#include <vector>
+
+#include "melotts.h"
+#include "tts_cache.h"
+
+// model input of one sentence, padded or trimmed to MAX_LENGTH
+typedef struct
+{
+    std::vector<int64_t> phones;
+    std::vector<int64_t> tones;
+    std::vector<int64_t> lang_ids;
+    int64_t phone_len;
+    std::string text;           // the sentence for the cache key, empty: never cached
+} tts_sentence_t;
+
+/**
+ * @brief Receives audio as soon as it is decoded, in order, a long sentence in several
+ *        chunks of one decoder window each
+ *
+ * @return int 0 to go on, anything else stops the pipeline
+ */
+typedef int (*tts_audio_callback_t)(int sentence, const float *data, int num_samples, void *userdata);
+
+typedef struct
+{
+    int64_t speaker_id;
+    float speed;
+    bool disable_bert;
+    tts_audio_callback_t callback;
+    void *userdata;
+    tts_cache_t *cache;         // NULL: no cache
+} tts_pipeline_options_t;
+
+typedef struct
+{
+    float first_chunk_ms;       // start to the first callback
+    float total_ms;
+    long long num_samples;
+    int cached;                 // sentences played from the cache
+} tts_pipeline_stats_t;
+
+/**
+ * @brief Synthesize the sentences with the encoder one sentence ahead of the decoder
+ *
+ * A worker thread runs the encoder and middle_process of sentence n+1 while the calling
+ * thread decodes sentence n and hands its audio to the callback, so the first audio is
+ * out after one sentence (or one decoder window of a long sentence) whatever the length
+ * of the text.
+ *
+ * With a cache, a sentence found there skips both models and its audio goes to the
+ * callback in one piece, at its place in the sentence order. Every sentence decoded
+ * in full is added to the cache.
+ *
+ * @return int 0: success; -1: error
+ */
+int run_melotts_pipeline(rknn_melotts_context_t *app_ctx, std::vector<tts_sentence_t> &sentences,
+                         const tts_pipeline_options_t *opts, tts_pipeline_stats_t *stats);
+
+#endif //_MELOTTS_TTS_PIPELINE_H_
@@ -0,0 +1,173 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*-------------------------------------------
+                Includes
+-------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mem_planner.h"
+
+struct Args {
+    std::vector<model_mem_t> models;
+    uint64_t budget = 0;            // bytes, 0: MemAvailable of the board
+    bool info_only = false;
+};
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options] <model.rknn>[:<contexts>[:<group>]] ...\n"
+           "\n"
+           "  --plan            Plan file, one model per line: <model.rknn> [contexts] [group], '#' starts a comment\n"
+           "  --budget_mb       Memory the models may take.(default: MemAvailable)\n"
+           "  --info_only       Only rknn_init with RKNN_FLAG_COLLECT_MODEL_INFO_ONLY, nothing is allocated,\n"
+           "                    the inputs / outputs are not counted\n"
+           "\n"
+           "  contexts: contexts of the model running at the same time.(default: 1)\n"
+           "  group:    models of a group run one after the other in the same threads, e.g. the\n"
+           "            det / cls / rec stages of ppocr, they can share the internal memory\n"
+           "\n"
+           "such as: %s yolov5s.rknn:2 ppocrv5_det.rknn:1:ocr ppocrv5_rec.rknn:3:ocr retinaface.rknn\n",
+           prog, prog);
+}
+
+static int add_model(Args &args, const std::string &path, int contexts, const std::string &group)
+{
+    if (path.empty() || contexts < 1)
+    {
+        printf("invalid model %s, contexts %d\n", path.c_str(), contexts);
+        return -1;
+    }
+    model_mem_t m;
+    m.path = path;
+    m.contexts = contexts;
+    m.group = group;
+    m.weight_size = m.internal_size = m.dma_size = m.io_size = 0;
+    m.sram_size = 0;
+    args.models.push_back(m);
+    return 0;
+}
+
+static int read_plan(Args &args, const char *path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        printf("open %s fail!\n", path);
+        return -1;
+    }
+    std::string line;
+    while (std::getline(in, line))
+    {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos)
+        {
+            line.resize(hash);
+        }
+        std::istringstream ss(line);
+        std::string model, group;
+        int contexts = 1;
+        if (!(ss >> model))
+        {
+            continue;
+        }
+        if (ss >> contexts)
+        {
+            ss >> group;
+        }
+        if (add_model(args, model, contexts, group) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int parse_args(int argc, char **argv, Args &args)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help")
+        {
+            return -1;
+        }
+        if (arg == "--info_only")
+        {
+            args.info_only = true;
+        }
+        else if (arg == "--plan" && i + 1 < argc)
+        {
+            if (read_plan(args, argv[++i]) != 0)
+            {
+                return -1;
+            }
+        }
+        else if (arg == "--budget_mb" && i + 1 < argc)
+        {
+            args.budget = (uint64_t)(atof(argv[++i]) * 1024 * 1024);
+        }
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            printf("unknown option %s\n", arg.c_str());
+            return -1;
+        }
+        else
+        {
+            // model[:contexts[:group]]
+            size_t c1 = arg.find(':');
+            size_t c2 = c1 == std::string::npos ? std::string::npos : arg.find(':', c1 + 1);
+            std::string path = arg.substr(0, c1);
+            int contexts = c1 == std::string::npos ? 1 : atoi(arg.substr(c1 + 1, c2 - c1 - 1).c_str());
+            std::string group = c2 == std::string::npos ? "" : arg.substr(c2 + 1);
+            if (add_model(args, path, contexts, group) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+    return args.models.empty() ? -1 : 0;
+}
+
+/*-------------------------------------------
+                  Main Function
+-------------------------------------------*/
+int main(int argc, char **argv)
+{
+    Args args;
+    if (parse_args(argc, argv, args) != 0)
+    {
+        usage(argv[0]);
+        return -1;
+    }
+
+    for (size_t i = 0; i < args.models.size(); i++)
+    {
+        if (query_model_mem(&args.models[i], args.info_only) != 0)
+        {
+            printf("query memory of %s fail!\n", args.models[i].path.c_str());
+            return -1;
+        }
+    }
+
+    mem_plan_t plan;
+    make_mem_plan(args.models, &plan);
+    return print_mem_plan(args.models, &plan, args.budget);
+}
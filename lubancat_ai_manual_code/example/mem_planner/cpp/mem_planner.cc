@@ -0,0 +1,288 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+
+#include "mem_planner.h"
+#include "rknn_api.h"
+#include "file_utils.h"
+
+#define MB(x) ((x) / (1024.0 * 1024.0))
+
+static int query_mem_size(const char *path, void *data, int size, uint32_t flag, rknn_mem_size *mem)
+{
+    rknn_context ctx = 0;
+    int ret = rknn_init(&ctx, data, size, flag, NULL);
+    if (ret < 0)
+    {
+        printf("rknn_init %s fail! ret=%d\n", path, ret);
+        return -1;
+    }
+    memset(mem, 0, sizeof(rknn_mem_size));
+    ret = rknn_query(ctx, RKNN_QUERY_MEM_SIZE, mem, sizeof(rknn_mem_size));
+    rknn_destroy(ctx);
+    if (ret != RKNN_SUCC)
+    {
+        printf("rknn_query RKNN_QUERY_MEM_SIZE %s fail! ret=%d\n", path, ret);
+        return -1;
+    }
+    return 0;
+}
+
+int query_model_mem(model_mem_t *model, bool info_only)
+{
+    char *data = NULL;
+    int size = read_data_from_file(model->path.c_str(), &data);
+    if (size <= 0)
+    {
+        printf("read %s fail!\n", model->path.c_str());
+        return -1;
+    }
+
+    rknn_mem_size mem;
+    model->dma_size = 0;
+    model->io_size = 0;
+    model->sram_size = 0;
+    int ret = query_mem_size(model->path.c_str(), data, size, RKNN_FLAG_COLLECT_MODEL_INFO_ONLY, &mem);
+    if (ret == 0)
+    {
+        model->weight_size = mem.total_weight_size;
+        model->internal_size = mem.total_internal_size;
+    }
+    // the dma total also holds the inputs / outputs and runtime buffers, it takes a real context
+    if (ret == 0 && !info_only)
+    {
+        ret = query_mem_size(model->path.c_str(), data, size, 0, &mem);
+        if (ret == 0)
+        {
+            uint64_t known = model->weight_size + model->internal_size;
+            model->dma_size = mem.total_dma_allocated_size;
+            model->io_size = model->dma_size > known ? model->dma_size - known : 0;
+            model->sram_size = mem.total_sram_size;
+        }
+    }
+    free(data);
+    return ret;
+}
+
+static uint64_t context_size(const model_mem_t &m)
+{
+    uint64_t known = m.weight_size + m.internal_size;
+    return m.dma_size > known ? m.dma_size : known;
+}
+
+static std::string model_name(const std::string &path)
+{
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+void make_mem_plan(const std::vector<model_mem_t> &models, mem_plan_t *plan)
+{
+    char text[512];
+    plan->naive = 0;
+    plan->advice.clear();
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        plan->naive += (uint64_t)models[i].contexts * context_size(models[i]);
+    }
+
+    // contexts of one model: one weight
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        const model_mem_t &m = models[i];
+        if (m.contexts > 1 && m.weight_size > 0)
+        {
+            snprintf(text, sizeof(text), "%s: create contexts 2..%d with rknn_dup_context of the first, they share the weight",
+                     model_name(m.path).c_str(), m.contexts);
+            mem_advice_t a = {text, (uint64_t)(m.contexts - 1) * m.weight_size, true};
+            plan->advice.push_back(a);
+        }
+    }
+
+    // a group runs its models one after the other, thread t needs one internal buffer, the largest
+    // internal size of the models with a context t
+    std::map<std::string, std::vector<const model_mem_t *>> groups;
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        if (!models[i].group.empty())
+        {
+            groups[models[i].group].push_back(&models[i]);
+        }
+    }
+    for (std::map<std::string, std::vector<const model_mem_t *>>::iterator it = groups.begin(); it != groups.end(); ++it)
+    {
+        const std::vector<const model_mem_t *> &members = it->second;
+        if (members.size() < 2)
+        {
+            continue;
+        }
+        int threads = 0;
+        uint64_t separate = 0;
+        std::string names;
+        for (size_t i = 0; i < members.size(); i++)
+        {
+            threads = std::max(threads, members[i]->contexts);
+            separate += (uint64_t)members[i]->contexts * members[i]->internal_size;
+            names += (i > 0 ? ", " : "") + model_name(members[i]->path);
+        }
+        uint64_t shared = 0;
+        uint64_t largest = 0;
+        for (int t = 0; t < threads; t++)
+        {
+            uint64_t buf = 0;
+            for (size_t i = 0; i < members.size(); i++)
+            {
+                if (members[i]->contexts > t)
+                {
+                    buf = std::max(buf, members[i]->internal_size);
+                }
+            }
+            shared += buf;
+            largest = std::max(largest, buf);
+        }
+        if (separate > shared)
+        {
+            snprintf(text, sizeof(text),
+                     "group %s (%s): RKNN_FLAG_INTERNAL_ALLOC_OUTSIDE, one rknn_set_internal_mem buffer per thread "
+                     "for all of them, %d x up to %.1f MB",
+                     it->first.c_str(), names.c_str(), threads, MB(largest));
+            mem_advice_t a = {text, separate - shared, true};
+            plan->advice.push_back(a);
+        }
+    }
+
+    // same weight size in other files: maybe the same network exported twice
+    std::map<uint64_t, std::vector<const model_mem_t *>> by_weight;
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        if (models[i].weight_size > 0)
+        {
+            by_weight[models[i].weight_size].push_back(&models[i]);
+        }
+    }
+    for (std::map<uint64_t, std::vector<const model_mem_t *>>::iterator it = by_weight.begin(); it != by_weight.end(); ++it)
+    {
+        const std::vector<const model_mem_t *> &same = it->second;
+        std::string names;
+        int files = 0;
+        for (size_t i = 0; i < same.size(); i++)
+        {
+            bool seen = false;
+            for (size_t j = 0; j < i; j++)
+            {
+                seen = seen || same[j]->path == same[i]->path;
+            }
+            if (!seen)
+            {
+                names += (files > 0 ? ", " : "") + model_name(same[i]->path);
+                files++;
+            }
+        }
+        if (files > 1)
+        {
+            snprintf(text, sizeof(text),
+                     "%s: same weight size, if they are exported from the same network rknn_init the others with "
+                     "RKNN_FLAG_SHARE_WEIGHT_MEM and rknn_init_extend.ctx of the first",
+                     names.c_str());
+            mem_advice_t a = {text, (uint64_t)(files - 1) * it->first, false};
+            plan->advice.push_back(a);
+        }
+    }
+
+    uint64_t saved = 0;
+    for (size_t i = 0; i < plan->advice.size(); i++)
+    {
+        if (plan->advice[i].certain)
+        {
+            saved += plan->advice[i].saved;
+        }
+    }
+    plan->planned = plan->naive > saved ? plan->naive - saved : 0;
+}
+
+static uint64_t mem_available(void)
+{
+    FILE *fp = fopen("/proc/meminfo", "r");
+    if (fp == NULL)
+    {
+        return 0;
+    }
+    char line[256];
+    unsigned long long kb = 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (sscanf(line, "MemAvailable: %llu kB", &kb) == 1)
+        {
+            break;
+        }
+    }
+    fclose(fp);
+    return (uint64_t)kb * 1024;
+}
+
+int print_mem_plan(const std::vector<model_mem_t> &models, const mem_plan_t *plan, uint64_t budget)
+{
+    bool info_only = false;
+    uint32_t sram_size = 0;
+    printf("%-32s %-8s %4s %9s %9s %9s %9s %9s\n", "model (MB)", "group", "ctx", "weight", "internal", "io",
+           "1 ctx", "total");
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        const model_mem_t &m = models[i];
+        info_only = info_only || m.dma_size == 0;
+        sram_size = std::max(sram_size, m.sram_size);
+        printf("%-32s %-8s %4d %9.1f %9.1f %9.1f %9.1f %9.1f\n", model_name(m.path).c_str(),
+               m.group.empty() ? "-" : m.group.c_str(), m.contexts, MB(m.weight_size), MB(m.internal_size),
+               MB(m.io_size), MB(context_size(m)), MB(m.contexts * context_size(m)));
+    }
+    if (info_only)
+    {
+        printf("io is 0 for models not loaded for real (--info_only), the totals miss their inputs / outputs\n");
+    }
+    if (sram_size > 0)
+    {
+        printf("SRAM reserved for rknn: %u KB, RKNN_FLAG_ENABLE_SRAM / RKNN_FLAG_SHARE_SRAM move internal memory there\n",
+               sram_size / 1024);
+    }
+
+    printf("\nevery context on its own: %9.1f MB\n", MB(plan->naive));
+    for (size_t i = 0; i < plan->advice.size(); i++)
+    {
+        const mem_advice_t &a = plan->advice[i];
+        printf("  %s %.1f MB: %s\n", a.certain ? "-" : "? (not counted)", MB(a.saved), a.what.c_str());
+    }
+    printf("with the advice:          %9.1f MB\n", MB(plan->planned));
+
+    const char *budget_name = "--budget_mb";
+    if (budget == 0)
+    {
+        budget = mem_available();
+        budget_name = "MemAvailable";
+    }
+    if (budget == 0)
+    {
+        return 0;
+    }
+    if (plan->planned <= budget)
+    {
+        printf("fits in %.1f MB (%s), %.1f MB left\n", MB(budget), budget_name, MB(budget - plan->planned));
+        return 0;
+    }
+    printf("over %.1f MB (%s) by %.1f MB\n", MB(budget), budget_name, MB(plan->planned - budget));
+    return 1;
+}
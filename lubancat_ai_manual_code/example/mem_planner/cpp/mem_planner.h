@@ -0,0 +1,66 @@
+#ifndef _RKNN_DEMO_MEM_PLANNER_H_
+#define _RKNN_DEMO_MEM_PLANNER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * NPU memory of a deployment that runs several models at once.
+ *
+ * Per context the runtime allocates the weight, the internal memory (intermediate
+ * tensors) and the input / output tensors, all in DMA memory. Contexts of one
+ * model made with rknn_dup_context share the weight. Contexts that never run at the
+ * same time, e.g. the stages of a pipeline in one thread, can share one internal
+ * buffer: RKNN_FLAG_INTERNAL_ALLOC_OUTSIDE and rknn_set_internal_mem with a buffer
+ * of the largest internal size. Models exported from the same network (other input
+ * size, ...) can share the weight with RKNN_FLAG_SHARE_WEIGHT_MEM.
+ */
+
+typedef struct {
+    std::string path;
+    int contexts;           // planned contexts, running concurrently
+    std::string group;      // models of a group run one after the other in a thread, "" for none
+
+    // RKNN_QUERY_MEM_SIZE
+    uint64_t weight_size;
+    uint64_t internal_size;
+    uint64_t dma_size;      // one context, 0 if the model was not loaded for real
+    uint64_t io_size;       // dma_size - weight - internal
+    uint32_t sram_size;
+} model_mem_t;
+
+typedef struct {
+    std::string what;
+    uint64_t saved;
+    bool certain;           // false: depends on how the models were exported, not in the planned total
+} mem_advice_t;
+
+typedef struct {
+    uint64_t naive;                     // every context allocates everything
+    uint64_t planned;                   // with the certain advice applied
+    std::vector<mem_advice_t> advice;
+} mem_plan_t;
+
+/**
+ * @brief Weight / internal sizes from a context with RKNN_FLAG_COLLECT_MODEL_INFO_ONLY, then
+ *        the DMA total of one real context unless info_only is set
+ *
+ * @return int 0: success; -1: error
+ */
+int query_model_mem(model_mem_t *model, bool info_only);
+
+/**
+ * @brief Totals with and without sharing, and what to share
+ */
+void make_mem_plan(const std::vector<model_mem_t> &models, mem_plan_t *plan);
+
+/**
+ * @brief Print the models, the plan and how it fits in budget bytes, 0: MemAvailable
+ *
+ * @return int 0: fits; 1: over budget
+ */
+int print_mem_plan(const std::vector<model_mem_t> &models, const mem_plan_t *plan, uint64_t budget);
+
+#endif // _RKNN_DEMO_MEM_PLANNER_H_
@@ -1,4 +1,5 @@
 #include "mobileclip_demo.h"
+#include "stage_profiler.h"
 
 static void print_tensor_attr(const rknn_tensor_attr& attr) {
 
@@ -219,7 +220,10 @@ cv::Mat MobileClip::mobileclip_image_infer(cv::Mat img)
     }
 
     // Run
-    ret = rknn_run(encode_image_ctx.rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(encode_image_ctx.rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -270,7 +274,10 @@ cv::Mat MobileClip::mobileclip_text_infer(std::vector<int> tokens)
     }
 
     // Run
-    ret = rknn_run(encode_text_ctx.rknn_ctx, NULL);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(encode_text_ctx.rknn_ctx, NULL);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
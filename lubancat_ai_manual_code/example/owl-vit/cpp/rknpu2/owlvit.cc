@@ -23,6 +23,7 @@
 #include "file_utils.h"
 #include "image_utils.h"
 #include "clip_tokenizer.h"
+#include "stage_profiler.h"
 
 inline static int clamp(float val, int min, int max) { return val > min ? (val < max ? val : max) : min; }
 
@@ -269,6 +270,7 @@ int release_owlvit_model(rknn_owlvit_context_t* app_ctx)
 static int inference_owlvit_text_model(rknn_owlvit_context_t* app_ctx, int64_t* input_ids, int64_t* attention_mask, 
             int text_nums, float* image_features, float* pred_boxes, letterbox_t* letter_box, object_detect_result_list* od_results)
 {
+    PROFILE_SCOPE("inference_owlvit_text_model");
     int ret;
     rknn_input inputs[app_ctx->owlvit_text_io_num.n_input];
     rknn_output outputs[app_ctx->owlvit_text_io_num.n_output];
@@ -317,7 +319,10 @@ static int inference_owlvit_text_model(rknn_owlvit_context_t* app_ctx, int64_t*
         }
 
         // Run
-        ret = rknn_run(app_ctx->owlvit_text_ctx, NULL);
+        {
+            PROFILE_SCOPE("rknn_run");
+            ret = rknn_run(app_ctx->owlvit_text_ctx, NULL);
+        }
         if (ret < 0)
         {
             printf("rknn_run fail! ret=%d\n", ret);
@@ -376,6 +381,7 @@ static int inference_owlvit_text_model(rknn_owlvit_context_t* app_ctx, int64_t*
 
 static int inference_owlvit_image_model(rknn_owlvit_context_t* app_ctx, image_buffer_t* img, float *pred_boxes, float *image_features)
 {
+    PROFILE_SCOPE("inference_owlvit_image_model");
     int ret;
     rknn_input inputs[app_ctx->owlvit_image_io_num.n_input];
     rknn_output outputs[app_ctx->owlvit_image_io_num.n_output];
@@ -397,8 +403,10 @@ static int inference_owlvit_image_model(rknn_owlvit_context_t* app_ctx, image_bu
     }
 
     // Run
-    printf("rknn_run owlvit_image_ctx\n");
-    ret = rknn_run(app_ctx->owlvit_image_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->owlvit_image_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -441,6 +449,7 @@ static int inference_owlvit_image_model(rknn_owlvit_context_t* app_ctx, image_bu
 
 int inference_owlvit_model(rknn_owlvit_context_t* app_ctx, image_buffer_t* img, char** text_input, int text_nums, object_detect_result_list* od_results)
 {
+    PROFILE_SCOPE("inference_owlvit_model");
     int ret;
     int bg_color = 114;
 
@@ -13,6 +13,7 @@
 // Reference from FastDeploy(https://github.com/PaddlePaddle/FastDeploy)
 
 #include "picodet.h"
+#include "stage_profiler.h"
 
 #include <math.h>
 #include <stdint.h>
@@ -273,6 +274,7 @@ int NMSForEachSample(
 
 int picodet_post_process(rknn_app_context_t *app_ctx, const float* boxes_data, const float* scores_data, object_detect_result* results) 
 {
+    PROFILE_SCOPE("picodet_post_process");
     uint32_t batch_size =  app_ctx->output_attrs[0].dims[0];
 
     uint32_t boxes_dim1 = app_ctx->output_attrs[0].dims[1];
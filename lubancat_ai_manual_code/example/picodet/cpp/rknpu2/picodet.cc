@@ -18,6 +18,7 @@
 #include "picodet.h"
 #include "image_utils.h"
 #include "dma_alloc.cpp"
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr *attr)
 {
@@ -177,6 +178,7 @@ int release_picodet_model(rknn_app_context_t *app_ctx)
 
 int inference_picodet_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result *od_results)
 {
+    PROFILE_SCOPE("inference_picodet_model");
     int ret;
     image_buffer_t dst_img;
     rknn_input inputs[app_ctx->io_num.n_input];
@@ -235,8 +237,10 @@ int inference_picodet_model(rknn_app_context_t *app_ctx, image_buffer_t *img, ob
     }
 
     // Run
-    // printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -132,7 +132,7 @@ static int crop_and_scale_image_yuv420sp(unsigned char *src, int src_width, int
         dst_y, dst_width, dst_height, dst_box_x, dst_box_y, dst_box_width, dst_box_height);
     
     crop_and_scale_image_c(2, src_uv, src_width / 2, src_height / 2, crop_x / 2, crop_y / 2, crop_width / 2, crop_height / 2,
-        dst_uv, dst_width / 2, dst_height / 2, dst_box_x, dst_box_y, dst_box_width, dst_box_height);
+        dst_uv, dst_width / 2, dst_height / 2, dst_box_x / 2, dst_box_y / 2, dst_box_width / 2, dst_box_height / 2);
 
     return 0;
 }
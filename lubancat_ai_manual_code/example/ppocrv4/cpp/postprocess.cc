@@ -7,6 +7,7 @@
 #include "ppocr_system.h"
 #include "clipper.h"
 #include "dict.h"
+#include "stage_profiler.h"
 
 using namespace std;
 
@@ -211,6 +212,7 @@ int dbnet_postprocess(float* output, int det_out_w, int det_out_h, float db_thre
                                                 const std::string &db_score_mode, const float &db_unclip_ratio, const std::string &db_box_type,
                                                 float scale_w, float scale_h, ppocr_det_result* results)
 {
+    PROFILE_SCOPE("dbnet_postprocess");
     // printf("[Info] db_threshold=%f, db_box_threshold=%f, use_dilation=%d, db_score_mode=%s, db_unclip_ratio=%f, db_box_type=%s\n",
     //                 db_threshold, db_box_threshold, use_dilation, db_score_mode.c_str(), db_unclip_ratio, db_box_type.c_str());
     int n = det_out_w * det_out_h;
@@ -408,6 +410,7 @@ int dbnet_postprocess(float* output, int det_out_w, int det_out_h, float db_thre
 
 int rec_postprocess(float* out_data, int out_channel, int out_seq_len, ppocr_rec_result* text)
 {
+    PROFILE_SCOPE("rec_postprocess");
     std::string str_res;
     float score = 0.f;
     int argmax_idx;
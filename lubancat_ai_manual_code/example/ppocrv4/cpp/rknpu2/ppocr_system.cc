@@ -7,6 +7,7 @@
 #include "opencv2/opencv.hpp"
 #include "ppocr_system.h"
 #include "image_utils.h"
+#include "stage_profiler.h"
 
 #define CLS_THRESH 0.9
 
@@ -241,6 +242,7 @@ int release_ppocr_model(rknn_app_context_t* app_ctx)
 
 int inference_ppocr_det_model(rknn_app_context_t* app_ctx, image_buffer_t* src_img, ppocr_det_postprocess_params* params, ppocr_det_result* out_result)
 {
+    PROFILE_SCOPE("inference_ppocr_det_model");
     int ret;
     image_buffer_t img;
     rknn_input inputs[1];
@@ -284,8 +286,10 @@ int inference_ppocr_det_model(rknn_app_context_t* app_ctx, image_buffer_t* src_i
     }
 
     // Run
-    // printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0) {
         printf("rknn_run fail! ret=%d\n", ret);
         return -1;
@@ -318,6 +322,7 @@ out:
 
 int inference_ppocr_rec_model(rknn_app_context_t* app_ctx, image_buffer_t* src_img, ppocr_rec_result* out_result)
 {
+    PROFILE_SCOPE("inference_ppocr_rec_model");
     int ret;
     rknn_input inputs[1];
     rknn_output outputs[1];
@@ -361,8 +366,10 @@ int inference_ppocr_rec_model(rknn_app_context_t* app_ctx, image_buffer_t* src_i
     }
 
     // Run
-    // printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0) {
         printf("rknn_run fail! ret=%d\n", ret);
         return -1;
@@ -393,6 +400,7 @@ out:
 
 int inference_ppocr_cls_model(rknn_app_context_t* app_ctx, const cv::Mat& srcimage, ppocr_cls_result* out_result)
 {
+    PROFILE_SCOPE("inference_ppocr_cls_model");
     int ret;
     rknn_input inputs[1];
     rknn_output outputs[1];
@@ -438,7 +446,10 @@ int inference_ppocr_cls_model(rknn_app_context_t* app_ctx, const cv::Mat& srcima
     }
 
     // inference
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0) {
         printf("rknn_run fail! ret=%d\n", ret);
         return -1;
@@ -475,6 +486,7 @@ out:
 
 int inference_ppocr_system_model(ppocr_system_app_context* sys_app_ctx, image_buffer_t* src_img, ppocr_det_postprocess_params* params, ppocr_text_recog_array_result_t* out_result)
 {
+    PROFILE_SCOPE("inference_ppocr_system_model");
     int ret;
     // Detect Text
     ppocr_det_result det_results;
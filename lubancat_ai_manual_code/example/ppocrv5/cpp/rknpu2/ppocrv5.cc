@@ -6,6 +6,7 @@
 #include <thread>
 
 #include "ppocrv5.h"
+#include "stage_profiler.h"
 
 static unsigned char* load_model(const char* filename, int* model_size)
 {
@@ -359,6 +360,7 @@ int release_ppocr_model(rknn_app_context_t* app_ctx)
 
 int inference_ppocr_det_model(rknn_app_context_t* app_ctx, image_buffer_t* src_img, ppocr_det_postprocess_params* params, ppocr_det_result* out_result)
 {
+    PROFILE_SCOPE("inference_ppocr_det_model");
     int ret;
     image_buffer_t img;
     rknn_input inputs[1];
@@ -409,8 +411,10 @@ int inference_ppocr_det_model(rknn_app_context_t* app_ctx, image_buffer_t* src_i
     }
 
     // Run
-    // printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0) {
         printf("rknn_run fail! ret=%d\n", ret);
         return -1;
@@ -444,6 +448,7 @@ out:
 void inference_ppocr_rec_worker_thread(int id, rknn_app_context_t* app_ctx, rknn_context& ctx, 
     const cv::Mat& in_image ,  const std::vector<std::array<int, 8>> & boxes_result, ppocr_text_recog_array_result_t* out_result, int n_threads)
 {
+    PROFILE_SCOPE("inference_ppocr_rec_worker_thread");
     int ret;
     int i = id;
 
@@ -511,7 +516,10 @@ void inference_ppocr_rec_worker_thread(int id, rknn_app_context_t* app_ctx, rknn
         assert(ret >= 0);
 
         // Run
-        ret = rknn_run(ctx, nullptr);
+        {
+            PROFILE_SCOPE("rknn_run");
+            ret = rknn_run(ctx, nullptr);
+        }
         assert(ret >= 0);
 
         // Get Output
@@ -577,6 +585,7 @@ void inference_ppocr_rec_worker_thread(int id, rknn_app_context_t* app_ctx, rknn
 int inference_ppocrv5_model(ppocr_system_app_context* sys_app_ctx,
     image_buffer_t* src_img, ppocr_det_postprocess_params* params, ppocr_text_recog_array_result_t* out_result)
 {
+    PROFILE_SCOPE("inference_ppocrv5_model");
     int ret;
     // TIMER timer;
 
@@ -32,13 +32,15 @@
 -------------------------------------------*/
 int main(int argc, char** argv)
 {
-    if (argc != 3) {
-        printf("%s <model_path> <image_path>\n", argv[0]);
+    if (argc != 3 && argc != 4) {
+        printf("%s <model_path> <image_path> [blend_alpha]\n", argv[0]);
+        printf("  blend_alpha: 0.0~1.0, blend the segment colors onto the source image\n");
         return -1;
     }
 
     const char* model_path = argv[1];
     const char* image_path = argv[2];
+    float blend_alpha = argc == 4 ? atof(argv[3]) : 0.0f;
 
     int ret;
     rknn_app_context_t rknn_app_ctx;
@@ -58,11 +60,18 @@ int main(int argc, char** argv)
         return -1;
     }
     
+    // full resolution result: the label map is upsampled instead of resizing the colored image
     image_buffer_t result_image;
     memset(&result_image, 0, sizeof(image_buffer_t));
-    result_image.height = rknn_app_ctx.model_height;
-    result_image.width = rknn_app_ctx.model_width;
+    result_image.height = src_image.height;
+    result_image.width = src_image.width;
     result_image.format = IMAGE_FORMAT_RGB888;
+    result_image.size = get_image_size(&result_image);
+    if (blend_alpha > 0.0f && src_image.format == IMAGE_FORMAT_RGB888) {
+        rknn_app_ctx.blend_alpha = blend_alpha;
+        result_image.virt_addr = (unsigned char*)malloc(result_image.size);
+        memcpy(result_image.virt_addr, src_image.virt_addr, result_image.size);
+    }
 
     ret = inference_ppseg_model(&rknn_app_ctx, &src_image, &result_image);
     if (ret != 0) {
@@ -70,13 +79,7 @@ int main(int argc, char** argv)
         goto out;
     }
 
-    ret = convert_image(&result_image, &src_image, NULL, NULL, 0);
-    if (ret < 0) {
-        printf("convert_image fail! ret=%d\n", ret);
-        return -1;
-    }
-
-    ret = write_image("./result.png",&src_image);
+    ret = write_image("./result.png", &result_image);
 
 out:
     ret = release_ppseg_model(&rknn_app_ctx);
@@ -0,0 +1,454 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "ppseg.h"
+#include "stage_profiler.h"
+
+typedef struct {
+    const char* name;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} seg_label_t;
+
+static const seg_label_t cityscapes_label[SEG_CLASS_NUM] = {
+    {"road", 128, 64, 128},
+    {"sidewalk", 244, 35, 232},
+    {"building", 70, 70, 70},
+    {"wall", 102, 102, 156},
+    {"fence", 190, 153, 153},
+    {"pole", 153, 153, 153},
+    {"traffic light", 250, 170, 30},
+    {"traffic sign", 220, 220, 0},
+    {"vegetation", 107, 142, 35},
+    {"terrain", 152, 251, 152},
+    {"sky", 70, 130, 180},
+    {"person", 220, 20, 60},
+    {"rider", 255, 0, 0},
+    {"car", 0, 0, 142},
+    {"truck", 0, 0, 70},
+    {"bus", 0, 60, 100},
+    {"train", 0, 80, 100},
+    {"motorcycle", 0, 0, 230},
+    {"bicycle", 119, 11, 32}
+};
+
+void init_segment_palette(uint8_t* palette)
+{
+    memset(palette, 0, SEG_PALETTE_SIZE * 3);
+    for (int i = 0; i < SEG_CLASS_NUM; i++) {
+        palette[i * 3 + 0] = cityscapes_label[i].r;
+        palette[i * 3 + 1] = cityscapes_label[i].g;
+        palette[i * 3 + 2] = cityscapes_label[i].b;
+    }
+}
+
+// fp16 bits -> int16 key with the same ordering as the float values,
+// so fp16 planes can be compared with integer instructions
+static inline int16_t fp16_order_key(uint16_t bits)
+{
+    int16_t s = (int16_t)bits;
+    return s ^ ((s >> 15) & 0x7fff);
+}
+
+static void argmax_nchw_int8(const int8_t* data, int num_class, int plane, uint8_t* label_map)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= plane; i += 16) {
+        int8x16_t max_val = vld1q_s8(data + i);
+        uint8x16_t max_idx = vdupq_n_u8(0);
+        const int8_t* p = data + i;
+        for (int c = 1; c < num_class; c++) {
+            p += plane;
+            int8x16_t v = vld1q_s8(p);
+            uint8x16_t gt = vcgtq_s8(v, max_val);
+            max_val = vmaxq_s8(v, max_val);
+            max_idx = vbslq_u8(gt, vdupq_n_u8((uint8_t)c), max_idx);
+        }
+        vst1q_u8(label_map + i, max_idx);
+    }
+#endif
+    for (; i < plane; i++) {
+        const int8_t* p = data + i;
+        int8_t max_val = *p;
+        uint8_t max_idx = 0;
+        for (int c = 1; c < num_class; c++) {
+            p += plane;
+            if (*p > max_val) {
+                max_val = *p;
+                max_idx = (uint8_t)c;
+            }
+        }
+        label_map[i] = max_idx;
+    }
+}
+
+static void argmax_nchw_fp16(const uint16_t* data, int num_class, int plane, uint8_t* label_map)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    const int16x8_t sign_mask = vdupq_n_s16(0x7fff);
+    for (; i + 8 <= plane; i += 8) {
+        int16x8_t s = vreinterpretq_s16_u16(vld1q_u16(data + i));
+        int16x8_t max_val = veorq_s16(s, vandq_s16(vshrq_n_s16(s, 15), sign_mask));
+        uint16x8_t max_idx = vdupq_n_u16(0);
+        const uint16_t* p = data + i;
+        for (int c = 1; c < num_class; c++) {
+            p += plane;
+            s = vreinterpretq_s16_u16(vld1q_u16(p));
+            int16x8_t v = veorq_s16(s, vandq_s16(vshrq_n_s16(s, 15), sign_mask));
+            uint16x8_t gt = vcgtq_s16(v, max_val);
+            max_val = vmaxq_s16(v, max_val);
+            max_idx = vbslq_u16(gt, vdupq_n_u16((uint16_t)c), max_idx);
+        }
+        vst1_u8(label_map + i, vmovn_u16(max_idx));
+    }
+#endif
+    for (; i < plane; i++) {
+        const uint16_t* p = data + i;
+        int16_t max_val = fp16_order_key(*p);
+        uint8_t max_idx = 0;
+        for (int c = 1; c < num_class; c++) {
+            p += plane;
+            int16_t v = fp16_order_key(*p);
+            if (v > max_val) {
+                max_val = v;
+                max_idx = (uint8_t)c;
+            }
+        }
+        label_map[i] = max_idx;
+    }
+}
+
+static void argmax_nchw_fp32(const float* data, int num_class, int plane, uint8_t* label_map)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 4 <= plane; i += 4) {
+        float32x4_t max_val = vld1q_f32(data + i);
+        uint32x4_t max_idx = vdupq_n_u32(0);
+        const float* p = data + i;
+        for (int c = 1; c < num_class; c++) {
+            p += plane;
+            float32x4_t v = vld1q_f32(p);
+            uint32x4_t gt = vcgtq_f32(v, max_val);
+            max_val = vmaxq_f32(v, max_val);
+            max_idx = vbslq_u32(gt, vdupq_n_u32((uint32_t)c), max_idx);
+        }
+        label_map[i + 0] = (uint8_t)vgetq_lane_u32(max_idx, 0);
+        label_map[i + 1] = (uint8_t)vgetq_lane_u32(max_idx, 1);
+        label_map[i + 2] = (uint8_t)vgetq_lane_u32(max_idx, 2);
+        label_map[i + 3] = (uint8_t)vgetq_lane_u32(max_idx, 3);
+    }
+#endif
+    for (; i < plane; i++) {
+        const float* p = data + i;
+        float max_val = *p;
+        uint8_t max_idx = 0;
+        for (int c = 1; c < num_class; c++) {
+            p += plane;
+            if (*p > max_val) {
+                max_val = *p;
+                max_idx = (uint8_t)c;
+            }
+        }
+        label_map[i] = max_idx;
+    }
+}
+
+// NHWC keeps the class scores of one pixel contiguous, a scalar scan is already cache friendly
+template <typename T, typename K, K (*key)(T)>
+static void argmax_nhwc(const T* data, int num_class, int plane, uint8_t* label_map)
+{
+    for (int i = 0; i < plane; i++) {
+        K max_val = key(data[0]);
+        uint8_t max_idx = 0;
+        for (int c = 1; c < num_class; c++) {
+            K v = key(data[c]);
+            if (v > max_val) {
+                max_val = v;
+                max_idx = (uint8_t)c;
+            }
+        }
+        label_map[i] = max_idx;
+        data += num_class;
+    }
+}
+
+static inline int8_t int8_key(int8_t v) { return v; }
+static inline int16_t fp16_key(uint16_t v) { return fp16_order_key(v); }
+static inline float fp32_key(float v) { return v; }
+
+int segment_argmax(const rknn_tensor_attr* attr, const void* data, uint8_t* label_map)
+{
+    if (attr == NULL || data == NULL || label_map == NULL || attr->n_dims != 4) {
+        return -1;
+    }
+
+    int num_class, height, width;
+    if (attr->fmt == RKNN_TENSOR_NHWC) {
+        height = attr->dims[1];
+        width = attr->dims[2];
+        num_class = attr->dims[3];
+    } else {
+        num_class = attr->dims[1];
+        height = attr->dims[2];
+        width = attr->dims[3];
+    }
+    if (num_class > SEG_PALETTE_SIZE) {
+        printf("segment_argmax: class num %d exceeds label range\n", num_class);
+        return -1;
+    }
+    int plane = height * width;
+
+    if (attr->fmt == RKNN_TENSOR_NHWC) {
+        switch (attr->type) {
+        case RKNN_TENSOR_INT8:
+            argmax_nhwc<int8_t, int8_t, int8_key>((const int8_t*)data, num_class, plane, label_map);
+            return 0;
+        case RKNN_TENSOR_FLOAT16:
+            argmax_nhwc<uint16_t, int16_t, fp16_key>((const uint16_t*)data, num_class, plane, label_map);
+            return 0;
+        case RKNN_TENSOR_FLOAT32:
+            argmax_nhwc<float, float, fp32_key>((const float*)data, num_class, plane, label_map);
+            return 0;
+        default:
+            break;
+        }
+    } else if (attr->fmt == RKNN_TENSOR_NCHW) {
+        switch (attr->type) {
+        case RKNN_TENSOR_INT8:
+            argmax_nchw_int8((const int8_t*)data, num_class, plane, label_map);
+            return 0;
+        case RKNN_TENSOR_FLOAT16:
+            argmax_nchw_fp16((const uint16_t*)data, num_class, plane, label_map);
+            return 0;
+        case RKNN_TENSOR_FLOAT32:
+            argmax_nchw_fp32((const float*)data, num_class, plane, label_map);
+            return 0;
+        default:
+            break;
+        }
+    }
+
+    printf("segment_argmax: unsupported output fmt=%s type=%s\n",
+           get_format_string(attr->fmt), get_type_string(attr->type));
+    return -1;
+}
+
+void init_label_x_map(int src_width, int dst_width, int* x_map)
+{
+    for (int x = 0; x < dst_width; x++) {
+        int sx = (int)(((int64_t)x * src_width) / dst_width);
+        x_map[x] = sx < src_width ? sx : src_width - 1;
+    }
+}
+
+int resize_label_map(const uint8_t* src, int src_width, int src_height, const int* x_map, uint8_t* dst, int dst_width,
+                     int dst_height)
+{
+    if (src == NULL || dst == NULL || dst_width <= 0 || dst_height <= 0) {
+        return -1;
+    }
+    if (src_width == dst_width && src_height == dst_height) {
+        memcpy(dst, src, dst_width * dst_height);
+        return 0;
+    }
+    if (x_map == NULL) {
+        return -1;
+    }
+
+    int last_sy = -1;
+    for (int y = 0; y < dst_height; y++) {
+        int sy = (int)(((int64_t)y * src_height) / dst_height);
+        if (sy >= src_height) {
+            sy = src_height - 1;
+        }
+        uint8_t* dst_row = dst + y * dst_width;
+        if (sy == last_sy) {
+            // upsampled rows repeat, copy the previous row instead of gathering again
+            memcpy(dst_row, dst_row - dst_width, dst_width);
+            continue;
+        }
+        const uint8_t* src_row = src + sy * src_width;
+        for (int x = 0; x < dst_width; x++) {
+            dst_row[x] = src_row[x_map[x]];
+        }
+        last_sy = sy;
+    }
+    return 0;
+}
+
+int colorize_label_map(const uint8_t* label_map, const uint8_t* palette, const image_buffer_t* blend_img, float alpha,
+                       image_buffer_t* dst_img)
+{
+    if (label_map == NULL || palette == NULL || dst_img == NULL || dst_img->virt_addr == NULL) {
+        return -1;
+    }
+    if (dst_img->format != IMAGE_FORMAT_RGB888) {
+        printf("colorize_label_map: dst format %d not support\n", dst_img->format);
+        return -1;
+    }
+
+    int pixels = dst_img->width * dst_img->height;
+    uint8_t* dst = dst_img->virt_addr;
+
+    if (blend_img == NULL || alpha >= 1.0f) {
+        for (int i = 0; i < pixels; i++) {
+            const uint8_t* color = palette + label_map[i] * 3;
+            dst[0] = color[0];
+            dst[1] = color[1];
+            dst[2] = color[2];
+            dst += 3;
+        }
+        return 0;
+    }
+
+    if (blend_img->virt_addr == NULL || blend_img->format != IMAGE_FORMAT_RGB888 ||
+        blend_img->width != dst_img->width || blend_img->height != dst_img->height) {
+        printf("colorize_label_map: blend image must be RGB888 with the same size as dst\n");
+        return -1;
+    }
+
+    // fixed point blend: dst = (src * (256 - a) + color * a) >> 8, color * a is precomputed per label
+    int a = (int)(alpha * 256.0f + 0.5f);
+    if (a < 0) {
+        a = 0;
+    }
+    uint16_t weighted_palette[SEG_PALETTE_SIZE * 3];
+    for (int i = 0; i < SEG_PALETTE_SIZE * 3; i++) {
+        weighted_palette[i] = (uint16_t)(palette[i] * a);
+    }
+    int inv_a = 256 - a;
+    const uint8_t* src = blend_img->virt_addr;
+    for (int i = 0; i < pixels; i++) {
+        const uint16_t* color = weighted_palette + label_map[i] * 3;
+        dst[0] = (uint8_t)((src[0] * inv_a + color[0]) >> 8);
+        dst[1] = (uint8_t)((src[1] * inv_a + color[1]) >> 8);
+        dst[2] = (uint8_t)((src[2] * inv_a + color[2]) >> 8);
+        src += 3;
+        dst += 3;
+    }
+    return 0;
+}
+
+int init_post_process(rknn_app_context_t* app_ctx)
+{
+    init_segment_palette(app_ctx->palette);
+    app_ctx->label_map = (uint8_t*)malloc(app_ctx->model_width * app_ctx->model_height);
+    if (app_ctx->label_map == NULL) {
+        printf("malloc label map fail!\n");
+        return -1;
+    }
+    app_ctx->full_label_map = NULL;
+    app_ctx->full_label_size = 0;
+    app_ctx->x_map = NULL;
+    app_ctx->x_map_size = 0;
+    app_ctx->x_map_src_width = 0;
+    app_ctx->x_map_dst_width = 0;
+    return 0;
+}
+
+void deinit_post_process(rknn_app_context_t* app_ctx)
+{
+    if (app_ctx->label_map != NULL) {
+        free(app_ctx->label_map);
+        app_ctx->label_map = NULL;
+    }
+    if (app_ctx->full_label_map != NULL) {
+        free(app_ctx->full_label_map);
+        app_ctx->full_label_map = NULL;
+        app_ctx->full_label_size = 0;
+    }
+    if (app_ctx->x_map != NULL) {
+        free(app_ctx->x_map);
+        app_ctx->x_map = NULL;
+        app_ctx->x_map_size = 0;
+    }
+}
+
+int post_process(rknn_app_context_t* app_ctx, const rknn_tensor_attr* attr, const void* output, image_buffer_t* result_img)
+{
+    PROFILE_SCOPE("post_process");
+    int ret;
+    int out_height, out_width;
+    if (attr->fmt == RKNN_TENSOR_NHWC) {
+        out_height = attr->dims[1];
+        out_width = attr->dims[2];
+    } else {
+        out_height = attr->dims[2];
+        out_width = attr->dims[3];
+    }
+    if (out_width * out_height > app_ctx->model_width * app_ctx->model_height) {
+        printf("post_process: output %dx%d larger than label map\n", out_width, out_height);
+        return -1;
+    }
+
+    ret = segment_argmax(attr, output, app_ctx->label_map);
+    if (ret != 0) {
+        return ret;
+    }
+
+    // only pay for the upsample when the caller asks for a result larger than the output
+    const uint8_t* labels = app_ctx->label_map;
+    if (result_img->width != out_width || result_img->height != out_height) {
+        int full_size = result_img->width * result_img->height;
+        if (app_ctx->full_label_size < full_size) {
+            free(app_ctx->full_label_map);
+            app_ctx->full_label_map = (uint8_t*)malloc(full_size);
+            if (app_ctx->full_label_map == NULL) {
+                app_ctx->full_label_size = 0;
+                printf("malloc full label map fail!\n");
+                return -1;
+            }
+            app_ctx->full_label_size = full_size;
+        }
+        // the column map only changes with the sizes
+        if (app_ctx->x_map_src_width != out_width || app_ctx->x_map_dst_width != result_img->width) {
+            if (app_ctx->x_map_size < result_img->width) {
+                free(app_ctx->x_map);
+                app_ctx->x_map = (int*)malloc(result_img->width * sizeof(int));
+                if (app_ctx->x_map == NULL) {
+                    app_ctx->x_map_size = 0;
+                    app_ctx->x_map_dst_width = 0;
+                    printf("malloc label x map fail!\n");
+                    return -1;
+                }
+                app_ctx->x_map_size = result_img->width;
+            }
+            init_label_x_map(out_width, result_img->width, app_ctx->x_map);
+            app_ctx->x_map_src_width = out_width;
+            app_ctx->x_map_dst_width = result_img->width;
+        }
+        ret = resize_label_map(app_ctx->label_map, out_width, out_height, app_ctx->x_map,
+                               app_ctx->full_label_map, result_img->width, result_img->height);
+        if (ret != 0) {
+            return ret;
+        }
+        labels = app_ctx->full_label_map;
+    }
+
+    result_img->format = IMAGE_FORMAT_RGB888;
+    result_img->size = get_image_size(result_img);
+    if (result_img->virt_addr == NULL) {
+        result_img->virt_addr = (unsigned char*)malloc(result_img->size);
+        if (result_img->virt_addr == NULL) {
+            printf("malloc buffer size:%d fail!\n", result_img->size);
+            return -1;
+        }
+        // nothing to blend onto in a fresh buffer
+        return colorize_label_map(labels, app_ctx->palette, NULL, 1.0f, result_img);
+    }
+
+    if (app_ctx->blend_alpha > 0.0f) {
+        return colorize_label_map(labels, app_ctx->palette, result_img, app_ctx->blend_alpha, result_img);
+    }
+    return colorize_label_map(labels, app_ctx->palette, NULL, 1.0f, result_img);
+}
@@ -0,0 +1,84 @@
+#ifndef _RKNN_PPSEG_DEMO_POSTPROCESS_H_
+#define _RKNN_PPSEG_DEMO_POSTPROCESS_H_
+
+#include <stdint.h>
+#include "rknn_api.h"
+#include "image_utils.h"
+
+#define SEG_CLASS_NUM 19
+#define SEG_PALETTE_SIZE 256
+
+/**
+ * @brief Allocate the reusable label map and build the palette
+ *
+ * @param app_ctx [in] Context with model_width/model_height set
+ * @return int 0: success; -1: error
+ */
+int init_post_process(rknn_app_context_t* app_ctx);
+
+void deinit_post_process(rknn_app_context_t* app_ctx);
+
+/**
+ * @brief Argmax the output into app_ctx->label_map, upsample it if result_img is larger than the
+ *        model input, and colorize it into result_img (blended when app_ctx->blend_alpha > 0)
+ *
+ * @param app_ctx [in] Context
+ * @param attr [in] Attribute describing output (dims, fmt, type)
+ * @param output [in] Output tensor data
+ * @param result_img [in/out] RGB888 result, virt_addr is allocated on first use if NULL
+ * @return int 0: success; -1: error
+ */
+int post_process(rknn_app_context_t* app_ctx, const rknn_tensor_attr* attr, const void* output, image_buffer_t* result_img);
+
+/**
+ * @brief Build the 256-entry RGB palette LUT (cityscapes colors, unused labels are black)
+ *
+ * @param palette [out] SEG_PALETTE_SIZE * 3 bytes
+ */
+void init_segment_palette(uint8_t* palette);
+
+/**
+ * @brief Per-pixel argmax over the class planes of a segmentation output
+ *
+ * Works directly on the native output type (INT8 / FP16 / FP32) so the output
+ * does not have to be converted with want_float. For affine quantized outputs
+ * the scale is shared by all classes, so the argmax of the raw int8 values is
+ * the argmax of the dequantized values.
+ *
+ * @param attr [in] Output tensor attribute (dims, fmt, type)
+ * @param data [in] Output tensor data
+ * @param label_map [out] height * width labels
+ * @return int 0: success; -1: error
+ */
+int segment_argmax(const rknn_tensor_attr* attr, const void* data, uint8_t* label_map);
+
+/**
+ * @brief Source column of every destination column of resize_label_map, the same for all rows
+ *
+ * @param x_map [out] dst_width columns
+ */
+void init_label_x_map(int src_width, int dst_width, int* x_map);
+
+/**
+ * @brief Nearest-neighbour resize of a label map
+ *
+ * @param x_map [in] Built by init_label_x_map for src_width / dst_width, may be NULL if the sizes match
+ * @return int 0: success; -1: error
+ */
+int resize_label_map(const uint8_t* src, int src_width, int src_height, const int* x_map, uint8_t* dst, int dst_width,
+                     int dst_height);
+
+/**
+ * @brief Colorize a label map through the palette LUT
+ *
+ * @param label_map [in] Labels with the same size as dst_img
+ * @param palette [in] SEG_PALETTE_SIZE * 3 bytes
+ * @param blend_img [in] Image to blend onto (RGB888, same size as dst_img), NULL for pure colors
+ * @param alpha [in] Weight of the palette color when blending, 0.0 ~ 1.0
+ * @param dst_img [out] RGB888 image, virt_addr must be allocated
+ * @return int 0: success; -1: error
+ */
+int colorize_label_map(const uint8_t* label_map, const uint8_t* palette, const image_buffer_t* blend_img, float alpha,
+                       image_buffer_t* dst_img);
+
+#endif //_RKNN_PPSEG_DEMO_POSTPROCESS_H_
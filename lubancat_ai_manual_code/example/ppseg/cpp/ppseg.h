@@ -3,7 +3,7 @@
 
 #include "rknn_api.h"
 #include "common.h"
-#include <tuple>
+#include <stdint.h>
 
 typedef struct {
     rknn_context rknn_ctx;
@@ -13,12 +13,29 @@ typedef struct {
     int model_channel;
     int model_width;
     int model_height;
+
+    uint8_t* label_map;         // argmax labels at model resolution, reused across frames
+    uint8_t* full_label_map;    // upsampled labels, only allocated when a larger result image is requested
+    int full_label_size;
+    int* x_map;                 // source column per result column, rebuilt when a width changes
+    int x_map_size;
+    int x_map_src_width;
+    int x_map_dst_width;
+    uint8_t palette[256 * 3];
+    float blend_alpha;          // > 0: blend palette colors onto the result image instead of overwriting it
 } rknn_app_context_t;
 
+#include "postprocess.h"
+
 int init_ppseg_model(const char* model_path, rknn_app_context_t* app_ctx);
 
 int release_ppseg_model(rknn_app_context_t* app_ctx);
 
+/**
+ * result_image decides the output resolution: at model size the label map is colorized as is,
+ * at any other size the label map is upsampled first. When blend_alpha > 0, result_image must
+ * already hold the RGB888 picture to blend onto.
+ */
 int inference_ppseg_model(rknn_app_context_t* app_ctx, image_buffer_t* img, image_buffer_t*result_image);
 
 #endif //_RKNN_DEMO_ppseg_H_
\ No newline at end of file
@@ -2,46 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
-#include <iostream>
-#include <chrono>
 #include "ppseg.h"
 #include "common.h"
 #include "file_utils.h"
 #include "image_utils.h"
-
-// Define the type of color
-using Color = std::tuple<int, int, int>;
-
-//Define a structure to represent a row of the table
-struct Entry {
-    int id;
-    const char* name;
-    Color color;
-};
-
-//Define a global table
-Entry cityscapes_label[] = {
-    {0, "road", Color(128, 64, 128)},
-    {1, "sidewalk", Color(244, 35, 232)},
-    {2, "building", Color(70, 70, 70)},
-    {3, "wall", Color(102, 102, 156)},
-    {4, "fence", Color(190, 153, 153)},
-    {5, "pole", Color(153, 153, 153)},
-    {6, "traffic light", Color(250, 170, 30)},
-    {7, "traffic sign", Color(220, 220, 0)},
-    {8, "vegetation", Color(107, 142, 35)},
-    {9, "terrain", Color(152, 251, 152)},
-    {10, "sky", Color(70, 130, 180)},
-    {11, "person", Color(220, 20, 60)},
-    {12, "rider", Color(255, 0, 0)},
-    {13, "car", Color(0, 0, 142)},
-    {14, "truck", Color(0, 0, 70)},
-    {15, "bus", Color(0, 60, 100)},
-    {16, "train", Color(0, 80, 100)},
-    {17, "motorcycle", Color(0, 0, 230)},
-    {18, "bicycle", Color(119, 11, 32)}
-};
-
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr* attr)
 {
@@ -52,46 +17,6 @@ static void dump_tensor_attr(rknn_tensor_attr* attr)
             get_qnt_type_string(attr->qnt_type), attr->zp, attr->scale);
 }
 
-Color getColorById(int id) {
-    for (const auto& entry : cityscapes_label) {
-        if (entry.id == id) {
-            return entry.color;
-        }
-    }
-    return Color(0, 0, 0);
-}
-
-int draw_segment_image(float* result, image_buffer_t* result_img)
-{
-    int height = result_img->height;
-    int width = result_img->width;
-    int num_class = 19;
-    result_img->virt_addr = (unsigned char*)malloc(3*height*width);
-    memset(result_img->virt_addr, 0, 3*height*width);
-    // [1,class,height,width] -> [1,3,height,width]
-    for (int batch = 0; batch < 1; batch++) {
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int maxClassIndex = 0;
-                for (int c = 1; c < num_class; c++) {
-                    int currentIndex = batch * (num_class * height * width) + c * (height * width) + y * width + x;
-                    int maxClassPos = batch * (num_class * height * width) + maxClassIndex * (height * width) + y * width + x;
-                    if (result[currentIndex] > result[maxClassPos]) {
-                        maxClassIndex = c;
-                    }
-                }
-                Color foundColor = getColorById(maxClassIndex);
-
-                int imageIndex = batch * (3 * height * width) + y * width * 3 + x * 3;
-                result_img->virt_addr[imageIndex] = std::get<0>(foundColor);       // R
-                result_img->virt_addr[imageIndex + 1] = std::get<1>(foundColor);   // G
-                result_img->virt_addr[imageIndex + 2] = std::get<2>(foundColor);   // B
-            }
-        }
-    }
-    return 0;
-}
-
 int init_ppseg_model(const char* model_path, rknn_app_context_t* app_ctx)
 {
     int ret;
@@ -175,11 +100,18 @@ int init_ppseg_model(const char* model_path, rknn_app_context_t* app_ctx)
     printf("model input height=%d, width=%d, channel=%d\n",
         app_ctx->model_height, app_ctx->model_width, app_ctx->model_channel);
 
+    ret = init_post_process(app_ctx);
+    if (ret != 0) {
+        printf("init_post_process fail! ret=%d\n", ret);
+        return -1;
+    }
+
     return 0;
 }
 
 int release_ppseg_model(rknn_app_context_t* app_ctx)
 {
+    deinit_post_process(app_ctx);
     if (app_ctx->input_attrs != NULL) {
         free(app_ctx->input_attrs);
         app_ctx->input_attrs = NULL;
@@ -197,6 +129,7 @@ int release_ppseg_model(rknn_app_context_t* app_ctx)
 
 int inference_ppseg_model(rknn_app_context_t* app_ctx, image_buffer_t* src_img, image_buffer_t* result_img)
 {
+    PROFILE_SCOPE("inference_ppseg_model");
     int ret;
     image_buffer_t img;
     rknn_input inputs[1];
@@ -238,19 +171,18 @@ int inference_ppseg_model(rknn_app_context_t* app_ctx, image_buffer_t* src_img,
     }
 
     // Run
-    printf("rknn_run\n");
-    auto start = std::chrono::high_resolution_clock::now();
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0) {
         printf("rknn_run fail! ret=%d\n", ret);
         return -1;
     }
-    auto stop = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "rknn run cost: " << float(duration.count()/1000.0) << " ms" << std::endl;
 
     // Get Output
-    outputs[0].want_float = 1;
+    // keep the native int8/fp16 data, argmax does not need dequantized scores
+    outputs[0].want_float = 0;
     ret = rknn_outputs_get(app_ctx->rknn_ctx, 1, outputs, NULL);
     if (ret < 0) {
         printf("rknn_outputs_get fail! ret=%d\n", ret);
@@ -259,7 +191,7 @@ int inference_ppseg_model(rknn_app_context_t* app_ctx, image_buffer_t* src_img,
 
     // Post Process
     // outputs -> take top1 pixel by pixel -> assign color
-    ret = draw_segment_image((float* )outputs[0].buf, result_img);
+    ret = post_process(app_ctx, &app_ctx->output_attrs[0], outputs[0].buf, result_img);
     // Remeber to release rknn output
     rknn_outputs_release(app_ctx->rknn_ctx, 1, outputs);
 
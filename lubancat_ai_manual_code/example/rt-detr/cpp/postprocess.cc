@@ -11,6 +11,7 @@
 // limitations under the License.
 
 #include "rtdetr.h"
+#include "stage_profiler.h"
 
 #include <math.h>
 #include <stdint.h>
@@ -206,6 +207,7 @@ static int process_fp32(float *pred_logits, float *pred_boxes,
 
 int post_process(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box, float conf_threshold, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("post_process");
     rknn_output *_outputs = (rknn_output *)outputs;
     std::vector<float> boxes;
     std::vector<float> objProbs;
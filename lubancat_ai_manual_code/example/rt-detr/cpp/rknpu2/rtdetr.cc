@@ -29,6 +29,7 @@
 #include "rknn_custom_op.h"
 
 #include "dma_alloc.cpp"
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr *attr) {
     char dims[128] = {0};
@@ -222,6 +223,7 @@ int release_rtdetr_model(rknn_app_context_t *app_ctx)
 
 int inference_rtdetr_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("inference_rtdetr_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -290,8 +292,10 @@ int inference_rtdetr_model(rknn_app_context_t *app_ctx, image_buffer_t *img, obj
     }
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
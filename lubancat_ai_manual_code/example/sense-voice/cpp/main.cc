@@ -22,10 +22,57 @@
 #include <vector>
 #include <string>
 #include <algorithm> 
+#include <atomic>
+#include <thread>
 
 #include "sensevoice.h"
 #include "audio_utils.h"
 #include "parser.h"
+#include "vad.h"
+#include "stream.h"
+
+#define MAX_CONTEXTS 8
+
+/*-------------------------------------------
+                  Functions
+-------------------------------------------*/
+// segments are taken in order by whichever context is free, results stay in segment order
+static int transcribe_segments(rknn_sensevoice_context_t *ctxs, int n_ctx, audio_buffer_t *audio,
+                               const std::vector<vad_segment_t> &segments, CMVNData &cmvn_data, int language,
+                               int text_norm, VocabEntry *vocab, std::vector<std::vector<std::string>> &texts)
+{
+    std::atomic<int> next(0);
+    std::atomic<int> failed(0);
+    texts.assign(segments.size(), std::vector<std::string>());
+
+    auto worker = [&](rknn_sensevoice_context_t *ctx) {
+        std::vector<float> input_data;
+        int length;
+        for (int i = next++; i < (int)segments.size() && !failed; i = next++)
+        {
+            audio_buffer_t segment = *audio;
+            segment.data = audio->data + segments[i].start;
+            segment.num_frames = segments[i].end - segments[i].start;
+            audio_preprocess(&segment, length, cmvn_data, input_data);
+            if (run_sensevoice(ctx, input_data, length, language, text_norm, vocab, texts[i]) != 0)
+            {
+                failed = 1;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < n_ctx; i++)
+    {
+        threads.emplace_back(worker, &ctxs[i]);
+    }
+    worker(&ctxs[0]);
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    return failed ? -1 : 0;
+}
 
 /*-------------------------------------------
                   Main Function
@@ -35,16 +82,19 @@ int main(int argc, char **argv)
     int ret;
     TIMER timer;
     float infer_time = 0.0;
+    float vad_time = 0.0;
     float audio_length = 0.0;
     float rtf = 0.0;
 
-    int length;
     int language;
     int text_norm;
 
-    rknn_sensevoice_context_t app_ctx;
-    std::vector<float> input_data;
-    std::vector<std::string> recognized_text;
+    rknn_sensevoice_context_t app_ctx[MAX_CONTEXTS];
+    int n_ctx = 0;
+    vad_options_t vad_opts;
+    std::vector<vad_segment_t> segments;
+    std::vector<std::vector<std::string>> recognized_text;
+    std::string text;
     VocabEntry vocab[VOCAB_LEN];
     CMVNData cmvn_data;
     audio_buffer_t audio;
@@ -78,72 +128,114 @@ int main(int argc, char **argv)
         return -1;
     }
 
-    memset(&app_ctx, 0, sizeof(rknn_sensevoice_context_t));
+    memset(app_ctx, 0, sizeof(app_ctx));
     memset(vocab, 0, sizeof(vocab));
     memset(&audio, 0, sizeof(audio_buffer_t));
 
     timer.tik();
-    ret = read_audio(args.audio_path.data(), &audio);
+    ret = load_cmvn("./model/am.mvn", cmvn_data);
     if (ret != 0)
     {
-        printf("read audio fail! ret=%d audio_path=%s\n", ret, args.audio_path.data());
+        printf("load_cmvn fail! ret=%d vocab_path=%s\n", ret);
         goto out;
     }
 
-    if (audio.num_channels == 2)
+    ret = read_vocab(args.tokens.data(), vocab);
+    if (ret != 0)
     {
-        ret = convert_channels(&audio);
-        if (ret != 0)
-        {
-            printf("convert channels fail! ret=%d\n", ret);
-            goto out;
-        }
+        printf("read vocab fail! ret=%d vocab_path=%s\n", ret, args.tokens.data());
+        goto out;
     }
+    timer.tok();
+    timer.print_time("load_cmvn & read_vocab");
 
-    if (audio.sample_rate != SAMPLE_RATE)
+    if (!args.stream.empty())
     {
-        ret = resample_audio(&audio, audio.sample_rate, SAMPLE_RATE);
+        // Streaming input, utterances are decoded by one context as soon as they end
+        stream_options_t stream_opts;
+        stream_opts.path = args.stream.c_str();
+        stream_opts.sample_rate = args.stream_rate;
+        stream_opts.num_channels = args.stream_channels;
+        vad_default_options(&stream_opts.vad_opts);
+        stream_opts.vad_opts.max_segment_s = std::min(std::max(args.max_segment, 1.0f), (float)CHUNK_LENGTH);
+        stream_opts.language = language;
+        stream_opts.text_norm = text_norm;
+
+        ret = init_sensevoice_model(args.model_path.data(), &app_ctx[0]);
         if (ret != 0)
         {
-            printf("resample audio fail! ret=%d\n", ret);
+            printf("init_sensevoice_model fail! ret=%d encoder_path=%s\n", ret, args.model_path.data());
             goto out;
         }
+        ret = run_sensevoice_stream(&app_ctx[0], &stream_opts, cmvn_data, vocab);
+        goto out;
     }
-    timer.tok();
-    timer.print_time("read_audio & convert_channels & resample_audio");
 
     timer.tik();
-    ret = load_cmvn("./model/am.mvn", cmvn_data);
+    ret = read_audio(args.audio_path.data(), &audio);
     if (ret != 0)
     {
-        printf("load_cmvn fail! ret=%d vocab_path=%s\n", ret);
+        printf("read audio fail! ret=%d audio_path=%s\n", ret, args.audio_path.data());
         goto out;
     }
 
-    ret = read_vocab(args.tokens.data(), vocab);
+    // downmix and resample in one polyphase pass
+    ret = convert_audio(&audio, SAMPLE_RATE);
     if (ret != 0)
     {
-        printf("read vocab fail! ret=%d vocab_path=%s\n", ret, args.tokens.data());
+        printf("convert audio fail! ret=%d\n", ret);
         goto out;
     }
     timer.tok();
-    timer.print_time("load_cmvn & read_vocab");
+    timer.print_time("read_audio & convert_audio");
 
-    // Initialize  model
+    // Split long audio at pauses, the model input holds CHUNK_LENGTH seconds
     timer.tik();
-    ret = init_sensevoice_model(args.model_path.data(), &app_ctx);
+    vad_default_options(&vad_opts);
+    vad_opts.max_segment_s = std::min(std::max(args.max_segment, 1.0f), (float)CHUNK_LENGTH);
+    if (audio.num_frames <= CHUNK_LENGTH * SAMPLE_RATE)
+    {
+        segments.push_back({0, audio.num_frames});
+    }
+    else
+    {
+        ret = vad_segment_audio(audio.data, audio.num_frames, SAMPLE_RATE, &vad_opts, segments);
+        if (ret != 0)
+        {
+            printf("vad_segment_audio fail! ret=%d\n", ret);
+            goto out;
+        }
+    }
+    timer.tok();
+    vad_time = timer.get_time() / 1000.0;
+    printf("%d segments\n", (int)segments.size());
+    timer.print_time("vad_segment_audio");
+
+    // Initialize  model, the other contexts share its weights
+    timer.tik();
+    ret = init_sensevoice_model(args.model_path.data(), &app_ctx[0]);
     if (ret != 0)
     {
         printf("init_sensevoice_model fail! ret=%d encoder_path=%s\n", ret, args.model_path.data());
         goto out;
     }
+    n_ctx = 1;
+    while (n_ctx < std::min(args.num_contexts, MAX_CONTEXTS) && n_ctx < (int)segments.size())
+    {
+        ret = dup_sensevoice_model(&app_ctx[0], &app_ctx[n_ctx]);
+        if (ret != 0)
+        {
+            printf("dup_sensevoice_model fail! ret=%d\n", ret);
+            goto out;
+        }
+        n_ctx++;
+    }
     timer.tok();
     timer.print_time("init_whisper_encoder_model");
 
     // Run inference
     timer.tik();
-    audio_preprocess(&audio, length, cmvn_data, input_data);
-    ret = run_sensevoice(&app_ctx, input_data, length, language, text_norm, vocab, recognized_text);
+    ret = transcribe_segments(app_ctx, n_ctx, &audio, segments, cmvn_data, language, text_norm, vocab, recognized_text);
     if (ret != 0)
     {
         printf("run_sensevoice fail! ret=%d\n", ret);
@@ -152,26 +244,45 @@ int main(int argc, char **argv)
     timer.tok();
     timer.print_time("run_sensevoice");
 
-    // print result
-    std::cout << "\nOutput: ";
-    for (const auto &str : recognized_text)
+    // print result, with the time of every segment for long audio
+    if (segments.size() > 1)
     {
-        std::cout << str;
+        printf("\n");
     }
-    std::cout << std::endl;
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        std::string segment_text;
+        for (const auto &str : recognized_text[i])
+        {
+            segment_text += str;
+        }
+        if (segments.size() > 1 && !segment_text.empty())
+        {
+            printf("[%8.2f - %8.2f] %s\n", segments[i].start / (float)SAMPLE_RATE, segments[i].end / (float)SAMPLE_RATE,
+                   segment_text.c_str());
+        }
+        text += segment_text;
+    }
+    if (text.empty())
+    {
+        text = "No speech detected";
+    }
+    std::cout << "\nOutput: " << text << std::endl;
 
-    infer_time = timer.get_time() / 1000.0;               // sec
+    infer_time = vad_time + timer.get_time() / 1000.0;    // sec
     audio_length = audio.num_frames / (float)SAMPLE_RATE; // sec
-    audio_length = audio_length > (float)CHUNK_LENGTH ? (float)CHUNK_LENGTH : audio_length;
     rtf = infer_time / audio_length;
     printf("\nReal Time Factor (RTF): %.3f / %.3f = %.3f\n", infer_time, audio_length, rtf);
 
 out:
 
-    ret = release_sensevoice_model(&app_ctx);
-    if (ret != 0)
+    for (int i = 0; i < MAX_CONTEXTS; i++)
     {
-        printf("release_sensevoice_model encoder_context fail! ret=%d\n", ret);
+        ret = release_sensevoice_model(&app_ctx[i]);
+        if (ret != 0)
+        {
+            printf("release_sensevoice_model encoder_context fail! ret=%d\n", ret);
+        }
     }
 
     for (int i = 0; i < VOCAB_LEN; ++i)
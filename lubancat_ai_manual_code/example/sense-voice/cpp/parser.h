@@ -13,6 +13,11 @@ struct Args {
     std::string audio_path = "./model/en.wav";
     std::string tokens = "./model/tokens.txt";
     int use_itn = 0; // 1 to use inverse text normalization, 0 to not use inverse text normalization
+    int num_contexts = 3;           // model contexts running segments of long audio concurrently
+    float max_segment = 7.0f;       // longest VAD segment in seconds, at most CHUNK_LENGTH
+    std::string stream;             // "-" or a FIFO of raw s16le PCM, replaces audio_path
+    int stream_rate = 16000;        // sample rate of the stream
+    int stream_channels = 1;        // interleaved channels of the stream
 };
 
 inline void usage(const std::string& prog) {
@@ -23,7 +28,13 @@ inline void usage(const std::string& prog) {
               << "  --tokens                Path to tokens.txt.(default: ./model/tokens.txt) \n"
               << "  --audio_path            The input wave to be recognized  (default: ./model/en.wav).\n"
               << "  --use-itn               1 to use inverse text normalization, 0 to not use inverse text normalization.(default: 0)\n"
-              << "  --language              Tthe language of the input wav file. Supported values: zh, en, ja, ko, yue, auto.(default: auto)\n";
+              << "  --language              Tthe language of the input wav file. Supported values: zh, en, ja, ko, yue, auto.(default: auto)\n"
+              << "  --num_contexts          Model contexts transcribing the VAD segments of long audio in parallel.(default: 3)\n"
+              << "  --max_segment           Longest VAD segment in seconds, at most 7.(default: 7)\n"
+              << "  --stream                Transcribe raw s16le PCM from - (stdin) or a FIFO utterance by utterance,\n"
+              << "                          e.g. arecord -f S16_LE -r 16000 -c 1 -t raw | ./sensevoice_demo --stream -\n"
+              << "  --stream_rate           Sample rate of the stream, resampled to 16 kHz.(default: 16000)\n"
+              << "  --stream_channels       Channels of the stream, downmixed to mono.(default: 1)\n";
 }
 
 inline Args parse_args(const std::vector<std::string>& argv) {
@@ -45,6 +56,16 @@ inline Args parse_args(const std::vector<std::string>& argv) {
             args.audio_path = argv[++i];
         } else if (arg == "--use-itn") {
             args.use_itn = std::stoi(argv[++i]);
+        } else if (arg == "--num_contexts") {
+            args.num_contexts = std::stoi(argv[++i]);
+        } else if (arg == "--max_segment") {
+            args.max_segment = std::stof(argv[++i]);
+        } else if (arg == "--stream") {
+            args.stream = argv[++i];
+        } else if (arg == "--stream_rate") {
+            args.stream_rate = std::stoi(argv[++i]);
+        } else if (arg == "--stream_channels") {
+            args.stream_channels = std::stoi(argv[++i]);
         } else {
             std::cout << "Unknown argument: " << arg << std::endl;
         }
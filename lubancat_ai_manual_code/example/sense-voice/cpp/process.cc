@@ -18,6 +18,11 @@
 #include <sstream>
 #include <string>
 #include <stdexcept>
+#include <algorithm>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #include <opencv2/opencv.hpp>
 
@@ -25,6 +30,7 @@
 #include "kaldi-native-fbank/csrc/feature-fbank.h"
 #include "kaldi-native-fbank/csrc/feature-window.h"
 #include "kaldi-native-fbank/csrc/mel-computations.h"
+#include "stage_profiler.h"
 
 int read_vocab(const char *fileName, VocabEntry *vocab)
 {
@@ -141,113 +147,110 @@ int load_cmvn(const std::string& cmvn_file, CMVNData& cmvn_data) {
     return 0;
 }
 
-void apply_cmvn(float* features, int num_frames, int num_features, const CMVNData& cmvn) {
-    if (cmvn.means.size() != static_cast<size_t>(num_features) || 
-        cmvn.vars.size() != static_cast<size_t>(num_features)) {
-        std::cout << "CMVN dimensions do not match feature dimensions!" << std::endl;
+// (x + mean) * inv_stddev over one fbank frame of an LFR row
+static inline void cmvn_frame(const float *src, const float *mean, const float *var, float *dst, int n)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t x = vaddq_f32(vld1q_f32(src + i), vld1q_f32(mean + i));
+        vst1q_f32(dst + i, vmulq_f32(x, vld1q_f32(var + i)));
     }
-
-    for (int i = 0; i < num_frames; ++i) {
-        for (int j = 0; j < num_features; ++j) {
-            features[i * num_features + j] = 
-                (features[i * num_features + j] + cmvn.means[j]) * cmvn.vars[j];
-        }
+#endif
+    for (; i < n; i++)
+    {
+        dst[i] = (src[i] + mean[i]) * var[i];
     }
 }
 
-static std::vector<float> apply_lfr(const std::vector<float>& inputs, int lfr_m, int lfr_n) 
+static inline void scale_samples(const float *src, float *dst, int n, float scale)
 {
-    int frame_dim = N_MELS;
-
-    int T = inputs.size() / frame_dim; // 总帧数
-
-    int T_lfr = static_cast<int>(ceil(T / static_cast<double>(lfr_n)));
-    int pad_size = (lfr_m - 1) / 2;
-
-    int total_len = (T + pad_size) * frame_dim;
-    std::vector<float> padded_inputs(total_len);
-
-    int first_frame_offset = 0;
-    for (int i = 0; i < pad_size; ++i) {
-        memcpy(&padded_inputs[i * frame_dim], &inputs[0], frame_dim * sizeof(float));
-        first_frame_offset = i * frame_dim;
-    }
-    memcpy(&padded_inputs[pad_size * frame_dim], inputs.data(), inputs.size() * sizeof(float));
-
-    T += pad_size;
-    std::vector<float> LFR_outputs;
-    LFR_outputs.reserve(T_lfr * lfr_m * frame_dim);
-
-    for (int i = 0; i < T_lfr; ++i) {
-        int start_idx = i * lfr_n * frame_dim;
-        int end_idx = start_idx + lfr_m * frame_dim;
-
-        if (end_idx <= padded_inputs.size()) {
-            LFR_outputs.insert(LFR_outputs.end(), 
-                                &padded_inputs[start_idx], 
-                                &padded_inputs[end_idx]);
-        } else {
-            int remaining = padded_inputs.size() - start_idx;
-            LFR_outputs.insert(LFR_outputs.end(),
-                                &padded_inputs[start_idx], 
-                                &padded_inputs[start_idx + remaining]);
-
-            int pad_num = lfr_m * frame_dim - remaining;
-            int last_frame_start = (T - 1) * frame_dim;
-            for (int p = 0; p < pad_num; ++p) {
-                int idx = last_frame_start + (p % frame_dim);
-                LFR_outputs.push_back(padded_inputs[idx]);
-            }
-        }
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f32(dst + i, vmulq_n_f32(vld1q_f32(src + i), scale));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        dst[i] = src[i] * scale;
     }
-
-    return LFR_outputs;
 }
 
-void audio_preprocess(audio_buffer_t *audio, int &len, CMVNData &cmvn_data, std::vector<float> &features)
+void init_fbank_options(knf::FbankOptions &opts)
 {
-    knf::FbankOptions opts;
     opts.frame_opts.dither = 0;
     opts.frame_opts.samp_freq = SAMPLE_RATE;
     opts.frame_opts.window_type = "hanning";
     opts.frame_opts.snip_edges = false;
     opts.mel_opts.num_bins = N_MELS;
+}
 
-    int audio_length = audio->num_frames;
-    std::vector<float> ori_audio_data(audio->data, audio->data + audio_length);
-
-    knf::OnlineFbank fbank(opts);
-    for (int32_t i = 0; i < audio_length; ++i) {
-        float s = ori_audio_data[i] * 32768;
-        fbank.AcceptWaveform(SAMPLE_RATE, &s, 1);
+void fbank_accept_waveform(knf::OnlineFbank &fbank, const float *samples, int n)
+{
+    // fbank expects 16 bit sample values, scale in blocks instead of copying the waveform
+    const int block = 4096;
+    float scaled[block];
+    for (int i = 0; i < n; i += block)
+    {
+        int m = std::min(block, n - i);
+        scale_samples(samples + i, scaled, m, 32768.0f);
+        fbank.AcceptWaveform(SAMPLE_RATE, scaled, m);
     }
+}
 
-    std::vector<float> mel_data;
+void fbank_to_features(knf::OnlineFbank &fbank, int num_frames, int &len, CMVNData &cmvn_data, std::vector<float> &features)
+{
+    // the model input is always INPUT_LENGTH rows, rows past the audio stay zero
+    features.assign(INPUT_LENGTH * FEATURES_LEN, 0.0f);
+    int T = std::min(num_frames, fbank.NumFramesReady());
+    if (T <= 0)
+    {
+        len = 0;
+        return;
+    }
 
-    int32_t n = fbank.NumFramesReady();
-    for (int32_t i = 0; i != n; ++i) {
-        const float *frame = fbank.GetFrame(i);
-        for (int32_t k = 0; k != N_MELS; ++k) {
-            mel_data.push_back(frame[k]);
+    // LFR stacks LFR_M fbank frames every LFR_N frames, the first frame is repeated
+    // (LFR_M - 1) / 2 times in front and the last one at the end. CMVN is applied
+    // while the frames are copied straight into the input rows.
+    int T_lfr = (T + LFR_N - 1) / LFR_N;
+    len = T_lfr;
+    if (len > INPUT_LENGTH)
+    {
+        len = INPUT_LENGTH;
+        std::cout << "features trim to INPUT_LENGTH!" << std::endl;
+    }
+    if (cmvn_data.means.size() != FEATURES_LEN || cmvn_data.vars.size() != FEATURES_LEN)
+    {
+        std::cout << "CMVN dimensions do not match feature dimensions!" << std::endl;
+        return;
+    }
+    const int pad = (LFR_M - 1) / 2;
+    const float *means = cmvn_data.means.data();
+    const float *vars = cmvn_data.vars.data();
+    for (int i = 0; i < len; i++)
+    {
+        float *row = features.data() + i * FEATURES_LEN;
+        for (int k = 0; k < LFR_M; k++)
+        {
+            int t = std::min(std::max(i * LFR_N + k - pad, 0), T - 1);
+            cmvn_frame(fbank.GetFrame(t), means + k * N_MELS, vars + k * N_MELS, row + k * N_MELS, N_MELS);
         }
     }
+}
 
-    // Apply LFR
-    features = apply_lfr(mel_data, LFR_M, LFR_N);
-
-    // Apply CMVN
-    int num_features = FEATURES_LEN;
-    len = features.size() / num_features;
-    apply_cmvn(features.data(), len, num_features, cmvn_data);
+void audio_preprocess(audio_buffer_t *audio, int &len, CMVNData &cmvn_data, std::vector<float> &features)
+{
+    PROFILE_SCOPE("audio_preprocess");
+    knf::FbankOptions opts;
+    init_fbank_options(opts);
 
-    // pad or trim
-    if (len < INPUT_LENGTH)
+    knf::OnlineFbank fbank(opts);
     {
-        features.resize(INPUT_LENGTH * FEATURES_LEN, 0.0f); // Pad with zeros
+        PROFILE_SCOPE("fbank");
+        fbank_accept_waveform(fbank, audio->data, audio->num_frames);
     }
-    else if (len > INPUT_LENGTH)
-    {
-        features.resize(INPUT_LENGTH * FEATURES_LEN); // Trim
-        std::cout << "features trim to INPUT_LENGTH!" << std::endl;
-    }
-}
\ No newline at end of file
+    fbank_to_features(fbank, fbank.NumFramesReady(), len, cmvn_data, features);
+}
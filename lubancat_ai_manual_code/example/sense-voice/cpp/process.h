@@ -3,6 +3,7 @@
 
 #include "rknn_api.h"
 #include "easy_timer.h"
+#include "kaldi-native-fbank/csrc/online-feature.h"
 
 #define SAMPLE_RATE 16000
 #define CHUNK_LENGTH 7
@@ -36,4 +37,10 @@ void logits_argmax(float *array, int *index);
 int read_vocab(const char *fileName, VocabEntry *vocab);
 void audio_preprocess(audio_buffer_t *audio, int &len, CMVNData &cmvn_data, std::vector<float> &data);
 
+// incremental feature extraction for streaming input: accept samples as they arrive,
+// then turn the first num_frames fbank frames into the model input (LFR + CMVN)
+void init_fbank_options(knf::FbankOptions &opts);
+void fbank_accept_waveform(knf::OnlineFbank &fbank, const float *samples, int n);
+void fbank_to_features(knf::OnlineFbank &fbank, int num_frames, int &len, CMVNData &cmvn_data, std::vector<float> &data);
+
 #endif //_RKNN_SENSEVOICE_DEMO_PROCESS_H_
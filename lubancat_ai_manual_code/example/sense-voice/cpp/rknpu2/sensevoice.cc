@@ -23,6 +23,7 @@
 #include "file_utils.h"
 #include "audio_utils.h"
 #include "process.h"
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr *attr)
 {
@@ -114,6 +115,29 @@ int init_sensevoice_model(const char *model_path, rknn_sensevoice_context_t *app
     return 0;
 }
 
+int dup_sensevoice_model(rknn_sensevoice_context_t *src_ctx, rknn_sensevoice_context_t *dst_ctx)
+{
+    int ret;
+    rknn_context ctx = 0;
+
+    // shares the weights with src_ctx, only the runtime buffers are allocated again
+    ret = rknn_dup_context(&src_ctx->rknn_ctx, &ctx);
+    if (ret != RKNN_SUCC)
+    {
+        printf("rknn_dup_context fail! ret=%d\n", ret);
+        return -1;
+    }
+
+    dst_ctx->rknn_ctx = ctx;
+    dst_ctx->io_num = src_ctx->io_num;
+    dst_ctx->input_attrs = (rknn_tensor_attr *)malloc(src_ctx->io_num.n_input * sizeof(rknn_tensor_attr));
+    memcpy(dst_ctx->input_attrs, src_ctx->input_attrs, src_ctx->io_num.n_input * sizeof(rknn_tensor_attr));
+    dst_ctx->output_attrs = (rknn_tensor_attr *)malloc(src_ctx->io_num.n_output * sizeof(rknn_tensor_attr));
+    memcpy(dst_ctx->output_attrs, src_ctx->output_attrs, src_ctx->io_num.n_output * sizeof(rknn_tensor_attr));
+
+    return 0;
+}
+
 int release_sensevoice_model(rknn_sensevoice_context_t *app_ctx)
 {
     if (app_ctx->input_attrs != NULL)
@@ -134,9 +158,10 @@ int release_sensevoice_model(rknn_sensevoice_context_t *app_ctx)
     return 0;
 }
 
-int run_sensevoice(rknn_sensevoice_context_t *app_ctx, std::vector<float> audio_data, int length,
+int run_sensevoice(rknn_sensevoice_context_t *app_ctx, const std::vector<float> &audio_data, int length,
     int language,  int text_norm, VocabEntry *vocab, std::vector<std::string> &recognized_text)
 {
+    PROFILE_SCOPE("run_sensevoice");
     int ret;
     int32_t idx[OUTPUT_LEN];
     float *output_data;
@@ -152,8 +177,7 @@ int run_sensevoice(rknn_sensevoice_context_t *app_ctx, std::vector<float> audio_
     inputs[0].index = 0;
     inputs[0].type = RKNN_TENSOR_FLOAT32;
     inputs[0].size = audio_data.size() * sizeof(float);
-    inputs[0].buf = (float *)malloc(inputs[0].size);
-    memcpy(inputs[0].buf, audio_data.data(), inputs[0].size);
+    inputs[0].buf = (void *)audio_data.data();     // rknn_inputs_set copies it, no staging copy needed
 
     inputs[1].index = 1;
     inputs[1].type = RKNN_TENSOR_INT32;
@@ -184,8 +208,10 @@ int run_sensevoice(rknn_sensevoice_context_t *app_ctx, std::vector<float> audio_
     }
 
     // Run
-    // printf("rknn_run ...\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -215,15 +241,10 @@ int run_sensevoice(rknn_sensevoice_context_t *app_ctx, std::vector<float> audio_
         }
     }
 
-    if (recognized_text.empty())
-    {
-        recognized_text.push_back("No speech detected");
-    }
-
 out:
     // Remeber to release rknn output
     rknn_outputs_release(app_ctx->rknn_ctx, 1, outputs);
-    for (int i = 0; i < 4; i++)
+    for (int i = 1; i < 4; i++)
     {
         if (inputs[i].buf != NULL)
         {
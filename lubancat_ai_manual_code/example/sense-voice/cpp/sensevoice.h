@@ -29,8 +29,9 @@ typedef struct
 } rknn_sensevoice_context_t;
 
 int init_sensevoice_model(const char *model_path, rknn_sensevoice_context_t *app_ctx);
+int dup_sensevoice_model(rknn_sensevoice_context_t *src_ctx, rknn_sensevoice_context_t *dst_ctx);
 int release_sensevoice_model(rknn_sensevoice_context_t *app_ctx);
-int run_sensevoice(rknn_sensevoice_context_t *app_ctx, std::vector<float> audio_data,
+int run_sensevoice(rknn_sensevoice_context_t *app_ctx, const std::vector<float> &audio_data,
     int length, int language,  int text_norm, VocabEntry *vocab, std::vector<std::string> &recognized_text);
 
 #endif //_RKNN_DEMO_SENSEVOICE_H_
\ No newline at end of file
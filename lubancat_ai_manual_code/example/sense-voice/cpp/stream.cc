@@ -0,0 +1,405 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+#include "stream.h"
+#include "audio_utils.h"
+#include "stage_profiler.h"
+
+#define RING_SAMPLES (1 << 20)      // ~65 s of 16 kHz audio, power of 2
+#define STREAM_BLOCK 4096           // samples taken from the ring at once
+#define VAD_FRAME_SAMPLES (SAMPLE_RATE * VAD_FRAME_MS / 1000)
+
+// single producer / single consumer ring of 16 bit samples
+typedef struct
+{
+    int16_t *data;
+    size_t mask;
+    std::atomic<size_t> head;       // written by the reader thread
+    std::atomic<size_t> tail;       // written by the decoding thread
+    std::atomic<int> eof;
+    std::atomic<int> stop;          // the decoder gave up, the reader ends after its current read
+} pcm_ring_t;
+
+static size_t ring_push(pcm_ring_t *ring, const int16_t *src, size_t n)
+{
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    size_t tail = ring->tail.load(std::memory_order_acquire);
+    n = std::min(n, ring->mask + 1 - (head - tail));
+    for (size_t i = 0; i < n; i++)
+    {
+        ring->data[(head + i) & ring->mask] = src[i];
+    }
+    ring->head.store(head + n, std::memory_order_release);
+    return n;
+}
+
+static size_t ring_pop(pcm_ring_t *ring, int16_t *dst, size_t n)
+{
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    size_t head = ring->head.load(std::memory_order_acquire);
+    n = std::min(n, head - tail);
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[i] = ring->data[(tail + i) & ring->mask];
+    }
+    ring->tail.store(tail + n, std::memory_order_release);
+    return n;
+}
+
+static void reader_thread(int fd, pcm_ring_t *ring)
+{
+    int16_t samples[4096];
+    size_t have = 0;    // bytes in samples, a read may end in the middle of a sample
+    while (!ring->stop.load(std::memory_order_relaxed))
+    {
+        ssize_t r = read(fd, (char *)samples + have, sizeof(samples) - have);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r <= 0)
+        {
+            break;
+        }
+        have += r;
+        size_t n = have / sizeof(int16_t);
+        size_t done = 0;
+        while (done < n && !ring->stop.load(std::memory_order_relaxed))
+        {
+            // a full ring only happens with input faster than real time (a piped file), hold the writer back
+            done += ring_push(ring, samples + done, n - done);
+            if (done < n)
+            {
+                usleep(1000);
+            }
+        }
+        if (have % sizeof(int16_t) != 0)
+        {
+            memcpy(samples, (char *)samples + n * sizeof(int16_t), 1);
+        }
+        have %= sizeof(int16_t);
+    }
+    ring->eof.store(1, std::memory_order_release);
+}
+
+typedef struct
+{
+    rknn_sensevoice_context_t *app_ctx;
+    const stream_options_t *opts;
+    CMVNData *cmvn_data;
+    VocabEntry *vocab;
+
+    std::vector<float> history;         // samples before the current utterance, for the padding
+    int64_t history_start;              // stream position of history[0]
+    int in_utterance;
+    std::vector<float> utterance;       // samples of the current utterance
+    std::vector<float> utterance_db;    // energy per VAD frame of the utterance
+    int64_t utterance_start;
+    std::unique_ptr<knf::OnlineFbank> fbank;
+    std::vector<float> features;
+    std::chrono::steady_clock::time_point last_speech;
+
+    int n_utterances;
+    double total_latency_ms;
+    double max_latency_ms;
+} stream_state_t;
+
+static void start_fbank(stream_state_t *s, const float *samples, int n)
+{
+    knf::FbankOptions fbank_opts;
+    init_fbank_options(fbank_opts);
+    s->fbank.reset(new knf::OnlineFbank(fbank_opts));
+    fbank_accept_waveform(*s->fbank, samples, n);
+}
+
+// decode the first n samples of the utterance, the fbank already holds their frames
+static int decode_utterance(stream_state_t *s, int n, int closed_by_vad)
+{
+    PROFILE_SCOPE("decode_utterance");
+    auto t0 = std::chrono::steady_clock::now();
+    int len;
+    std::vector<std::string> text;
+    fbank_to_features(*s->fbank, (n + VAD_FRAME_SAMPLES / 2) / VAD_FRAME_SAMPLES, len, *s->cmvn_data, s->features);
+    int ret = run_sensevoice(s->app_ctx, s->features, len, s->opts->language, s->opts->text_norm, s->vocab, text);
+    if (ret != 0)
+    {
+        printf("run_sensevoice fail! ret=%d\n", ret);
+        return -1;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::string joined;
+    for (const auto &str : text)
+    {
+        joined += str;
+    }
+    double decode_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    float start_s = s->utterance_start / (float)SAMPLE_RATE;
+    float end_s = (s->utterance_start + n) / (float)SAMPLE_RATE;
+    if (closed_by_vad)
+    {
+        // from the last frame above the threshold, live input adds the min_silence_ms hangover to it
+        double latency_ms = std::chrono::duration<double, std::milli>(t1 - s->last_speech).count();
+        s->total_latency_ms += latency_ms;
+        s->max_latency_ms = std::max(s->max_latency_ms, latency_ms);
+        s->n_utterances++;
+        printf("[%8.2f - %8.2f] %s (latency %.1f ms, decode %.1f ms)\n", start_s, end_s, joined.c_str(), latency_ms,
+               decode_ms);
+    }
+    else
+    {
+        printf("[%8.2f - %8.2f] %s (cut at max_segment, decode %.1f ms)\n", start_s, end_s, joined.c_str(), decode_ms);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+static int process_frame(stream_state_t *s, vad_stream_t *vad, const float *frame)
+{
+    const vad_options_t *vad_opts = &s->opts->vad_opts;
+    int pad_samples = vad_opts->pad_ms / VAD_FRAME_MS * VAD_FRAME_SAMPLES;
+    int max_samples = (int)(vad_opts->max_segment_s * SAMPLE_RATE);
+
+    float db = vad_frame_energy_db(frame, VAD_FRAME_SAMPLES);
+    int event = vad_stream_frame(vad, db);
+    if (vad->speech)
+    {
+        s->last_speech = std::chrono::steady_clock::now();
+    }
+    int64_t frame_start = (int64_t)(vad->frame_index - 1) * VAD_FRAME_SAMPLES;
+
+    if (s->in_utterance)
+    {
+        s->utterance.insert(s->utterance.end(), frame, frame + VAD_FRAME_SAMPLES);
+        s->utterance_db.push_back(db);
+        fbank_accept_waveform(*s->fbank, frame, VAD_FRAME_SAMPLES);
+    }
+    else
+    {
+        s->history.insert(s->history.end(), frame, frame + VAD_FRAME_SAMPLES);
+    }
+
+    if (event == VAD_SPEECH_START)
+    {
+        // the utterance starts pad_ms before the first speech frame, take it from the history
+        int64_t start = std::max((int64_t)vad->event_frame * VAD_FRAME_SAMPLES - pad_samples, s->history_start);
+        int offset = (int)(start - s->history_start);
+        s->utterance.assign(s->history.begin() + offset, s->history.end());
+        s->utterance_db.clear();
+        for (size_t i = 0; i + VAD_FRAME_SAMPLES <= s->utterance.size(); i += VAD_FRAME_SAMPLES)
+        {
+            s->utterance_db.push_back(vad_frame_energy_db(s->utterance.data() + i, VAD_FRAME_SAMPLES));
+        }
+        s->utterance_start = start;
+        start_fbank(s, s->utterance.data(), s->utterance.size());
+        s->in_utterance = 1;
+    }
+    else if (event == VAD_SPEECH_END)
+    {
+        // min_silence_ms > pad_ms, the padding after the speech is already in the utterance
+        int64_t end = std::min((int64_t)vad->event_frame * VAD_FRAME_SAMPLES + pad_samples,
+                               s->utterance_start + (int64_t)s->utterance.size());
+        if (decode_utterance(s, (int)(end - s->utterance_start), 1) != 0)
+        {
+            return -1;
+        }
+        s->in_utterance = 0;
+        s->history.clear();
+        s->history_start = frame_start + VAD_FRAME_SAMPLES;
+    }
+
+    if (s->in_utterance && (int)s->utterance.size() >= max_samples)
+    {
+        // cut at the quietest frame of the second half, the rest starts the next part
+        int n_frames = s->utterance_db.size();
+        int cut = n_frames / 2;
+        for (int i = cut + 1; i < n_frames; i++)
+        {
+            if (s->utterance_db[i] < s->utterance_db[cut])
+            {
+                cut = i;
+            }
+        }
+        if (decode_utterance(s, cut * VAD_FRAME_SAMPLES, 0) != 0)
+        {
+            return -1;
+        }
+        s->utterance.erase(s->utterance.begin(), s->utterance.begin() + cut * VAD_FRAME_SAMPLES);
+        s->utterance_db.erase(s->utterance_db.begin(), s->utterance_db.begin() + cut);
+        s->utterance_start += cut * VAD_FRAME_SAMPLES;
+        start_fbank(s, s->utterance.data(), s->utterance.size());
+    }
+
+    // outside speech only the padding and the frames of a pending start are needed
+    size_t keep = (size_t)(pad_samples + (vad_opts->min_speech_ms / VAD_FRAME_MS + 1) * VAD_FRAME_SAMPLES);
+    if (!s->in_utterance && s->history.size() > 4 * keep)
+    {
+        size_t drop = s->history.size() - keep;
+        s->history.erase(s->history.begin(), s->history.begin() + drop);
+        s->history_start += drop;
+    }
+    return 0;
+}
+
+int run_sensevoice_stream(rknn_sensevoice_context_t *app_ctx, const stream_options_t *opts, CMVNData &cmvn_data,
+                          VocabEntry *vocab)
+{
+    int fd = strcmp(opts->path, "-") == 0 ? STDIN_FILENO : open(opts->path, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("open %s fail!\n", opts->path);
+        return -1;
+    }
+
+    static pcm_ring_t ring;
+    ring.data = (int16_t *)malloc(RING_SAMPLES * sizeof(int16_t));
+    if (ring.data == NULL)
+    {
+        printf("malloc ring fail!\n");
+        if (fd != STDIN_FILENO)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    ring.mask = RING_SAMPLES - 1;
+    ring.head = 0;
+    ring.tail = 0;
+    ring.eof = 0;
+    ring.stop = 0;
+
+    stream_state_t state;
+    state.app_ctx = app_ctx;
+    state.opts = opts;
+    state.cmvn_data = &cmvn_data;
+    state.vocab = vocab;
+    state.history_start = 0;
+    state.in_utterance = 0;
+    state.utterance_start = 0;
+    state.n_utterances = 0;
+    state.total_latency_ms = 0.0;
+    state.max_latency_ms = 0.0;
+    state.utterance.reserve((size_t)(opts->vad_opts.max_segment_s * SAMPLE_RATE) + VAD_FRAME_SAMPLES);
+
+    vad_stream_t vad;
+    vad_stream_init(&vad, &opts->vad_opts);
+
+    // the input runs through the resampler block by block, at 16 kHz mono it only converts
+    audio_resampler_t rs;
+    if (audio_resampler_init(&rs, opts->sample_rate, SAMPLE_RATE, opts->num_channels) != 0)
+    {
+        free(ring.data);
+        ring.data = NULL;
+        if (fd != STDIN_FILENO)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    int channels = opts->num_channels;
+    std::vector<float> block(STREAM_BLOCK);
+    std::vector<float> resampled;       // 16 kHz mono samples not yet cut into VAD frames
+
+    printf("streaming from %s, raw %d Hz %d ch s16le\n", opts->path, opts->sample_rate, channels);
+    std::thread reader(reader_thread, fd, &ring);
+
+    int ret = 0;
+    int16_t pcm[STREAM_BLOCK];
+    size_t have = 0;
+    int last = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    while (ret == 0 && !last)
+    {
+        int eof = ring.eof.load(std::memory_order_acquire);
+        have += ring_pop(&ring, pcm + have, STREAM_BLOCK - STREAM_BLOCK % channels - have);
+        // eof was seen before the pop, an empty ring now means nothing more will come
+        last = eof && ring.head.load(std::memory_order_acquire) == ring.tail.load(std::memory_order_relaxed);
+        int frames = (int)(have / channels);
+        if (frames == 0 && !last)
+        {
+            usleep(2000);
+            continue;
+        }
+        for (int i = 0; i < frames * channels; i++)
+        {
+            block[i] = pcm[i] / 32768.0f;
+        }
+        have -= frames * channels;
+        memmove(pcm, pcm + frames * channels, have * sizeof(int16_t));
+
+        size_t old_size = resampled.size();
+        resampled.resize(old_size + audio_resampler_max_output(&rs, frames));
+        int n = audio_resampler_process(&rs, block.data(), frames, resampled.data() + old_size);
+        if (n >= 0 && last)
+        {
+            int tail = audio_resampler_flush(&rs, resampled.data() + old_size + n);
+            n = tail < 0 ? -1 : n + tail;
+        }
+        if (n < 0)
+        {
+            ret = -1;
+            break;
+        }
+        resampled.resize(old_size + n);
+
+        size_t consumed = 0;
+        while (ret == 0 && resampled.size() - consumed >= VAD_FRAME_SAMPLES)
+        {
+            ret = process_frame(&state, &vad, resampled.data() + consumed);
+            consumed += VAD_FRAME_SAMPLES;
+        }
+        resampled.erase(resampled.begin(), resampled.begin() + consumed);
+    }
+    audio_resampler_release(&rs);
+    if (ret == 0 && vad_stream_flush(&vad) == VAD_SPEECH_END && state.in_utterance)
+    {
+        ret = decode_utterance(&state, state.utterance.size(), 1);
+    }
+    if (ret != 0)
+    {
+        // the reader may wait in read() on a live source forever, leave it and its ring to the exit
+        ring.stop = 1;
+        reader.detach();
+        return ret;
+    }
+    reader.join();
+    if (fd != STDIN_FILENO)
+    {
+        close(fd);
+    }
+    free(ring.data);
+    ring.data = NULL;
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    double audio_s = vad.frame_index * VAD_FRAME_MS / 1000.0;
+    printf("\n%.2f s of audio in %.2f s, %d utterances", audio_s, wall_s, state.n_utterances);
+    if (state.n_utterances > 0)
+    {
+        printf(", end of speech to text latency avg %.1f ms max %.1f ms", state.total_latency_ms / state.n_utterances,
+               state.max_latency_ms);
+    }
+    printf("\n");
+    return ret;
+}
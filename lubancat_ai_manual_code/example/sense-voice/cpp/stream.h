@@ -0,0 +1,31 @@
+#ifndef _RKNN_SENSEVOICE_DEMO_STREAM_H_
+#define _RKNN_SENSEVOICE_DEMO_STREAM_H_
+
+#include "sensevoice.h"
+#include "vad.h"
+
+typedef struct
+{
+    const char *path;           // "-" for stdin, or a FIFO / file of raw interleaved s16le PCM
+    int sample_rate;            // resampled to 16 kHz on the fly
+    int num_channels;           // downmixed to mono on the fly
+    vad_options_t vad_opts;
+    int language;
+    int text_norm;
+} stream_options_t;
+
+/**
+ * @brief Transcribe a live PCM stream utterance by utterance
+ *
+ * A reader thread moves the PCM into a lock-free ring, the calling thread runs the
+ * VAD and feeds the fbank while the speech arrives, and decodes every utterance as
+ * soon as the VAD closes it. Utterances longer than vad_opts.max_segment_s are cut
+ * at their quietest frame. Prints the text with the latency from the last speech
+ * frame to the text of every utterance, returns at the end of the stream.
+ *
+ * @return int 0: success; -1: error
+ */
+int run_sensevoice_stream(rknn_sensevoice_context_t *app_ctx, const stream_options_t *opts, CMVNData &cmvn_data,
+                          VocabEntry *vocab);
+
+#endif //_RKNN_SENSEVOICE_DEMO_STREAM_H_
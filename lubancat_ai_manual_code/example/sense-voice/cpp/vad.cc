@@ -0,0 +1,206 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "vad.h"
+#include "stage_profiler.h"
+
+void vad_default_options(vad_options_t *opts)
+{
+    opts->threshold_db = 10.0f;
+    opts->min_energy_db = -55.0f;
+    opts->min_speech_ms = 60;
+    opts->min_silence_ms = 300;
+    opts->pad_ms = 150;
+    opts->max_segment_s = 7.0f;    // CHUNK_LENGTH, 124 LFR frames of the model input hold ~7.4 s
+}
+
+float vad_frame_energy_db(const float *samples, int n)
+{
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += (double)samples[i] * samples[i];
+    }
+    return 10.0f * log10f((float)(sum / (n > 0 ? n : 1)) + 1e-10f);
+}
+
+void vad_stream_init(vad_stream_t *vad, const vad_options_t *opts)
+{
+    memset(vad, 0, sizeof(vad_stream_t));
+    vad->opts = *opts;
+}
+
+int vad_stream_frame(vad_stream_t *vad, float db)
+{
+    int min_speech = vad->opts.min_speech_ms / VAD_FRAME_MS;
+    int min_silence = vad->opts.min_silence_ms / VAD_FRAME_MS;
+    int i = vad->frame_index++;
+    int event = VAD_NONE;
+
+    // the noise floor drops fast and rises slowly
+    if (i == 0)
+    {
+        vad->noise_db = db;
+    }
+    if (db < vad->noise_db)
+    {
+        vad->noise_db = 0.8f * vad->noise_db + 0.2f * db;
+    }
+    else
+    {
+        vad->noise_db += 0.001f * (db - vad->noise_db);
+    }
+    vad->speech = db > vad->noise_db + vad->opts.threshold_db && db > vad->opts.min_energy_db;
+
+    // hangover: a start needs min_speech speech frames, an end min_silence silent ones
+    if (!vad->in_speech)
+    {
+        vad->count = vad->speech ? vad->count + 1 : 0;
+        if (vad->count >= min_speech)
+        {
+            vad->in_speech = 1;
+            vad->event_frame = i - vad->count + 1;
+            vad->count = 0;
+            event = VAD_SPEECH_START;
+        }
+    }
+    else
+    {
+        vad->count = vad->speech ? 0 : vad->count + 1;
+        if (vad->count >= min_silence)
+        {
+            vad->in_speech = 0;
+            vad->event_frame = i - vad->count + 1;
+            vad->count = 0;
+            event = VAD_SPEECH_END;
+        }
+    }
+    return event;
+}
+
+int vad_stream_flush(vad_stream_t *vad)
+{
+    if (!vad->in_speech)
+    {
+        return VAD_NONE;
+    }
+    vad->in_speech = 0;
+    vad->event_frame = vad->frame_index - vad->count;
+    vad->count = 0;
+    return VAD_SPEECH_END;
+}
+
+int vad_segment_audio(const float *audio, int num_samples, int sample_rate, const vad_options_t *opts,
+                      std::vector<vad_segment_t> &segments)
+{
+    PROFILE_SCOPE("vad_segment_audio");
+    segments.clear();
+    int frame_len = sample_rate * VAD_FRAME_MS / 1000;
+    int max_frames = (int)(opts->max_segment_s * 1000 / VAD_FRAME_MS);
+    if (audio == NULL || frame_len <= 0 || max_frames < 2)
+    {
+        printf("vad_segment_audio: invalid input\n");
+        return -1;
+    }
+    if (num_samples <= 0)
+    {
+        return 0;
+    }
+
+    int n_frames = (num_samples + frame_len - 1) / frame_len;
+    std::vector<float> db(n_frames);
+    std::vector<vad_segment_t> runs;
+    vad_stream_t vad;
+    vad_stream_init(&vad, opts);
+    int run_start = 0;
+    for (int i = 0; i < n_frames; i++)
+    {
+        int n = std::min(frame_len, num_samples - i * frame_len);
+        db[i] = vad_frame_energy_db(audio + i * frame_len, n);
+        int event = vad_stream_frame(&vad, db[i]);
+        if (event == VAD_SPEECH_START)
+        {
+            run_start = vad.event_frame;
+        }
+        else if (event == VAD_SPEECH_END)
+        {
+            runs.push_back({run_start, vad.event_frame});
+        }
+    }
+    if (vad_stream_flush(&vad) == VAD_SPEECH_END)
+    {
+        runs.push_back({run_start, vad.event_frame});
+    }
+
+    // pad and join runs that overlap after padding
+    int pad = opts->pad_ms / VAD_FRAME_MS;
+    std::vector<vad_segment_t> padded;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        int start = runs[i].start - pad > 0 ? runs[i].start - pad : 0;
+        int end = runs[i].end + pad < n_frames ? runs[i].end + pad : n_frames;
+        if (!padded.empty() && start <= padded.back().end)
+        {
+            padded.back().end = end;
+        }
+        else
+        {
+            padded.push_back({start, end});
+        }
+    }
+
+    // cut long segments at the quietest frame of the second half of the window
+    std::vector<vad_segment_t> pieces;
+    for (size_t i = 0; i < padded.size(); i++)
+    {
+        int start = padded[i].start;
+        int end = padded[i].end;
+        while (end - start > max_frames)
+        {
+            int cut = start + max_frames / 2;
+            for (int j = cut + 1; j < start + max_frames; j++)
+            {
+                if (db[j] < db[cut])
+                {
+                    cut = j;
+                }
+            }
+            pieces.push_back({start, cut});
+            start = cut;
+        }
+        pieces.push_back({start, end});
+    }
+
+    // merge neighbours while they fit, fewer and longer inputs give the model more context
+    for (size_t i = 0; i < pieces.size(); i++)
+    {
+        if (!segments.empty() && pieces[i].end - segments.back().start <= max_frames)
+        {
+            segments.back().end = pieces[i].end;
+        }
+        else
+        {
+            segments.push_back(pieces[i]);
+        }
+    }
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        segments[i].start *= frame_len;
+        segments[i].end = segments[i].end * frame_len < num_samples ? segments[i].end * frame_len : num_samples;
+    }
+    return 0;
+}
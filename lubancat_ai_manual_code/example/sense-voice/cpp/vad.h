@@ -0,0 +1,86 @@
+#ifndef _RKNN_SENSEVOICE_DEMO_VAD_H_
+#define _RKNN_SENSEVOICE_DEMO_VAD_H_
+
+#include <vector>
+
+#define VAD_FRAME_MS 10
+
+typedef struct
+{
+    float threshold_db;     // a frame is speech when its energy is this far above the noise floor
+    float min_energy_db;    // frames below this level (dBFS) are never speech
+    int min_speech_ms;      // shorter bursts are dropped (clicks, coughs)
+    int min_silence_ms;     // shorter pauses do not end a segment
+    int pad_ms;             // context kept before and after every segment
+    float max_segment_s;    // segments are cut at the quietest frame to fit the model input
+} vad_options_t;
+
+typedef struct
+{
+    int start;              // first sample
+    int end;                // one past the last sample
+} vad_segment_t;
+
+#define VAD_NONE 0
+#define VAD_SPEECH_START 1
+#define VAD_SPEECH_END 2
+
+// frame by frame detector, the offline segmentation runs on top of it
+typedef struct
+{
+    vad_options_t opts;
+    float noise_db;         // adaptive noise floor
+    int frame_index;        // frames seen so far
+    int in_speech;
+    int count;              // speech frames before a start / silent frames inside speech
+    int speech;             // the last frame was above the threshold
+    int event_frame;        // first speech frame for VAD_SPEECH_START, one past the last for VAD_SPEECH_END
+} vad_stream_t;
+
+/**
+ * @brief Default options for 16 kHz speech, segments fit the 7 s SenseVoice input
+ */
+void vad_default_options(vad_options_t *opts);
+
+/**
+ * @brief Energy of one VAD_FRAME_MS frame in dBFS
+ */
+float vad_frame_energy_db(const float *samples, int n);
+
+void vad_stream_init(vad_stream_t *vad, const vad_options_t *opts);
+
+/**
+ * @brief Feed the energy of the next frame
+ *
+ * Starts and ends are reported with a delay of min_speech_ms / min_silence_ms,
+ * event_frame tells where they really happened.
+ *
+ * @return int VAD_NONE / VAD_SPEECH_START / VAD_SPEECH_END
+ */
+int vad_stream_frame(vad_stream_t *vad, float energy_db);
+
+/**
+ * @brief End of input, closes an open segment
+ *
+ * @return int VAD_SPEECH_END if a segment was open, else VAD_NONE
+ */
+int vad_stream_flush(vad_stream_t *vad);
+
+/**
+ * @brief Split audio of any length into speech segments of at most max_segment_s
+ *
+ * Energy based: the noise floor follows the quiet frames, speech is detected with
+ * hangover, neighbouring segments are merged while they fit max_segment_s and longer
+ * ones are cut at the quietest 10 ms frame of their second half.
+ *
+ * @param audio [in] Mono samples in [-1, 1]
+ * @param num_samples [in] Number of samples
+ * @param sample_rate [in] Sample rate
+ * @param opts [in] Options
+ * @param segments [out] Segments in time order
+ * @return int 0: success; -1: error
+ */
+int vad_segment_audio(const float *audio, int num_samples, int sample_rate, const vad_options_t *opts,
+                      std::vector<vad_segment_t> &segments);
+
+#endif //_RKNN_SENSEVOICE_DEMO_VAD_H_
@@ -1,7 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
 #include <sndfile.h>
 #include <math.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 #include "audio_utils.h"
 
 int read_audio(const char *path, audio_buffer_t *audio)
@@ -71,34 +77,406 @@ int save_audio(const char *path, float *data, int num_frames, int sample_rate, i
     return 0;
 }
 
-int resample_audio(audio_buffer_t *audio, int original_sample_rate, int desired_sample_rate)
+int audio_writer_open(audio_writer_t *writer, const char *path, int sample_rate, int num_channels)
 {
-    int original_length = audio->num_frames;
-    int out_length = round(original_length * (double)desired_sample_rate / (double)original_sample_rate);
-    printf("resample_audio: %d HZ -> %d HZ \n", original_sample_rate, desired_sample_rate);
+    SF_INFO sfinfo = {0};
+
+    memset(writer, 0, sizeof(audio_writer_t));
+    sfinfo.samplerate = sample_rate;
+    sfinfo.channels = num_channels;
+    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
 
-    float *resampled_data = (float *)malloc(out_length * sizeof(float));
-    if (!resampled_data)
+    SNDFILE *outfile = sf_open(path, SFM_WRITE, &sfinfo);
+    if (!outfile)
     {
+        fprintf(stderr, "Error: failed to open file '%s' for writing: %s\n", path, sf_strerror(NULL));
         return -1;
     }
+    // rewrite the sizes in the header after every write, readers see the audio so far
+    sf_command(outfile, SFC_SET_UPDATE_HEADER_AUTO, NULL, SF_TRUE);
+
+    writer->file = outfile;
+    writer->sample_rate = sample_rate;
+    writer->num_channels = num_channels;
+    return 0;
+}
 
-    for (int i = 0; i < out_length; ++i)
+int audio_writer_write(audio_writer_t *writer, const float *data, int num_frames)
+{
+    sf_count_t num_written_frames = sf_writef_float((SNDFILE *)writer->file, data, num_frames);
+    if (num_written_frames != num_frames)
     {
-        double src_index = i * (double)original_sample_rate / (double)desired_sample_rate;
-        int left_index = (int)floor(src_index);
-        int right_index = (left_index + 1 < original_length) ? left_index + 1 : left_index;
-        double fraction = src_index - left_index;
-        resampled_data[i] = (1.0f - fraction) * audio->data[left_index] + fraction * audio->data[right_index];
+        fprintf(stderr, "Error: failed to write all frames. Expected %ld, wrote %ld.\n", (long)num_frames, (long)num_written_frames);
+        return -1;
     }
+    writer->num_frames += num_frames;
+    return 0;
+}
 
-    audio->num_frames = out_length;
-    free(audio->data);
-    audio->data = resampled_data;
+void audio_writer_close(audio_writer_t *writer)
+{
+    if (writer->file != NULL)
+    {
+        sf_close((SNDFILE *)writer->file);
+        writer->file = NULL;
+    }
+}
+
+#define RESAMPLER_TAPS 48             // taps per phase per unit of decimation, ~1.7 kHz transition at 48 kHz
+#define RESAMPLER_KAISER_BETA 8.0      // ~80 dB stopband
+#define RESAMPLER_MAX_BANK_SIZE (4 << 20)
+#define RESAMPLER_CACHE_SIZE 16
+
+typedef struct
+{
+    int up;
+    int down;
+    int taps_per_phase;
+    float *bank;
+} resampler_bank_t;
+
+static resampler_bank_t g_bank_cache[RESAMPLER_CACHE_SIZE];
+static pthread_mutex_t g_bank_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int gcd(int a, int b)
+{
+    while (b != 0)
+    {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
 
+// Kaiser windowed sinc at the upsampled rate, split into up phases of taps coefficients,
+// every row reversed so that output = dot(row, input[base - taps + 1 .. base])
+static float *design_bank(int up, int down, int taps)
+{
+    int n = taps * up - 1;      // odd length, the center is a whole sample
+    double center = (n - 1) / 2.0;
+    double fc = 0.45 * (up < down ? up : down) / ((double)up * down);   // 0.9 of the lower nyquist, in cycles per upsampled sample
+    float *bank = (float *)calloc((size_t)up * taps, sizeof(float));
+    if (bank == NULL)
+    {
+        return NULL;
+    }
+    double i0_beta = bessel_i0(RESAMPLER_KAISER_BETA);
+    for (int i = 0; i < n; i++)
+    {
+        double x = i - center;
+        double sinc = x == 0.0 ? 2.0 * fc : sin(2.0 * M_PI * fc * x) / (M_PI * x);
+        double r = 2.0 * i / (n - 1) - 1.0;
+        double w = bessel_i0(RESAMPLER_KAISER_BETA * sqrt(1.0 - r * r)) / i0_beta;
+        int phase = i % up;
+        int k = i / up;
+        bank[phase * taps + (taps - 1 - k)] = (float)(sinc * w * up);
+    }
+    return bank;
+}
+
+static const float *get_bank(int up, int down, int taps)
+{
+    const float *bank = NULL;
+    pthread_mutex_lock(&g_bank_lock);
+    int i;
+    for (i = 0; i < RESAMPLER_CACHE_SIZE && g_bank_cache[i].bank != NULL; i++)
+    {
+        if (g_bank_cache[i].up == up && g_bank_cache[i].down == down && g_bank_cache[i].taps_per_phase == taps)
+        {
+            bank = g_bank_cache[i].bank;
+            break;
+        }
+    }
+    if (bank == NULL && i < RESAMPLER_CACHE_SIZE)
+    {
+        g_bank_cache[i].bank = design_bank(up, down, taps);
+        g_bank_cache[i].up = up;
+        g_bank_cache[i].down = down;
+        g_bank_cache[i].taps_per_phase = taps;
+        bank = g_bank_cache[i].bank;
+    }
+    pthread_mutex_unlock(&g_bank_lock);
+    return bank;
+}
+
+static inline float dot_product(const float *a, const float *b, int n)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    acc0 = vaddq_f32(acc0, acc1);
+    float32x2_t sum2 = vadd_f32(vget_low_f32(acc0), vget_high_f32(acc0));
+    float sum = vget_lane_f32(vpadd_f32(sum2, sum2), 0);
+#else
+    // independent partial sums, the compiler can keep them in vector lanes
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    float sum = (s0 + s1) + (s2 + s3);
+#endif
+    for (; i < n; i++)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+int audio_resampler_init(audio_resampler_t *rs, int in_rate, int out_rate, int num_channels)
+{
+    memset(rs, 0, sizeof(audio_resampler_t));
+    if (in_rate <= 0 || out_rate <= 0 || num_channels <= 0)
+    {
+        printf("audio_resampler_init: invalid rate %d -> %d or channels %d\n", in_rate, out_rate, num_channels);
+        return -1;
+    }
+    int g = gcd(in_rate, out_rate);
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    rs->up = out_rate / g;
+    rs->down = in_rate / g;
+    rs->num_channels = num_channels;
+    if (rs->up == rs->down)
+    {
+        return 0;       // downmix only
+    }
+
+    int ratio = (rs->down + rs->up - 1) / rs->up;
+    rs->taps_per_phase = RESAMPLER_TAPS * ratio;
+    if ((long long)rs->up * rs->taps_per_phase * sizeof(float) > RESAMPLER_MAX_BANK_SIZE)
+    {
+        printf("audio_resampler_init: %d -> %d needs %d filter phases, too many\n", in_rate, out_rate, rs->up);
+        return -1;
+    }
+    rs->bank = get_bank(rs->up, rs->down, rs->taps_per_phase);
+    if (rs->bank == NULL)
+    {
+        printf("audio_resampler_init: no filter bank for %d -> %d\n", in_rate, out_rate);
+        return -1;
+    }
+
+    // history of zeros before the first sample, the first output sits on the filter center
+    rs->buf_start = -(rs->taps_per_phase - 1);
+    rs->buf_len = rs->taps_per_phase - 1;
+    rs->buf_cap = 0;
+    rs->next_u = (rs->taps_per_phase * rs->up - 2) / 2;
     return 0;
 }
 
+int audio_resampler_max_output(const audio_resampler_t *rs, int in_frames)
+{
+    long long in_end = rs->in_total + in_frames + rs->taps_per_phase;
+    return (int)(in_end * rs->up / rs->down - rs->out_total + 2);
+}
+
+static int reserve_buf(audio_resampler_t *rs, int frames)
+{
+    if (rs->buf_len + frames <= rs->buf_cap)
+    {
+        return 0;
+    }
+    int cap = rs->buf_cap > 0 ? rs->buf_cap : 4096;
+    while (cap < rs->buf_len + frames)
+    {
+        cap *= 2;
+    }
+    float *buf = (float *)realloc(rs->buf, cap * sizeof(float));
+    if (buf == NULL)
+    {
+        return -1;
+    }
+    if (rs->buf_cap == 0)
+    {
+        memset(buf, 0, rs->buf_len * sizeof(float));    // the zero history of init
+    }
+    rs->buf = buf;
+    rs->buf_cap = cap;
+    return 0;
+}
+
+static void downmix(const float *in, int frames, int num_channels, float *out)
+{
+    if (num_channels == 1)
+    {
+        memcpy(out, in, frames * sizeof(float));
+        return;
+    }
+    float scale = 1.0f / num_channels;
+    for (int i = 0; i < frames; i++)
+    {
+        float sum = 0.0f;
+        for (int c = 0; c < num_channels; c++)
+        {
+            sum += in[i * num_channels + c];
+        }
+        out[i] = sum * scale;
+    }
+}
+
+// outputs whose input window is complete, at most limit of them
+static int produce(audio_resampler_t *rs, float *out, long long limit)
+{
+    int taps = rs->taps_per_phase;
+    long long buf_end = rs->buf_start + rs->buf_len;
+    int n = 0;
+    while (rs->out_total < limit)
+    {
+        long long base = rs->next_u / rs->up;
+        if (base >= buf_end)
+        {
+            break;
+        }
+        int phase = (int)(rs->next_u % rs->up);
+        out[n++] = dot_product(rs->bank + phase * taps, rs->buf + (base - taps + 1 - rs->buf_start), taps);
+        rs->next_u += rs->down;
+        rs->out_total++;
+    }
+
+    // keep what the next output still needs
+    long long keep_from = rs->next_u / rs->up - taps + 1;
+    int drop = (int)(keep_from - rs->buf_start);
+    if (drop > rs->buf_len)
+    {
+        drop = rs->buf_len;
+    }
+    if (drop > 0)
+    {
+        memmove(rs->buf, rs->buf + drop, (rs->buf_len - drop) * sizeof(float));
+        rs->buf_len -= drop;
+        rs->buf_start += drop;
+    }
+    return n;
+}
+
+int audio_resampler_process(audio_resampler_t *rs, const float *in, int in_frames, float *out)
+{
+    if (in_frames < 0)
+    {
+        return -1;
+    }
+    if (rs->up == rs->down)
+    {
+        downmix(in, in_frames, rs->num_channels, out);
+        rs->in_total += in_frames;
+        rs->out_total += in_frames;
+        return in_frames;
+    }
+    if (reserve_buf(rs, in_frames) != 0)
+    {
+        printf("audio_resampler_process: out of memory\n");
+        return -1;
+    }
+    downmix(in, in_frames, rs->num_channels, rs->buf + rs->buf_len);
+    rs->buf_len += in_frames;
+    rs->in_total += in_frames;
+    return produce(rs, out, LLONG_MAX);
+}
+
+int audio_resampler_flush(audio_resampler_t *rs, float *out)
+{
+    if (rs->up == rs->down)
+    {
+        return 0;
+    }
+    // zeros past the end complete the windows of the last outputs
+    int pad = rs->taps_per_phase;
+    if (reserve_buf(rs, pad) != 0)
+    {
+        printf("audio_resampler_flush: out of memory\n");
+        return -1;
+    }
+    memset(rs->buf + rs->buf_len, 0, pad * sizeof(float));
+    rs->buf_len += pad;
+    long long total = (rs->in_total * rs->up + rs->down / 2) / rs->down;
+    return produce(rs, out, total);
+}
+
+void audio_resampler_release(audio_resampler_t *rs)
+{
+    if (rs->buf != NULL)
+    {
+        free(rs->buf);
+        rs->buf = NULL;
+    }
+    rs->buf_len = 0;
+    rs->buf_cap = 0;
+}
+
+int convert_audio(audio_buffer_t *audio, int desired_sample_rate)
+{
+    if (audio->num_channels == 1 && audio->sample_rate == desired_sample_rate)
+    {
+        return 0;
+    }
+    printf("convert_audio: %d HZ %d ch -> %d HZ 1 ch\n", audio->sample_rate, audio->num_channels, desired_sample_rate);
+
+    audio_resampler_t rs;
+    if (audio_resampler_init(&rs, audio->sample_rate, desired_sample_rate, audio->num_channels) != 0)
+    {
+        return -1;
+    }
+    float *out = (float *)malloc(audio_resampler_max_output(&rs, audio->num_frames) * sizeof(float));
+    if (out == NULL)
+    {
+        audio_resampler_release(&rs);
+        return -1;
+    }
+    int n = audio_resampler_process(&rs, audio->data, audio->num_frames, out);
+    int tail = n >= 0 ? audio_resampler_flush(&rs, out + n) : -1;
+    audio_resampler_release(&rs);
+    if (tail < 0)
+    {
+        free(out);
+        return -1;
+    }
+
+    free(audio->data);
+    audio->data = out;
+    audio->num_frames = n + tail;
+    audio->num_channels = 1;
+    audio->sample_rate = desired_sample_rate;
+    return 0;
+}
+
+int resample_audio(audio_buffer_t *audio, int original_sample_rate, int desired_sample_rate)
+{
+    printf("resample_audio: %d HZ -> %d HZ \n", original_sample_rate, desired_sample_rate);
+
+    // data is treated as mono like before, convert_audio also handles interleaved channels
+    int num_channels = audio->num_channels;
+    audio->num_channels = 1;
+    audio->sample_rate = original_sample_rate;
+    int ret = convert_audio(audio, desired_sample_rate);
+    audio->num_channels = num_channels;
+    return ret;
+}
+
 int convert_channels(audio_buffer_t *audio)
 {
 
@@ -14,6 +14,39 @@ typedef struct
     int sample_rate;
 } audio_buffer_t;
 
+// WAV file written block by block, the header is kept valid after every block
+typedef struct
+{
+    void *file;                 // SNDFILE
+    int sample_rate;
+    int num_channels;
+    long long num_frames;       // frames written so far
+} audio_writer_t;
+
+/*
+ * Polyphase FIR resampler, out_rate / in_rate reduced to up / down. One windowed
+ * sinc of taps_per_phase * up taps is split into up phases; filter banks are
+ * cached per ratio so creating a resampler for a known ratio is cheap. Input is
+ * interleaved with num_channels channels and downmixed to mono in the same pass.
+ */
+typedef struct
+{
+    int in_rate;
+    int out_rate;
+    int up;                     // out_rate / gcd
+    int down;                   // in_rate / gcd
+    int num_channels;
+    int taps_per_phase;
+    const float *bank;          // up rows of taps_per_phase coefficients, shared, reversed for a forward dot product
+    float *buf;                 // mono input still needed by the next outputs
+    int buf_len;
+    int buf_cap;
+    long long buf_start;        // input index of buf[0]
+    long long next_u;           // next output at the upsampled rate, input index = next_u / up
+    long long in_total;         // input frames accepted
+    long long out_total;        // output frames produced
+} audio_resampler_t;
+
 /**
  * @brief Reads an audio file into a buffer.
  *
@@ -35,6 +68,26 @@ int read_audio(const char *path, audio_buffer_t *audio);
  */
 int save_audio(const char *path, float *data, int num_frames, int sample_rate, int num_channels);
 
+/**
+ * @brief Creates a WAV file for incremental writing.
+ *
+ * @param writer [out] Writer state.
+ * @param path [in] Path to the output WAV file.
+ * @param sample_rate [in] Sampling rate of the audio data.
+ * @param num_channels [in] Number of channels in the audio data.
+ * @return int 0 on success, -1 on error.
+ */
+int audio_writer_open(audio_writer_t *writer, const char *path, int sample_rate, int num_channels);
+
+/**
+ * @brief Appends frames, the file is playable up to them when this returns.
+ *
+ * @return int 0 on success, -1 on error.
+ */
+int audio_writer_write(audio_writer_t *writer, const float *data, int num_frames);
+
+void audio_writer_close(audio_writer_t *writer);
+
 /**
  * @brief Resamples audio data to a desired sample rate.
  *
@@ -63,6 +116,55 @@ int resample_audio(audio_buffer_t *audio, int original_sample_rate, int desired_
  */
 int convert_channels(audio_buffer_t *audio);
 
+/**
+ * @brief Downmixes to mono and resamples in one pass, replacing audio->data.
+ *
+ * @param audio [in/out] Pointer to the audio buffer, any channel count and sample rate.
+ * @param desired_sample_rate [in] The target sample rate.
+ * @return int 0 on success, -1 on error.
+ */
+int convert_audio(audio_buffer_t *audio, int desired_sample_rate);
+
+/**
+ * @brief Creates a streaming resampler.
+ *
+ * @param rs [out] Resampler state.
+ * @param in_rate [in] Input sample rate.
+ * @param out_rate [in] Output sample rate.
+ * @param num_channels [in] Interleaved input channels, the output is mono.
+ * @return int 0 on success, -1 on error.
+ */
+int audio_resampler_init(audio_resampler_t *rs, int in_rate, int out_rate, int num_channels);
+
+/**
+ * @brief Upper bound of the output frames for in_frames more input frames.
+ */
+int audio_resampler_max_output(const audio_resampler_t *rs, int in_frames);
+
+/**
+ * @brief Resamples the next block of a stream, the state carries over between calls.
+ *
+ * Output lags the input by the filter delay (taps_per_phase / 2 input frames),
+ * audio_resampler_flush returns the rest at the end of the stream.
+ *
+ * @param rs [in/out] Resampler state.
+ * @param in [in] Interleaved input frames.
+ * @param in_frames [in] Number of input frames.
+ * @param out [out] Mono output, room for audio_resampler_max_output(rs, in_frames) frames.
+ * @return int Number of output frames, -1 on error.
+ */
+int audio_resampler_process(audio_resampler_t *rs, const float *in, int in_frames, float *out);
+
+/**
+ * @brief Returns the delayed tail, the stream has in_total * out_rate / in_rate frames then.
+ *
+ * @param out [out] Room for audio_resampler_max_output(rs, 0) frames.
+ * @return int Number of output frames, -1 on error.
+ */
+int audio_resampler_flush(audio_resampler_t *rs, float *out);
+
+void audio_resampler_release(audio_resampler_t *rs);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
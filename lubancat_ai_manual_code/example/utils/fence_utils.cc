@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#if !defined(DISABLE_RGA)
+#include "im2d.hpp"
+#endif
+
+#include "fence_utils.h"
+#include "image_utils.h"
+
+int fence_cpu_create(void)
+{
+    int fd = eventfd(0, EFD_CLOEXEC);
+    if (fd < 0) {
+        printf("eventfd fail! %s\n", strerror(errno));
+        return -1;
+    }
+    return fd;
+}
+
+int fence_cpu_signal(int fence_fd)
+{
+    uint64_t one = 1;
+    if (write(fence_fd, &one, sizeof(one)) != sizeof(one)) {
+        printf("signal fence %d fail! %s\n", fence_fd, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int fence_wait(int fence_fd, int timeout_ms)
+{
+    if (fence_fd < 0) {
+        return 0;
+    }
+    struct pollfd pfd;
+    pfd.fd = fence_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int ret;
+    do {
+        ret = poll(&pfd, 1, timeout_ms);
+    } while (ret < 0 && errno == EINTR);
+    if (ret == 0) {
+        printf("wait fence %d timeout after %d ms\n", fence_fd, timeout_ms);
+        return -1;
+    }
+    if (ret < 0 || (pfd.revents & (POLLERR | POLLNVAL))) {
+        printf("wait fence %d fail! %s\n", fence_fd, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+void fence_close(int fence_fd)
+{
+    if (fence_fd >= 0) {
+        close(fence_fd);
+    }
+}
+
+/*-------------------------------------------
+            CPU conversion thread
+-------------------------------------------*/
+
+typedef struct {
+    image_buffer_t src;
+    image_buffer_t dst;
+    image_rect_t src_box;
+    image_rect_t dst_box;
+    char color;
+    int fence_fd;   // own copy, the one handed out may be closed before the job is done
+} cpu_convert_job_t;
+
+static void* cpu_convert_thread(void* arg)
+{
+    cpu_convert_job_t* job = (cpu_convert_job_t*)arg;
+    if (convert_image_cpu(&job->src, &job->dst, &job->src_box, &job->dst_box, job->color) != 0) {
+        printf("convert image on cpu thread fail!\n");
+    }
+    fence_cpu_signal(job->fence_fd);
+    fence_close(job->fence_fd);
+    free(job);
+    return NULL;
+}
+
+static int convert_image_cpu_async(image_buffer_t* src_img, image_buffer_t* dst_img, image_rect_t* src_box,
+                                   image_rect_t* dst_box, char color, int* fence_fd)
+{
+    int fence = fence_cpu_create();
+    if (fence < 0) {
+        return -1;
+    }
+    cpu_convert_job_t* job = (cpu_convert_job_t*)malloc(sizeof(cpu_convert_job_t));
+    if (job == NULL) {
+        fence_close(fence);
+        return -1;
+    }
+    job->src = *src_img;
+    job->dst = *dst_img;
+    job->src_box = *src_box;
+    job->dst_box = *dst_box;
+    job->color = color;
+    job->fence_fd = dup(fence);
+
+    pthread_t tid;
+    if (job->fence_fd < 0 || pthread_create(&tid, NULL, cpu_convert_thread, job) != 0) {
+        printf("start convert thread fail!\n");
+        fence_close(job->fence_fd);
+        fence_close(fence);
+        free(job);
+        return -1;
+    }
+    pthread_detach(tid);
+    *fence_fd = fence;
+    return 0;
+}
+
+/*-------------------------------------------
+               RGA async job
+-------------------------------------------*/
+
+#if !defined(DISABLE_RGA)
+static int get_rga_fmt(image_format_t fmt)
+{
+    switch (fmt) {
+    case IMAGE_FORMAT_RGB888:
+        return RK_FORMAT_RGB_888;
+    case IMAGE_FORMAT_RGBA8888:
+        return RK_FORMAT_RGBA_8888;
+    case IMAGE_FORMAT_YUV420SP_NV12:
+        return RK_FORMAT_YCbCr_420_SP;
+    case IMAGE_FORMAT_YUV420SP_NV21:
+        return RK_FORMAT_YCrCb_420_SP;
+    default:
+        return -1;
+    }
+}
+
+// wrapped buffers, not handles: a handle may not be released while a job on it is in flight
+static rga_buffer_t wrap_image(image_buffer_t* img)
+{
+    int fmt = get_rga_fmt(img->format);
+    if (img->fd > 0) {
+        return wrapbuffer_fd(img->fd, img->width, img->height, fmt, img->width, img->height);
+    }
+    return wrapbuffer_virtualaddr(img->virt_addr, img->width, img->height, fmt, img->width, img->height);
+}
+
+static im_rect to_im_rect(image_rect_t* box)
+{
+    im_rect rect;
+    rect.x = box->left;
+    rect.y = box->top;
+    rect.width = box->right - box->left + 1;
+    rect.height = box->bottom - box->top + 1;
+    return rect;
+}
+
+static int convert_image_rga_async(image_buffer_t* src_img, image_buffer_t* dst_img, image_rect_t* src_box,
+                                   image_rect_t* dst_box, char color, int* fence_fd)
+{
+    rga_buffer_t src = wrap_image(src_img);
+    rga_buffer_t dst = wrap_image(dst_img);
+    rga_buffer_t pat;
+    memset(&pat, 0, sizeof(rga_buffer_t));
+    im_rect srect = to_im_rect(src_box);
+    im_rect drect = to_im_rect(dst_box);
+    im_rect prect;
+    memset(&prect, 0, sizeof(im_rect));
+
+    // the padding first, the resize waits for it on the RGA
+    int fill_fence = -1;
+    if (drect.width != dst_img->width || drect.height != dst_img->height) {
+        im_rect whole = {0, 0, dst_img->width, dst_img->height};
+        int imcolor;
+        memset(&imcolor, color, sizeof(imcolor));
+        IM_STATUS ret_rga = imfill(dst, whole, imcolor, 0, &fill_fence);
+        if (ret_rga <= 0) {
+            printf("async imfill fail! %s\n", imStrError(ret_rga));
+            return -1;
+        }
+    }
+
+    int release_fence = -1;
+    IM_STATUS ret_rga = improcess(src, dst, pat, srect, drect, prect, fill_fence, &release_fence, NULL, IM_ASYNC);
+    if (ret_rga <= 0) {
+        printf("async improcess fail! %s\n", imStrError(ret_rga));
+        // the CPU takes over dst_img, the fill must not still be writing it
+        fence_wait(fill_fence, -1);
+        fence_close(fill_fence);
+        return -1;
+    }
+    fence_close(fill_fence);
+    *fence_fd = release_fence;
+    return 0;
+}
+#endif
+
+int convert_image_async(image_buffer_t* src_img, image_buffer_t* dst_img, image_rect_t* src_box,
+                        image_rect_t* dst_box, char color, int* fence_fd)
+{
+    *fence_fd = -1;
+#if !defined(DISABLE_RGA)
+#if defined(RV1106_1103)
+    if (src_img->width % 4 == 0 && dst_img->width % 4 == 0) {
+#else
+    if (src_img->width % 16 == 0 && dst_img->width % 16 == 0) {
+#endif
+        if (convert_image_rga_async(src_img, dst_img, src_box, dst_box, color, fence_fd) == 0) {
+            return 0;
+        }
+        printf("try convert image use cpu\n");
+    }
+#endif
+    return convert_image_cpu_async(src_img, dst_img, src_box, dst_box, color, fence_fd);
+}
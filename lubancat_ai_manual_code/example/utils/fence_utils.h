@@ -0,0 +1,65 @@
+#ifndef _RKNN_MODEL_ZOO_FENCE_UTILS_H_
+#define _RKNN_MODEL_ZOO_FENCE_UTILS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+
+/*
+ * A fence is a file descriptor that becomes readable (POLLIN) once the job behind it
+ * is done: the release fence of an RGA job, the fence rknn_run returns with
+ * RKNN_FLAG_FENCE_OUT_OUTSIDE, or a CPU fence, an eventfd signaled by a thread that
+ * does the job on the CPU (no RGA, or off-device with the rknn stub). All of them
+ * are waited on and passed along the same way. A fence that is handed out is closed
+ * by the one who got it, -1 stands for a job that is already done.
+ */
+
+/**
+ * @brief New CPU fence, not signaled
+ *
+ * @return int fence fd; -1: error
+ */
+int fence_cpu_create(void);
+
+/**
+ * @brief Signal a CPU fence, the fd stays open
+ *
+ * @return int 0: success; -1: error
+ */
+int fence_cpu_signal(int fence_fd);
+
+/**
+ * @brief Wait for a fence
+ *
+ * @param fence_fd [in] Fence, -1 returns at once
+ * @param timeout_ms [in] -1: no timeout
+ * @return int 0: signaled; -1: timeout or error
+ */
+int fence_wait(int fence_fd, int timeout_ms);
+
+/**
+ * @brief Close a fence, -1 is ignored
+ */
+void fence_close(int fence_fd);
+
+/**
+ * @brief convert_image without waiting for the result
+ *
+ * The RGA job is queued and its release fence returned. Without RGA, or if the RGA can
+ * not take the image, convert_image_cpu runs on a thread behind a CPU fence.
+ * src_image and dst_image buffers must stay valid until the fence is signaled, and
+ * dst_image must be allocated.
+ *
+ * @param fence_fd [out] Fence of the conversion
+ * @return int 0: success; -1: error
+ */
+int convert_image_async(image_buffer_t* src_image, image_buffer_t* dst_image, image_rect_t* src_box,
+                        image_rect_t* dst_box, char color, int* fence_fd);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif // _RKNN_MODEL_ZOO_FENCE_UTILS_H_
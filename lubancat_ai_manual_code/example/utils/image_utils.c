@@ -4,8 +4,10 @@
 #include <math.h>
 #include <sys/time.h>
 
+#if !defined(DISABLE_RGA)
 #include "im2d.h"
 #include "drmrga.h"
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_THREAD_LOCALS
@@ -18,6 +20,7 @@
 
 #include "image_utils.h"
 #include "file_utils.h"
+#include "fence_utils.h"
 
 static const char* filter_image_names[] = {
     "jpg",
@@ -35,37 +38,12 @@ static const char* filter_image_names[] = {
 static const char* subsampName[TJ_NUMSAMP] = {"4:4:4", "4:2:2", "4:2:0", "Grayscale", "4:4:0", "4:1:1"};
 static const char* colorspaceName[TJ_NUMCS] = {"RGB", "YCbCr", "GRAY", "CMYK", "YCCK"};
 
-static int read_image_jpeg(const char* path, image_buffer_t* image)
+static int decode_image_jpeg(const unsigned char* jpegBuf, unsigned long size, image_buffer_t* image)
 {
-    FILE* jpegFile = NULL;
-    unsigned long jpegSize;
     int flags = 0;
     int width, height;
     int origin_width, origin_height;
-    unsigned char* imgBuf = NULL;
-    unsigned char* jpegBuf = NULL;
-    unsigned long size;
     unsigned short orientation = 1;
-    struct timeval tv1, tv2;
-
-    if ((jpegFile = fopen(path, "rb")) == NULL) {
-        printf("open input file failure\n");
-    }
-    if (fseek(jpegFile, 0, SEEK_END) < 0 || (size = ftell(jpegFile)) < 0 || fseek(jpegFile, 0, SEEK_SET) < 0) {
-        printf("determining input file size failure\n");
-    }
-    if (size == 0) {
-        printf("determining input file size, Input file contains no data\n");
-    }
-    jpegSize = (unsigned long)size;
-    if ((jpegBuf = (unsigned char*)malloc(jpegSize * sizeof(unsigned char))) == NULL) {
-        printf("allocating JPEG buffer\n");
-    }
-    if (fread(jpegBuf, jpegSize, 1, jpegFile) < 1) {
-        printf("reading input file");
-    }
-    fclose(jpegFile);
-    jpegFile = NULL;
 
     tjhandle handle = NULL;
     int subsample, colorspace;
@@ -127,10 +105,40 @@ static int read_image_jpeg(const char* path, image_buffer_t* image)
     image->virt_addr = sw_out_buf;
     image->size = sw_out_size;
 out:
+    return 0;
+}
+
+static int read_image_jpeg(const char* path, image_buffer_t* image)
+{
+    FILE* jpegFile = NULL;
+    unsigned long jpegSize;
+    unsigned char* jpegBuf = NULL;
+    unsigned long size;
+
+    if ((jpegFile = fopen(path, "rb")) == NULL) {
+        printf("open input file failure\n");
+    }
+    if (fseek(jpegFile, 0, SEEK_END) < 0 || (size = ftell(jpegFile)) < 0 || fseek(jpegFile, 0, SEEK_SET) < 0) {
+        printf("determining input file size failure\n");
+    }
+    if (size == 0) {
+        printf("determining input file size, Input file contains no data\n");
+    }
+    jpegSize = (unsigned long)size;
+    if ((jpegBuf = (unsigned char*)malloc(jpegSize * sizeof(unsigned char))) == NULL) {
+        printf("allocating JPEG buffer\n");
+    }
+    if (fread(jpegBuf, jpegSize, 1, jpegFile) < 1) {
+        printf("reading input file");
+    }
+    fclose(jpegFile);
+    jpegFile = NULL;
+
+    int ret = decode_image_jpeg(jpegBuf, size, image);
     if (jpegBuf) {
         free(jpegBuf);
     }
-    return 0;
+    return ret;
 }
 
 static int write_image_jpeg(const char* path, int quality, const image_buffer_t* image)
@@ -209,6 +217,8 @@ static int read_image_raw(const char* path, image_buffer_t* image)
     return 0;
 }
 
+static int set_image_stb(unsigned char* pixeldata, int w, int h, int c, image_buffer_t* image);
+
 static int read_image_stb(const char* path, image_buffer_t* image)
 {
     // 默认图像为3通道
@@ -218,6 +228,22 @@ static int read_image_stb(const char* path, image_buffer_t* image)
         printf("error: read image %s fail\n", path);
         return -1;
     }
+    return set_image_stb(pixeldata, w, h, c, image);
+}
+
+static int decode_image_stb(const unsigned char* data, int size, image_buffer_t* image)
+{
+    int w, h, c;
+    unsigned char* pixeldata = stbi_load_from_memory(data, size, &w, &h, &c, 0);
+    if (!pixeldata) {
+        printf("error: decode image fail, %s\n", stbi_failure_reason());
+        return -1;
+    }
+    return set_image_stb(pixeldata, w, h, c, image);
+}
+
+static int set_image_stb(unsigned char* pixeldata, int w, int h, int c, image_buffer_t* image)
+{
     // printf("load image wxhxc=%dx%dx%d path=%s\n", w, h, c, path);
     int size = w * h * c;
 
@@ -259,6 +285,33 @@ int read_image(const char* path, image_buffer_t* image)
     }
 }
 
+int decode_image(const char* path, const unsigned char* data, int size, image_buffer_t* image)
+{
+    const char* _ext = strrchr(path, '.');
+    if (!_ext || data == NULL || size <= 0) {
+        return -1;
+    }
+    if (strcmp(_ext, ".data") == 0) {
+        if (image->virt_addr == NULL) {
+            image->virt_addr = (unsigned char*)malloc(size + 1);
+            if (image->virt_addr == NULL) {
+                return -1;
+            }
+            image->virt_addr[size] = 0;
+            image->size = size;
+        }
+        memcpy(image->virt_addr, data, size);
+        return 0;
+#ifndef DISABLE_LIBJPEG
+    } else if (strcmp(_ext, ".jpg") == 0 || strcmp(_ext, ".jpeg") == 0 || strcmp(_ext, ".JPG") == 0 ||
+        strcmp(_ext, ".JPEG") == 0) {
+        return decode_image_jpeg(data, size, image);
+#endif
+    } else {
+        return decode_image_stb(data, size, image);
+    }
+}
+
 int write_image(const char* path, const image_buffer_t* img)
 {
     int ret;
@@ -381,12 +434,12 @@ static int crop_and_scale_image_yuv420sp(unsigned char *src, int src_width, int
         dst_y, dst_width, dst_height, dst_box_x, dst_box_y, dst_box_width, dst_box_height);
     
     crop_and_scale_image_c(2, src_uv, src_width / 2, src_height / 2, crop_x / 2, crop_y / 2, crop_width / 2, crop_height / 2,
-        dst_uv, dst_width / 2, dst_height / 2, dst_box_x, dst_box_y, dst_box_width, dst_box_height);
+        dst_uv, dst_width / 2, dst_height / 2, dst_box_x / 2, dst_box_y / 2, dst_box_width / 2, dst_box_height / 2);
 
     return 0;
 }
 
-static int convert_image_cpu(image_buffer_t *src, image_buffer_t *dst, image_rect_t *src_box, image_rect_t *dst_box, char color) {
+int convert_image_cpu(image_buffer_t *src, image_buffer_t *dst, image_rect_t *src_box, image_rect_t *dst_box, char color) {
     int ret;
     if (dst->virt_addr == NULL) {
         return -1;
@@ -454,10 +507,10 @@ static int convert_image_cpu(image_buffer_t *src, image_buffer_t *dst, image_rec
         printf("convert_image_cpu fail %d\n", reti);
         return -1;
     }
-    printf("finish\n");
     return 0;
 }
 
+#if !defined(DISABLE_RGA)
 static int get_rga_fmt(image_format_t fmt) {
     switch (fmt)
     {
@@ -473,6 +526,7 @@ static int get_rga_fmt(image_format_t fmt) {
         return -1;
     }
 }
+#endif
 
 int get_image_size(image_buffer_t* image)
 {
@@ -495,6 +549,7 @@ int get_image_size(image_buffer_t* image)
     }
 }
 
+#if !defined(DISABLE_RGA)
 static int convert_image_rga(image_buffer_t* src_img, image_buffer_t* dst_img, image_rect_t* src_box, image_rect_t* dst_box, char color)
 {
     int ret = 0;
@@ -669,6 +724,7 @@ err:
     // printf("finish\n");
     return ret;
 }
+#endif
 
 int convert_image(image_buffer_t* src_img, image_buffer_t* dst_img, image_rect_t* src_box, image_rect_t* dst_box, char color)
 {
@@ -696,7 +752,8 @@ int convert_image(image_buffer_t* src_img, image_buffer_t* dst_img, image_rect_t
     return ret;
 }
 
-int convert_image_with_letterbox(image_buffer_t* src_image, image_buffer_t* dst_image, letterbox_t* letterbox, char color)
+// fence_fd != NULL: queue the conversion, see convert_image_async
+static int letterbox_convert(image_buffer_t* src_image, image_buffer_t* dst_image, letterbox_t* letterbox, char color, int* fence_fd)
 {
     int ret = 0;
     int allow_slight_change = 1;
@@ -787,6 +844,19 @@ int convert_image_with_letterbox(image_buffer_t* src_image, image_buffer_t* dst_
             return -1;
         }
     }
+    if (fence_fd != NULL) {
+        return convert_image_async(src_image, dst_image, &src_box, &dst_box, color, fence_fd);
+    }
     ret = convert_image(src_image, dst_image, &src_box, &dst_box, color);
     return ret;
+}
+
+int convert_image_with_letterbox(image_buffer_t* src_image, image_buffer_t* dst_image, letterbox_t* letterbox, char color)
+{
+    return letterbox_convert(src_image, dst_image, letterbox, color, NULL);
+}
+
+int convert_image_with_letterbox_async(image_buffer_t* src_image, image_buffer_t* dst_image, letterbox_t* letterbox, char color, int* fence_fd)
+{
+    return letterbox_convert(src_image, dst_image, letterbox, color, fence_fd);
 }
\ No newline at end of file
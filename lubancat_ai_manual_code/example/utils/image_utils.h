@@ -26,6 +26,17 @@ typedef struct {
  */
 int read_image(const char* path, image_buffer_t* image);
 
+/**
+ * @brief Decode an image file already read into memory, like read_image
+ *
+ * @param path [in] Image path, only its extension picks the decoder
+ * @param data [in] File contents
+ * @param size [in] File size
+ * @param image [out] Decoded image
+ * @return int 0: success; -1: error
+ */
+int decode_image(const char* path, const unsigned char* data, int size, image_buffer_t* image);
+
 /**
  * @brief Write image file (support jpg/png)
  * 
@@ -47,6 +58,13 @@ int write_image(const char* path, const image_buffer_t* image);
  */
 int convert_image(image_buffer_t* src_image, image_buffer_t* dst_image, image_rect_t* src_box, image_rect_t* dst_box, char color);
 
+/**
+ * @brief Convert image on CPU (bilinear), same arguments as convert_image, src and dst must have the same format
+ *
+ * @return int 0: success; -1: error
+ */
+int convert_image_cpu(image_buffer_t* src_image, image_buffer_t* dst_image, image_rect_t* src_box, image_rect_t* dst_box, char color);
+
 /**
  * @brief Convert image with letterbox
  * 
@@ -58,6 +76,18 @@ int convert_image(image_buffer_t* src_image, image_buffer_t* dst_image, image_re
  */
 int convert_image_with_letterbox(image_buffer_t* src_image, image_buffer_t* dst_image, letterbox_t* letterbox, char color);
 
+/**
+ * @brief Convert image with letterbox, returns once the conversion is queued
+ * 
+ * @param src_image [in] Source Image, valid until the fence is signaled
+ * @param dst_image [out] Target Image
+ * @param letterbox [out] Letterbox
+ * @param color [in] Fill color on target image
+ * @param fence_fd [out] Fence signaled once dst_image is written, see fence_utils.h
+ * @return int 0: success; -1: error
+ */
+int convert_image_with_letterbox_async(image_buffer_t* src_image, image_buffer_t* dst_image, letterbox_t* letterbox, char color, int* fence_fd);
+
 /**
  * @brief Get the image size
  * 
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "rknn_async.h"
+
+void rknn_async_init(rknn_async_t* async, rknn_context ctx, uint32_t n_output)
+{
+    memset(async, 0, sizeof(rknn_async_t));
+    async->ctx = ctx;
+    async->n_output = n_output;
+}
+
+static int run(rknn_async_t* async, uint64_t* frame_id)
+{
+    rknn_run_extend extend;
+    memset(&extend, 0, sizeof(extend));
+    int ret = rknn_run(async->ctx, &extend);
+    if (ret < 0) {
+        printf("rknn_run fail! ret=%d\n", ret);
+        return -1;
+    }
+    async->runs++;
+    *frame_id = extend.frame_id != 0 ? extend.frame_id : async->runs;
+    return 0;
+}
+
+int rknn_async_run(rknn_async_t* async, int* slot)
+{
+    uint64_t frame_id;
+    if (run(async, &frame_id) != 0) {
+        return -1;
+    }
+    *slot = (int)(frame_id % RKNN_ASYNC_SLOTS);
+    async->slot_frame[*slot] = frame_id;
+    async->submitted = frame_id;
+    return 0;
+}
+
+int rknn_async_outputs_get(rknn_async_t* async, rknn_output outputs[], int* slot, uint64_t* frame_id)
+{
+    rknn_output_extend extend;
+    memset(&extend, 0, sizeof(extend));
+    int ret = rknn_outputs_get(async->ctx, async->n_output, outputs, &extend);
+    if (ret < 0) {
+        printf("rknn_outputs_get fail! ret=%d\n", ret);
+        return -1;
+    }
+    // without a frame id from the runtime: the frame before the last run, frame 1 right after the first
+    uint64_t id = extend.frame_id != 0 ? extend.frame_id : async->runs > 1 ? async->runs - 1 : async->runs;
+    int s = (int)(id % RKNN_ASYNC_SLOTS);
+    if (id <= async->returned || async->slot_frame[s] != id) {
+        // handed out before (the first frame comes back twice) or a frame of rknn_async_flush
+        rknn_outputs_release(async->ctx, async->n_output, outputs);
+        if (id > async->returned && rknn_async_pending(async)) {
+            printf("rknn_async: result of frame %llu lost\n", (unsigned long long)async->submitted);
+            async->returned = async->submitted;
+        }
+        return 0;
+    }
+    async->slot_frame[s] = 0;
+    async->returned = id;
+    *slot = s;
+    *frame_id = id;
+    return 1;
+}
+
+int rknn_async_pending(const rknn_async_t* async)
+{
+    return async->submitted > async->returned ? 1 : 0;
+}
+
+int rknn_async_flush(rknn_async_t* async)
+{
+    uint64_t frame_id;
+    return run(async, &frame_id);
+}
@@ -0,0 +1,80 @@
+#ifndef _RKNN_MODEL_ZOO_RKNN_ASYNC_H_
+#define _RKNN_MODEL_ZOO_RKNN_ASYNC_H_
+
+#include <stdint.h>
+
+#include "rknn_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Frame bookkeeping of a context created with RKNN_FLAG_ASYNC_MASK.
+ *
+ * In async mode rknn_run returns once the frame is queued and rknn_outputs_get
+ * returns the outputs of the frame before it without waiting (only right after the
+ * first run it waits for that run). The post process of frame N-1 then runs on the
+ * CPU while the NPU runs frame N, without an extra thread.
+ *
+ * The result that comes back is not the one of the frame just submitted, so anything
+ * the post process needs per frame (letterbox, the source image) has to be kept until
+ * its result arrives. rknn_async_run hands out a slot per frame for that, and
+ * rknn_async_outputs_get tells the slot and frame id of the result it returns, from
+ * the frame_id of rknn_output_extend. A result is returned once; a frame whose result
+ * is not back yet is pending until rknn_async_flush at the end of a stream.
+ */
+
+#define RKNN_ASYNC_SLOTS 4
+
+typedef struct {
+    rknn_context ctx;
+    uint32_t n_output;
+    uint64_t slot_frame[RKNN_ASYNC_SLOTS];  // frame id using each slot, 0: none
+    uint64_t runs;                          // rknn_run calls, frame ids of runtimes that do not fill them
+    uint64_t submitted;                     // frame id of the last rknn_async_run
+    uint64_t returned;                      // frame id of the last result handed out
+} rknn_async_t;
+
+/**
+ * @brief Start the bookkeeping of a context initialized with RKNN_FLAG_ASYNC_MASK
+ */
+void rknn_async_init(rknn_async_t* async, rknn_context ctx, uint32_t n_output);
+
+/**
+ * @brief rknn_run of the inputs set before, returns without waiting for the NPU
+ *
+ * @param slot [out] Index in [0, RKNN_ASYNC_SLOTS) for per frame data of the caller
+ * @return int 0: success; -1: error
+ */
+int rknn_async_run(rknn_async_t* async, int* slot);
+
+/**
+ * @brief Outputs of the oldest frame not handed out yet, usually the one before the last run
+ *
+ * @param outputs [in/out] index / want_float set by the caller, like rknn_outputs_get; release
+ *                them with rknn_outputs_release when 1 is returned
+ * @param slot [out] Slot rknn_async_run gave the frame
+ * @param frame_id [out] Frame id of the outputs
+ * @return int 1: got a result; 0: no new result; -1: error
+ */
+int rknn_async_outputs_get(rknn_async_t* async, rknn_output outputs[], int* slot, uint64_t* frame_id);
+
+/**
+ * @return int 1: a frame has been run but its result is not back yet; 0: none
+ */
+int rknn_async_pending(const rknn_async_t* async);
+
+/**
+ * @brief End of a stream: runs the last inputs once more, so the next
+ *        rknn_async_outputs_get returns the result of the last frame
+ *
+ * @return int 0: success; -1: error
+ */
+int rknn_async_flush(rknn_async_t* async);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _RKNN_MODEL_ZOO_RKNN_ASYNC_H_
@@ -0,0 +1,393 @@
+/*
+ * Opt-in recorder of model inputs and outputs, preloaded in front of librknnrt:
+ *
+ *   RKNN_CAPTURE_FILE=/data/cap.rkcap LD_PRELOAD=lib/librknncapture.so ./yolov5_image_demo ...
+ *
+ * It wraps rknn_inputs_set / rknn_outputs_get and, for zero-copy demos, the
+ * memories bound with rknn_set_io_mem (written when a blocking rknn_run returns),
+ * and appends one frame per sampled run to a tensor_capture ring file.
+ *
+ * A context with RKNN_FLAG_ASYNC_MASK gets the outputs of the frame before the last
+ * run; they are recorded under that frame's id, without inputs, which belong to the
+ * next frame by then.
+ *
+ *   RKNN_CAPTURE_FILE       capture file, recording is off when unset
+ *   RKNN_CAPTURE_SIZE_MB    ring size, default 256, older frames are overwritten
+ *   RKNN_CAPTURE_EVERY      record every n-th run of a context, default 1
+ *   RKNN_CAPTURE_INPUTS     0 to leave out the input tensors, default 1
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "rknn_api.h"
+#include "tensor_capture.h"
+
+#define CAPTURE_MAX_CTX 64
+
+typedef struct {
+    rknn_context ctx;
+    int used;
+    uint32_t flag;
+    rknn_input_output_num io_num;
+    rknn_tensor_attr in_attrs[TENSOR_CAPTURE_MAX_TENSORS];
+    rknn_tensor_attr out_attrs[TENSOR_CAPTURE_MAX_TENSORS];
+    void* in_data[TENSOR_CAPTURE_MAX_TENSORS];              // copies of the last rknn_inputs_set
+    tensor_capture_tensor_t in_tensors[TENSOR_CAPTURE_MAX_TENSORS];
+    rknn_tensor_mem* in_mems[TENSOR_CAPTURE_MAX_TENSORS];
+    rknn_tensor_attr in_mem_attrs[TENSOR_CAPTURE_MAX_TENSORS];
+    rknn_tensor_mem* out_mems[TENSOR_CAPTURE_MAX_TENSORS];
+    rknn_tensor_attr out_mem_attrs[TENSOR_CAPTURE_MAX_TENSORS];
+    uint64_t frame_id;
+    uint64_t out_frame_id;                                  // async: frame of the last recorded outputs
+} capture_ctx_t;
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock;
+    int enabled;
+    int every;
+    int with_inputs;
+    tensor_capture_t cap;
+    capture_ctx_t ctxs[CAPTURE_MAX_CTX];
+
+    int (*init)(rknn_context*, void*, uint32_t, uint32_t, rknn_init_extend*);
+    int (*dup_context)(rknn_context*, rknn_context*);
+    int (*destroy)(rknn_context);
+    int (*query)(rknn_context, rknn_query_cmd, void*, uint32_t);
+    int (*inputs_set)(rknn_context, uint32_t, rknn_input*);
+    int (*run)(rknn_context, rknn_run_extend*);
+    int (*outputs_get)(rknn_context, uint32_t, rknn_output*, rknn_output_extend*);
+    int (*set_io_mem)(rknn_context, rknn_tensor_mem*, rknn_tensor_attr*);
+} g = {PTHREAD_ONCE_INIT, PTHREAD_MUTEX_INITIALIZER};
+
+static void* next_symbol(const char* name)
+{
+    void* sym = dlsym(RTLD_NEXT, name);
+    if (sym == NULL) {
+        printf("rknn_capture: %s not found, is librknnrt linked?\n", name);
+        abort();
+    }
+    return sym;
+}
+
+static void capture_init(void)
+{
+    g.init = next_symbol("rknn_init");
+    g.dup_context = next_symbol("rknn_dup_context");
+    g.destroy = next_symbol("rknn_destroy");
+    g.query = next_symbol("rknn_query");
+    g.inputs_set = next_symbol("rknn_inputs_set");
+    g.run = next_symbol("rknn_run");
+    g.outputs_get = next_symbol("rknn_outputs_get");
+    g.set_io_mem = next_symbol("rknn_set_io_mem");
+
+    const char* path = getenv("RKNN_CAPTURE_FILE");
+    if (path == NULL || path[0] == '\0') {
+        return;
+    }
+    const char* size_mb = getenv("RKNN_CAPTURE_SIZE_MB");
+    const char* every = getenv("RKNN_CAPTURE_EVERY");
+    const char* inputs = getenv("RKNN_CAPTURE_INPUTS");
+    uint64_t capacity = (uint64_t)(size_mb != NULL ? atoi(size_mb) : 256) << 20;
+    g.every = every != NULL && atoi(every) > 0 ? atoi(every) : 1;
+    g.with_inputs = inputs != NULL ? atoi(inputs) != 0 : 1;
+    if (tensor_capture_create(path, capacity, &g.cap) != 0) {
+        return;
+    }
+    g.enabled = 1;
+    printf("rknn_capture: recording to %s, %llu MB ring, every %d run\n", path,
+           (unsigned long long)(capacity >> 20), g.every);
+}
+
+static void ensure_init(void)
+{
+    pthread_once(&g.once, capture_init);
+}
+
+// caller holds g.lock
+static capture_ctx_t* find_ctx(rknn_context ctx)
+{
+    for (int i = 0; i < CAPTURE_MAX_CTX; i++) {
+        if (g.ctxs[i].used && g.ctxs[i].ctx == ctx) {
+            return &g.ctxs[i];
+        }
+    }
+    return NULL;
+}
+
+static void add_ctx(rknn_context ctx, uint32_t flag)
+{
+    rknn_input_output_num io_num;
+    if (g.query(ctx, RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num)) != RKNN_SUCC ||
+        io_num.n_input > TENSOR_CAPTURE_MAX_TENSORS / 2 || io_num.n_output > TENSOR_CAPTURE_MAX_TENSORS / 2) {
+        printf("rknn_capture: skip context with too many tensors\n");
+        return;
+    }
+    pthread_mutex_lock(&g.lock);
+    for (int i = 0; i < CAPTURE_MAX_CTX; i++) {
+        capture_ctx_t* c = &g.ctxs[i];
+        if (c->used) {
+            continue;
+        }
+        memset(c, 0, sizeof(capture_ctx_t));
+        c->used = 1;
+        c->ctx = ctx;
+        c->flag = flag;
+        c->io_num = io_num;
+        for (uint32_t j = 0; j < io_num.n_input; j++) {
+            c->in_attrs[j].index = j;
+            g.query(ctx, RKNN_QUERY_INPUT_ATTR, &c->in_attrs[j], sizeof(rknn_tensor_attr));
+        }
+        for (uint32_t j = 0; j < io_num.n_output; j++) {
+            c->out_attrs[j].index = j;
+            g.query(ctx, RKNN_QUERY_OUTPUT_ATTR, &c->out_attrs[j], sizeof(rknn_tensor_attr));
+        }
+        break;
+    }
+    pthread_mutex_unlock(&g.lock);
+}
+
+static int is_async(const capture_ctx_t* c)
+{
+    return (c->flag & RKNN_FLAG_ASYNC_MASK) != 0;
+}
+
+static int sampled(uint64_t frame_id)
+{
+    return frame_id % g.every == 0;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// caller holds g.lock, outputs are appended by the caller after the inputs
+static void begin_frame(capture_ctx_t* c, uint64_t frame_id, tensor_capture_frame_t* frame)
+{
+    frame->frame_id = frame_id;
+    frame->timestamp_ns = now_ns();
+    frame->ctx = (uint64_t)c->ctx;
+    frame->n_tensors = 0;
+    if (!g.with_inputs || is_async(c)) {
+        return;
+    }
+    for (uint32_t i = 0; i < c->io_num.n_input; i++) {
+        tensor_capture_tensor_t* t = &frame->tensors[frame->n_tensors];
+        if (c->in_mems[i] != NULL) {
+            t->kind = TENSOR_CAPTURE_INPUT;
+            t->want_float = 0;
+            t->attr = c->in_mem_attrs[i];
+            t->size = c->in_mems[i]->size;
+            t->data = (const uint8_t*)c->in_mems[i]->virt_addr + c->in_mems[i]->offset;
+        } else if (c->in_data[i] != NULL) {
+            *t = c->in_tensors[i];
+        } else {
+            continue;
+        }
+        frame->n_tensors++;
+    }
+}
+
+int rknn_init(rknn_context* context, void* model, uint32_t size, uint32_t flag, rknn_init_extend* extend)
+{
+    ensure_init();
+    int ret = g.init(context, model, size, flag, extend);
+    if (ret == RKNN_SUCC && g.enabled) {
+        add_ctx(*context, flag);
+    }
+    return ret;
+}
+
+int rknn_dup_context(rknn_context* context_in, rknn_context* context_out)
+{
+    ensure_init();
+    int ret = g.dup_context(context_in, context_out);
+    if (ret == RKNN_SUCC && g.enabled) {
+        // the copy runs like the original, e.g. with RKNN_FLAG_ASYNC_MASK
+        pthread_mutex_lock(&g.lock);
+        capture_ctx_t* c = find_ctx(*context_in);
+        uint32_t flag = c != NULL ? c->flag : 0;
+        pthread_mutex_unlock(&g.lock);
+        add_ctx(*context_out, flag);
+    }
+    return ret;
+}
+
+int rknn_destroy(rknn_context context)
+{
+    ensure_init();
+    if (g.enabled) {
+        pthread_mutex_lock(&g.lock);
+        capture_ctx_t* c = find_ctx(context);
+        if (c != NULL) {
+            for (int i = 0; i < TENSOR_CAPTURE_MAX_TENSORS; i++) {
+                free(c->in_data[i]);
+            }
+            c->used = 0;
+        }
+        pthread_mutex_unlock(&g.lock);
+    }
+    return g.destroy(context);
+}
+
+int rknn_query(rknn_context context, rknn_query_cmd cmd, void* info, uint32_t size)
+{
+    ensure_init();
+    return g.query(context, cmd, info, size);
+}
+
+int rknn_inputs_set(rknn_context context, uint32_t n_inputs, rknn_input inputs[])
+{
+    ensure_init();
+    if (g.enabled && g.with_inputs) {
+        pthread_mutex_lock(&g.lock);
+        capture_ctx_t* c = find_ctx(context);
+        // only the inputs of the next run if it is sampled
+        if (c != NULL && !is_async(c) && sampled(c->frame_id + 1)) {
+            for (uint32_t i = 0; i < n_inputs; i++) {
+                uint32_t index = inputs[i].index;
+                if (index >= c->io_num.n_input) {
+                    continue;
+                }
+                tensor_capture_tensor_t* t = &c->in_tensors[index];
+                if (c->in_data[index] == NULL || t->size < inputs[i].size) {
+                    free(c->in_data[index]);
+                    c->in_data[index] = malloc(inputs[i].size);
+                }
+                if (c->in_data[index] == NULL) {
+                    continue;
+                }
+                memcpy(c->in_data[index], inputs[i].buf, inputs[i].size);
+                t->kind = TENSOR_CAPTURE_INPUT;
+                t->want_float = 0;
+                t->attr = c->in_attrs[index];
+                if (!inputs[i].pass_through) {
+                    t->attr.type = inputs[i].type;
+                    t->attr.fmt = inputs[i].fmt;
+                }
+                t->size = inputs[i].size;
+                t->data = c->in_data[index];
+            }
+        }
+        pthread_mutex_unlock(&g.lock);
+    }
+    return g.inputs_set(context, n_inputs, inputs);
+}
+
+int rknn_set_io_mem(rknn_context ctx, rknn_tensor_mem* mem, rknn_tensor_attr* attr)
+{
+    ensure_init();
+    int ret = g.set_io_mem(ctx, mem, attr);
+    if (ret != RKNN_SUCC || !g.enabled || mem == NULL || attr == NULL) {
+        return ret;
+    }
+    pthread_mutex_lock(&g.lock);
+    capture_ctx_t* c = find_ctx(ctx);
+    if (c != NULL) {
+        // an attr of the output queries is an output, everything else an input
+        int is_output = 0;
+        for (uint32_t i = 0; i < c->io_num.n_output; i++) {
+            if (attr->index == i && strcmp(attr->name, c->out_attrs[i].name) == 0) {
+                is_output = 1;
+            }
+        }
+        if (is_output) {
+            c->out_mems[attr->index] = mem;
+            c->out_mem_attrs[attr->index] = *attr;
+        } else if (attr->index < c->io_num.n_input) {
+            c->in_mems[attr->index] = mem;
+            c->in_mem_attrs[attr->index] = *attr;
+        }
+    }
+    pthread_mutex_unlock(&g.lock);
+    return ret;
+}
+
+int rknn_run(rknn_context context, rknn_run_extend* extend)
+{
+    ensure_init();
+    int ret = g.run(context, extend);
+    if (!g.enabled || ret != RKNN_SUCC) {
+        return ret;
+    }
+    pthread_mutex_lock(&g.lock);
+    capture_ctx_t* c = find_ctx(context);
+    if (c != NULL) {
+        c->frame_id++;
+        int blocking = !is_async(c) && (extend == NULL || extend->non_block == 0);
+        if (blocking && c->io_num.n_output > 0 && c->out_mems[0] != NULL && sampled(c->frame_id)) {
+            // zero copy, the bound output memories hold the result now
+            static tensor_capture_frame_t frame;
+            begin_frame(c, c->frame_id, &frame);
+            for (uint32_t i = 0; i < c->io_num.n_output; i++) {
+                rknn_tensor_mem* mem = c->out_mems[i];
+                if (mem == NULL) {
+                    continue;
+                }
+                tensor_capture_tensor_t* t = &frame.tensors[frame.n_tensors++];
+                t->kind = TENSOR_CAPTURE_OUTPUT;
+                t->want_float = 0;
+                t->attr = c->out_mem_attrs[i];
+                t->size = mem->size;
+                t->data = (const uint8_t*)mem->virt_addr + mem->offset;
+            }
+            tensor_capture_write(&g.cap, &frame);
+        }
+    }
+    pthread_mutex_unlock(&g.lock);
+    return ret;
+}
+
+int rknn_outputs_get(rknn_context context, uint32_t n_outputs, rknn_output outputs[], rknn_output_extend* extend)
+{
+    ensure_init();
+    int ret = g.outputs_get(context, n_outputs, outputs, extend);
+    if (!g.enabled || ret != RKNN_SUCC) {
+        return ret;
+    }
+    pthread_mutex_lock(&g.lock);
+    capture_ctx_t* c = find_ctx(context);
+    uint64_t frame_id = c != NULL ? c->frame_id : 0;
+    if (c != NULL && is_async(c)) {
+        // the frame before the last run, except right after the first run; the first result
+        // comes back twice and is recorded once
+        if (extend != NULL && extend->frame_id != 0) {
+            frame_id = extend->frame_id;
+        } else if (frame_id > 1) {
+            frame_id--;
+        }
+        if (frame_id <= c->out_frame_id) {
+            frame_id = 0;
+        } else {
+            c->out_frame_id = frame_id;
+        }
+    }
+    if (c != NULL && frame_id != 0 && sampled(frame_id)) {
+        static tensor_capture_frame_t frame;
+        begin_frame(c, frame_id, &frame);
+        for (uint32_t i = 0; i < n_outputs && frame.n_tensors < TENSOR_CAPTURE_MAX_TENSORS; i++) {
+            if (outputs[i].index >= c->io_num.n_output || outputs[i].buf == NULL) {
+                continue;
+            }
+            tensor_capture_tensor_t* t = &frame.tensors[frame.n_tensors++];
+            t->kind = TENSOR_CAPTURE_OUTPUT;
+            t->want_float = outputs[i].want_float;
+            t->attr = c->out_attrs[outputs[i].index];
+            t->size = outputs[i].size;
+            t->data = outputs[i].buf;
+        }
+        tensor_capture_write(&g.cap, &frame);
+    }
+    pthread_mutex_unlock(&g.lock);
+    return ret;
+}
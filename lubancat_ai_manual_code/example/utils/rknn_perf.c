@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rknn_perf.h"
+
+#define MAX_COLUMNS 32
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void rknn_perf_init(rknn_perf_t* perf, rknn_context ctx)
+{
+    memset(perf, 0, sizeof(rknn_perf_t));
+    perf->ctx = ctx;
+}
+
+void rknn_perf_release(rknn_perf_t* perf)
+{
+    free(perf->layers);
+    memset(perf, 0, sizeof(rknn_perf_t));
+}
+
+void rknn_perf_frame_begin(rknn_perf_t* perf)
+{
+    perf->frame_start_us = now_us();
+}
+
+static int split(char* line, char* tokens[], int max_tokens)
+{
+    int n = 0;
+    char* save = NULL;
+    for (char* t = strtok_r(line, " \t\r", &save); t != NULL && n < max_tokens; t = strtok_r(NULL, " \t\r", &save)) {
+        tokens[n++] = t;
+    }
+    return n;
+}
+
+static int is_number(const char* s)
+{
+    if (*s == '\0') {
+        return 0;
+    }
+    for (; *s; s++) {
+        if (*s < '0' || *s > '9') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static rknn_perf_layer_t* find_layer(rknn_perf_t* perf, int id, int hint)
+{
+    if (hint < perf->n_layers && perf->layers[hint].id == id) {
+        return &perf->layers[hint];
+    }
+    for (int i = 0; i < perf->n_layers; i++) {
+        if (perf->layers[i].id == id) {
+            return &perf->layers[i];
+        }
+    }
+    if (perf->n_layers == perf->cap_layers) {
+        int cap = perf->cap_layers > 0 ? perf->cap_layers * 2 : 64;
+        rknn_perf_layer_t* layers = (rknn_perf_layer_t*)realloc(perf->layers, cap * sizeof(rknn_perf_layer_t));
+        if (layers == NULL) {
+            return NULL;
+        }
+        perf->layers = layers;
+        perf->cap_layers = cap;
+    }
+    rknn_perf_layer_t* layer = &perf->layers[perf->n_layers++];
+    memset(layer, 0, sizeof(rknn_perf_layer_t));
+    layer->id = id;
+    return layer;
+}
+
+// the layer table of the runtime, columns are found by their names in the header line
+static int parse_detail(rknn_perf_t* perf, char* text, double* layer_us)
+{
+    int op_col = -1, target_col = -1, time_col = -1;
+    int row = 0;
+    char* save = NULL;
+    *layer_us = 0;
+    for (char* line = strtok_r(text, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        char* tokens[MAX_COLUMNS];
+        int n = split(line, tokens, MAX_COLUMNS);
+        if (n == 0) {
+            continue;
+        }
+        if (time_col < 0) {
+            if (strcmp(tokens[0], "ID") != 0) {
+                continue;
+            }
+            // runtime 1.x splits "DDR Cycles", "NPU Cycles" and "Total Cycles" in two words
+            int col = 0;
+            for (int i = 0; i < n; i++) {
+                if (strcmp(tokens[i], "Cycles") == 0) {
+                    continue;
+                }
+                if (strcmp(tokens[i], "OpType") == 0) {
+                    op_col = col;
+                } else if (strcmp(tokens[i], "Target") == 0) {
+                    target_col = col;
+                } else if (strcmp(tokens[i], "Time(us)") == 0) {
+                    time_col = col;
+                }
+                col++;
+            }
+            continue;
+        }
+        if (!is_number(tokens[0]) || n <= time_col) {
+            continue;
+        }
+        rknn_perf_layer_t* layer = find_layer(perf, atoi(tokens[0]), row++);
+        if (layer == NULL) {
+            printf("rknn_perf: out of memory\n");
+            return -1;
+        }
+        double us = atof(tokens[time_col]);
+        if (layer->op_type[0] == '\0') {
+            snprintf(layer->op_type, sizeof(layer->op_type), "%s", op_col >= 0 ? tokens[op_col] : "-");
+            snprintf(layer->target, sizeof(layer->target), "%s", target_col >= 0 ? tokens[target_col] : "-");
+            snprintf(layer->name, sizeof(layer->name), "%s", n > time_col + 1 ? tokens[n - 1] : "");
+        }
+        layer->total_us += us;
+        *layer_us += us;
+    }
+    if (time_col < 0) {
+        printf("rknn_perf: no layer table in RKNN_QUERY_PERF_DETAIL\n");
+        return -1;
+    }
+    return 0;
+}
+
+int rknn_perf_frame_end(rknn_perf_t* perf)
+{
+    int64_t e2e_us = now_us() - perf->frame_start_us;
+
+    rknn_perf_run run;
+    memset(&run, 0, sizeof(run));
+    int ret = rknn_query(perf->ctx, RKNN_QUERY_PERF_RUN, &run, sizeof(run));
+    if (ret != RKNN_SUCC) {
+        printf("rknn_query RKNN_QUERY_PERF_RUN fail! ret=%d\n", ret);
+        return -1;
+    }
+    perf->runs++;
+    perf->e2e_us += e2e_us;
+    perf->npu_us += run.run_duration;
+
+    // without the layer table the time split is still printed
+    rknn_perf_detail detail;
+    memset(&detail, 0, sizeof(detail));
+    ret = rknn_query(perf->ctx, RKNN_QUERY_PERF_DETAIL, &detail, sizeof(detail));
+    if (ret != RKNN_SUCC || detail.perf_data == NULL) {
+        if (perf->detail_runs == 0 && perf->runs == 1) {
+            printf("rknn_query RKNN_QUERY_PERF_DETAIL fail! ret=%d, init with RKNN_FLAG_COLLECT_PERF_MASK\n", ret);
+        }
+        return 0;
+    }
+    size_t len = detail.data_len > 0 ? (size_t)detail.data_len : strlen(detail.perf_data);
+    char* text = (char*)malloc(len + 1);
+    if (text == NULL) {
+        return 0;
+    }
+    memcpy(text, detail.perf_data, len);
+    text[len] = '\0';
+    double layer_us;
+    if (parse_detail(perf, text, &layer_us) == 0) {
+        perf->detail_runs++;
+        perf->layer_us += layer_us;
+    }
+    free(text);
+    return 0;
+}
+
+static int cmp_layer_time(const void* a, const void* b)
+{
+    double ta = (*(const rknn_perf_layer_t* const*)a)->total_us;
+    double tb = (*(const rknn_perf_layer_t* const*)b)->total_us;
+    return ta < tb ? 1 : (ta > tb ? -1 : 0);
+}
+
+static void print_op_types(const rknn_perf_t* perf, rknn_perf_layer_t** sorted)
+{
+    // the layers are sorted by time, so are the op types in order of first appearance
+    const char* types[256];
+    double type_us[256];
+    int type_layers[256];
+    int n_types = 0;
+    for (int i = 0; i < perf->n_layers; i++) {
+        int t = 0;
+        while (t < n_types && strcmp(types[t], sorted[i]->op_type) != 0) {
+            t++;
+        }
+        if (t == n_types) {
+            if (n_types == 256) {
+                continue;
+            }
+            types[t] = sorted[i]->op_type;
+            type_us[t] = 0;
+            type_layers[t] = 0;
+            n_types++;
+        }
+        type_us[t] += sorted[i]->total_us;
+        type_layers[t]++;
+    }
+    for (int i = 1; i < n_types; i++) {
+        for (int j = i; j > 0 && type_us[j] > type_us[j - 1]; j--) {
+            const char* ts = types[j]; types[j] = types[j - 1]; types[j - 1] = ts;
+            double tu = type_us[j]; type_us[j] = type_us[j - 1]; type_us[j - 1] = tu;
+            int tl = type_layers[j]; type_layers[j] = type_layers[j - 1]; type_layers[j - 1] = tl;
+        }
+    }
+    printf("%-20s %8s %12s %8s\n", "op type", "layers", "avg (us)", "share");
+    for (int i = 0; i < n_types; i++) {
+        printf("%-20s %8d %12.1f %7.1f%%\n", types[i], type_layers[i], type_us[i] / perf->detail_runs,
+               perf->layer_us > 0 ? type_us[i] * 100 / perf->layer_us : 0);
+    }
+}
+
+void rknn_perf_print(const rknn_perf_t* perf, int top_n)
+{
+    if (perf->runs == 0) {
+        printf("rknn_perf: no run\n");
+        return;
+    }
+    printf("---- rknn perf, %u runs, layer table of %u ----\n", perf->runs, perf->detail_runs);
+    if (perf->detail_runs > 0 && perf->n_layers > 0) {
+        rknn_perf_layer_t** sorted = (rknn_perf_layer_t**)malloc(perf->n_layers * sizeof(rknn_perf_layer_t*));
+        if (sorted != NULL) {
+            for (int i = 0; i < perf->n_layers; i++) {
+                sorted[i] = &perf->layers[i];
+            }
+            qsort(sorted, perf->n_layers, sizeof(rknn_perf_layer_t*), cmp_layer_time);
+            int n = top_n > 0 && top_n < perf->n_layers ? top_n : perf->n_layers;
+            double cum = 0;
+            printf("%-6s %-20s %-6s %12s %8s %8s  %s\n", "ID", "op type", "target", "avg (us)", "share", "cum",
+                   "name");
+            for (int i = 0; i < n; i++) {
+                const rknn_perf_layer_t* l = sorted[i];
+                double share = perf->layer_us > 0 ? l->total_us * 100 / perf->layer_us : 0;
+                cum += share;
+                printf("%-6d %-20s %-6s %12.1f %7.1f%% %7.1f%%  %s\n", l->id, l->op_type, l->target,
+                       l->total_us / perf->detail_runs, share, cum, l->name);
+            }
+            if (n < perf->n_layers) {
+                printf("... %d more layers, %.1f%% of the time\n", perf->n_layers - n, 100 - cum);
+            }
+            printf("\n");
+            print_op_types(perf, sorted);
+            free(sorted);
+        }
+        printf("\n");
+    }
+    double e2e_ms = perf->e2e_us / perf->runs / 1000;
+    double npu_ms = perf->npu_us / perf->runs / 1000;
+    printf("end-to-end    avg %9.3f ms\n", e2e_ms);
+    printf("npu run       avg %9.3f ms  %5.1f%%  RKNN_QUERY_PERF_RUN\n", npu_ms,
+           e2e_ms > 0 ? npu_ms * 100 / e2e_ms : 0);
+    if (perf->detail_runs > 0) {
+        printf("  layers      avg %9.3f ms          sum of the layer table\n",
+               perf->layer_us / perf->detail_runs / 1000);
+    }
+    printf("host          avg %9.3f ms  %5.1f%%  pre/post process, copies, rknn api calls\n", e2e_ms - npu_ms,
+           e2e_ms > 0 ? (e2e_ms - npu_ms) * 100 / e2e_ms : 0);
+}
@@ -0,0 +1,86 @@
+#ifndef _RKNN_MODEL_ZOO_RKNN_PERF_H_
+#define _RKNN_MODEL_ZOO_RKNN_PERF_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "rknn_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per layer profile of a context created with RKNN_FLAG_COLLECT_PERF_MASK.
+ *
+ *   rknn_perf_frame_begin(&perf);
+ *   inference_xxx_model(...);                 // pre process, rknn_run, post process
+ *   rknn_perf_frame_end(&perf);               // RKNN_QUERY_PERF_RUN / PERF_DETAIL of that run
+ *   ...
+ *   rknn_perf_print(&perf, 20);
+ *
+ * Layer times of the runtime table are summed over the runs and printed sorted,
+ * with the share of each layer and op type. Next to them the end-to-end time of a
+ * frame is split into the NPU run time (RKNN_QUERY_PERF_RUN) and the rest, the
+ * host side: when a frame gets slower, a longer NPU run points at the model or the
+ * runtime, a longer rest at the pre/post process.
+ *
+ * Collecting the layer table slows the run down, compare end-to-end times of
+ * builds without the flag. One run must finish before it is queried, so this
+ * does not work with RKNN_FLAG_ASYNC_MASK.
+ */
+
+#define RKNN_PERF_DEFAULT_RUNS 100
+
+typedef struct {
+    int id;
+    char op_type[32];
+    char target[8];
+    char name[128];
+    double total_us;    // over all runs with a layer table
+} rknn_perf_layer_t;
+
+typedef struct {
+    rknn_context ctx;
+    uint32_t runs;
+    uint32_t detail_runs;   // runs the layer table could be read for
+    int64_t frame_start_us;
+    double e2e_us;          // sums over the runs
+    double npu_us;
+    double layer_us;
+    rknn_perf_layer_t* layers;
+    int n_layers;
+    int cap_layers;
+} rknn_perf_t;
+
+/**
+ * @brief Start a profile of a context initialized with RKNN_FLAG_COLLECT_PERF_MASK
+ */
+void rknn_perf_init(rknn_perf_t* perf, rknn_context ctx);
+
+/**
+ * @brief Start of the end-to-end time of a frame
+ */
+void rknn_perf_frame_begin(rknn_perf_t* perf);
+
+/**
+ * @brief End of the frame, after the outputs of its rknn_run have been read
+ *
+ * @return int 0: success; -1: the run time could not be queried
+ */
+int rknn_perf_frame_end(rknn_perf_t* perf);
+
+/**
+ * @brief Print the layer table sorted by time, the op types and the time split
+ *
+ * @param top_n [in] Layers printed, 0: all
+ */
+void rknn_perf_print(const rknn_perf_t* perf, int top_n);
+
+void rknn_perf_release(rknn_perf_t* perf);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _RKNN_MODEL_ZOO_RKNN_PERF_H_
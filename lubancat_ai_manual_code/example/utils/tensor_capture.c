@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tensor_capture.h"
+
+#define CAPTURE_MAGIC "RKNNCAP1"
+#define CAPTURE_VERSION 1
+#define CAPTURE_HEADER_SIZE 4096
+#define FRAME_MAGIC 0x4d52464b      // "KFRM"
+#define PAD_MAGIC 0x4441504b        // "KPAD", rest of the ring is unused, continue at 0
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t attr_size;             // sizeof(rknn_tensor_attr) of the writer
+    uint32_t reserved0;
+    uint64_t capacity;              // bytes of the ring
+    uint64_t head;                  // offset of the oldest frame
+    uint64_t tail;                  // offset of the next write
+    uint64_t n_frames;              // frames in the ring
+    uint64_t n_written;
+    uint64_t n_dropped;
+} capture_header_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t n_tensors;
+    uint64_t record_size;           // header, tensors and data, 8 byte aligned
+    uint64_t frame_id;
+    uint64_t timestamp_ns;
+    uint64_t ctx;
+} frame_record_t;
+
+typedef struct {
+    uint32_t kind;
+    uint32_t want_float;
+    uint32_t size;
+    uint32_t reserved;
+    rknn_tensor_attr attr;
+} tensor_record_t;
+
+#define ALIGN8(x) (((x) + 7) & ~(uint64_t)7)
+
+static capture_header_t* header_of(const tensor_capture_t* cap)
+{
+    return (capture_header_t*)cap->map;
+}
+
+static uint8_t* ring_of(const tensor_capture_t* cap)
+{
+    return cap->map + CAPTURE_HEADER_SIZE;
+}
+
+static uint64_t record_size_of(const tensor_capture_frame_t* frame)
+{
+    uint64_t size = sizeof(frame_record_t);
+    for (int i = 0; i < frame->n_tensors; i++) {
+        size += ALIGN8(sizeof(tensor_record_t)) + ALIGN8(frame->tensors[i].size);
+    }
+    return size;
+}
+
+static int map_file(tensor_capture_t* cap, size_t size, int writable)
+{
+    cap->map = (uint8_t*)mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, cap->fd, 0);
+    if (cap->map == MAP_FAILED) {
+        cap->map = NULL;
+        return -1;
+    }
+    cap->map_size = size;
+    cap->writable = writable;
+    return 0;
+}
+
+int tensor_capture_create(const char* path, uint64_t capacity, tensor_capture_t* cap)
+{
+    memset(cap, 0, sizeof(tensor_capture_t));
+    cap->fd = -1;
+    capacity = ALIGN8(capacity);
+    if (capacity < 4096) {
+        printf("capture ring %llu too small\n", (unsigned long long)capacity);
+        return -1;
+    }
+    cap->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (cap->fd < 0) {
+        printf("open capture %s fail!\n", path);
+        return -1;
+    }
+    size_t size = CAPTURE_HEADER_SIZE + capacity;
+    if (ftruncate(cap->fd, size) != 0 || map_file(cap, size, 1) != 0) {
+        printf("map capture %s fail!\n", path);
+        close(cap->fd);
+        cap->fd = -1;
+        return -1;
+    }
+    capture_header_t* hdr = header_of(cap);
+    memset(hdr, 0, sizeof(capture_header_t));
+    memcpy(hdr->magic, CAPTURE_MAGIC, sizeof(hdr->magic));
+    hdr->version = CAPTURE_VERSION;
+    hdr->header_size = CAPTURE_HEADER_SIZE;
+    hdr->attr_size = sizeof(rknn_tensor_attr);
+    hdr->capacity = capacity;
+    return 0;
+}
+
+// drop the oldest frames until none of them starts in [start, end)
+static void evict(capture_header_t* hdr, uint8_t* ring, uint64_t start, uint64_t end)
+{
+    while (hdr->n_frames > 0 && hdr->head >= start && hdr->head < end) {
+        if (hdr->capacity - hdr->head < sizeof(frame_record_t)) {
+            hdr->head = 0;
+            continue;
+        }
+        const frame_record_t* rec = (const frame_record_t*)(ring + hdr->head);
+        if (rec->magic == PAD_MAGIC) {
+            hdr->head = 0;
+            continue;
+        }
+        hdr->head += rec->record_size;
+        if (hdr->head >= hdr->capacity) {
+            hdr->head = 0;
+        }
+        hdr->n_frames--;
+        hdr->n_dropped++;
+    }
+}
+
+int tensor_capture_write(tensor_capture_t* cap, const tensor_capture_frame_t* frame)
+{
+    if (cap->map == NULL || !cap->writable || frame->n_tensors > TENSOR_CAPTURE_MAX_TENSORS) {
+        return -1;
+    }
+    capture_header_t* hdr = header_of(cap);
+    uint8_t* ring = ring_of(cap);
+    uint64_t rec_size = record_size_of(frame);
+    if (rec_size > hdr->capacity) {
+        printf("capture frame of %llu bytes larger than the ring\n", (unsigned long long)rec_size);
+        return -1;
+    }
+
+    uint64_t pos = hdr->tail;
+    if (pos + rec_size > hdr->capacity) {
+        evict(hdr, ring, pos, hdr->capacity);
+        if (hdr->capacity - pos >= sizeof(frame_record_t)) {
+            frame_record_t* pad = (frame_record_t*)(ring + pos);
+            memset(pad, 0, sizeof(frame_record_t));
+            pad->magic = PAD_MAGIC;
+            pad->record_size = hdr->capacity - pos;
+        }
+        pos = 0;
+    }
+    evict(hdr, ring, pos, pos + rec_size);
+
+    frame_record_t* rec = (frame_record_t*)(ring + pos);
+    rec->magic = FRAME_MAGIC;
+    rec->n_tensors = frame->n_tensors;
+    rec->record_size = rec_size;
+    rec->frame_id = frame->frame_id;
+    rec->timestamp_ns = frame->timestamp_ns;
+    rec->ctx = frame->ctx;
+    uint8_t* p = (uint8_t*)(rec + 1);
+    for (int i = 0; i < frame->n_tensors; i++) {
+        const tensor_capture_tensor_t* t = &frame->tensors[i];
+        tensor_record_t* tr = (tensor_record_t*)p;
+        memset(tr, 0, sizeof(tensor_record_t));
+        tr->kind = t->kind;
+        tr->want_float = t->want_float;
+        tr->size = t->size;
+        tr->attr = t->attr;
+        p += ALIGN8(sizeof(tensor_record_t));
+        memcpy(p, t->data, t->size);
+        p += ALIGN8(t->size);
+    }
+
+    // the header last, a crash while copying leaves the previous state
+    if (hdr->n_frames == 0) {
+        hdr->head = pos;
+    }
+    hdr->tail = pos + rec_size;
+    hdr->n_frames++;
+    hdr->n_written++;
+    return 0;
+}
+
+int tensor_capture_open(const char* path, tensor_capture_t* cap)
+{
+    memset(cap, 0, sizeof(tensor_capture_t));
+    cap->fd = open(path, O_RDONLY);
+    if (cap->fd < 0) {
+        printf("open capture %s fail!\n", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(cap->fd, &st) != 0 || st.st_size < CAPTURE_HEADER_SIZE || map_file(cap, st.st_size, 0) != 0) {
+        printf("map capture %s fail!\n", path);
+        close(cap->fd);
+        cap->fd = -1;
+        return -1;
+    }
+    const capture_header_t* hdr = header_of(cap);
+    if (memcmp(hdr->magic, CAPTURE_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != CAPTURE_VERSION ||
+        hdr->attr_size != sizeof(rknn_tensor_attr) || CAPTURE_HEADER_SIZE + hdr->capacity > (uint64_t)st.st_size) {
+        printf("%s is not a capture file of this version\n", path);
+        tensor_capture_close(cap);
+        return -1;
+    }
+    tensor_capture_rewind(cap);
+    return 0;
+}
+
+void tensor_capture_rewind(tensor_capture_t* cap)
+{
+    const capture_header_t* hdr = header_of(cap);
+    cap->read_pos = hdr->head;
+    cap->read_left = hdr->n_frames;
+}
+
+int tensor_capture_next(tensor_capture_t* cap, tensor_capture_frame_t* frame)
+{
+    const capture_header_t* hdr = header_of(cap);
+    const uint8_t* ring = ring_of(cap);
+    while (cap->read_left > 0) {
+        if (hdr->capacity - cap->read_pos < sizeof(frame_record_t)) {
+            cap->read_pos = 0;
+            continue;
+        }
+        const frame_record_t* rec = (const frame_record_t*)(ring + cap->read_pos);
+        if (rec->magic == PAD_MAGIC) {
+            cap->read_pos = 0;
+            continue;
+        }
+        if (rec->magic != FRAME_MAGIC || rec->n_tensors > TENSOR_CAPTURE_MAX_TENSORS ||
+            rec->record_size > hdr->capacity - cap->read_pos) {
+            printf("corrupt capture frame at %llu\n", (unsigned long long)cap->read_pos);
+            return -1;
+        }
+        frame->frame_id = rec->frame_id;
+        frame->timestamp_ns = rec->timestamp_ns;
+        frame->ctx = rec->ctx;
+        frame->n_tensors = rec->n_tensors;
+        const uint8_t* p = (const uint8_t*)(rec + 1);
+        for (uint32_t i = 0; i < rec->n_tensors; i++) {
+            const tensor_record_t* tr = (const tensor_record_t*)p;
+            tensor_capture_tensor_t* t = &frame->tensors[i];
+            t->kind = tr->kind;
+            t->want_float = tr->want_float;
+            t->attr = tr->attr;
+            t->size = tr->size;
+            p += ALIGN8(sizeof(tensor_record_t));
+            t->data = p;
+            p += ALIGN8(tr->size);
+        }
+        cap->read_pos += rec->record_size;
+        if (cap->read_pos >= hdr->capacity) {
+            cap->read_pos = 0;
+        }
+        cap->read_left--;
+        return 1;
+    }
+    return 0;
+}
+
+void tensor_capture_stats(const tensor_capture_t* cap, uint64_t* n_frames, uint64_t* n_written, uint64_t* n_dropped)
+{
+    const capture_header_t* hdr = header_of(cap);
+    if (n_frames != NULL) {
+        *n_frames = hdr->n_frames;
+    }
+    if (n_written != NULL) {
+        *n_written = hdr->n_written;
+    }
+    if (n_dropped != NULL) {
+        *n_dropped = hdr->n_dropped;
+    }
+}
+
+void tensor_capture_close(tensor_capture_t* cap)
+{
+    if (cap->map != NULL) {
+        munmap(cap->map, cap->map_size);
+        cap->map = NULL;
+    }
+    if (cap->fd >= 0) {
+        close(cap->fd);
+        cap->fd = -1;
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef _RKNN_MODEL_ZOO_TENSOR_CAPTURE_H_
+#define _RKNN_MODEL_ZOO_TENSOR_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rknn_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Capture file of model inputs / outputs.
+ *
+ * A fixed size file: a 4 KB header followed by a ring of frame records. When the
+ * ring is full the oldest frames are overwritten, so a recorder can run for days
+ * with a bounded disk footprint. Every record holds the rknn_tensor_attr of its
+ * tensors (dims, fmt, type, zp, scale) and the raw data, 8 byte aligned, so a
+ * reader can use the tensors in place from the mapping.
+ */
+
+#define TENSOR_CAPTURE_MAX_TENSORS 32
+
+#define TENSOR_CAPTURE_INPUT 0
+#define TENSOR_CAPTURE_OUTPUT 1
+
+typedef struct {
+    uint32_t kind;              // TENSOR_CAPTURE_INPUT / TENSOR_CAPTURE_OUTPUT
+    uint32_t want_float;        // data was dequantized to float32 by rknn_outputs_get
+    rknn_tensor_attr attr;      // attr of the model tensor, type / fmt of the data when want_float is 0
+    uint32_t size;              // bytes of data
+    const void* data;
+} tensor_capture_tensor_t;
+
+typedef struct {
+    uint64_t frame_id;          // rknn_run count of the context
+    uint64_t timestamp_ns;      // CLOCK_REALTIME
+    uint64_t ctx;               // rknn_context, to tell the models of one process apart
+    int n_tensors;
+    tensor_capture_tensor_t tensors[TENSOR_CAPTURE_MAX_TENSORS];
+} tensor_capture_frame_t;
+
+typedef struct {
+    int fd;
+    uint8_t* map;
+    size_t map_size;
+    int writable;
+    uint64_t read_pos;          // reader: offset of the next frame
+    uint64_t read_left;         // reader: frames left
+} tensor_capture_t;
+
+/**
+ * @brief Create (or truncate) a capture file with a ring of the given size
+ *
+ * @param path [in] File path
+ * @param capacity [in] Bytes of the frame ring, the file is 4 KB larger
+ * @param cap [out] Capture handle
+ * @return int 0: success; -1: error
+ */
+int tensor_capture_create(const char* path, uint64_t capacity, tensor_capture_t* cap);
+
+/**
+ * @brief Append one frame, dropping the oldest frames if the ring is full
+ *
+ * @return int 0: success; -1: error (e.g. frame larger than the ring)
+ */
+int tensor_capture_write(tensor_capture_t* cap, const tensor_capture_frame_t* frame);
+
+/**
+ * @brief Open a capture file read only, positioned at the oldest frame
+ *
+ * @return int 0: success; -1: error
+ */
+int tensor_capture_open(const char* path, tensor_capture_t* cap);
+
+/**
+ * @brief Read the next frame, tensor data points into the mapping
+ *
+ * @return int 1: got a frame; 0: no more frames; -1: corrupt file
+ */
+int tensor_capture_next(tensor_capture_t* cap, tensor_capture_frame_t* frame);
+
+/**
+ * @brief Go back to the oldest frame
+ */
+void tensor_capture_rewind(tensor_capture_t* cap);
+
+/**
+ * @brief Frames in the ring / written in total / overwritten
+ */
+void tensor_capture_stats(const tensor_capture_t* cap, uint64_t* n_frames, uint64_t* n_written, uint64_t* n_dropped);
+
+void tensor_capture_close(tensor_capture_t* cap);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _RKNN_MODEL_ZOO_TENSOR_CAPTURE_H_
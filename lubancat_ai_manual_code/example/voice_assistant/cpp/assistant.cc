@@ -0,0 +1,402 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "assistant.h"
+
+#define DEFAULT_MIN_FIRST_CHARS 6
+#define DEFAULT_MAX_CHARS 40        // split_sentence of the melotts demo cuts at 40 too
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+// sentences from the LLM callback to the TTS thread
+typedef struct
+{
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<std::string> sentences;
+    bool done;              // the reply is complete, nothing more will be queued
+    bool failed;            // the TTS gave up, the LLM stops feeding it
+} sentence_queue_t;
+
+// one turn, shared by the LLM callback and the TTS thread
+typedef struct
+{
+    assistant_t *assistant;
+    time_point_t start;
+    assistant_turn_stats_t *stats;
+    sentence_splitter_t splitter;
+    sentence_queue_t queue;
+    bool first_token;
+    bool first_audio;       // written by the TTS thread only
+    long long num_samples;
+} turn_state_t;
+
+static float elapsed_ms(time_point_t from)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - from).count();
+}
+
+static int utf8_length(const std::string &s, size_t begin, size_t end)
+{
+    int n = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        n += ((unsigned char)s[i] & 0xc0) != 0x80;
+    }
+    return n;
+}
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+#define MARK_NONE 0
+#define MARK_WEAK 1         // comma like, ends a sentence only when it is long enough
+#define MARK_STRONG 2
+#define MARK_UNDECIDED 3    // ascii mark at the end of the text, depends on the next byte
+
+// punctuation at s[i], its byte length in *len
+static int punctuation(const std::string &s, size_t i, int *len)
+{
+    static const char *strong[] = {"\xe3\x80\x82", "\xef\xbc\x81", "\xef\xbc\x9f", "\xef\xbc\x9b",
+                                   "\xe2\x80\xa6"};     // 。！？；…
+    static const char *weak[] = {"\xef\xbc\x8c", "\xe3\x80\x81", "\xef\xbc\x9a"};     // ，、：
+    char c = s[i];
+    *len = 1;
+    if (c == '\n')
+    {
+        return MARK_STRONG;
+    }
+    if (c == '.' || c == '!' || c == '?' || c == ';' || c == ',' || c == ':')
+    {
+        if (i + 1 == s.size())
+        {
+            return MARK_UNDECIDED;
+        }
+        if (!is_space(s[i + 1]))
+        {
+            return MARK_NONE;
+        }
+        return c == ',' || c == ':' ? MARK_WEAK : MARK_STRONG;
+    }
+    if (((unsigned char)c & 0x80) == 0)
+    {
+        return MARK_NONE;
+    }
+    for (const char *m : strong)
+    {
+        if (s.compare(i, 3, m) == 0)
+        {
+            *len = 3;
+            return MARK_STRONG;
+        }
+    }
+    for (const char *m : weak)
+    {
+        if (s.compare(i, 3, m) == 0)
+        {
+            *len = 3;
+            return MARK_WEAK;
+        }
+    }
+    return MARK_NONE;
+}
+
+// letters, digits or CJK, not only punctuation such as the rest of a ……
+static bool speakable(const std::string &s)
+{
+    size_t i = 0;
+    while (i < s.size())
+    {
+        int len;
+        int mark = punctuation(s, i, &len);
+        unsigned char c = s[i];
+        if (isalnum(c) || ((c & 0x80) != 0 && mark == MARK_NONE))
+        {
+            return true;
+        }
+        i += len;
+    }
+    return false;
+}
+
+// strip white space and markdown, drop pieces with nothing to speak
+static void emit(sentence_splitter_t *splitter, size_t end, std::vector<std::string> &out)
+{
+    std::string sentence;
+    for (size_t i = 0; i < end; i++)
+    {
+        char c = splitter->pending[i];
+        if (c == '*' || c == '#' || c == '`')
+        {
+            continue;
+        }
+        sentence += is_space(c) ? ' ' : c;
+    }
+    splitter->pending.erase(0, end);
+
+    size_t b = sentence.find_first_not_of(' ');
+    size_t e = sentence.find_last_not_of(' ');
+    if (b == std::string::npos)
+    {
+        return;
+    }
+    sentence = sentence.substr(b, e - b + 1);
+    if (speakable(sentence))
+    {
+        out.push_back(sentence);
+        splitter->emitted++;
+    }
+}
+
+void sentence_splitter_init(sentence_splitter_t *splitter, int min_first_chars, int max_chars)
+{
+    splitter->pending.clear();
+    splitter->emitted = 0;
+    splitter->min_first_chars = min_first_chars;
+    splitter->max_chars = max_chars;
+}
+
+void sentence_splitter_push(sentence_splitter_t *splitter, const char *text, std::vector<std::string> &out)
+{
+    splitter->pending += text;
+    const std::string &s = splitter->pending;
+    size_t i = 0;
+    while (i < s.size())
+    {
+        int len;
+        int mark = punctuation(s, i, &len);
+        if (mark == MARK_UNDECIDED)
+        {
+            return;
+        }
+        if (mark == MARK_STRONG ||
+            (mark == MARK_WEAK && utf8_length(s, 0, i) >= (splitter->emitted == 0 ? splitter->min_first_chars
+                                                                                   : splitter->max_chars)))
+        {
+            emit(splitter, i + len, out);
+            i = 0;
+            continue;
+        }
+        i += len;
+    }
+
+    // no punctuation for too long, cut at the last space or else anywhere
+    if (utf8_length(s, 0, s.size()) >= 2 * splitter->max_chars)
+    {
+        size_t cut = s.find_last_of(' ');
+        if (cut == std::string::npos || cut == 0)
+        {
+            // keep a character that is not complete yet
+            cut = s.size();
+            size_t lead = cut - 1;
+            while (lead > 0 && ((unsigned char)s[lead] & 0xc0) == 0x80)
+            {
+                lead--;
+            }
+            unsigned char c = s[lead];
+            size_t need = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : c >= 0xc0 ? 2 : 1;
+            if (lead + need > cut)
+            {
+                cut = lead;
+            }
+        }
+        emit(splitter, cut, out);
+    }
+}
+
+void sentence_splitter_flush(sentence_splitter_t *splitter, std::vector<std::string> &out)
+{
+    emit(splitter, splitter->pending.size(), out);
+}
+
+void assistant_default_options(assistant_options_t *opts)
+{
+    opts->min_first_chars = DEFAULT_MIN_FIRST_CHARS;
+    opts->max_chars = DEFAULT_MAX_CHARS;
+    opts->callback = NULL;
+    opts->userdata = NULL;
+}
+
+int assistant_init(assistant_t *assistant, asr_backend_t *asr, llm_backend_t *llm, tts_backend_t *tts,
+                   const assistant_options_t *opts)
+{
+    if (asr == NULL || llm == NULL || tts == NULL || opts == NULL)
+    {
+        printf("assistant_init: missing backend\n");
+        return -1;
+    }
+    assistant->asr = asr;
+    assistant->llm = llm;
+    assistant->tts = tts;
+    assistant->opts = *opts;
+    return 0;
+}
+
+static int on_audio(const float *data, int num_samples, void *userdata)
+{
+    turn_state_t *turn = (turn_state_t *)userdata;
+    if (!turn->first_audio)
+    {
+        turn->stats->first_audio_ms = elapsed_ms(turn->start);
+        turn->first_audio = true;
+    }
+    turn->num_samples += num_samples;
+    const assistant_options_t *opts = &turn->assistant->opts;
+    return opts->callback != NULL ? opts->callback(data, num_samples, opts->userdata) : 0;
+}
+
+static void tts_thread(turn_state_t *turn)
+{
+    tts_backend_t *tts = turn->assistant->tts;
+    sentence_queue_t *queue = &turn->queue;
+    while (true)
+    {
+        std::string sentence;
+        {
+            std::unique_lock<std::mutex> lk(queue->lock);
+            queue->cond.wait(lk, [&] { return queue->done || !queue->sentences.empty(); });
+            if (queue->sentences.empty())
+            {
+                return;
+            }
+            sentence = queue->sentences.front();
+            queue->sentences.pop_front();
+        }
+        if (tts->synthesize(tts->ctx, sentence.c_str(), on_audio, turn) != 0)
+        {
+            printf("tts fail! sentence=%s\n", sentence.c_str());
+            std::lock_guard<std::mutex> lk(queue->lock);
+            queue->failed = true;
+            queue->sentences.clear();
+            return;
+        }
+    }
+}
+
+static bool queue_sentences(turn_state_t *turn, std::vector<std::string> &sentences)
+{
+    if (sentences.empty())
+    {
+        return true;
+    }
+    if (turn->stats->sentences == 0)
+    {
+        turn->stats->first_sentence_ms = elapsed_ms(turn->start);
+    }
+    turn->stats->sentences += sentences.size();
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lk(turn->queue.lock);
+        failed = turn->queue.failed;
+        if (!failed)
+        {
+            turn->queue.sentences.insert(turn->queue.sentences.end(), sentences.begin(), sentences.end());
+        }
+    }
+    turn->queue.cond.notify_one();
+    sentences.clear();
+    return !failed;
+}
+
+static int on_text(const char *text, void *userdata)
+{
+    turn_state_t *turn = (turn_state_t *)userdata;
+    if (!turn->first_token)
+    {
+        turn->stats->first_token_ms = elapsed_ms(turn->start);
+        turn->first_token = true;
+    }
+    turn->stats->reply += text;
+    printf("%s", text);
+    fflush(stdout);
+
+    std::vector<std::string> sentences;
+    sentence_splitter_push(&turn->splitter, text, sentences);
+    return queue_sentences(turn, sentences) ? 0 : -1;
+}
+
+int assistant_run_turn(assistant_t *assistant, const char *audio_path, const char *reference,
+                       assistant_turn_stats_t *stats)
+{
+    stats->transcript.clear();
+    stats->reply.clear();
+    stats->asr_ms = stats->first_token_ms = stats->first_sentence_ms = stats->first_audio_ms = 0;
+    stats->llm_ms = stats->total_ms = stats->audio_s = 0;
+    stats->sentences = 0;
+    stats->ok = false;
+
+    turn_state_t turn;
+    turn.assistant = assistant;
+    turn.start = std::chrono::steady_clock::now();
+    turn.stats = stats;
+    sentence_splitter_init(&turn.splitter, assistant->opts.min_first_chars, assistant->opts.max_chars);
+    turn.queue.done = false;
+    turn.queue.failed = false;
+    turn.first_token = false;
+    turn.first_audio = false;
+    turn.num_samples = 0;
+
+    asr_backend_t *asr = assistant->asr;
+    if (asr->transcribe(asr->ctx, audio_path, reference, stats->transcript) != 0)
+    {
+        printf("asr fail! audio_path=%s\n", audio_path);
+        return -1;
+    }
+    stats->asr_ms = elapsed_ms(turn.start);
+    printf("user: %s\nassistant: ", stats->transcript.c_str());
+    fflush(stdout);
+    if (stats->transcript.empty())
+    {
+        printf("(no speech)\n");
+        stats->ok = true;
+        return 0;
+    }
+
+    // the TTS thread speaks while the LLM is still generating
+    std::thread tts(tts_thread, &turn);
+    llm_backend_t *llm = assistant->llm;
+    int ret = llm->generate(llm->ctx, stats->transcript.c_str(), on_text, &turn);
+    stats->llm_ms = elapsed_ms(turn.start);
+    printf("\n");
+
+    std::vector<std::string> sentences;
+    sentence_splitter_flush(&turn.splitter, sentences);
+    queue_sentences(&turn, sentences);
+    {
+        std::lock_guard<std::mutex> lk(turn.queue.lock);
+        turn.queue.done = true;
+    }
+    turn.queue.cond.notify_one();
+    tts.join();
+
+    stats->total_ms = elapsed_ms(turn.start);
+    stats->audio_s = (float)turn.num_samples / assistant->tts->sample_rate;
+    if (ret != 0)
+    {
+        printf("llm fail! ret=%d\n", ret);
+        return -1;
+    }
+    stats->ok = !turn.queue.failed;
+    return stats->ok ? 0 : -1;
+}
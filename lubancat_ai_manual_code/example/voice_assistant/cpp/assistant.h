@@ -0,0 +1,87 @@
+#ifndef _VOICE_ASSISTANT_ASSISTANT_H_
+#define _VOICE_ASSISTANT_ASSISTANT_H_
+
+#include <string>
+#include <vector>
+
+#include "backends.h"
+
+/*
+ * Speech in, speech out in one process. A turn runs the ASR on the utterance, then
+ * the LLM; its tokens are cut into sentences as they arrive and every sentence goes
+ * to a TTS thread at once, so the first sentence is spoken while the rest of the
+ * reply is still being generated. The audio reaches the sink sentence by sentence.
+ */
+
+typedef struct
+{
+    int min_first_chars;    // the first sentence of a reply is cut at a comma once it is this long
+    int max_chars;          // longer sentences are cut at a comma, then at a space
+    backend_audio_callback_t callback;      // audio sink, called from the TTS thread
+    void *userdata;
+} assistant_options_t;
+
+// all times from the end of speech, i.e. the start of assistant_run_turn
+typedef struct
+{
+    std::string transcript;
+    std::string reply;
+    float asr_ms;           // transcript ready
+    float first_token_ms;
+    float first_sentence_ms;    // first sentence handed to the TTS
+    float first_audio_ms;       // first audio out of the TTS
+    float llm_ms;           // generation finished
+    float total_ms;         // last audio out
+    float audio_s;          // length of the spoken reply
+    int sentences;
+    bool ok;
+} assistant_turn_stats_t;
+
+typedef struct
+{
+    asr_backend_t *asr;
+    llm_backend_t *llm;
+    tts_backend_t *tts;
+    assistant_options_t opts;
+} assistant_t;
+
+void assistant_default_options(assistant_options_t *opts);
+
+int assistant_init(assistant_t *assistant, asr_backend_t *asr, llm_backend_t *llm, tts_backend_t *tts,
+                   const assistant_options_t *opts);
+
+/**
+ * @brief One utterance to one spoken reply, returns once the last audio is out
+ *
+ * @param audio_path [in] The utterance, complete: its end is the end of speech
+ * @param reference [in] Transcript for the stub ASR, may be NULL
+ * @return int 0: success; -1: error
+ */
+int assistant_run_turn(assistant_t *assistant, const char *audio_path, const char *reference,
+                       assistant_turn_stats_t *stats);
+
+// streaming sentence splitter, exposed for the demo
+typedef struct
+{
+    std::string pending;
+    int emitted;            // sentences cut so far in this reply
+    int min_first_chars;
+    int max_chars;
+} sentence_splitter_t;
+
+void sentence_splitter_init(sentence_splitter_t *splitter, int min_first_chars, int max_chars);
+
+/**
+ * @brief Append generated text, complete sentences are appended to out
+ *
+ * ASCII . ! ? ; , : only end a sentence before white space, so 3.14 or 10:30 stay in
+ * one piece; a mark at the very end of the text waits for the next piece.
+ */
+void sentence_splitter_push(sentence_splitter_t *splitter, const char *text, std::vector<std::string> &out);
+
+/**
+ * @brief End of the reply, the rest goes to out as the last sentence
+ */
+void sentence_splitter_flush(sentence_splitter_t *splitter, std::vector<std::string> &out);
+
+#endif //_VOICE_ASSISTANT_ASSISTANT_H_
@@ -0,0 +1,156 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <vector>
+
+#include "backends.h"
+#include "melotts.h"
+#include "lexicon_bin.h"
+#include "tts_cache.h"
+
+typedef struct
+{
+    rknn_melotts_context_t app_ctx;
+    lexicon_bin_t lexicon;
+    int lang_id;
+    int64_t speaker_id;
+    float speed;
+    bool use_cache;
+    tts_cache_t cache;
+    std::vector<float> wav;
+} melotts_backend_t;
+
+static const std::map<std::string, int> language_id_map = {
+    {"ZH", 3}, {"JP", 1}, {"EN", 2}, {"ZH_MIX_EN", 3}, {"KR", 4}, {"SP", 5}, {"ES", 5}, {"FR", 6}};
+
+static std::vector<int64_t> intersperse(const std::vector<int> &lst, int item)
+{
+    std::vector<int64_t> result(lst.size() * 2 + 1, item);
+    for (size_t i = 1; i < result.size(); i += 2)
+    {
+        result[i] = lst[i / 2];
+    }
+    return result;
+}
+
+static int melotts_synthesize(void *ctx, const char *sentence, backend_audio_callback_t callback, void *userdata)
+{
+    melotts_backend_t *tts = (melotts_backend_t *)ctx;
+    // assistant replies repeat a lot (greetings, "sorry, ..."), those skip both models
+    std::string key;
+    if (tts->use_cache)
+    {
+        key = tts_cache_key(sentence, tts->speaker_id, tts->speed);
+        if (tts_cache_lookup(&tts->cache, key, tts->wav) == 0)
+        {
+            return callback(tts->wav.data(), tts->wav.size(), userdata) != 0 ? -1 : 0;
+        }
+    }
+
+    std::vector<int> phones_bef, tones_bef;
+    lexicon_bin_convert(&tts->lexicon, "_" + std::string(sentence) + "_", phones_bef, tones_bef);
+    std::vector<int> lang_ids_bef(phones_bef.size(), tts->lang_id);
+    std::vector<int64_t> phones = intersperse(phones_bef, 0);
+    std::vector<int64_t> tones = intersperse(tones_bef, 0);
+    std::vector<int64_t> lang_ids = intersperse(lang_ids_bef, 0);
+    int64_t phone_len = phones.size() < MAX_LENGTH ? phones.size() : MAX_LENGTH;
+    phones.resize(MAX_LENGTH, 0);
+    tones.resize(MAX_LENGTH, 0);
+    lang_ids.resize(MAX_LENGTH, 0);
+
+    tts->wav.clear();
+    int ret = inference_melotts_model(&tts->app_ctx, phones, phone_len, tones, lang_ids, tts->speaker_id, tts->speed,
+                                      true, tts->wav);
+    if (ret != 0)
+    {
+        printf("inference_melotts_model fail! ret=%d\n", ret);
+        return -1;
+    }
+    if (tts->use_cache)
+    {
+        tts_cache_insert(&tts->cache, key, tts->wav.data(), tts->wav.size());
+    }
+    return callback(tts->wav.data(), tts->wav.size(), userdata) != 0 ? -1 : 0;
+}
+
+static void melotts_release(void *ctx)
+{
+    melotts_backend_t *tts = (melotts_backend_t *)ctx;
+    release_melotts_model(&tts->app_ctx.encoder_context);
+    release_melotts_model(&tts->app_ctx.decoder_context);
+    lexicon_bin_release(&tts->lexicon);
+    if (tts->use_cache)
+    {
+        tts_cache_release(&tts->cache);
+    }
+    delete tts;
+}
+
+int melotts_backend_init(tts_backend_t *backend, const melotts_backend_options_t *opts)
+{
+    auto it = language_id_map.find(opts->language);
+    if (it == language_id_map.end())
+    {
+        printf("melotts: unknown language %s\n", opts->language);
+        return -1;
+    }
+
+    melotts_backend_t *tts = new melotts_backend_t();
+    tts->lang_id = it->second;
+    tts->speaker_id = opts->speaker_id;
+    tts->speed = opts->speed;
+    tts->use_cache = false;
+
+    if (lexicon_bin_load(LEXICON_BIN_FILE, &tts->lexicon) != 0)
+    {
+        printf("%s not found, compiling %s\n", LEXICON_BIN_FILE, LEXICON_ZH_FILE);
+        std::vector<uint8_t> blob;
+        if (lexicon_bin_build(LEXICON_ZH_FILE, TOKENS_ZH_FILE, blob) != 0 ||
+            lexicon_bin_open_memory(blob, &tts->lexicon) != 0)
+        {
+            printf("load lexicon fail!\n");
+            melotts_release(tts);
+            return -1;
+        }
+    }
+    int ret = init_melotts_model(opts->encoder_path, &tts->app_ctx.encoder_context);
+    if (ret == 0)
+    {
+        ret = init_melotts_model(opts->decoder_path, &tts->app_ctx.decoder_context);
+    }
+    if (ret != 0)
+    {
+        printf("init_melotts_model fail! ret=%d\n", ret);
+        melotts_release(tts);
+        return -1;
+    }
+    if (opts->cache_mb > 0)
+    {
+        if (tts_cache_init(&tts->cache, opts->cache_dir, (size_t)opts->cache_mb << 20) != 0)
+        {
+            printf("tts_cache_init fail! cache_dir=%s\n", opts->cache_dir);
+            melotts_release(tts);
+            return -1;
+        }
+        tts->use_cache = true;
+    }
+
+    backend->ctx = tts;
+    backend->sample_rate = SAMPLE_RATE;
+    backend->synthesize = melotts_synthesize;
+    backend->release = melotts_release;
+    return 0;
+}
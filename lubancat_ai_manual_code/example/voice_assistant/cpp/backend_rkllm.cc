@@ -0,0 +1,122 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "backends.h"
+#include "rkllm.h"
+
+// Qwen chat template, as in the rkllm demo
+#define PROMPT_PREFIX "<|im_start|>user\n"
+#define PROMPT_POSTFIX "<|im_end|>\n<|im_start|>assistant\n"
+#define DEFAULT_SYSTEM_PROMPT \
+    "<|im_start|>system\nYou are a voice assistant. Answer in a few short spoken sentences, no lists or markdown.<|im_end|>\n"
+
+typedef struct
+{
+    LLMHandle handle;
+} rkllm_backend_t;
+
+// userdata of one rkllm_run
+typedef struct
+{
+    backend_text_callback_t callback;
+    void *userdata;
+    bool stopped;           // the callback asked to stop, the rest of the reply is dropped
+    bool failed;
+} rkllm_job_t;
+
+static int rkllm_result_callback(RKLLMResult *result, void *userdata, LLMCallState state)
+{
+    rkllm_job_t *job = (rkllm_job_t *)userdata;
+    if (job == NULL)
+    {
+        return 0;
+    }
+    if (state == RKLLM_RUN_ERROR)
+    {
+        job->failed = true;
+    }
+    else if (state == RKLLM_RUN_NORMAL && result->text != NULL && !job->stopped)
+    {
+        job->stopped = job->callback(result->text, job->userdata) != 0;
+    }
+    return 0;
+}
+
+static int rkllm_generate(void *ctx, const char *prompt, backend_text_callback_t callback, void *userdata)
+{
+    rkllm_backend_t *llm = (rkllm_backend_t *)ctx;
+    RKLLMInput input;
+    memset(&input, 0, sizeof(RKLLMInput));
+    input.input_type = RKLLM_INPUT_PROMPT;
+    input.role = "user";
+    input.prompt_input = (char *)prompt;
+
+    RKLLMInferParam infer_params;
+    memset(&infer_params, 0, sizeof(RKLLMInferParam));
+    infer_params.mode = RKLLM_INFER_GENERATE;
+    infer_params.keep_history = 0;
+
+    rkllm_job_t job;
+    job.callback = callback;
+    job.userdata = userdata;
+    job.stopped = false;
+    job.failed = false;
+    int ret = rkllm_run(llm->handle, &input, &infer_params, &job);
+    if (ret != 0 || job.failed)
+    {
+        printf("rkllm_run fail! ret=%d\n", ret);
+        return -1;
+    }
+    return 0;
+}
+
+static void rkllm_release(void *ctx)
+{
+    rkllm_backend_t *llm = (rkllm_backend_t *)ctx;
+    rkllm_destroy(llm->handle);
+    delete llm;
+}
+
+int rkllm_backend_init(llm_backend_t *backend, const rkllm_backend_options_t *opts)
+{
+    RKLLMParam param = rkllm_createDefaultParam();
+    param.model_path = opts->model_path;
+    param.top_k = 1;
+    param.top_p = 0.95;
+    param.temperature = 0.8;
+    param.repeat_penalty = 1.1;
+    param.max_new_tokens = opts->max_new_tokens;
+    param.max_context_len = opts->max_context_len;
+    param.skip_special_token = true;
+    // the SenseVoice and MeloTTS contexts are in iommu domain 0
+    param.extend_param.base_domain_id = 1;
+    param.extend_param.embed_flash = 1;
+
+    rkllm_backend_t *llm = new rkllm_backend_t;
+    int ret = rkllm_init(&llm->handle, &param, rkllm_result_callback);
+    if (ret != 0)
+    {
+        printf("rkllm init fail! ret=%d model_path=%s\n", ret, opts->model_path);
+        delete llm;
+        return -1;
+    }
+    rkllm_set_chat_template(llm->handle, opts->system_prompt != NULL ? opts->system_prompt : DEFAULT_SYSTEM_PROMPT,
+                            PROMPT_PREFIX, PROMPT_POSTFIX);
+
+    backend->ctx = llm;
+    backend->generate = rkllm_generate;
+    backend->release = rkllm_release;
+    return 0;
+}
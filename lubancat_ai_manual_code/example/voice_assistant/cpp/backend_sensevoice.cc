@@ -0,0 +1,137 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "backends.h"
+#include "sensevoice.h"
+#include "audio_utils.h"
+#include "vad.h"
+
+typedef struct
+{
+    rknn_sensevoice_context_t app_ctx;
+    VocabEntry vocab[VOCAB_LEN];
+    CMVNData cmvn_data;
+    vad_options_t vad_opts;
+    int language;
+    int text_norm;
+    std::vector<float> input_data;
+} sensevoice_backend_t;
+
+static int sensevoice_transcribe(void *ctx, const char *audio_path, const char *reference, std::string &text)
+{
+    sensevoice_backend_t *asr = (sensevoice_backend_t *)ctx;
+    audio_buffer_t audio;
+    memset(&audio, 0, sizeof(audio_buffer_t));
+    int ret = read_audio(audio_path, &audio);
+    if (ret != 0)
+    {
+        printf("read audio fail! ret=%d audio_path=%s\n", ret, audio_path);
+        return -1;
+    }
+    ret = convert_audio(&audio, SAMPLE_RATE);
+    if (ret != 0)
+    {
+        printf("convert audio fail! ret=%d\n", ret);
+        free(audio.data);
+        return -1;
+    }
+
+    // a question fits one model input, longer audio is cut at its pauses
+    std::vector<vad_segment_t> segments;
+    if (audio.num_frames <= CHUNK_LENGTH * SAMPLE_RATE)
+    {
+        segments.push_back({0, audio.num_frames});
+    }
+    else if (vad_segment_audio(audio.data, audio.num_frames, SAMPLE_RATE, &asr->vad_opts, segments) != 0)
+    {
+        free(audio.data);
+        return -1;
+    }
+
+    text.clear();
+    for (size_t i = 0; i < segments.size() && ret == 0; i++)
+    {
+        audio_buffer_t segment = audio;
+        segment.data = audio.data + segments[i].start;
+        segment.num_frames = segments[i].end - segments[i].start;
+        int length;
+        std::vector<std::string> pieces;
+        audio_preprocess(&segment, length, asr->cmvn_data, asr->input_data);
+        ret = run_sensevoice(&asr->app_ctx, asr->input_data, length, asr->language, asr->text_norm, asr->vocab, pieces);
+        for (const auto &piece : pieces)
+        {
+            text += piece;
+        }
+    }
+    free(audio.data);
+    if (ret != 0)
+    {
+        printf("run_sensevoice fail! ret=%d\n", ret);
+        return -1;
+    }
+    size_t b = text.find_first_not_of(' ');
+    text = b == std::string::npos ? "" : text.substr(b);
+    return 0;
+}
+
+static void sensevoice_release(void *ctx)
+{
+    sensevoice_backend_t *asr = (sensevoice_backend_t *)ctx;
+    release_sensevoice_model(&asr->app_ctx);
+    for (int i = 0; i < VOCAB_LEN; ++i)
+    {
+        if (asr->vocab[i].token != NULL)
+        {
+            free(asr->vocab[i].token);
+        }
+    }
+    delete asr;
+}
+
+int sensevoice_backend_init(asr_backend_t *backend, const sensevoice_backend_options_t *opts)
+{
+    sensevoice_backend_t *asr = new sensevoice_backend_t();
+    asr->language = opts->language;
+    asr->text_norm = opts->text_norm;
+    vad_default_options(&asr->vad_opts);
+
+    if (load_cmvn(opts->cmvn_path, asr->cmvn_data) != 0)
+    {
+        printf("load_cmvn fail! cmvn_path=%s\n", opts->cmvn_path);
+        sensevoice_release(asr);
+        return -1;
+    }
+    if (read_vocab(opts->tokens_path, asr->vocab) != 0)
+    {
+        printf("read vocab fail! vocab_path=%s\n", opts->tokens_path);
+        sensevoice_release(asr);
+        return -1;
+    }
+    int ret = init_sensevoice_model(opts->model_path, &asr->app_ctx);
+    if (ret != 0)
+    {
+        printf("init_sensevoice_model fail! ret=%d model_path=%s\n", ret, opts->model_path);
+        sensevoice_release(asr);
+        return -1;
+    }
+
+    backend->ctx = asr;
+    backend->transcribe = sensevoice_transcribe;
+    backend->release = sensevoice_release;
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "backends.h"
+
+#define ASR_STUB_MS 120.0f
+#define TTS_STUB_MS 60.0f
+#define TTS_STUB_RTF 0.15f
+#define STUB_CJK_CHAR_S 0.22f       // speaking time of one CJK character
+#define STUB_ASCII_CHAR_S 0.07f
+#define STUB_CHUNK_S 0.5f           // audio goes out in chunks like the decoder windows
+
+typedef struct
+{
+    float latency_ms;
+} stub_asr_t;
+
+typedef struct
+{
+    int sample_rate;
+    float latency_ms;
+    float rtf;
+} stub_tts_t;
+
+static float env_float(const char *name, float def)
+{
+    const char *v = getenv(name);
+    return v != NULL ? (float)atof(v) : def;
+}
+
+static void sleep_ms(float ms)
+{
+    if (ms > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds((long long)(ms * 1000)));
+    }
+}
+
+static int stub_transcribe(void *ctx, const char * /* audio_path */, const char *reference, std::string &text)
+{
+    stub_asr_t *asr = (stub_asr_t *)ctx;
+    sleep_ms(asr->latency_ms);
+    text = reference != NULL ? reference : "";
+    return 0;
+}
+
+static int stub_synthesize(void *ctx, const char *sentence, backend_audio_callback_t callback, void *userdata)
+{
+    stub_tts_t *tts = (stub_tts_t *)ctx;
+    float seconds = 0;
+    for (const char *p = sentence; *p != '\0'; p++)
+    {
+        unsigned char c = *p;
+        if ((c & 0xc0) == 0xc0)
+        {
+            seconds += STUB_CJK_CHAR_S;
+        }
+        else if (c < 0x80)
+        {
+            seconds += STUB_ASCII_CHAR_S;
+        }
+    }
+
+    // encoder first, then one decoder window after the other
+    sleep_ms(tts->latency_ms);
+    int total = (int)(seconds * tts->sample_rate);
+    int chunk = (int)(STUB_CHUNK_S * tts->sample_rate);
+    std::vector<float> pcm(chunk);
+    for (int done = 0; done < total; done += chunk)
+    {
+        int n = total - done < chunk ? total - done : chunk;
+        sleep_ms(n * 1000.0f / tts->sample_rate * tts->rtf);
+        for (int i = 0; i < n; i++)
+        {
+            pcm[i] = 0.1f * sinf(2.0f * (float)M_PI * 220.0f * (done + i) / tts->sample_rate);
+        }
+        if (callback(pcm.data(), n, userdata) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void stub_release(void *ctx)
+{
+    free(ctx);
+}
+
+int stub_asr_backend_init(asr_backend_t *backend)
+{
+    stub_asr_t *asr = (stub_asr_t *)malloc(sizeof(stub_asr_t));
+    asr->latency_ms = env_float("ASR_STUB_MS", ASR_STUB_MS);
+    backend->ctx = asr;
+    backend->transcribe = stub_transcribe;
+    backend->release = stub_release;
+    return 0;
+}
+
+int stub_tts_backend_init(tts_backend_t *backend, int sample_rate)
+{
+    stub_tts_t *tts = (stub_tts_t *)malloc(sizeof(stub_tts_t));
+    tts->sample_rate = sample_rate;
+    tts->latency_ms = env_float("TTS_STUB_MS", TTS_STUB_MS);
+    tts->rtf = env_float("TTS_STUB_RTF", TTS_STUB_RTF);
+    backend->ctx = tts;
+    backend->sample_rate = sample_rate;
+    backend->synthesize = stub_synthesize;
+    backend->release = stub_release;
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef _VOICE_ASSISTANT_BACKENDS_H_
+#define _VOICE_ASSISTANT_BACKENDS_H_
+
+#include <string>
+
+/*
+ * The three models behind small function tables, so the pipeline does not know
+ * whether SenseVoice / RKLLM / MeloTTS or a host stub is behind them. Every backend
+ * is used from one thread at a time.
+ */
+
+/**
+ * @brief Receives generated text piece by piece
+ *
+ * @return int 0 to go on, anything else stops the generation
+ */
+typedef int (*backend_text_callback_t)(const char *text, void *userdata);
+
+/**
+ * @brief Receives mono float audio of the TTS sample rate
+ *
+ * @return int 0 to go on, anything else stops the synthesis
+ */
+typedef int (*backend_audio_callback_t)(const float *data, int num_samples, void *userdata);
+
+typedef struct
+{
+    void *ctx;
+    // audio_path: the utterance, reference: its transcript if known (used by the stub)
+    int (*transcribe)(void *ctx, const char *audio_path, const char *reference, std::string &text);
+    void (*release)(void *ctx);
+} asr_backend_t;
+
+typedef struct
+{
+    void *ctx;
+    int (*generate)(void *ctx, const char *prompt, backend_text_callback_t callback, void *userdata);
+    void (*release)(void *ctx);
+} llm_backend_t;
+
+typedef struct
+{
+    void *ctx;
+    int sample_rate;
+    int (*synthesize)(void *ctx, const char *sentence, backend_audio_callback_t callback, void *userdata);
+    void (*release)(void *ctx);
+} tts_backend_t;
+
+typedef struct
+{
+    const char *model_path;
+    const char *tokens_path;
+    const char *cmvn_path;
+    int language;           // 0 auto, 3 zh, 4 en, 11 ja, 12 ko
+    int text_norm;          // 14 with inverse text normalization, 15 without
+} sensevoice_backend_options_t;
+
+typedef struct
+{
+    const char *encoder_path;
+    const char *decoder_path;
+    const char *language;   // ZH_MIX_EN, EN, ...
+    int speaker_id;
+    float speed;
+    const char *cache_dir;  // NULL or "": memory only
+    int cache_mb;           // 0: no sentence cache
+} melotts_backend_options_t;
+
+typedef struct
+{
+    const char *model_path;
+    int max_new_tokens;
+    int max_context_len;
+    const char *system_prompt;
+} rkllm_backend_options_t;
+
+/**
+ * @brief Backends on the NPU, 0: success; -1: error
+ */
+int sensevoice_backend_init(asr_backend_t *asr, const sensevoice_backend_options_t *opts);
+int melotts_backend_init(tts_backend_t *tts, const melotts_backend_options_t *opts);
+int rkllm_backend_init(llm_backend_t *llm, const rkllm_backend_options_t *opts);
+
+/**
+ * @brief Host stubs: the ASR returns the reference transcript, the TTS returns a tone
+ *        as long as the sentence would take to speak, both sleep like the models
+ *
+ * environment: ASR_STUB_MS (default 120) per utterance, TTS_STUB_MS (default 60) per
+ * sentence, TTS_STUB_RTF (default 0.15) synthesis time per second of audio
+ */
+int stub_asr_backend_init(asr_backend_t *asr);
+int stub_tts_backend_init(tts_backend_t *tts, int sample_rate);
+
+#endif //_VOICE_ASSISTANT_BACKENDS_H_
@@ -0,0 +1,315 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*-------------------------------------------
+                Includes
+-------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "assistant.h"
+#include "backends.h"
+
+struct Args {
+    std::string turns;                  // one utterance per line: <wav_path>[\t<transcript>]
+    std::string asr = "model/sensevoice.rknn";      // or "stub"
+    std::string tokens = "model/sensevoice_tokens.txt";
+    std::string cmvn = "model/am.mvn";
+    std::string asr_language = "auto";  // zh, en, ja, ko, auto
+    std::string llm = "model/qwen.rkllm";
+    int max_new_tokens = 256;
+    int max_context_len = 1024;
+    std::string tts = "model/encoder-ZH_MIX_EN.rknn";   // or "stub"
+    std::string tts_decoder = "model/decoder-ZH_MIX_EN.rknn";
+    std::string tts_language = "ZH_MIX_EN";
+    int speaker_id = 1;
+    float speed = 1.0f;
+    int cache_mb = 16;
+    std::string cache_dir;
+    std::string output;                 // raw s16le mono PCM, a file or a FIFO read by a player
+};
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s --turns turns.txt [options]\n"
+           "\n"
+           "  --turns           One utterance per line, <wav_path>[<TAB><transcript>], the transcript is what the\n"
+           "                    stub ASR returns\n"
+           "  --asr             SenseVoice model or stub.(default: model/sensevoice.rknn)\n"
+           "  --tokens          SenseVoice tokens.(default: model/sensevoice_tokens.txt)\n"
+           "  --cmvn            SenseVoice am.mvn.(default: model/am.mvn)\n"
+           "  --asr_language    zh, en, ja, ko, auto.(default: auto)\n"
+           "  --llm             RKLLM model.(default: model/qwen.rkllm)\n"
+           "  --max_new_tokens  (default: 256)\n"
+           "  --max_context_len (default: 1024)\n"
+           "  --tts             MeloTTS encoder or stub.(default: model/encoder-ZH_MIX_EN.rknn)\n"
+           "  --tts_decoder     MeloTTS decoder.(default: model/decoder-ZH_MIX_EN.rknn)\n"
+           "  --tts_language    ZH_MIX_EN, EN, ...(default: ZH_MIX_EN)\n"
+           "  --speaker         (default: 1)\n"
+           "  --speed           (default: 1.0)\n"
+           "  --cache_mb        Sentence audio cache, 0 disables it.(default: 16)\n"
+           "  --cache_dir       Disk store of the sentence cache.(default: memory only)\n"
+           "  --output          Raw s16le mono PCM at the TTS rate, e.g. a FIFO read by\n"
+           "                    aplay -t raw -f S16_LE -r 44100 -c 1 <fifo>\n",
+           prog);
+}
+
+static int parse_args(int argc, char **argv, Args &args)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc)
+        {
+            return -1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--turns") args.turns = value;
+        else if (arg == "--asr") args.asr = value;
+        else if (arg == "--tokens") args.tokens = value;
+        else if (arg == "--cmvn") args.cmvn = value;
+        else if (arg == "--asr_language") args.asr_language = value;
+        else if (arg == "--llm") args.llm = value;
+        else if (arg == "--max_new_tokens") args.max_new_tokens = atoi(value.c_str());
+        else if (arg == "--max_context_len") args.max_context_len = atoi(value.c_str());
+        else if (arg == "--tts") args.tts = value;
+        else if (arg == "--tts_decoder") args.tts_decoder = value;
+        else if (arg == "--tts_language") args.tts_language = value;
+        else if (arg == "--speaker") args.speaker_id = atoi(value.c_str());
+        else if (arg == "--speed") args.speed = atof(value.c_str());
+        else if (arg == "--cache_mb") args.cache_mb = atoi(value.c_str());
+        else if (arg == "--cache_dir") args.cache_dir = value;
+        else if (arg == "--output") args.output = value;
+        else
+        {
+            printf("Unknown argument: %s\n", arg.c_str());
+            return -1;
+        }
+    }
+    return args.turns.empty() ? -1 : 0;
+}
+
+// the audio of every sentence goes out as soon as it is synthesized
+static int write_pcm(const float *data, int num_samples, void *userdata)
+{
+    FILE *fp = (FILE *)userdata;
+    std::vector<int16_t> pcm(num_samples);
+    for (int i = 0; i < num_samples; i++)
+    {
+        float v = data[i] * 32768.0f;
+        pcm[i] = v > 32767.0f ? 32767 : v < -32768.0f ? -32768 : (int16_t)v;
+    }
+    if (fwrite(pcm.data(), sizeof(int16_t), num_samples, fp) != (size_t)num_samples)
+    {
+        printf("write pcm fail! %s\n", strerror(errno));
+        return -1;
+    }
+    fflush(fp);
+    return 0;
+}
+
+#ifndef ASR_TTS_STUB
+static int asr_language_id(const std::string &language)
+{
+    if (language == "zh") return 3;
+    if (language == "en") return 4;
+    if (language == "ja") return 11;
+    if (language == "ko") return 12;
+    return 0;
+}
+#endif
+
+/*-------------------------------------------
+                  Main Function
+-------------------------------------------*/
+int main(int argc, char **argv)
+{
+    Args args;
+    if (parse_args(argc, argv, args) != 0)
+    {
+        usage(argv[0]);
+        return -1;
+    }
+    // a player closing the FIFO must not kill the assistant
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::string> paths, references;
+    std::ifstream in(args.turns);
+    if (!in.is_open())
+    {
+        printf("open %s fail!\n", args.turns.c_str());
+        return -1;
+    }
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+        size_t tab = line.find('\t');
+        paths.push_back(line.substr(0, tab));
+        references.push_back(tab == std::string::npos ? "" : line.substr(tab + 1));
+    }
+
+    asr_backend_t asr;
+    llm_backend_t llm;
+    tts_backend_t tts;
+    memset(&asr, 0, sizeof(asr));
+    memset(&llm, 0, sizeof(llm));
+    memset(&tts, 0, sizeof(tts));
+    assistant_t assistant;
+    assistant_options_t opts;
+    FILE *output = NULL;
+    int ret = -1;
+    int n_ok = 0;
+    float sum_first_audio = 0, max_first_audio = 0;
+
+    if (args.asr == "stub")
+    {
+        ret = stub_asr_backend_init(&asr);
+    }
+    else
+    {
+#ifdef ASR_TTS_STUB
+        printf("built with ASR_TTS_STUB, only --asr stub is available\n");
+        ret = -1;
+#else
+        sensevoice_backend_options_t asr_opts;
+        asr_opts.model_path = args.asr.c_str();
+        asr_opts.tokens_path = args.tokens.c_str();
+        asr_opts.cmvn_path = args.cmvn.c_str();
+        asr_opts.language = asr_language_id(args.asr_language);
+        asr_opts.text_norm = 15;
+        ret = sensevoice_backend_init(&asr, &asr_opts);
+#endif
+    }
+    if (ret != 0)
+    {
+        goto out;
+    }
+
+    rkllm_backend_options_t llm_opts;
+    llm_opts.model_path = args.llm.c_str();
+    llm_opts.max_new_tokens = args.max_new_tokens;
+    llm_opts.max_context_len = args.max_context_len;
+    llm_opts.system_prompt = NULL;
+    ret = rkllm_backend_init(&llm, &llm_opts);
+    if (ret != 0)
+    {
+        goto out;
+    }
+
+    if (args.tts == "stub")
+    {
+        ret = stub_tts_backend_init(&tts, 44100);
+    }
+    else
+    {
+#ifdef ASR_TTS_STUB
+        printf("built with ASR_TTS_STUB, only --tts stub is available\n");
+        ret = -1;
+#else
+        melotts_backend_options_t tts_opts;
+        tts_opts.encoder_path = args.tts.c_str();
+        tts_opts.decoder_path = args.tts_decoder.c_str();
+        tts_opts.language = args.tts_language.c_str();
+        tts_opts.speaker_id = args.speaker_id;
+        tts_opts.speed = args.speed;
+        tts_opts.cache_dir = args.cache_dir.c_str();
+        tts_opts.cache_mb = args.cache_mb;
+        ret = melotts_backend_init(&tts, &tts_opts);
+#endif
+    }
+    if (ret != 0)
+    {
+        goto out;
+    }
+
+    assistant_default_options(&opts);
+    if (!args.output.empty())
+    {
+        output = fopen(args.output.c_str(), "wb");
+        if (output == NULL)
+        {
+            printf("open %s fail! %s\n", args.output.c_str(), strerror(errno));
+            ret = -1;
+            goto out;
+        }
+        opts.callback = write_pcm;
+        opts.userdata = output;
+    }
+    ret = assistant_init(&assistant, &asr, &llm, &tts, &opts);
+    if (ret != 0)
+    {
+        goto out;
+    }
+
+    // one turn after the other, the user speaks again once the reply is out
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        assistant_turn_stats_t stats;
+        printf("\n--- turn %zu: %s\n", i, paths[i].c_str());
+        if (assistant_run_turn(&assistant, paths[i].c_str(), references[i].c_str(), &stats) != 0)
+        {
+            ret = -1;
+            continue;
+        }
+        printf("end of speech to: text %.1f ms, first token %.1f ms, first sentence %.1f ms, first audio %.1f ms, "
+               "reply done %.1f ms, audio done %.1f ms (%d sentences, %.2f s of audio)\n",
+               stats.asr_ms, stats.first_token_ms, stats.first_sentence_ms, stats.first_audio_ms, stats.llm_ms,
+               stats.total_ms, stats.sentences, stats.audio_s);
+        if (stats.sentences > 0)
+        {
+            n_ok++;
+            sum_first_audio += stats.first_audio_ms;
+            max_first_audio = stats.first_audio_ms > max_first_audio ? stats.first_audio_ms : max_first_audio;
+        }
+    }
+    if (n_ok > 0)
+    {
+        printf("\n%d turns, end of speech to first audio avg %.1f ms max %.1f ms\n", n_ok, sum_first_audio / n_ok,
+               max_first_audio);
+    }
+
+out:
+    if (output != NULL)
+    {
+        fclose(output);
+    }
+    if (tts.release != NULL)
+    {
+        tts.release(tts.ctx);
+    }
+    if (llm.release != NULL)
+    {
+        llm.release(llm.ctx);
+    }
+    if (asr.release != NULL)
+    {
+        asr.release(asr.ctx);
+    }
+    return ret;
+}
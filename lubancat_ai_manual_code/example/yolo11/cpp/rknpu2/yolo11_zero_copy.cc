@@ -21,6 +21,7 @@
 #include "common.h"
 #include "file_utils.h"
 #include "image_utils.h"
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr *attr) {
     char dims[128] = {0};
@@ -250,6 +251,7 @@ int release_yolo11_model(rknn_app_context_t *app_ctx) {
 }
 
 int inference_yolo11_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results) {
+    PROFILE_SCOPE("inference_yolo11_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -286,8 +288,10 @@ int inference_yolo11_model(rknn_app_context_t *app_ctx, image_buffer_t *img, obj
     }
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0) {
         printf("rknn_run fail! ret=%d\n", ret);
         return -1;
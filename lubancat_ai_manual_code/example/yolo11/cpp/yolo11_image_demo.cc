@@ -21,6 +21,7 @@
 #include <string.h>
 
 #include "yolo11.h"
+#include "rknn_perf.h"
 #include "image_utils.h"
 #include "file_utils.h"
 #include "image_drawing.h"
@@ -34,22 +35,33 @@
 -------------------------------------------*/
 int main(int argc, char **argv)
 {
-    if (argc != 3)
+    if (argc != 3 && !((argc == 4 || argc == 5) && strcmp(argv[3], "profile") == 0))
     {
-        printf("%s <model_path> <image_path>\n", argv[0]);
+        printf("%s <model_path> <image_path> [profile [runs]]\n", argv[0]);
+        printf("profile: per layer NPU time over the runs (default %d), NPU run vs end-to-end time\n",
+               RKNN_PERF_DEFAULT_RUNS);
         return -1;
     }
 
     const char *model_path = argv[1];
     const char *image_path = argv[2];
+    bool profile = argc >= 4;
+    int profile_runs = argc == 5 ? atoi(argv[4]) : RKNN_PERF_DEFAULT_RUNS;
 
     int ret;
+    rknn_perf_t perf;
     rknn_app_context_t rknn_app_ctx;
+    memset(&perf, 0, sizeof(rknn_perf_t));
     memset(&rknn_app_ctx, 0, sizeof(rknn_app_context_t));
 
     init_post_process();
 
+#ifndef ZERO_COPY
+    ret = profile ? init_yolo11_profile_model(model_path, &rknn_app_ctx) : init_yolo11_model(model_path, &rknn_app_ctx);
+#else
+    // no layer table in this build, only the time split
     ret = init_yolo11_model(model_path, &rknn_app_ctx);
+#endif
     if (ret != 0)
     {
         printf("init_yolo11_model fail! ret=%d model_path=%s\n", ret, model_path);
@@ -87,6 +99,19 @@ int main(int argc, char **argv)
         goto out;
     }
 
+    if (profile)
+    {
+        // the run above was the warm up
+        rknn_perf_init(&perf, rknn_app_ctx.rknn_ctx);
+        for (int i = 0; i < profile_runs && ret == 0; i++)
+        {
+            rknn_perf_frame_begin(&perf);
+            ret = inference_yolo11_model(&rknn_app_ctx, &src_image, &od_results);
+            rknn_perf_frame_end(&perf);
+        }
+        rknn_perf_print(&perf, 20);
+    }
+
     // 画框和概率
     char text[256];
     for (int i = 0; i < od_results.count; i++)
@@ -111,6 +136,7 @@ int main(int argc, char **argv)
 
 out:
     deinit_post_process();
+    rknn_perf_release(&perf);
 
     ret = release_yolo11_model(&rknn_app_ctx);
     if (ret != 0)
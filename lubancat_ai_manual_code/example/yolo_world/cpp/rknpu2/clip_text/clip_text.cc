@@ -19,6 +19,7 @@
 #include "common.h"
 #include "file_utils.h"
 #include "clip_tokenizer.h"
+#include "stage_profiler.h"
 
 
 static void dump_tensor_attr(rknn_tensor_attr* attr)
@@ -123,6 +124,7 @@ int release_clip_text_model(rknn_clip_context* clip_ctx)
 
 int inference_clip_text_model(rknn_clip_context* clip_ctx, char** input_texts, int text_num, float text_output[])
 {
+    PROFILE_SCOPE("inference_clip_text_model");
     int ret;
     int* tokens;
     rknn_input inputs[clip_ctx->io_num.n_input];
@@ -182,8 +184,10 @@ int inference_clip_text_model(rknn_clip_context* clip_ctx, char** input_texts, i
         }
 
         // Run
-        // printf("rknn_run_%d\n", i+1);
-        ret = rknn_run(clip_ctx->rknn_ctx, NULL);
+        {
+            PROFILE_SCOPE("rknn_run");
+            ret = rknn_run(clip_ctx->rknn_ctx, NULL);
+        }
         if (ret < 0)
         {
             printf("rknn_run fail! ret=%d\n", ret);
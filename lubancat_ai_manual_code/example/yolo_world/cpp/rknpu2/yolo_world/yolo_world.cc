@@ -22,6 +22,7 @@
 #include "common.h"
 #include "file_utils.h"
 #include "image_utils.h"
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr* attr)
 {
@@ -152,6 +153,7 @@ int release_yolo_world_model(rknn_app_context_t *app_ctx)
 
 int inference_yolo_world_model(rknn_app_context_t *app_ctx, image_buffer_t *img, float* text_input, int text_size, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("inference_yolo_world_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -213,8 +215,10 @@ int inference_yolo_world_model(rknn_app_context_t *app_ctx, image_buffer_t *img,
     }
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
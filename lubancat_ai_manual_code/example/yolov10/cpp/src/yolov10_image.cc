@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "yolov10.h"
+#include "rknn_perf.h"
 #include "image_utils.h"
 #include "file_utils.h"
 #include "image_drawing.h"
@@ -30,24 +31,30 @@
 -------------------------------------------*/
 int main(int argc, char **argv)
 {
-    if (argc != 3)
+    if (argc != 3 && !((argc == 4 || argc == 5) && strcmp(argv[3], "profile") == 0))
     {
-        printf("%s <model_path> <image_path>\n", argv[0]);
+        printf("%s <model_path> <image_path> [profile [runs]]\n", argv[0]);
+        printf("profile: per layer NPU time over the runs (default %d), NPU run vs end-to-end time\n",
+               RKNN_PERF_DEFAULT_RUNS);
         return -1;
     }
 
     const char *model_path = argv[1];
     const char *image_path = argv[2];
+    bool profile = argc >= 4;
+    int profile_runs = argc == 5 ? atoi(argv[4]) : RKNN_PERF_DEFAULT_RUNS;
 
     int ret;
     TIMER print_out;
+    rknn_perf_t perf;
     rknn_app_context_t rknn_app_ctx;
+    memset(&perf, 0, sizeof(rknn_perf_t));
     memset(&rknn_app_ctx, 0, sizeof(rknn_app_context_t));
 
     init_post_process();
 
 #ifndef ENABLE_ZERO_COPY
-    ret = init_yolov10_model(model_path, &rknn_app_ctx);
+    ret = profile ? init_yolov10_profile_model(model_path, &rknn_app_ctx) : init_yolov10_model(model_path, &rknn_app_ctx);
 #else
     ret = init_yolov10_zero_copy_model(model_path, &rknn_app_ctx);
 #endif
@@ -85,6 +92,23 @@ int main(int argc, char **argv)
     print_out.tok();
     print_out.print_time("inference_yolov10_model");
 
+    if (profile)
+    {
+        // the run above was the warm up; the zero copy build has no layer table, only the time split
+        rknn_perf_init(&perf, rknn_app_ctx.rknn_ctx);
+        for (int i = 0; i < profile_runs && ret == 0; i++)
+        {
+            rknn_perf_frame_begin(&perf);
+#ifndef ENABLE_ZERO_COPY
+            ret = inference_yolov10_model(&rknn_app_ctx, &src_image, &od_results);
+#else
+            ret = inference_yolov10_zero_copy_model(&rknn_app_ctx, &src_image, &od_results);
+#endif
+            rknn_perf_frame_end(&perf);
+        }
+        rknn_perf_print(&perf, 20);
+    }
+
     // 画框和概率
     char text[256];
     for (int i = 0; i < od_results.count; i++)
@@ -109,6 +133,7 @@ int main(int argc, char **argv)
 
 out:
     deinit_post_process();
+    rknn_perf_release(&perf);
 
 #ifndef ENABLE_ZERO_COPY
     ret = release_yolov10_model(&rknn_app_ctx);
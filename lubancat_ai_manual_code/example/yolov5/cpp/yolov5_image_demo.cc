@@ -25,6 +25,7 @@
 #include "file_utils.h"
 #include "image_drawing.h"
 #include "easy_timer.h"
+#include "rknn_perf.h"
 
 #if defined(RV1106_1103) 
     #include "dma_alloc.hpp"
@@ -35,24 +36,30 @@
 -------------------------------------------*/
 int main(int argc, char **argv)
 {
-    if (argc != 3)
+    if (argc != 3 && !((argc == 4 || argc == 5) && strcmp(argv[3], "profile") == 0))
     {
-        printf("%s <model_path> <image_path>\n", argv[0]);
+        printf("%s <model_path> <image_path> [profile [runs]]\n", argv[0]);
+        printf("profile: per layer NPU time over the runs (default %d), NPU run vs end-to-end time\n",
+               RKNN_PERF_DEFAULT_RUNS);
         return -1;
     }
 
     const char *model_path = argv[1];
     const char *image_path = argv[2];
+    bool profile = argc >= 4;
+    int profile_runs = argc == 5 ? atoi(argv[4]) : RKNN_PERF_DEFAULT_RUNS;
 
     int ret;
     TIMER timer;
+    rknn_perf_t perf;
     rknn_app_context_t rknn_app_ctx;
+    memset(&perf, 0, sizeof(rknn_perf_t));
     memset(&rknn_app_ctx, 0, sizeof(rknn_app_context_t));
 
     init_post_process();
 
 #ifndef ENABLE_ZERO_COPY
-    ret = init_yolov5_model(model_path, &rknn_app_ctx);
+    ret = profile ? init_yolov5_profile_model(model_path, &rknn_app_ctx) : init_yolov5_model(model_path, &rknn_app_ctx);
 #else
     ret = init_yolov5_zero_copy_model(model_path, &rknn_app_ctx);
 #endif
@@ -99,6 +106,23 @@ int main(int argc, char **argv)
     timer.tok();
     timer.print_time("inference_yolov5_model");
 
+    if (profile)
+    {
+        // the run above was the warm up; the zero copy build has no layer table, only the time split
+        rknn_perf_init(&perf, rknn_app_ctx.rknn_ctx);
+        for (int i = 0; i < profile_runs && ret == 0; i++)
+        {
+            rknn_perf_frame_begin(&perf);
+#ifndef ENABLE_ZERO_COPY
+            ret = inference_yolov5_model(&rknn_app_ctx, &src_image, &od_results);
+#else
+            ret = inference_yolov5_zero_copy_model(&rknn_app_ctx, &src_image, &od_results);
+#endif
+            rknn_perf_frame_end(&perf);
+        }
+        rknn_perf_print(&perf, 20);
+    }
+
     // 画框和概率
     char text[256];
     for (int i = 0; i < od_results.count; i++)
@@ -123,6 +147,7 @@ int main(int argc, char **argv)
 
 out:
     deinit_post_process();
+    rknn_perf_release(&perf);
 
 #ifndef ENABLE_ZERO_COPY
     ret = release_yolov5_model(&rknn_app_ctx);
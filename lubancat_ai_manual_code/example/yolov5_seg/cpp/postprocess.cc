@@ -26,6 +26,7 @@
 #include "dma_alloc.cpp"
 #include "drm_alloc.cpp"
 #include "Float16.h"
+#include "stage_profiler.h"
 
 #include <set>
 #include <vector>
@@ -699,6 +700,7 @@ static int process_fp32(rknn_output *all_input, int input_id, int *anchor, int g
 
 int post_process(rknn_app_context_t *app_ctx, rknn_output *outputs, letterbox_t *letter_box, float conf_threshold, float nms_threshold, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("post_process");
 
     std::vector<float> filterBoxes;
     std::vector<float> objProbs;
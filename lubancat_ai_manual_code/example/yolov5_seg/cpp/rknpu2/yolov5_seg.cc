@@ -6,6 +6,7 @@
 #include "yolov5_seg.h"
 #include "image_utils.h"
 #include "dma_alloc.h"
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr *attr)
 {
@@ -164,6 +165,7 @@ int release_yolov5_seg_model(rknn_app_context_t *app_ctx)
 
 int inference_yolov5_seg_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("inference_yolov5_seg_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -232,8 +234,10 @@ int inference_yolov5_seg_model(rknn_app_context_t *app_ctx, image_buffer_t *img,
     }
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -471,6 +475,7 @@ int init_yolov5seg_zero_copy_model(const char *model_path, rknn_app_context_t *a
 
 int inference_yolov5seg_zero_copy_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("inference_yolov5seg_zero_copy_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -526,8 +531,10 @@ int inference_yolov5seg_zero_copy_model(rknn_app_context_t *app_ctx, image_buffe
     memcpy(app_ctx->input_mems[0]->virt_addr, dst_img.virt_addr, app_ctx->input_attrs[0].size);
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -25,6 +25,7 @@
 #include "file_utils.h"
 #include "image_utils.h"
 #include "dma_alloc.cpp"
+#include "stage_profiler.h"
 
 const int anchor[3][6] = {{4,5,  8,10,  13,16},
                           {23,29,  43,55,  73,105},
@@ -261,6 +262,7 @@ static int process_fp32(float *input, int *anchor, int grid_h, int grid_w, int h
 
 int post_process(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box, float conf_threshold, float nms_threshold, yolov5face_result_list *od_results)
 {
+    PROFILE_SCOPE("post_process");
     rknn_output *_outputs = (rknn_output *)outputs;
     std::vector<float> filterBoxes;
     std::vector<float> objProbs;
@@ -470,6 +472,7 @@ int release_yolov5face_model(rknn_app_context_t *app_ctx)
 
 int inference_yolov5face_model(rknn_app_context_t *app_ctx, image_buffer_t *img, yolov5face_result_list *od_results)
 {
+    PROFILE_SCOPE("inference_yolov5face_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -537,8 +540,10 @@ int inference_yolov5face_model(rknn_app_context_t *app_ctx, image_buffer_t *img,
     }
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -15,6 +15,8 @@
 #define _RKNN_DEMO_YOLOV8_H_
 
 #include "rknn_api.h"
+#include "image_utils.h"
+#include "rknn_async.h"
 
 typedef struct {
     rknn_context rknn_ctx;
@@ -25,6 +27,11 @@ typedef struct {
     int model_width;
     int model_height;
     bool is_quant;
+
+    // init_yolov8_async_model only
+    rknn_async_t async;
+    letterbox_t async_letter_box[RKNN_ASYNC_SLOTS];
+    image_buffer_t async_input;     // letterboxed frame, reused
 } rknn_app_context_t;
 
 #include "postprocess.h"
@@ -36,4 +43,26 @@ int release_yolov8_model(rknn_app_context_t* app_ctx);
 
 int inference_yolov8_model(rknn_app_context_t* app_ctx, image_buffer_t* img, object_detect_result_list* od_results);
 
+/**
+ * @brief Context with RKNN_FLAG_COLLECT_PERF_MASK for rknn_perf.h, release it with release_yolov8_model
+ */
+int init_yolov8_profile_model(const char *model_path, rknn_app_context_t *app_ctx);
+
+/**
+ * @brief Context with RKNN_FLAG_ASYNC_MASK, release it with release_yolov8_model
+ */
+int init_yolov8_async_model(const char *model_path, rknn_app_context_t *app_ctx);
+
+/**
+ * @brief Queue img on the NPU and post process the result of an earlier frame meanwhile
+ *
+ * @param img [in] Next frame, NULL at the end of the stream to get the last result
+ * @param od_results [out] Detections of frame frame_id
+ * @param frame_id [out] Frame the detections belong to, app_ctx->async.submitted after the call is the id
+ *                 of img; 0: no result this time (first frames, or nothing left at the end)
+ * @return int 0: success; <0: error
+ */
+int inference_yolov8_async_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results,
+                                 uint64_t *frame_id);
+
 #endif //_RKNN_DEMO_YOLOV8_H_
\ No newline at end of file
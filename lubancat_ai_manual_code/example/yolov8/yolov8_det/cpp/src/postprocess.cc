@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "yolov8.h"
+#include "stage_profiler.h"
 
 #include <math.h>
 #include <stdint.h>
@@ -353,6 +354,7 @@ static int process_fp32(float *box_tensor, float *score_tensor, float *score_sum
 
 int post_process(rknn_app_context_t *app_ctx, rknn_output *outputs, letterbox_t *letter_box, float conf_threshold, float nms_threshold, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("post_process");
     std::vector<float> filterBoxes;
     std::vector<float> objProbs;
     std::vector<int> classId;
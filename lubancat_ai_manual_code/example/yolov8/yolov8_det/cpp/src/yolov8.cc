@@ -18,6 +18,7 @@
 #include "yolov8.h"
 #include "image_utils.h"
 #include "dma_alloc.cpp"
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr *attr)
 {
@@ -50,7 +51,7 @@ static unsigned char* load_model(const char* filename, int* model_size)
     return model;
 }
 
-int init_yolov8_model(const char *model_path, rknn_app_context_t *app_ctx)
+static int init_model(const char *model_path, rknn_app_context_t *app_ctx, uint32_t flag)
 {
     int ret;
     int model_len = 0;
@@ -64,7 +65,7 @@ int init_yolov8_model(const char *model_path, rknn_app_context_t *app_ctx)
         return -1;
     }
 
-    ret = rknn_init(&ctx, model, model_len, 0, NULL);
+    ret = rknn_init(&ctx, model, model_len, flag, NULL);
     free(model);
     if (ret < 0)
     {
@@ -153,8 +154,27 @@ int init_yolov8_model(const char *model_path, rknn_app_context_t *app_ctx)
     return 0;
 }
 
+int init_yolov8_model(const char *model_path, rknn_app_context_t *app_ctx)
+{
+    return init_model(model_path, app_ctx, 0);
+}
+
+int init_yolov8_profile_model(const char *model_path, rknn_app_context_t *app_ctx)
+{
+    return init_model(model_path, app_ctx, RKNN_FLAG_COLLECT_PERF_MASK);
+}
+
 int release_yolov8_model(rknn_app_context_t *app_ctx)
 {
+    if (app_ctx->async_input.virt_addr != NULL)
+    {
+#if defined(DMA_ALLOC_DMA32)
+        dma_buf_free(app_ctx->async_input.size, &app_ctx->async_input.fd, app_ctx->async_input.virt_addr);
+#else
+        free(app_ctx->async_input.virt_addr);
+#endif
+        app_ctx->async_input.virt_addr = NULL;
+    }
     if (app_ctx->rknn_ctx != 0)
     {
         rknn_destroy(app_ctx->rknn_ctx);
@@ -175,6 +195,7 @@ int release_yolov8_model(rknn_app_context_t *app_ctx)
 
 int inference_yolov8_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("inference_yolov8_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -243,8 +264,10 @@ int inference_yolov8_model(rknn_app_context_t *app_ctx, image_buffer_t *img, obj
     }
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -282,4 +305,117 @@ out:
     }
 
     return ret;
-}
\ No newline at end of file
+}
+
+int init_yolov8_async_model(const char *model_path, rknn_app_context_t *app_ctx)
+{
+    int ret = init_model(model_path, app_ctx, RKNN_FLAG_ASYNC_MASK);
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    // one input buffer for all frames, rknn_inputs_set copies it
+    image_buffer_t *input = &app_ctx->async_input;
+    memset(input, 0, sizeof(image_buffer_t));
+    input->width = app_ctx->model_width;
+    input->height = app_ctx->model_height;
+    input->format = IMAGE_FORMAT_RGB888;
+    input->size = get_image_size(input);
+#if defined(DMA_ALLOC_DMA32)
+    ret = dma_buf_alloc(DMA_HEAP_DMA32_UNCACHE_PATCH, input->size, &input->fd, (void **)&input->virt_addr);
+    if (ret < 0)
+    {
+        printf("alloc dma32_heap buffer failed!\n");
+        input->virt_addr = NULL;
+        return -1;
+    }
+#else
+    input->virt_addr = (unsigned char *)malloc(input->size);
+    if (input->virt_addr == NULL)
+    {
+        printf("malloc buffer size:%d fail!\n", input->size);
+        return -1;
+    }
+#endif
+
+    rknn_async_init(&app_ctx->async, app_ctx->rknn_ctx, app_ctx->io_num.n_output);
+    return 0;
+}
+
+int inference_yolov8_async_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results,
+                                 uint64_t *frame_id)
+{
+    PROFILE_SCOPE("inference_yolov8_async_model");
+    int ret;
+    int slot;
+    rknn_input inputs[app_ctx->io_num.n_input];
+    rknn_output outputs[app_ctx->io_num.n_output];
+    int bg_color = 114;
+
+    memset(od_results, 0x00, sizeof(*od_results));
+    *frame_id = 0;
+
+    if (img != NULL)
+    {
+        // Pre Process, the letterbox is kept until the result of this frame is back
+        letterbox_t letter_box;
+        memset(&letter_box, 0, sizeof(letterbox_t));
+        ret = convert_image_with_letterbox(img, &app_ctx->async_input, &letter_box, bg_color);
+        if (ret < 0)
+        {
+            printf("convert_image_with_letterbox fail! ret=%d\n", ret);
+            return -1;
+        }
+
+        memset(inputs, 0, sizeof(inputs));
+        inputs[0].index = 0;
+        inputs[0].type = RKNN_TENSOR_UINT8;
+        inputs[0].fmt = RKNN_TENSOR_NHWC;
+        inputs[0].size = app_ctx->model_width * app_ctx->model_height * app_ctx->model_channel;
+        inputs[0].buf = app_ctx->async_input.virt_addr;
+        ret = rknn_inputs_set(app_ctx->rknn_ctx, app_ctx->io_num.n_input, inputs);
+        if (ret < 0)
+        {
+            printf("rknn_input_set fail! ret=%d\n", ret);
+            return -1;
+        }
+
+        // Run, returns once the frame is queued
+        {
+            PROFILE_SCOPE("rknn_run");
+            ret = rknn_async_run(&app_ctx->async, &slot);
+        }
+        if (ret != 0)
+        {
+            return -1;
+        }
+        app_ctx->async_letter_box[slot] = letter_box;
+    }
+    else if (!rknn_async_pending(&app_ctx->async))
+    {
+        return 0;
+    }
+    else if (rknn_async_flush(&app_ctx->async) != 0)
+    {
+        return -1;
+    }
+
+    // Get Output of an earlier frame while the NPU runs this one
+    memset(outputs, 0, sizeof(outputs));
+    for (int i = 0; i < app_ctx->io_num.n_output; i++)
+    {
+        outputs[i].index = i;
+        outputs[i].want_float = (!app_ctx->is_quant);
+    }
+    ret = rknn_async_outputs_get(&app_ctx->async, outputs, &slot, frame_id);
+    if (ret <= 0)
+    {
+        return ret;
+    }
+
+    // Post Process with the letterbox of that frame
+    post_process(app_ctx, outputs, &app_ctx->async_letter_box[slot], BOX_THRESH, NMS_THRESH, od_results);
+    rknn_outputs_release(app_ctx->rknn_ctx, app_ctx->io_num.n_output, outputs);
+    return 0;
+}
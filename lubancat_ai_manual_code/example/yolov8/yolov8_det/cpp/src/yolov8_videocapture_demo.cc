@@ -28,21 +28,47 @@
 
 double __get_us(struct timeval t) { return (t.tv_sec * 1000000 + t.tv_usec); }
 
+static void draw_results(cv::Mat &frame, object_detect_result_list *od_results)
+{
+    char text[256];
+    for (int i = 0; i < od_results->count; i++)
+    {
+        object_detect_result *det_result = &(od_results->results[i]);
+        printf("%s @ (%d %d %d %d) %.3f\n", coco_cls_to_name(det_result->cls_id),
+            det_result->box.left, det_result->box.top,
+            det_result->box.right, det_result->box.bottom,
+            det_result->prop);
+        int x1 = det_result->box.left;
+        int y1 = det_result->box.top;
+        int x2 = det_result->box.right;
+        int y2 = det_result->box.bottom;
+
+        rectangle(frame, cv::Point(x1, y1), cv::Point(x2, y2), cv::Scalar(255, 0, 0, 255), 2);
+        sprintf(text, "%s %.1f%%", coco_cls_to_name(det_result->cls_id), det_result->prop * 100);
+        putText(frame, text, cv::Point(x1, y1 - 6), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0,0,255), 1, cv::LINE_AA);
+    }
+}
+
 /*-------------------------------------------
                   Main Function
 -------------------------------------------*/
 int main(int argc, char **argv)
 {
-    if (argc != 3)
+    if (argc != 3 && !(argc == 4 && strcmp(argv[3], "async") == 0))
     {
-        printf("%s <model path> <camera device id/video path>\n", argv[0]);
+        printf("%s <model path> <camera device id/video path> [async]\n", argv[0]);
         printf("Usage: %s  yolov8s.rknn  0 \n", argv[0]);
         printf("Usage: %s  yolov8s.rknn /path/xxxx.mp4\n", argv[0]);
+        printf("async: post process of a frame overlaps the NPU run of the next one, the boxes come one frame later\n");
         return -1;
     }
 
     const char *model_path = argv[1];
     const char *device_name = argv[2];
+    bool async = argc == 4;
+    // async: frames wait here until their result is back
+    cv::Mat pending_frames[RKNN_ASYNC_SLOTS];
+    uint64_t result_id = 0;
 
     int ret;
     cv::Mat image, frame;
@@ -74,7 +100,7 @@ int main(int argc, char **argv)
 
     // 初始化
     init_post_process();
-    ret = init_yolov8_model(model_path, &rknn_app_ctx);
+    ret = async ? init_yolov8_async_model(model_path, &rknn_app_ctx) : init_yolov8_model(model_path, &rknn_app_ctx);
     if (ret != 0)
     {
         printf("init_yolov8_seg_model fail! ret=%d model_path=%s\n", ret, model_path);
@@ -85,42 +111,47 @@ int main(int argc, char **argv)
 	while(true) {
         gettimeofday(&start_time, NULL);
 
-        if (!cap.read(frame)) {  
+        bool end = !cap.read(frame);
+        if (end && !async) {  
             printf("cap read frame fail!\n");
             break;  
         }  
 
-        cv::cvtColor(frame, image, cv::COLOR_BGR2RGB);
-        src_image.width  = image.cols;
-        src_image.height = image.rows;
-        src_image.format = IMAGE_FORMAT_RGB888;
-        src_image.virt_addr = (unsigned char*)image.data;
+        if (!end) {
+            cv::cvtColor(frame, image, cv::COLOR_BGR2RGB);
+            src_image.width  = image.cols;
+            src_image.height = image.rows;
+            src_image.format = IMAGE_FORMAT_RGB888;
+            src_image.virt_addr = (unsigned char*)image.data;
+        }
 
-        ret = inference_yolov8_model(&rknn_app_ctx, &src_image, &od_results);
+        if (async) {
+            // at the end of the stream NULL fetches the last result
+            ret = inference_yolov8_async_model(&rknn_app_ctx, end ? NULL : &src_image, &od_results, &result_id);
+            if (ret == 0 && !end) {
+                pending_frames[rknn_app_ctx.async.submitted % RKNN_ASYNC_SLOTS] = frame.clone();
+            }
+        } else {
+            ret = inference_yolov8_model(&rknn_app_ctx, &src_image, &od_results);
+        }
         if (ret != 0)
         {
             printf("init_yolov8_seg_model fail! ret=%d\n", ret);
             goto out;
         }
 
-        // draw boxes
-        char text[256];
-        for (int i = 0; i < od_results.count; i++)
-        {
-            object_detect_result *det_result = &(od_results.results[i]);
-            printf("%s @ (%d %d %d %d) %.3f\n", coco_cls_to_name(det_result->cls_id),
-                det_result->box.left, det_result->box.top,
-                det_result->box.right, det_result->box.bottom,
-                det_result->prop);
-            int x1 = det_result->box.left;
-            int y1 = det_result->box.top;
-            int x2 = det_result->box.right;
-            int y2 = det_result->box.bottom;
-
-            rectangle(frame, cv::Point(x1, y1), cv::Point(x2, y2), cv::Scalar(255, 0, 0, 255), 2);
-            sprintf(text, "%s %.1f%%", coco_cls_to_name(det_result->cls_id), det_result->prop * 100);
-            putText(frame, text, cv::Point(x1, y1 - 6), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0,0,255), 1, cv::LINE_AA);
+        if (async) {
+            if (result_id == 0) {
+                if (end) {
+                    break;
+                }
+                continue;
+            }
+            // the boxes belong to an earlier frame, draw them on that one
+            frame = pending_frames[result_id % RKNN_ASYNC_SLOTS];
         }
+        // draw boxes
+        draw_results(frame, &od_results);
 
 		// 计算FPS
         gettimeofday(&stop_time, NULL);
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "yolov8_pose.h"
+#include "stage_profiler.h"
 
 #include <math.h>
 #include <stdint.h>
@@ -390,6 +391,7 @@ static int process_fp32(float *input, int grid_h, int grid_w, int stride,
 
 int post_process(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box, float conf_threshold, float nms_threshold,
                  object_detect_result_list *od_results) {
+    PROFILE_SCOPE("post_process");
 
     rknn_output *_outputs = (rknn_output *)outputs;
     std::vector<float> filterBoxes;
@@ -21,6 +21,7 @@
 #include "file_utils.h"
 #include "image_utils.h"
 #include "dma_alloc.cpp"
+#include "stage_profiler.h"
 
 #include <sys/time.h>
 
@@ -156,6 +157,7 @@ int release_yolov8_pose_model(rknn_app_context_t *app_ctx)
 
 int inference_yolov8_pose_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("inference_yolov8_pose_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -222,10 +224,12 @@ int inference_yolov8_pose_model(rknn_app_context_t *app_ctx, image_buffer_t *img
     }
 
     // Run
-    printf("rknn_run\n");
     // int start_us,end_us;
     // start_us = getCurrentTimeUs();
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     // end_us = getCurrentTimeUs() - start_us;
     // printf("rknn_run time=%.2fms, FPS = %.2f\n",end_us / 1000.f, 
     //         1000.f * 1000.f / end_us);
@@ -6,6 +6,7 @@
 #include "yolov8_seg.h"
 #include "image_utils.h"
 #include "dma_alloc.h"
+#include "stage_profiler.h"
 
 static void dump_tensor_attr(rknn_tensor_attr *attr)
 {
@@ -165,6 +166,7 @@ int release_yolov8_seg_model(rknn_app_context_t *app_ctx)
 
 int inference_yolov8_seg_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("inference_yolov8_seg_model");
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -234,8 +236,10 @@ int inference_yolov8_seg_model(rknn_app_context_t *app_ctx, image_buffer_t *img,
     }
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        PROFILE_SCOPE("rknn_run");
+        ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    }
     if (ret < 0)
     {
         printf("rknn_run fail! ret=%d\n", ret);
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "yolox.h"
+#include "stage_profiler.h"
 
 #include <math.h>
 #include <stdint.h>
@@ -425,6 +426,7 @@ static int process_fp32(float *input, int grid_h, int grid_w, int height, int wi
 
 int post_process(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box, float conf_threshold, float nms_threshold, object_detect_result_list *od_results)
 {
+    PROFILE_SCOPE("post_process");
 #if defined(RV1106_1103) 
     rknn_tensor_mem **_outputs = (rknn_tensor_mem **)outputs;
 #else
@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "yolox.h"
+#include "rknn_perf.h"
 #include "image_utils.h"
 #include "file_utils.h"
 #include "image_drawing.h"
@@ -33,26 +34,37 @@
 -------------------------------------------*/
 int main(int argc, char **argv)
 {
-    if (argc != 3)
+    if (argc != 3 && !((argc == 4 || argc == 5) && strcmp(argv[3], "profile") == 0))
     {
-        printf("%s <model_path> <image_path>\n", argv[0]);
+        printf("%s <model_path> <image_path> [profile [runs]]\n", argv[0]);
+        printf("profile: per layer NPU time over the runs (default %d), NPU run vs end-to-end time\n",
+               RKNN_PERF_DEFAULT_RUNS);
         return -1;
     }
 
     const char *model_path = argv[1];
     const char *image_path = argv[2];
+    bool profile = argc >= 4;
+    int profile_runs = argc == 5 ? atoi(argv[4]) : RKNN_PERF_DEFAULT_RUNS;
 
     int ret;
     TIMER timer;
 
+    rknn_perf_t perf;
     rknn_app_context_t rknn_app_ctx;
+    memset(&perf, 0, sizeof(rknn_perf_t));
     memset(&rknn_app_ctx, 0, sizeof(rknn_app_context_t));
 
     timer.indent_set("");
     init_post_process();
 
     timer.tik();
+#ifndef RV1106_1103
+    ret = profile ? init_yolox_profile_model(model_path, &rknn_app_ctx) : init_yolox_model(model_path, &rknn_app_ctx);
+#else
+    // no layer table in this build, only the time split
     ret = init_yolox_model(model_path, &rknn_app_ctx);
+#endif
     if (ret != 0)
     {
         printf("init_yolox_model fail! ret=%d model_path=%s\n", ret, model_path);
@@ -96,6 +108,19 @@ int main(int argc, char **argv)
     timer.tok();
     timer.print_time("inference_yolox_model");
 
+    if (profile)
+    {
+        // the run above was the warm up
+        rknn_perf_init(&perf, rknn_app_ctx.rknn_ctx);
+        for (int i = 0; i < profile_runs && ret == 0; i++)
+        {
+            rknn_perf_frame_begin(&perf);
+            ret = inference_yolox_model(&rknn_app_ctx, &src_image, &od_results);
+            rknn_perf_frame_end(&perf);
+        }
+        rknn_perf_print(&perf, 20);
+    }
+
     // 画框和概率
     char text[256];
     for (int i = 0; i < od_results.count; i++)
@@ -120,6 +145,7 @@ int main(int argc, char **argv)
 
 out:
     deinit_post_process();
+    rknn_perf_release(&perf);
 
     ret = release_yolox_model(&rknn_app_ctx);
     if (ret != 0)
@@ -46,21 +46,68 @@ static const unsigned char colors[19][3] = {
     {139, 125, 96}
 };
 
+static void draw_results(cv::Mat &frame, object_detect_result_list *od_results)
+{
+    char text[256];
+    int color_index = 0;
+    for (int i = 0; i < od_results->count; i++)
+    {
+        const unsigned char* color = colors[color_index % 19];
+        cv::Scalar cc(color[0], color[1], color[2]);
+        color_index++;
+
+        object_detect_result *det_result = &(od_results->results[i]);
+        printf("%s @ (%d %d %d %d) %.3f\n", coco_cls_to_name(det_result->cls_id),
+            det_result->box.left, det_result->box.top,
+            det_result->box.right, det_result->box.bottom,
+            det_result->prop);
+        sprintf(text, "%s %.1f%%", coco_cls_to_name(det_result->cls_id), det_result->prop * 100);
+
+        cv::rectangle(frame, cv::Rect(cv::Point(det_result->box.left, det_result->box.top), 
+                        cv::Point(det_result->box.right, det_result->box.bottom)), cc, 2);
+
+        int baseLine = 0;
+        cv::Size label_size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseLine);
+
+        int x = det_result->box.left;
+        int y = det_result->box.top - label_size.height - baseLine;
+        if (y < 0)
+            y = 0;
+        if (x + label_size.width > frame.cols)
+            x = frame.cols - label_size.width;
+
+        cv::rectangle(frame, cv::Rect(cv::Point(x, y), cv::Size(label_size.width, label_size.height + baseLine)),cc,-1);
+        cv::putText(frame, text, cv::Point(x, y + label_size.height),cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255));
+    }
+}
+
 /*-------------------------------------------
                   Main Function
 -------------------------------------------*/
 int main(int argc, char **argv)
 {
-    if (argc != 3)
+    if (argc != 3 && !(argc == 4 && strcmp(argv[3], "async") == 0))
     {
-        printf("%s <model path> <camera device id/video path>\n", argv[0]);
+        printf("%s <model path> <camera device id/video path> [async]\n", argv[0]);
         printf("Usage: %s  yolox.rknn  0 \n", argv[0]);
         printf("Usage: %s  yolox.rknn /path/xxxx.mp4\n", argv[0]);
+        printf("async: post process of a frame overlaps the NPU run of the next one, the boxes come one frame later\n");
         return -1;
     }
 
     const char *model_path = argv[1];
     const char *device_name = argv[2];
+    bool async = argc == 4;
+#if defined(RV1106_1103)
+    if (async) {
+        // the bound output memory is rewritten by the run in flight
+        printf("async is not available with the zero copy api, running sync\n");
+        async = false;
+    }
+#endif
+    // async: frames wait here until their result is back
+    cv::Mat pending_frames[RKNN_ASYNC_SLOTS];
+    uint64_t result_id = 0;
 
     int ret;
     TIMER timer;
@@ -96,7 +143,11 @@ int main(int argc, char **argv)
 
     // 初始化
     init_post_process();
+#if defined(RV1106_1103)
     ret = init_yolox_model(model_path, &rknn_app_ctx);
+#else
+    ret = async ? init_yolox_async_model(model_path, &rknn_app_ctx) : init_yolox_model(model_path, &rknn_app_ctx);
+#endif
     if (ret != 0)
     {
         printf("init yolox_model fail! ret=%d model_path=%s\n", ret, model_path);
@@ -108,22 +159,37 @@ int main(int argc, char **argv)
         gettimeofday(&start_time, NULL);
 
         cap >> frame;
-        if (frame.empty())
+        bool end = frame.empty();
+        if (end && !async)
             break;
         // if (!cap.read(frame)) {  
         //     printf("cap read frame fail!\n");
         //     break;  
         // }  
 
-        cv::cvtColor(frame, image, cv::COLOR_BGR2RGB);
-        // image.convertTo(image, CV_8UC3);
-        src_image.width  = image.cols;
-        src_image.height = image.rows;
-        src_image.format = IMAGE_FORMAT_RGB888;
-        src_image.virt_addr = reinterpret_cast<unsigned char *>(image.data);
+        if (!end) {
+            cv::cvtColor(frame, image, cv::COLOR_BGR2RGB);
+            // image.convertTo(image, CV_8UC3);
+            src_image.width  = image.cols;
+            src_image.height = image.rows;
+            src_image.format = IMAGE_FORMAT_RGB888;
+            src_image.virt_addr = reinterpret_cast<unsigned char *>(image.data);
+        }
 
         timer.tik();
+#if defined(RV1106_1103)
         ret = inference_yolox_model(&rknn_app_ctx, &src_image, &od_results);
+#else
+        if (async) {
+            // at the end of the stream NULL fetches the last result
+            ret = inference_yolox_async_model(&rknn_app_ctx, end ? NULL : &src_image, &od_results, &result_id);
+            if (ret == 0 && !end) {
+                pending_frames[rknn_app_ctx.async.submitted % RKNN_ASYNC_SLOTS] = frame.clone();
+            }
+        } else {
+            ret = inference_yolox_model(&rknn_app_ctx, &src_image, &od_results);
+        }
+#endif
         if (ret != 0)
         {
             printf("inference yolox_model fail! ret=%d\n", ret);
@@ -132,37 +198,17 @@ int main(int argc, char **argv)
         timer.tok();
         timer.print_time("inference_yolox_model");
 
-        char text[256];
-        int color_index = 0;
-        for (int i = 0; i < od_results.count; i++)
-        {
-            const unsigned char* color = colors[color_index % 19];
-            cv::Scalar cc(color[0], color[1], color[2]);
-            color_index++;
-
-            object_detect_result *det_result = &(od_results.results[i]);
-            printf("%s @ (%d %d %d %d) %.3f\n", coco_cls_to_name(det_result->cls_id),
-                det_result->box.left, det_result->box.top,
-                det_result->box.right, det_result->box.bottom,
-                det_result->prop);
-            sprintf(text, "%s %.1f%%", coco_cls_to_name(det_result->cls_id), det_result->prop * 100);
-
-            cv::rectangle(frame, cv::Rect(cv::Point(det_result->box.left, det_result->box.top), 
-                            cv::Point(det_result->box.right, det_result->box.bottom)), cc, 2);
-
-            int baseLine = 0;
-            cv::Size label_size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseLine);
-
-            int x = det_result->box.left;
-            int y = det_result->box.top - label_size.height - baseLine;
-            if (y < 0)
-                y = 0;
-            if (x + label_size.width > frame.cols)
-                x = frame.cols - label_size.width;
-
-            cv::rectangle(frame, cv::Rect(cv::Point(x, y), cv::Size(label_size.width, label_size.height + baseLine)),cc,-1);
-            cv::putText(frame, text, cv::Point(x, y + label_size.height),cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255));
+        if (async) {
+            if (result_id == 0) {
+                if (end) {
+                    break;
+                }
+                continue;
+            }
+            // the boxes belong to an earlier frame, draw them on that one
+            frame = pending_frames[result_id % RKNN_ASYNC_SLOTS];
         }
+        draw_results(frame, &od_results);
 		cv::imshow("Yolox Videocapture Demo", frame);
 
 		char c = cv::waitKey(1);